@@ -0,0 +1,583 @@
+/** @file
+  Implementacja dużych współczynników wielomianów
+
+  @authors Izabela Ożdżeńska <io417924@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "big_coeff.h"
+
+/**
+ * Liczba cyfr (w systemie o podstawie @f$2^{32}@f$) wystarczająca do zapisania
+ * wartości bezwzględnej liczby typu poly_coeff_t.
+ */
+#define SMALL_DIGITS (sizeof(unsigned long) / sizeof(uint32_t))
+
+/**
+ * Podstawa, w której duże współczynniki zamieniane są na zapis dziesiętny:
+ * największa potęga dziesiątki mieszcząca się w cyfrze.
+ */
+#define DECIMAL_BASE 1000000000
+
+/**
+ * Liczba cyfr dziesiętnych cyfry w podstawie @p DECIMAL_BASE.
+ */
+#define DECIMAL_BASE_DIGITS 9
+
+/**
+ * To jest struktura przechowująca duży współczynnik: liczbę całkowitą
+ * zapisaną jako znak i cyfry wartości bezwzględnej w systemie o podstawie
+ * @f$2^{32}@f$, od najmniej znaczącej.
+ */
+typedef struct BigCoeff {
+    atomic_size_t refs; ///< liczba odwołań do współczynnika
+    bool negative;      ///< czy liczba jest ujemna
+    size_t len;         ///< liczba cyfr
+    uint32_t digits[];  ///< cyfry wartości bezwzględnej
+} BigCoeff;
+
+/**
+ * To jest struktura przechowująca widok współczynnika (dużego lub nie) jako
+ * znaku i cyfr wartości bezwzględnej. Cyfry współczynnika, który nie jest
+ * duży, przechowywane są w samym widoku, więc nie wolno go kopiować.
+ */
+typedef struct BigView {
+    bool negative;                 ///< czy liczba jest ujemna
+    size_t len;                    ///< liczba cyfr
+    const uint32_t *digits;        ///< cyfry wartości bezwzględnej
+    uint32_t small[SMALL_DIGITS];  ///< cyfry współczynnika, który nie jest duży
+} BigView;
+
+/**
+ * Daje duży współczynnik wskazywany przez wielomian.
+ * @param[in] p : duży współczynnik
+ * @return duży współczynnik
+ */
+static inline BigCoeff* BigOf(const Poly *p) {
+    assert(PolyIsBigCoeff(p));
+    return (BigCoeff*) ((uintptr_t) p->arr & ~POLY_BIG_COEFF_TAG);
+}
+
+/**
+ * Przydziela duży współczynnik o zadanej liczbie cyfr.
+ * @param[in] len : liczba cyfr
+ * @return duży współczynnik z nieustalonymi cyframi
+ */
+static BigCoeff* BigAlloc(size_t len) {
+    BigCoeff *big = malloc(sizeof(BigCoeff) + len * sizeof(uint32_t));
+    if (big == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    atomic_init(&big->refs, 1);
+    big->negative = false;
+    big->len = len;
+    return big;
+}
+
+/**
+ * Tworzy wielomian z nowo wyliczonego dużego współczynnika. Jeśli jego wartość
+ * mieści się w typie poly_coeff_t, zwalnia go i zwraca zwykły współczynnik.
+ * @param[in] big : duży współczynnik, do którego jest jedno odwołanie
+ * @return współczynnik równy @p big
+ */
+static Poly BigNormalize(BigCoeff *big) {
+    while (big->len > 0 && big->digits[big->len - 1] == 0) big->len--;
+    if (big->len == 0) big->negative = false;
+    if (big->len <= SMALL_DIGITS) {
+        unsigned long abs = 0;
+        for (size_t i = big->len; i-- > 0;) {
+            // Przesunięcie jest rozbite na dwa, by było poprawne także dla
+            // 32-bitowego typu long.
+            abs = abs << 16 << 16 | big->digits[i];
+        }
+        if (abs <= LONG_MAX || (big->negative && abs - 1 <= LONG_MAX)) {
+            poly_coeff_t value = big->negative ?
+                                 -(poly_coeff_t) (abs - 1) - 1 :
+                                 (poly_coeff_t) abs;
+            free(big);
+            return PolyFromCoeff(value);
+        }
+    }
+    return (Poly) {.coeff = 0,
+                   .arr = (Mono*) ((uintptr_t) big | POLY_BIG_COEFF_TAG)};
+}
+
+/**
+ * Tworzy wielomian z nowo wyliczonego dużego współczynnika, redukując go
+ * modulo, jeśli ustawiony jest moduł (patrz: BigNormalize()).
+ * @param[in] big : duży współczynnik, do którego jest jedno odwołanie
+ * @return współczynnik równy @p big (modulo moduł)
+ */
+static Poly BigResult(BigCoeff *big) {
+    Poly res = BigNormalize(big);
+    if (!ModEnabled() || !PolyIsBigCoeff(&res)) return res;
+    Poly reduced = PolyFromCoeff(BigCoeffMod(&res));
+    BigCoeffDestroy(&res);
+    return reduced;
+}
+
+/**
+ * Tworzy widok współczynnika.
+ * @param[in] p : współczynnik
+ * @param[out] view : widok
+ */
+static void BigViewOf(const Poly *p, BigView *view) {
+    if (PolyIsBigCoeff(p)) {
+        const BigCoeff *big = BigOf(p);
+        view->negative = big->negative;
+        view->len = big->len;
+        view->digits = big->digits;
+        return;
+    }
+    // Wartość bezwzględna w typie bez znaku obsługuje także LONG_MIN.
+    unsigned long abs = p->coeff < 0 ? -(unsigned long) p->coeff
+                                     : (unsigned long) p->coeff;
+    view->negative = p->coeff < 0;
+    view->len = 0;
+    while (abs > 0) {
+        view->small[view->len++] = (uint32_t) abs;
+        abs = abs >> 16 >> 16;
+    }
+    view->digits = view->small;
+}
+
+/**
+ * Porównuje wartości bezwzględne dwóch liczb.
+ * @param[in] a : widok liczby @f$a@f$
+ * @param[in] b : widok liczby @f$b@f$
+ * @return -1, 0 lub 1, jeśli odpowiednio @f$|a| < |b|@f$, @f$|a| = |b|@f$
+ * lub @f$|a| > |b|@f$
+ */
+static int BigCompareAbs(const BigView *a, const BigView *b) {
+    if (a->len != b->len) return a->len < b->len ? -1 : 1;
+    for (size_t i = a->len; i-- > 0;) {
+        if (a->digits[i] != b->digits[i]) {
+            return a->digits[i] < b->digits[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Robi kopię dużego współczynnika, zwiększając licznik odwołań do niego.
+ * @param[in] p : duży współczynnik
+ * @return skopiowany współczynnik
+ */
+Poly BigCoeffClone(const Poly *p) {
+    atomic_fetch_add_explicit(&BigOf(p)->refs, 1, memory_order_relaxed);
+    return *p;
+}
+
+/**
+ * Usuwa odwołanie do dużego współczynnika i zwalnia go, jeśli było ostatnie.
+ * @param[in] p : duży współczynnik
+ */
+void BigCoeffDestroy(Poly *p) {
+    BigCoeff *big = BigOf(p);
+    if (atomic_fetch_sub_explicit(&big->refs, 1, memory_order_acq_rel) == 1) {
+        free(big);
+    }
+}
+
+/**
+ * Dodaje dwa współczynniki, z których co najmniej jeden jest duży lub których
+ * suma nie mieści się w typie poly_coeff_t. Jeśli ustawiony jest moduł,
+ * wynik jest redukowany modulo.
+ * @param[in] p : współczynnik @f$p@f$
+ * @param[in] q : współczynnik @f$q@f$
+ * @return @f$p + q@f$
+ */
+Poly BigCoeffAdd(const Poly *p, const Poly *q) {
+    BigView p_view, q_view;
+    BigViewOf(p, &p_view);
+    BigViewOf(q, &q_view);
+    // Liczba [a] ma nie mniejszą wartość bezwzględną niż [b], więc znak
+    // wyniku jest znakiem [a].
+    const BigView *a = &p_view, *b = &q_view;
+    if (BigCompareAbs(a, b) < 0) {
+        a = &q_view;
+        b = &p_view;
+    }
+    BigCoeff *res = BigAlloc(a->len + 1);
+    res->negative = a->negative;
+    if (a->negative == b->negative) {
+        uint64_t carry = 0;
+        for (size_t i = 0; i < a->len; i++) {
+            carry += (uint64_t) a->digits[i] + (i < b->len ? b->digits[i] : 0);
+            res->digits[i] = (uint32_t) carry;
+            carry >>= 32;
+        }
+        res->digits[a->len] = (uint32_t) carry;
+    }
+    else {
+        uint64_t borrow = 0;
+        for (size_t i = 0; i < a->len; i++) {
+            uint64_t sub = (i < b->len ? b->digits[i] : 0) + borrow;
+            borrow = a->digits[i] < sub;
+            res->digits[i] = (uint32_t) (a->digits[i] - sub);
+        }
+        res->digits[a->len] = 0;
+    }
+    return BigResult(res);
+}
+
+/**
+ * Mnoży dwa współczynniki, z których co najmniej jeden jest duży lub których
+ * iloczyn nie mieści się w typie poly_coeff_t. Jeśli ustawiony jest moduł,
+ * wynik jest redukowany modulo.
+ * @param[in] p : współczynnik @f$p@f$
+ * @param[in] q : współczynnik @f$q@f$
+ * @return @f$p * q@f$
+ */
+Poly BigCoeffMul(const Poly *p, const Poly *q) {
+    BigView a, b;
+    BigViewOf(p, &a);
+    BigViewOf(q, &b);
+    BigCoeff *res = BigAlloc(a.len + b.len);
+    res->negative = a.negative != b.negative;
+    memset(res->digits, 0, res->len * sizeof(uint32_t));
+    for (size_t i = 0; i < a.len; i++) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < b.len; j++) {
+            carry += (uint64_t) a.digits[i] * b.digits[j] + res->digits[i + j];
+            res->digits[i + j] = (uint32_t) carry;
+            carry >>= 32;
+        }
+        res->digits[i + b.len] = (uint32_t) carry;
+    }
+    return BigResult(res);
+}
+
+/**
+ * Dzieli współczynnik przez dodatnią liczbę, która go dzieli. Cyfry dzielone
+ * są od najbardziej znaczącej, z resztą przenoszoną do kolejnej cyfry.
+ * @param[in] p : współczynnik @f$p@f$ (duży lub nie)
+ * @param[in] d : dzielnik @f$d > 0@f$, @f$d \mid p@f$
+ * @return @f$p / d@f$
+ */
+Poly BigCoeffDivExact(const Poly *p, uint32_t d) {
+    assert(d > 0 && !ModEnabled());
+    if (!PolyIsBigCoeff(p)) {
+        assert(p->coeff % (poly_coeff_t) d == 0);
+        return PolyFromCoeff(p->coeff / (poly_coeff_t) d);
+    }
+    const BigCoeff *big = BigOf(p);
+    BigCoeff *res = BigAlloc(big->len);
+    res->negative = big->negative;
+    uint64_t rem = 0;
+    for (size_t i = big->len; i-- > 0;) {
+        uint64_t cur = rem << 32 | big->digits[i];
+        res->digits[i] = (uint32_t) (cur / d);
+        rem = cur % d;
+    }
+    assert(rem == 0);
+    return BigNormalize(res);
+}
+
+/**
+ * Dzieli wartości bezwzględne liczb z resztą, zakładając, że dzielnik ma co
+ * najmniej dwie cyfry, a dzielna nie mniej cyfr niż dzielnik. Cyfry ilorazu
+ * wyznaczane są od najbardziej znaczącej: każda jest szacowana z dwóch
+ * najstarszych cyfr reszty i poprawiana co najwyżej dwukrotnie, o ile
+ * najstarsza cyfra dzielnika ma ustawiony najstarszy bit (algorytm D Knutha).
+ * @param[in] u : widok dzielnej
+ * @param[in] v : widok dzielnika
+ * @param[out] quot : cyfry ilorazu, @f$u.len - v.len + 1@f$ cyfr
+ * @param[out] rem : cyfry reszty, @f$v.len@f$ cyfr
+ */
+static void BigDivMagnitude(const BigView *u, const BigView *v,
+                            uint32_t quot[], uint32_t rem[]) {
+    const uint64_t base = (uint64_t) 1 << 32;
+    size_t n = v->len, m = u->len - n;
+    assert(n >= 2 && u->len >= n);
+    // Normalizacja: przesuwamy obie liczby tak, by najstarszy bit dzielnika
+    // był ustawiony.
+    unsigned shift = 0;
+    while ((v->digits[n - 1] << shift & 0x80000000u) == 0) shift++;
+    uint32_t *vn = malloc((n + u->len + 1) * sizeof(uint32_t));
+    if (vn == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    uint32_t *un = vn + n;
+    for (size_t i = n; i-- > 1;) {
+        vn[i] = v->digits[i] << shift |
+                (uint32_t) ((uint64_t) v->digits[i - 1] >> (32 - shift));
+    }
+    vn[0] = v->digits[0] << shift;
+    un[u->len] = (uint32_t) ((uint64_t) u->digits[u->len - 1] >> (32 - shift));
+    for (size_t i = u->len; i-- > 1;) {
+        un[i] = u->digits[i] << shift |
+                (uint32_t) ((uint64_t) u->digits[i - 1] >> (32 - shift));
+    }
+    un[0] = u->digits[0] << shift;
+
+    for (size_t j = m + 1; j-- > 0;) {
+        uint64_t num = (uint64_t) un[j + n] << 32 | un[j + n - 1];
+        uint64_t qhat = num / vn[n - 1], rhat = num % vn[n - 1];
+        while (qhat >= base ||
+               qhat * vn[n - 2] > (rhat << 32 | un[j + n - 2])) {
+            qhat--;
+            rhat += vn[n - 1];
+            if (rhat >= base) break;
+        }
+        // Odejmujemy qhat * vn od reszty.
+        int64_t borrow = 0, t;
+        for (size_t i = 0; i < n; i++) {
+            uint64_t product = qhat * vn[i];
+            t = (int64_t) un[i + j] - borrow - (int64_t) (product & 0xffffffffu);
+            un[i + j] = (uint32_t) t;
+            borrow = (int64_t) (product >> 32) - (t >> 32);
+        }
+        t = (int64_t) un[j + n] - borrow;
+        un[j + n] = (uint32_t) t;
+        quot[j] = (uint32_t) qhat;
+        if (t < 0) {
+            // Oszacowanie było o jeden za duże: dodajemy dzielnik z powrotem.
+            quot[j]--;
+            uint64_t carry = 0;
+            for (size_t i = 0; i < n; i++) {
+                carry += (uint64_t) un[i + j] + vn[i];
+                un[i + j] = (uint32_t) carry;
+                carry >>= 32;
+            }
+            un[j + n] += (uint32_t) carry;
+        }
+    }
+    for (size_t i = 0; i + 1 < n; i++) {
+        rem[i] = un[i] >> shift |
+                 (uint32_t) ((uint64_t) un[i + 1] << (32 - shift));
+    }
+    rem[n - 1] = un[n - 1] >> shift;
+    free(vn);
+}
+
+/**
+ * Dzieli współczynnik przez niezerowy współczynnik z resztą. Iloraz jest
+ * zaokrąglany w stronę zera, więc reszta ma znak dzielnej. Wolno ją wywołać
+ * tylko wtedy, gdy nie jest ustawiony moduł.
+ * @param[in] p : dzielna @f$p@f$
+ * @param[in] q : dzielnik @f$q \neq 0@f$
+ * @param[out] rem : reszta @f$p - q \cdot (p / q)@f$
+ * @return iloraz @f$p / q@f$
+ */
+Poly BigCoeffDivRem(const Poly *p, const Poly *q, Poly *rem) {
+    assert(!ModEnabled() && !PolyIsZero(q));
+    BigView u, v;
+    BigViewOf(p, &u);
+    BigViewOf(q, &v);
+    if (BigCompareAbs(&u, &v) < 0) {
+        *rem = PolyIsBigCoeff(p) ? BigCoeffClone(p) : *p;
+        return PolyZero();
+    }
+    BigCoeff *quot = BigAlloc(u.len - v.len + 1), *r = BigAlloc(v.len);
+    quot->negative = u.negative != v.negative;
+    r->negative = u.negative;
+    if (v.len == 1) {
+        uint64_t rest = 0;
+        for (size_t i = u.len; i-- > 0;) {
+            uint64_t cur = rest << 32 | u.digits[i];
+            quot->digits[i] = (uint32_t) (cur / v.digits[0]);
+            rest = cur % v.digits[0];
+        }
+        r->digits[0] = (uint32_t) rest;
+    }
+    else {
+        BigDivMagnitude(&u, &v, quot->digits, r->digits);
+    }
+    *rem = BigNormalize(r);
+    return BigNormalize(quot);
+}
+
+/**
+ * Wylicza największy wspólny dzielnik dwóch współczynników algorytmem
+ * Euklidesa. Gdy obie liczby mieszczą się w typie poly_coeff_t, kończy go na
+ * liczbach typu unsigned long. Wolno ją wywołać tylko wtedy, gdy nie jest
+ * ustawiony moduł.
+ * @param[in] p : współczynnik @f$p@f$
+ * @param[in] q : współczynnik @f$q@f$
+ * @return nieujemny @f$\gcd(p, q)@f$
+ */
+Poly BigCoeffGcd(const Poly *p, const Poly *q) {
+    assert(!ModEnabled());
+    Poly a = PolyIsBigCoeff(p) ? BigCoeffClone(p) : *p;
+    Poly b = PolyIsBigCoeff(q) ? BigCoeffClone(q) : *q;
+    while (PolyIsBigCoeff(&a) || PolyIsBigCoeff(&b)) {
+        if (PolyIsZero(&b)) break;
+        Poly r, quot = BigCoeffDivRem(&a, &b, &r);
+        PolyDestroy(&quot);
+        PolyDestroy(&a);
+        a = b;
+        b = r;
+    }
+    if (!PolyIsBigCoeff(&a)) {
+        // Wartość bezwzględna w typie bez znaku obsługuje także LONG_MIN.
+        unsigned long x = a.coeff < 0 ? -(unsigned long) a.coeff
+                                      : (unsigned long) a.coeff;
+        unsigned long y = b.coeff < 0 ? -(unsigned long) b.coeff
+                                      : (unsigned long) b.coeff;
+        while (y != 0) {
+            unsigned long r = x % y;
+            x = y;
+            y = r;
+        }
+        if (x <= LONG_MAX) return PolyFromCoeff((poly_coeff_t) x);
+        Poly minus = PolyFromCoeff(LONG_MIN), one = PolyFromCoeff(-1);
+        return BigCoeffMul(&minus, &one);
+    }
+    if (BigOf(&a)->negative) {
+        Poly one = PolyFromCoeff(-1), abs = BigCoeffMul(&a, &one);
+        BigCoeffDestroy(&a);
+        a = abs;
+    }
+    return a;
+}
+
+/**
+ * Sprawdza równość dwóch współczynników, z których co najmniej jeden jest
+ * duży.
+ * @param[in] p : współczynnik @f$p@f$
+ * @param[in] q : współczynnik @f$q@f$
+ * @return @f$p = q@f$
+ */
+bool BigCoeffIsEq(const Poly *p, const Poly *q) {
+    BigView a, b;
+    BigViewOf(p, &a);
+    BigViewOf(q, &b);
+    return a.negative == b.negative && BigCompareAbs(&a, &b) == 0;
+}
+
+/**
+ * Wylicza skrót wartości dużego współczynnika.
+ * @param[in] p : duży współczynnik
+ * @return skrót
+ */
+size_t BigCoeffHash(const Poly *p) {
+    const BigCoeff *big = BigOf(p);
+    size_t hash = big->negative ? ~(size_t) 0 : 0;
+    for (size_t i = 0; i < big->len; i++) {
+        hash = (hash ^ big->digits[i]) * (size_t) 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+ * Zamienia liczbę na jej zapis dziesiętny. Cyfry w podstawie
+ * @p DECIMAL_BASE wyznaczane są przez kolejne dzielenia wartości
+ * bezwzględnej, od najmniej znaczącej.
+ * @param[in] view : widok liczby
+ * @return zapis dziesiętny zakończony znakiem '\0', przydzielony przez
+ * malloc()
+ */
+static char* BigViewToStr(const BigView *view) {
+    // Cyfra w podstawie 2^32 ma mniej niż 10 cyfr dziesiętnych.
+    char *str = malloc(10 * view->len + 2);
+    uint32_t *rest = malloc((view->len + 1) * sizeof(uint32_t));
+    if (str == NULL || rest == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    memcpy(rest, view->digits, view->len * sizeof(uint32_t));
+    size_t rest_len = view->len, str_len = 0;
+    do {
+        uint64_t rem = 0;
+        for (size_t i = rest_len; i-- > 0;) {
+            uint64_t curr = rem << 32 | rest[i];
+            rest[i] = (uint32_t) (curr / DECIMAL_BASE);
+            rem = curr % DECIMAL_BASE;
+        }
+        while (rest_len > 0 && rest[rest_len - 1] == 0) rest_len--;
+        // Cyfry w podstawie DECIMAL_BASE poza najbardziej znaczącą
+        // uzupełniamy zerami.
+        for (int i = 0; i < DECIMAL_BASE_DIGITS && (rest_len > 0 || rem > 0);
+             i++) {
+            str[str_len++] = (char) ('0' + rem % 10);
+            rem /= 10;
+        }
+    } while (rest_len > 0);
+    free(rest);
+
+    if (str_len == 0) str[str_len++] = '0';
+    if (view->negative) str[str_len++] = '-';
+    for (size_t i = 0, j = str_len; i + 1 < j; i++, j--) {
+        char temp = str[i];
+        str[i] = str[j - 1];
+        str[j - 1] = temp;
+    }
+    str[str_len] = '\0';
+    return str;
+}
+
+/**
+ * Zamienia współczynnik na jego zapis dziesiętny (patrz: BigViewToStr()).
+ * @param[in] p : współczynnik
+ * @return zapis dziesiętny zakończony znakiem '\0', przydzielony przez
+ * malloc()
+ */
+char* BigCoeffToStr(const Poly *p) {
+    BigView view;
+    BigViewOf(p, &view);
+    return BigViewToStr(&view);
+}
+
+/**
+ * Zamienia liczbę zapisaną jako znak i cyfry wartości bezwzględnej
+ * w systemie o podstawie @f$2^{32}@f$ na jej zapis dziesiętny.
+ * @param[in] negative : czy liczba jest ujemna
+ * @param[in] len : liczba cyfr
+ * @param[in] digits : cyfry wartości bezwzględnej, od najmniej znaczącej
+ * @return zapis dziesiętny zakończony znakiem '\0', przydzielony przez
+ * malloc()
+ */
+char* BigCoeffDigitsToStr(bool negative, size_t len, const uint32_t digits[]) {
+    BigView view = {.negative = negative, .len = len, .digits = digits};
+    return BigViewToStr(&view);
+}
+
+/**
+ * Daje znak i cyfry wartości bezwzględnej dużego współczynnika.
+ * @param[in] p : duży współczynnik
+ * @param[out] negative : czy współczynnik jest ujemny
+ * @param[out] digits : cyfry wartości bezwzględnej w systemie o podstawie
+ * @f$2^{32}@f$, od najmniej znaczącej; ważne, dopóki istnieje @p p
+ * @return liczba cyfr
+ */
+size_t BigCoeffDigits(const Poly *p, bool *negative, const uint32_t **digits) {
+    const BigCoeff *big = BigOf(p);
+    *negative = big->negative;
+    *digits = big->digits;
+    return big->len;
+}
+
+/**
+ * Tworzy współczynnik z liczby zapisanej jako znak i cyfry wartości
+ * bezwzględnej. Jeśli ustawiony jest moduł, wynik jest redukowany modulo.
+ * @param[in] negative : czy liczba jest ujemna
+ * @param[in] len : liczba cyfr
+ * @param[in] digits : cyfry wartości bezwzględnej w systemie o podstawie
+ * @f$2^{32}@f$, od najmniej znaczącej
+ * @return współczynnik równy zadanej liczbie
+ */
+Poly BigCoeffFromDigits(bool negative, size_t len, const uint32_t digits[]) {
+    BigCoeff *big = BigAlloc(len);
+    big->negative = negative;
+    memcpy(big->digits, digits, len * sizeof(uint32_t));
+    return BigResult(big);
+}
+
+/**
+ * Daje resztę z dzielenia współczynnika przez ustawiony moduł. Cyfry
+ * wartości bezwzględnej przetwarzane są schematem Hornera, od najbardziej
+ * znaczącej.
+ * @param[in] p : współczynnik
+ * @return @f$p \bmod mod@f$
+ */
+poly_coeff_t BigCoeffMod(const Poly *p) {
+    assert(ModEnabled());
+    if (!PolyIsBigCoeff(p)) return ModReduce(p->coeff);
+    const BigCoeff *big = BigOf(p);
+    // Cyfry przetwarzane są połówkami po 16 bitów, by było to poprawne także
+    // dla 32-bitowego typu long.
+    poly_coeff_t half_base = ModReduce((poly_coeff_t) 1 << 16), res = 0;
+    for (size_t i = big->len; i-- > 0;) {
+        res = ModAdd(ModMulReduced(res, half_base), big->digits[i] >> 16);
+        res = ModAdd(ModMulReduced(res, half_base), big->digits[i] & 0xffff);
+    }
+    return big->negative && res != 0 ? (poly_coeff_t) mod_arith.mod - res : res;
+}
@@ -0,0 +1,250 @@
+/** @file
+  Interfejs dużych współczynników wielomianów
+
+  Współczynniki wielomianów są przechowywane jako liczby typu poly_coeff_t
+  i na nich wykonywane są obliczenia. Dodawanie i mnożenie współczynników
+  sprawdza, czy nastąpiło przepełnienie, i tylko wtedy wynik przechowywany
+  jest jako duża liczba całkowita dowolnej precyzji (patrz: PolyIsBigCoeff()).
+  Duże współczynniki nie są modyfikowane po utworzeniu, więc kopie
+  współdzielą je, zwiększając licznik odwołań. Wynik działania na dużych
+  współczynnikach, który mieści się w typie poly_coeff_t, jest z powrotem
+  zamieniany na zwykły współczynnik, więc każda liczba ma dokładnie jedną
+  reprezentację. Gdy ustawiony jest moduł (patrz: mod_arith.h), działania
+  wykonywane są modulo i duże współczynniki nie powstają.
+
+  @authors Izabela Ożdżeńska <io417924@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#ifndef GAMMA_BIG_COEFF_H
+#define GAMMA_BIG_COEFF_H
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "mod_arith.h"
+#include "poly.h"
+
+/**
+ * Robi kopię dużego współczynnika, zwiększając licznik odwołań do niego.
+ * @param[in] p : duży współczynnik
+ * @return skopiowany współczynnik
+ */
+Poly BigCoeffClone(const Poly *p);
+
+/**
+ * Usuwa odwołanie do dużego współczynnika i zwalnia go, jeśli było ostatnie.
+ * @param[in] p : duży współczynnik
+ */
+void BigCoeffDestroy(Poly *p);
+
+/**
+ * Dodaje dwa współczynniki, z których co najmniej jeden jest duży lub których
+ * suma nie mieści się w typie poly_coeff_t. Jeśli ustawiony jest moduł,
+ * wynik jest redukowany modulo.
+ * @param[in] p : współczynnik @f$p@f$
+ * @param[in] q : współczynnik @f$q@f$
+ * @return @f$p + q@f$
+ */
+Poly BigCoeffAdd(const Poly *p, const Poly *q);
+
+/**
+ * Mnoży dwa współczynniki, z których co najmniej jeden jest duży lub których
+ * iloczyn nie mieści się w typie poly_coeff_t. Jeśli ustawiony jest moduł,
+ * wynik jest redukowany modulo.
+ * @param[in] p : współczynnik @f$p@f$
+ * @param[in] q : współczynnik @f$q@f$
+ * @return @f$p * q@f$
+ */
+Poly BigCoeffMul(const Poly *p, const Poly *q);
+
+/**
+ * Dzieli współczynnik przez dodatnią liczbę, która go dzieli. Wolno ją
+ * wywołać tylko wtedy, gdy nie jest ustawiony moduł.
+ * @param[in] p : współczynnik @f$p@f$ (duży lub nie)
+ * @param[in] d : dzielnik @f$d > 0@f$, @f$d \mid p@f$
+ * @return @f$p / d@f$
+ */
+Poly BigCoeffDivExact(const Poly *p, uint32_t d);
+
+/**
+ * Dzieli współczynnik przez niezerowy współczynnik z resztą, zaokrąglając
+ * iloraz w stronę zera. Wolno ją wywołać tylko wtedy, gdy nie jest ustawiony
+ * moduł.
+ * @param[in] p : dzielna @f$p@f$
+ * @param[in] q : dzielnik @f$q \neq 0@f$
+ * @param[out] rem : reszta @f$p - q \cdot (p / q)@f$, o znaku @p p
+ * @return iloraz @f$p / q@f$
+ */
+Poly BigCoeffDivRem(const Poly *p, const Poly *q, Poly *rem);
+
+/**
+ * Wylicza największy wspólny dzielnik dwóch współczynników. Wolno ją
+ * wywołać tylko wtedy, gdy nie jest ustawiony moduł.
+ * @param[in] p : współczynnik @f$p@f$
+ * @param[in] q : współczynnik @f$q@f$
+ * @return nieujemny @f$\gcd(p, q)@f$
+ */
+Poly BigCoeffGcd(const Poly *p, const Poly *q);
+
+/**
+ * Sprawdza równość dwóch współczynników, z których co najmniej jeden jest
+ * duży.
+ * @param[in] p : współczynnik @f$p@f$
+ * @param[in] q : współczynnik @f$q@f$
+ * @return @f$p = q@f$
+ */
+bool BigCoeffIsEq(const Poly *p, const Poly *q);
+
+/**
+ * Wylicza skrót wartości dużego współczynnika.
+ * @param[in] p : duży współczynnik
+ * @return skrót
+ */
+size_t BigCoeffHash(const Poly *p);
+
+/**
+ * Zamienia współczynnik na jego zapis dziesiętny.
+ * @param[in] p : współczynnik
+ * @return zapis dziesiętny zakończony znakiem '\0', przydzielony przez
+ * malloc()
+ */
+char* BigCoeffToStr(const Poly *p);
+
+/**
+ * Zamienia liczbę zapisaną jako znak i cyfry wartości bezwzględnej
+ * w systemie o podstawie @f$2^{32}@f$ na jej zapis dziesiętny.
+ * @param[in] negative : czy liczba jest ujemna
+ * @param[in] len : liczba cyfr
+ * @param[in] digits : cyfry wartości bezwzględnej, od najmniej znaczącej
+ * @return zapis dziesiętny zakończony znakiem '\0', przydzielony przez
+ * malloc()
+ */
+char* BigCoeffDigitsToStr(bool negative, size_t len, const uint32_t digits[]);
+
+/**
+ * Daje znak i cyfry wartości bezwzględnej dużego współczynnika.
+ * @param[in] p : duży współczynnik
+ * @param[out] negative : czy współczynnik jest ujemny
+ * @param[out] digits : cyfry wartości bezwzględnej w systemie o podstawie
+ * @f$2^{32}@f$, od najmniej znaczącej; ważne, dopóki istnieje @p p
+ * @return liczba cyfr
+ */
+size_t BigCoeffDigits(const Poly *p, bool *negative, const uint32_t **digits);
+
+/**
+ * Tworzy współczynnik z liczby zapisanej jako znak i cyfry wartości
+ * bezwzględnej. Jeśli ustawiony jest moduł, wynik jest redukowany modulo.
+ * @param[in] negative : czy liczba jest ujemna
+ * @param[in] len : liczba cyfr
+ * @param[in] digits : cyfry wartości bezwzględnej w systemie o podstawie
+ * @f$2^{32}@f$, od najmniej znaczącej
+ * @return współczynnik równy zadanej liczbie
+ */
+Poly BigCoeffFromDigits(bool negative, size_t len, const uint32_t digits[]);
+
+/**
+ * Daje resztę z dzielenia współczynnika przez ustawiony moduł.
+ * @param[in] p : współczynnik
+ * @return @f$p \bmod mod@f$
+ */
+poly_coeff_t BigCoeffMod(const Poly *p);
+
+/**
+ * Dodaje dwie liczby typu poly_coeff_t, sprawdzając, czy nastąpiło
+ * przepełnienie.
+ * @param[in] a : liczba @f$a@f$
+ * @param[in] b : liczba @f$b@f$
+ * @param[out] res : @f$a + b@f$, jeśli nie nastąpiło przepełnienie
+ * @return Czy nastąpiło przepełnienie?
+ */
+static inline bool CoeffAddOverflow(poly_coeff_t a, poly_coeff_t b,
+                                    poly_coeff_t *res) {
+#ifdef __GNUC__
+    return __builtin_add_overflow(a, b, res);
+#else
+    if ((b > 0 && a > LONG_MAX - b) || (b < 0 && a < LONG_MIN - b)) return true;
+    *res = a + b;
+    return false;
+#endif
+}
+
+/**
+ * Mnoży dwie liczby typu poly_coeff_t, sprawdzając, czy nastąpiło
+ * przepełnienie.
+ * @param[in] a : liczba @f$a@f$
+ * @param[in] b : liczba @f$b@f$
+ * @param[out] res : @f$a * b@f$, jeśli nie nastąpiło przepełnienie
+ * @return Czy nastąpiło przepełnienie?
+ */
+static inline bool CoeffMulOverflow(poly_coeff_t a, poly_coeff_t b,
+                                    poly_coeff_t *res) {
+#ifdef __GNUC__
+    return __builtin_mul_overflow(a, b, res);
+#else
+    if (a > 0 ? (b > 0 ? a > LONG_MAX / b : b < LONG_MIN / a)
+              : (b > 0 ? a < LONG_MIN / b : a != 0 && b < LONG_MAX / a)) {
+        return true;
+    }
+    *res = a * b;
+    return false;
+#endif
+}
+
+/**
+ * Dodaje dwa współczynniki.
+ * @param[in] p : współczynnik @f$p@f$
+ * @param[in] q : współczynnik @f$q@f$
+ * @return @f$p + q@f$
+ */
+static inline Poly CoeffAdd(const Poly *p, const Poly *q) {
+    poly_coeff_t res;
+    if (p->arr == NULL && q->arr == NULL) {
+        if (ModEnabled()) return PolyFromCoeff(ModAdd(p->coeff, q->coeff));
+        if (!CoeffAddOverflow(p->coeff, q->coeff, &res)) {
+            return PolyFromCoeff(res);
+        }
+    }
+    return BigCoeffAdd(p, q);
+}
+
+/**
+ * Mnoży dwa współczynniki.
+ * @param[in] p : współczynnik @f$p@f$
+ * @param[in] q : współczynnik @f$q@f$
+ * @return @f$p * q@f$
+ */
+static inline Poly CoeffMul(const Poly *p, const Poly *q) {
+    poly_coeff_t res;
+    if (p->arr == NULL && q->arr == NULL) {
+        if (ModEnabled()) return PolyFromCoeff(ModMul(p->coeff, q->coeff));
+        if (!CoeffMulOverflow(p->coeff, q->coeff, &res)) {
+            return PolyFromCoeff(res);
+        }
+    }
+    return BigCoeffMul(p, q);
+}
+
+/**
+ * Sprawdza równość dwóch współczynników.
+ * @param[in] p : współczynnik @f$p@f$
+ * @param[in] q : współczynnik @f$q@f$
+ * @return @f$p = q@f$
+ */
+static inline bool CoeffIsEq(const Poly *p, const Poly *q) {
+    // Liczba mieszcząca się w typie poly_coeff_t nigdy nie jest duża.
+    if (p->arr == NULL && q->arr == NULL) return p->coeff == q->coeff;
+    return BigCoeffIsEq(p, q);
+}
+
+/**
+ * Wylicza skrót wartości współczynnika.
+ * @param[in] p : współczynnik
+ * @return skrót
+ */
+static inline size_t CoeffHash(const Poly *p) {
+    return p->arr == NULL ? (size_t) p->coeff : BigCoeffHash(p);
+}
+
+#endif //GAMMA_BIG_COEFF_H
@@ -5,16 +5,132 @@
   @date 2021
 */
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "calc_parse.h"
+#include "calc_stats.h"
+#include "mod_arith.h"
+#include "mono_alloc.h"
+#include "thread_pool.h"
 
 /**
- * Wykonuje funkcję GetInput().
+ * Zamienia napis na liczbę wątków puli.
+ * @param[in] str : napis
+ * @param[out] threads : liczba wątków
+ * @return Czy napis jest poprawną, dodatnią liczbą wątków?
+ */
+static bool ParseThreads(const char *str, size_t *threads) {
+    char *end;
+    unsigned long value = strtoul(str, &end, 10);
+    if (str[0] < '0' || str[0] > '9' || *end != '\0' || value == 0) {
+        return false;
+    }
+    *threads = value;
+    return true;
+}
+
+/**
+ * Zamienia napis na moduł, modulo który liczone są współczynniki.
+ * @param[in] str : napis
+ * @param[out] mod : moduł
+ * @return Czy napis jest poprawnym modułem z przedziału @f$[2, MOD\_MAX]@f$?
+ */
+static bool ParseModulus(const char *str, poly_coeff_t *mod) {
+    char *end;
+    unsigned long value = strtoul(str, &end, 10);
+    if (str[0] < '0' || str[0] > '9' || *end != '\0' || value < 2 ||
+        value > MOD_MAX) {
+        return false;
+    }
+    *mod = (poly_coeff_t) value;
+    return true;
+}
+
+/**
+ * Ustawia opcje kalkulatora podane w wierszu poleceń, a następnie wykonuje
+ * funkcję GetInput(). Dostępne opcje:
+ * "--intern" - włącza internowanie wielomianów (patrz: PolySetInterning()),
+ * "--threads n" - wykonuje mnożenie, składanie i wyliczanie wartości
+ * wielomianów przy użyciu puli @f$n@f$ wątków (patrz: thread_pool.h).
+ * Liczbę wątków można też podać w zmiennej środowiskowej POLY_THREADS; opcja
+ * wiersza poleceń ma pierwszeństwo.
+ * "--mod p" - liczy współczynniki wielomianów modulo @f$p@f$ (patrz:
+ * PolySetModulus()), tak jak polecenie "MOD p". Moduł jest jeden; nie ma
+ * trybu liczenia modulo kilka liczb pierwszych z odtwarzaniem wyników
+ * z reszt (patrz: mod_arith.h).
+ * "--script file" - wczytuje polecenia z pliku @p file zamiast ze
+ * standardowego wejścia. Zwykły plik jest odwzorowywany w pamięci i dzielony
+ * na wiersze bez kopiowania (patrz: line_reader.h).
+ * "--flat" - wykonuje polecenia ADD, SUB i MUL w rozłożonej reprezentacji
+ * wielomianów ze spakowanymi wykładnikami (patrz: poly_flat.h).
+ * "--lazy" - wykonuje polecenia ADD, SUB, MUL i NEG leniwie: wynik jest
+ * obliczany dopiero, gdy odczytuje go inne polecenie, a ciąg działań
+ * obliczany jest bez wyników pośrednich (patrz: poly_expr.h).
+ * "--stats" - zlicza działania biblioteki (patrz: PolyCounters) i po
+ * wykonaniu wszystkich poleceń wypisuje na standardowe wyjście diagnostyczne
+ * statystyki wykonania poleceń, tak jak polecenie "STATS" (patrz:
+ * calc_stats.h).
+ * @param[in] argc : liczba argumentów wiersza poleceń
+ * @param[in] argv : argumenty wiersza poleceń
  * @return 0, jeśli program zakończył się prawidłowo; 1, jeśli wystąpił błąd
  * krytyczny
  */
-int main() {
-    GetInput();
+int main(int argc, char *argv[]) {
+    size_t threads = 1;
+    poly_coeff_t mod;
+    const char *script = NULL;
+    bool stats = false;
+    const char *env_threads = getenv("POLY_THREADS");
+    if (env_threads != NULL && !ParseThreads(env_threads, &threads)) {
+        fprintf(stderr, "Invalid POLY_THREADS value\n");
+        exit(1);
+    }
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--intern") == 0) {
+            PolySetInterning(true);
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc &&
+                 ParseThreads(argv[i + 1], &threads)) {
+            i++;
+        }
+        else if (strcmp(argv[i], "--mod") == 0 && i + 1 < argc &&
+                 ParseModulus(argv[i + 1], &mod)) {
+            PolySetModulus(mod);
+            i++;
+        }
+        else if (strcmp(argv[i], "--script") == 0 && i + 1 < argc) {
+            script = argv[++i];
+        }
+        else if (strcmp(argv[i], "--flat") == 0) {
+            UseFlatEngine(true);
+        }
+        else if (strcmp(argv[i], "--lazy") == 0) {
+            UseLazyEvaluation(true);
+        }
+        else if (strcmp(argv[i], "--stats") == 0) {
+            StatsEnableCounters();
+            stats = true;
+        }
+        else {
+            fprintf(stderr, "Usage: %s [--intern] [--threads n] [--mod p] "
+                    "[--script file] [--flat] [--lazy] [--stats]\n", argv[0]);
+            exit(1);
+        }
+    }
+    LineReader input;
+    if (script == NULL) {
+        LineReaderFromStream(&input, stdin);
+    }
+    else if (!LineReaderOpen(&input, script)) {
+        fprintf(stderr, "Cannot open script %s\n", script);
+        exit(1);
+    }
+    PoolStart(threads);
+    GetInput(&input);
+    LineReaderClose(&input);
+    if (stats) StatsPrint(stderr);
+    PoolStop();
+    MonoAllocCleanup();
     exit(0);
 }
-
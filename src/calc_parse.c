@@ -10,13 +10,20 @@
 #include <ctype.h>
 #include <string.h>
 #include <stdlib.h>
-#include <errno.h>
 #include <limits.h>
 
 #include <stdio.h>
 
+#include "big_coeff.h"
 #include "calc_parse.h"
+#include "calc_stats.h"
+#include "mod_arith.h"
+#include "mono_alloc.h"
 #include "poly.h"
+#include "poly_eval.h"
+#include "poly_expr.h"
+#include "poly_flat.h"
+#include "poly_view.h"
 
 /**
  * Początkowy rozmiar tablicy, której rozmiar może być w przyszłości
@@ -24,36 +31,135 @@
  */
 #define INITIAL_SIZE 4
 
+/**
+ * Liczba punktów polecenia "EVAL_BATCH" wyliczanych i wypisywanych razem.
+ */
+#define EVAL_BATCH_CHUNK 4096
+
 /**
  * Sprawdza czy tekst zaczyna się od zadanego prefiksu.
  * @param input : tekst
+ * @param len : długość tekstu
  * @param prefix : prefiks
  * @return 1, jeśli tekst zaczyna się od zadanego prefiksu; 0 w przeciwnym
  * wypadku
  */
-static bool startsWith(const char *input, const char *prefix) {
-    if (strlen(prefix) > strlen(input)) return false;
-    for (size_t i = 0; prefix[i]; i++) {
-        if (input[i] != prefix[i]) return false;
+static bool startsWith(const char *input, size_t len, const char *prefix) {
+    size_t prefix_len = strlen(prefix);
+    return prefix_len <= len && memcmp(input, prefix, prefix_len) == 0;
+}
+
+/**
+ * Sprawdza czy tekst jest równy zadanemu słowu.
+ * @param input : tekst
+ * @param len : długość tekstu
+ * @param word : słowo
+ * @return 1, jeśli tekst jest równy słowu; 0 w przeciwnym wypadku
+ */
+static bool isWord(const char *input, size_t len, const char *word) {
+    return strlen(word) == len && memcmp(input, word, len) == 0;
+}
+
+/**
+ * To jest struktura przechowująca stan wczytywania wielomianu z tekstu.
+ * Jednomiany wczytywanych wielomianów odkładane są na wspólny stos
+ * jednomianów: wielomian na głębszym poziomie zagnieżdżenia zostaje w całości
+ * wczytany (i zdjęty ze stosu) zanim wczytywanie wielomianu na płytszym
+ * poziomie będzie kontynuowane.
+ */
+typedef struct PolyParser {
+    const char *cursor;     ///< pozycja, od której wczytywany jest tekst
+    const char *end;        ///< koniec tekstu; tekst nie musi być zakończony
+                            ///< znakiem '\0'
+    Mono *monos;            ///< stos wczytanych jednomianów
+    size_t monos_size;      ///< liczba jednomianów na stosie
+    size_t monos_capacity;  ///< pojemność stosu jednomianów
+} PolyParser;
+
+/**
+ * Daje znak na pozycji wczytywania.
+ * @param[in] parser : stan wczytywania
+ * @return znak na pozycji wczytywania lub EOF na końcu tekstu
+ */
+static inline int Peek(const PolyParser *parser) {
+    return parser->cursor < parser->end ? (unsigned char) *parser->cursor : EOF;
+}
+
+/**
+ * Sprawdza, czy znak na zadanej pozycji tekstu jest cyfrą.
+ * @param[in] c : pozycja w tekście
+ * @param[in] end : koniec tekstu
+ * @return Czy przed końcem tekstu na pozycji @p c jest cyfra?
+ */
+static inline bool IsDigitAt(const char *c, const char *end) {
+    return c < end && isdigit((unsigned char) *c);
+}
+
+/**
+ * Wczytuje liczbę całkowitą w zapisie dziesiętnym, opcjonalnie poprzedzoną
+ * znakiem '-'. Przesuwa pozycję wczytywania za wczytaną liczbę.
+ * @param[in,out] parser : stan wczytywania
+ * @param[out] res : wczytana liczba
+ * @return 1, jeśli wczytano liczbę mieszczącą się w typie long; 0 w przeciwnym
+ * wypadku
+ */
+static bool ParseNumber(PolyParser *parser, long *res) {
+    const char *c = parser->cursor;
+    bool negative = (Peek(parser) == '-');
+    if (negative) c++;
+    if (!IsDigitAt(c, parser->end)) return false;
+    long value = 0;
+    for (; IsDigitAt(c, parser->end); c++) {
+        int digit = *c - '0';
+        // Liczby ujemne kumulujemy jako ujemne, aby zmieścić LONG_MIN.
+        if (negative) {
+            if (value < (LONG_MIN + digit) / 10) return false;
+            value = value * 10 - digit;
+        }
+        else {
+            if (value > (LONG_MAX - digit) / 10) return false;
+            value = value * 10 + digit;
+        }
+    }
+    parser->cursor = c;
+    *res = value;
+    return true;
+}
+
+/**
+ * Wczytuje liczbę nieujemną w zapisie dziesiętnym, bez znaku. Przesuwa
+ * pozycję wczytywania za wczytaną liczbę.
+ * @param[in,out] parser : stan wczytywania
+ * @param[out] res : wczytana liczba
+ * @return 1, jeśli wczytano liczbę mieszczącą się w typie unsigned long;
+ * 0 w przeciwnym wypadku
+ */
+static bool ParseUnsigned(PolyParser *parser, unsigned long *res) {
+    const char *c = parser->cursor;
+    if (!IsDigitAt(c, parser->end)) return false;
+    unsigned long value = 0;
+    for (; IsDigitAt(c, parser->end); c++) {
+        unsigned digit = (unsigned) (*c - '0');
+        if (value > (ULONG_MAX - digit) / 10) return false;
+        value = value * 10 + digit;
     }
+    parser->cursor = c;
+    *res = value;
     return true;
 }
 
 /**
  * Sprawdza czy zadany tekst można zinterpretować jako wielomian będący
- * współczynnikiem.
+ * współczynnikiem i wczytuje ten współczynnik.
  * @param[in] input : tekst
+ * @param[in] end : koniec tekstu
+ * @param[out] res : wczytany współczynnik
  * @return 1, jeśli zadany tekst można zinterpretować jako współczynnik
  * wielomianu; 0 w przeciwnym wypadku
  */
-bool correctCoeff(const char *input) {
-    if (input[0] == '\0')return false;
-    if (input[0] == '+' || isspace(input[0])) return false;
-    char *endptr;
-    errno = 0;
-    strtol(input, &endptr, 10);
-    if (endptr[0] != '\0' || errno) return false;
-    else return true;
+static bool correctCoeff(const char *input, const char *end, long *res) {
+    PolyParser parser = {.cursor = input, .end = end};
+    return ParseNumber(&parser, res) && parser.cursor == end;
 }
 
 /**
@@ -63,38 +169,19 @@ bool correctCoeff(const char *input) {
  */
 #define correctAtArg correctCoeff
 
-/**
- * Sprawdza czy zadany tekst można zinterpretować jako wykładnik potęgi
- * zmiennej jednomianu.
- * @param[in] input : tekst
- * @return 1, jeśli zadany tekst można zinterpretować jako wykładnik potęgi
- * zmiennej jednomianu; 0 w przeciwnym wypadku
- */
-bool correctExp(const char *input) {
-    if (!correctCoeff(input)) return false;
-    else {
-        char *endptr;
-        long num = strtol(input, &endptr, 10);
-        if (num < 0 || num > INT_MAX) return false;
-        else return true;
-    }
-}
-
 /**
  * Sprawdza czy zadany tekst można zinterpretować jako argument polecenia
- * z opcją <DEG_BY>.
+ * z opcją <DEG_BY> i wczytuje ten argument.
  * @param[in] input : tekst
+ * @param[in] end : koniec tekstu
+ * @param[out] res : wczytany argument
  * @return 1, jeśli zadany tekst można zinterpretować jako argument polecenia
  * z opcją <DEG_BY>; 0 w przeciwnym wypadku
  */
-static bool correctDegArg(const char *input) {
-    if (input[0] == '\0') return false;
-    if (input[0] == '+' || input[0] == '-' || isspace(input[0])) return false;
-    char *endptr;
-    errno = 0;
-    strtoul(input, &endptr, 10);
-    if (endptr[0] != '\0' || errno) return false;
-    else return true;
+static bool correctDegArg(const char *input, const char *end,
+                          unsigned long *res) {
+    PolyParser parser = {.cursor = input, .end = end};
+    return ParseUnsigned(&parser, res) && parser.cursor == end;
 }
 
 /**
@@ -104,280 +191,337 @@ static bool correctDegArg(const char *input) {
  */
 #define correctComposeArg correctDegArg
 
-static bool correctMono(const char *input);
+/**
+ * Argument polecenia z opcją <MOD> ma ten sam format co argument polecenia
+ * z opcją <DEG_BY>, co jest sprawdzane przez funkcję correctDegArg().
+ */
+#define correctModArg correctDegArg
 
 /**
- * Sprawdza czy zadany tekst można zinterpretować jako wielomian. Akceptowane
- * są następujące formaty tekstowe wielomianu:
- * "<współczynnik>", gdzie współczynnik to tekst, który można zinterpretować
- * jako wielomian będący współczynnikiem (ptarz: correctCoeff())
- * "(<jednomian>)"
- * "(<jednomian>)+@f$\ldots@f$+(<jednomian>)", gdzie <jednomian> to tekst,
- * który można zinterpretować jako jednomian (patrz: correctMono())
- * @param[in] input
- * @return 1, jeśli zadany tekst można zinterpretować jako wielomian;
- * 0 w przeciwnym wypadku
+ * Argumenty poleceń z opcjami <ROT> i <PICK> mają ten sam format co argument
+ * polecenia z opcją <DEG_BY>, co jest sprawdzane przez funkcję correctDegArg().
  */
-bool correctPoly(const char *input) {
-    if (input[0] == '\0') return false;
-    if (isdigit(input[0]) || input[0] == '-') {
-        return correctCoeff(input);
-    }
-    else {
-        size_t idx = 0, start_idx, parentheses;
-        while (true) {
-            if (input[idx] == '\0') return false;
-            start_idx = idx;
-            if (input[start_idx] != '(') return false;
-            else parentheses = 1;
-            // Szukamy nawiasu zamykającego nawias na pozycji [start_idx]
-            while (parentheses > 0) {
-                idx++;
-                if (input[idx] == '\0') return false;
-                if (input[idx] == '(') parentheses++;
-                if (input[idx] == ')') parentheses--;
-            }
-            if (idx - start_idx == 1) return false; // Znaleziono "()".
-            char *mono = malloc(idx - start_idx);
-            mono[idx - start_idx - 1] = '\0'; // To jest tekst pomiędzy
-            // nawiasami na pozycjach [start_idx] i [idx].
-            strncpy(mono, input + start_idx + 1, idx - start_idx - 1);
-            if (!correctMono(mono)) {
-                free(mono);
-                return false;
-            }
-            free(mono);
+#define correctStackArg correctDegArg
 
-            if (input[idx + 1] == '\0') return true; // [input] zakończył się
-            // w odpowiednim momencie.
-            else if (input[idx + 1] != '+') return false; // Po zakończonym
-            // jednomianie nie wystąpił '+'.
-            else idx += 2;
-        }
+/**
+ * Argument polecenia z opcją <POW> ma ten sam format co argument polecenia
+ * z opcją <DEG_BY>, co jest sprawdzane przez funkcję correctDegArg().
+ */
+#define correctPowArg correctDegArg
+
+/**
+ * Liczba cyfr dziesiętnych dopisywanych naraz do dużego współczynnika:
+ * @f$10^9 < 2^{32}@f$, więc porcja mieści się w jednej jego cyfrze.
+ */
+#define DECIMAL_CHUNK_DIGITS 9
+
+/**
+ * Mnoży liczbę zapisaną cyframi w systemie o podstawie @f$2^{32}@f$ przez
+ * @p factor i dodaje do niej @p addend, dopisując w razie potrzeby nową
+ * najbardziej znaczącą cyfrę.
+ * @param[in,out] digits : cyfry liczby, od najmniej znaczącej; tablica
+ * przydzielona przez malloc()
+ * @param[in,out] len : liczba cyfr
+ * @param[in,out] capacity : pojemność tablicy cyfr
+ * @param[in] factor : mnożnik
+ * @param[in] addend : składnik
+ */
+static void DigitsMulAdd(uint32_t **digits, size_t *len, size_t *capacity,
+                         uint32_t factor, uint32_t addend) {
+    uint64_t carry = addend;
+    for (size_t i = 0; i < *len; i++) {
+        uint64_t x = (uint64_t) (*digits)[i] * factor + carry;
+        (*digits)[i] = (uint32_t) x;
+        carry = x >> 32;
+    }
+    if (carry == 0) return;
+    if (*len == *capacity) {
+        *capacity *= 2;
+        *digits = realloc(*digits, *capacity * sizeof(uint32_t));
+        if (*digits == NULL) exit(1); // Błąd podczas alokacji pamięci.
     }
+    (*digits)[(*len)++] = (uint32_t) carry;
 }
 
 /**
- * Sprawdza czy zadany tekst można zinterpretować jako jednomian. Akceptowany
- * jest następujący format tekstowy jednomianu:
- * "<wielomian>,<wykładnik potęgi>", gdzie <wielomian> to tekst, który można
- * zinterpretować jako wielomian (patrz: correctPoly()), a <wykładnik potęgi>
- * to tekst, który można zinterpretować jako wykładnik potęgi (patrz:
- * correctExp()).
- * @param[in] input : tekst
- * @return 1, jeśli zadany tekst można zinterpretować jako jednomian;
- * 0 w przeciwnym wypadku
+ * Wczytuje współczynnik: liczbę całkowitą w zapisie dziesiętnym, opcjonalnie
+ * poprzedzoną znakiem '-'. Liczba, która nie mieści się w typie
+ * poly_coeff_t, staje się dużym współczynnikiem (patrz: big_coeff.h), więc
+ * wczytywane są też wielomiany wypisane poleceniem PRINT. Przesuwa pozycję
+ * wczytywania za wczytaną liczbę.
+ * @param[in,out] parser : stan wczytywania
+ * @param[out] res : wczytany współczynnik
+ * @return 1, jeśli wczytano liczbę; 0 w przeciwnym wypadku
  */
-static bool correctMono(const char *input) {
-    if (input[0] == '\0') return false;
-    size_t input_len = strlen(input);
-    size_t comma_idx = 0; // To jest pozycja, na której znajduje się ostatni
-    // przecinek.
-    for (size_t i = input_len; i > 0; i--) {
-        if (input[i] == ',') {
-            comma_idx = i;
-            break;
-        }
-    }
-    if (comma_idx == 0 || comma_idx == input_len - 1) return false;
-    // Podzielenie [input] na lewą część ([poly]) i prawą część ([exp]).
-    char *poly = malloc(comma_idx + 1);
-    char *exp = malloc(input_len - comma_idx);
-    poly[comma_idx] = '\0', exp[input_len - comma_idx - 1] = '\0';
-    strncpy(poly, input, comma_idx);
-    strncpy(exp, input + comma_idx + 1, input_len - comma_idx - 1);
-
-    if (correctPoly(poly) && correctExp(exp)) {
-        free(poly);
-        free(exp);
+static bool ParseCoeff(PolyParser *parser, Poly *res) {
+    poly_coeff_t value;
+    if (ParseNumber(parser, &value)) {
+        *res = PolyFromCoeff(value);
         return true;
     }
-    else {
-        free(poly);
-        free(exp);
-        return false;
+    const char *c = parser->cursor;
+    bool negative = (Peek(parser) == '-');
+    if (negative) c++;
+    if (!IsDigitAt(c, parser->end)) return false;
+    // Liczba nie mieści się w typie long. Kolejne porcje cyfr dziesiętnych
+    // dopisujemy do cyfr w systemie o podstawie 2^32.
+    size_t len = 0, capacity = 4;
+    uint32_t *digits = malloc(capacity * sizeof(uint32_t));
+    if (digits == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    while (IsDigitAt(c, parser->end)) {
+        uint32_t chunk = 0, factor = 1;
+        for (int i = 0; i < DECIMAL_CHUNK_DIGITS && IsDigitAt(c, parser->end);
+             i++, c++) {
+            chunk = chunk * 10 + (uint32_t) (*c - '0');
+            factor *= 10;
+        }
+        DigitsMulAdd(&digits, &len, &capacity, factor, chunk);
+    }
+    parser->cursor = c;
+    *res = BigCoeffFromDigits(negative, len, digits);
+    free(digits);
+    return true;
+}
+
+/**
+ * Odkłada jednomian na stos jednomianów, powiększając go w razie potrzeby.
+ * @param[in,out] parser : stan wczytywania
+ * @param[in] m : jednomian
+ */
+static void PushParsedMono(PolyParser *parser, Mono m) {
+    if (parser->monos_size == parser->monos_capacity) {
+        parser->monos_capacity *= 2;
+        parser->monos = realloc(parser->monos,
+                                parser->monos_capacity * sizeof(Mono));
+        if (parser->monos == NULL) exit(1); // Błąd podczas alokacji pamięci.
     }
+    parser->monos[parser->monos_size] = m;
+    parser->monos_size++;
 }
 
-static Mono StrToMono(const char *input);
+static bool ParseMono(PolyParser *parser, Mono *res);
 
 /**
- * Konwertuje zadany tekst na wielomian niebędący współczynnikiem.
- * @param[in] input : tekst
- * @return skonwertowany wielomian niebędący współczynnikiem
+ * Wczytuje wielomian, przesuwając pozycję wczytywania za jego zapis.
+ * Akceptowane są następujące formaty tekstowe wielomianu:
+ * "<współczynnik>", gdzie współczynnik to liczba całkowita (patrz:
+ * ParseCoeff());
+ * "(<jednomian>)";
+ * "(<jednomian>)+@f$\ldots@f$+(<jednomian>)", gdzie <jednomian> ma format
+ * opisany w dokumentacji funkcji ParseMono().
+ * Jednomiany wielomianu trafiają na stos jednomianów tylko na czas jego
+ * wczytywania. W przypadku błędu na stosie mogą pozostać jednomiany, które
+ * zwalnia ReadPoly().
+ * @param[in,out] parser : stan wczytywania
+ * @param[out] res : wczytany wielomian
+ * @return 1, jeśli wczytano poprawny wielomian; 0 w przeciwnym wypadku
  */
-static Poly StrToPolyNonCoeff(const char *input) {
-    Mono *monos = malloc(INITIAL_SIZE * sizeof(Mono)); // To jest tablica
-    // jednomianów zawartych w [input].
-    size_t monos_idx = 0, monos_size = INITIAL_SIZE;
-    size_t idx = 0, start_idx, parentheses;
+static bool ParsePoly(PolyParser *parser, Poly *res) {
+    if (Peek(parser) != '(') return ParseCoeff(parser, res);
+    size_t start = parser->monos_size;
     while (true) {
-        if (monos_idx == monos_size) { // Zwiększ [monos], jeśli jest zapełniona.
-            monos_size *= 2;
-            monos = realloc(monos, monos_size * sizeof(Mono));
-        }
-        start_idx = idx;
-        parentheses = 1;
-        // Szukamy nawiasu zamykającego nawias na pozycji [start_idx]
-        while (parentheses > 0) {
-            idx++;
-            if (input[idx] == '(') parentheses++;
-            if (input[idx] == ')') parentheses--;
+        parser->cursor++; // Pomijamy '('.
+        Mono m;
+        if (!ParseMono(parser, &m)) return false;
+        if (Peek(parser) != ')') {
+            MonoDestroy(&m);
+            return false;
         }
-        char *mono = malloc(idx - start_idx);
-        mono[idx - start_idx - 1] = '\0';
-        strncpy(mono, input + start_idx + 1, idx - start_idx - 1);
-
-        Mono new_mono = StrToMono(mono);
-        monos[monos_idx] = new_mono;
-        monos_idx++;
-        free(mono);
+        parser->cursor++;
+        // Jednomiany tożsamościowo równe zeru nie zmieniają sumy.
+        if (!PolyIsZero(&m.p)) PushParsedMono(parser, m);
 
-        if (input[idx + 1] == '\0') break;
-        else idx += 2;
+        if (Peek(parser) != '+') break;
+        parser->cursor++;
+        if (Peek(parser) != '(') return false; // Po '+' musi wystąpić
+        // kolejny jednomian.
     }
-    monos_size = monos_idx;
-    Poly res = PolyAddMonos(monos_size, monos);
-    free(monos);
-    return res;
+    // Zdejmujemy jednomiany tego wielomianu ze stosu. Jednomiany podane
+    // w kolejności wykładników nie są już sortowane.
+    *res = PolyAddMonos(parser->monos_size - start, parser->monos + start);
+    parser->monos_size = start;
+    return true;
 }
 
 /**
- * Konwertuje zadany tekst na wielomian. W przypadku, gdy zadany tekst nie może
- * być zinterpretowany jako wielomian, program kończy działanie.
- * @param[in] input : tekst
- * @return wielomian - wynik konwersji
+ * Wczytuje jednomian, przesuwając pozycję wczytywania za jego zapis.
+ * Akceptowany jest następujący format tekstowy jednomianu:
+ * "<wielomian>,<wykładnik potęgi>", gdzie <wielomian> ma format opisany
+ * w dokumentacji funkcji ParsePoly(), a <wykładnik potęgi> to liczba z zakresu
+ * od 0 do INT_MAX.
+ * @param[in,out] parser : stan wczytywania
+ * @param[out] res : wczytany jednomian
+ * @return 1, jeśli wczytano poprawny jednomian; 0 w przeciwnym wypadku
  */
-Poly StrToPoly(const char *input) {
-    assert(correctPoly(input));
-    if (isdigit(input[0]) || input[0] == '-') {
-        char *endptr;
-        long coeff = strtol(input, &endptr, 10);
-        return PolyFromCoeff(coeff);
+static bool ParseMono(PolyParser *parser, Mono *res) {
+    Poly p;
+    if (!ParsePoly(parser, &p)) return false;
+    long exp;
+    if (Peek(parser) != ',') {
+        PolyDestroy(&p);
+        return false;
     }
-    else {
-        return StrToPolyNonCoeff(input);
+    parser->cursor++;
+    if (!ParseNumber(parser, &exp) || exp < 0 || exp > INT_MAX) {
+        PolyDestroy(&p);
+        return false;
     }
+    if (PolyIsZero(&p)) *res = MonoFromPoly(&p, 0);
+    else *res = MonoFromPoly(&p, (poly_exp_t) exp);
+    return true;
 }
 
 /**
- * Konwertuje zadany tekst na jednomian.
- * @param[in] input : tekst
- * @return jednomian - wynik konwersji
- */
-static Mono StrToMono(const char *input) {
-    assert(input[0] != '\0');
-    size_t input_len = strlen(input);
-    size_t comma_idx = 0;
-    for (size_t i = input_len; i > 0; i--) {
-        if (input[i] == ',') {
-            comma_idx = i;
-            break;
-        }
+ * Konwertuje tekst o zadanej długości na wielomian w jednym przejściu,
+ * jednocześnie sprawdzając jego poprawność (format opisany jest
+ * w dokumentacji funkcji ParsePoly()).
+ * @param[in] input : tekst, niekoniecznie zakończony znakiem '\0'
+ * @param[in] len : długość tekstu
+ * @param[out] res : wielomian - wynik konwersji
+ * @return 1, jeśli zadany tekst można zinterpretować jako wielomian;
+ * 0 w przeciwnym wypadku
+ */
+static bool ReadPolyText(const char *input, size_t len, Poly *res) {
+    PolyParser parser = {.cursor = input, .end = input + len, .monos_size = 0,
+                         .monos_capacity = INITIAL_SIZE};
+    parser.monos = malloc(INITIAL_SIZE * sizeof(Mono));
+    if (parser.monos == NULL) exit(1); // Błąd podczas alokacji pamięci.
+
+    bool correct = ParsePoly(&parser, res);
+    if (correct && parser.cursor != parser.end) {
+        PolyDestroy(res);
+        correct = false;
+    }
+    // Po błędzie na stosie zostają jednomiany niedokończonych wielomianów.
+    for (size_t i = 0; i < parser.monos_size; i++) {
+        MonoDestroy(&parser.monos[i]);
     }
-    assert(comma_idx != 0 && comma_idx != input_len - 1);
-    // Podzielenie [input] na lewą część (poly) i prawą część (exp).
-    char *poly = malloc(comma_idx + 1), *exp = malloc(input_len - comma_idx);
-    poly[comma_idx] = '\0', exp[input_len - comma_idx - 1] = '\0';
-    strncpy(poly, input, comma_idx);
-    strncpy(exp, input + comma_idx + 1, input_len - comma_idx - 1);
+    free(parser.monos);
+    return correct;
+}
 
-    char *endptr;
-    Poly p = StrToPoly(poly);
-    poly_exp_t e = (int) strtol(exp, &endptr, 10);
-    free(poly);
-    free(exp);
-    if (PolyIsZero(&p) && e != 0) return MonoFromPoly(&p, 0);
-    else return MonoFromPoly(&p, e);
+/**
+ * Konwertuje zadany tekst na wielomian w jednym przejściu, jednocześnie
+ * sprawdzając jego poprawność (format opisany jest w dokumentacji funkcji
+ * ParsePoly()).
+ * @param[in] input : tekst
+ * @param[out] res : wielomian - wynik konwersji
+ * @return 1, jeśli zadany tekst można zinterpretować jako wielomian;
+ * 0 w przeciwnym wypadku
+ */
+bool ReadPoly(const char *input, Poly *res) {
+    return ReadPolyText(input, strlen(input), res);
 }
 
 /**
- * To jest struktura przechowująca tekst razem z jego długością.
+ * Rozmiar bufora wyjścia, przez który wypisywane są wielomiany.
  */
-typedef struct StringPair {
-    char *string;   ///< tekst
-    size_t size;    ///< długość tekstu
-} StringPair;
+#define OUTPUT_BUFFER_SIZE ((size_t) 1 << 16)
 
-static StringPair MonoToStrPair(const Mono *m);
+/**
+ * To jest struktura przechowująca bufor wyjścia. Wielomian wypisywany jest
+ * bezpośrednio do bufora, który po zapełnieniu jest przekazywany do strumienia
+ * wyjściowego, więc wypisanie wielomianu dowolnej wielkości wymaga stałej
+ * ilości dodatkowej pamięci.
+ */
+typedef struct OutputBuffer {
+    FILE *stream;                   ///< strumień wyjściowy
+    size_t size;                    ///< liczba znaków w buforze
+    char data[OUTPUT_BUFFER_SIZE];  ///< zawartość bufora
+} OutputBuffer;
+
+/** To jest bufor wyjścia używany przez PrintPoly(). */
+static OutputBuffer output;
 
 /**
- * Konwertuje wielomian na tekst w formie struktury StringPair, w formacie
- * opisanym w dokumentacji funkcji correctPoly().
- * @param[in] p : wielomian
- * @return tekst będący wynikiem konwersji
+ * Przekazuje zawartość bufora wyjścia do strumienia wyjściowego.
  */
-static StringPair PolyToStrPair(const Poly *p) {
-    char *res = NULL;
-    size_t size = 0;
-    if (PolyIsCoeff(p)) {
-        if (!asprintf(&res, "%ld", p->coeff)) exit(1);
-        size = strlen(res);
+static void FlushOutput(void) {
+    if (fwrite(output.data, 1, output.size, output.stream) != output.size) {
+        exit(1); // Błąd podczas wypisywania.
     }
-    else {
-        StringPair monos_str[p->size];
-        for (size_t i = 0; i < p->size; i++) {
-            monos_str[i] = MonoToStrPair(&p->arr[p->size - i - 1]);
-            size += monos_str[i].size;
-        }
-        size_t parentheses = 3 * p->size - 1;
-        size += parentheses;
-        res = realloc(res, size + 1);
-
-        size_t res_idx = 0;
-        for (size_t i = 0; i < p->size; i++) {
-            res[res_idx] = '(';
-            res_idx++;
-            strcpy(res + res_idx, monos_str[i].string);
-            res_idx += monos_str[i].size;
-            res[res_idx] = ')';
-            res_idx++;
-            if (res_idx == size) res[res_idx] = '\0';
-            else res[res_idx] = '+';
-            res_idx++;
-
-            free(monos_str[i].string);
-        }
-    }
-    return (StringPair) {.string = res, .size = size};
+    output.size = 0;
 }
 
 /**
- * Konwertuje jednomian na tekst w formie struktury StringPair, w formacie
- * opisanym w dokumentacji funkcji correctMono().
- * @param[in] m : jednomian
- * @return tekst będący wynikiem konwersji
+ * Dopisuje znak do bufora wyjścia.
+ * @param[in] c : znak
  */
-static StringPair MonoToStrPair(const Mono *m) {
-    char *res = NULL;
-    size_t size;
+static inline void PutChar(char c) {
+    if (output.size == OUTPUT_BUFFER_SIZE) FlushOutput();
+    output.data[output.size++] = c;
+}
 
-    StringPair poly = PolyToStrPair(&m->p);
-    char *exp;
-    if (!asprintf(&exp, "%d", m->exp)) exit(1);
-    size_t exp_size = strlen(exp);
+/**
+ * Dopisuje do bufora wyjścia zapis dziesiętny liczby całkowitej.
+ * @param[in] value : liczba
+ */
+static void PutNumber(long value) {
+    char digits[24]; // Mieści zapis dziesiętny dowolnej liczby typu long.
+    size_t len = 0;
+    // Wartość bezwzględna w typie bez znaku obsługuje także LONG_MIN.
+    unsigned long abs_value = value < 0 ? -(unsigned long) value
+                                       : (unsigned long) value;
+    do {
+        digits[len++] = (char) ('0' + abs_value % 10);
+        abs_value /= 10;
+    } while (abs_value > 0);
+    if (value < 0) digits[len++] = '-';
 
-    size = poly.size + exp_size + 1;
-    res = malloc(size + 1);
-    strcpy(res, poly.string);
-    res[poly.size] = ',';
-    strcpy(res + poly.size + 1, exp);
-    free(exp);
-    res[size] = '\0';
+    if (OUTPUT_BUFFER_SIZE - output.size < len) FlushOutput();
+    while (len > 0) {
+        output.data[output.size++] = digits[--len];
+    }
+}
 
-    free(poly.string);
+/**
+ * Dopisuje do bufora wyjścia zapis dziesiętny dużego współczynnika.
+ * @param[in] p : duży współczynnik
+ */
+static void PutBigCoeff(const Poly *p) {
+    char *digits = BigCoeffToStr(p);
+    for (size_t i = 0; digits[i] != '\0'; i++) {
+        PutChar(digits[i]);
+    }
+    free(digits);
+}
 
-    return (StringPair) {.string = res, .size = size};
+/**
+ * Dopisuje do bufora wyjścia wielomian w formacie opisanym w dokumentacji
+ * funkcji ParsePoly(). Jednomiany wypisywane są w kolejności rosnących
+ * wykładników.
+ * @param[in] p : wielomian
+ */
+static void PutPoly(const Poly *p) {
+    if (PolyIsBigCoeff(p)) {
+        PutBigCoeff(p);
+        return;
+    }
+    if (PolyIsCoeff(p)) {
+        PutNumber(p->coeff);
+        return;
+    }
+    for (size_t i = p->size; i-- > 0;) {
+        PutChar('(');
+        PutPoly(&p->arr[i].p);
+        PutChar(',');
+        PutNumber(p->arr[i].exp);
+        PutChar(')');
+        if (i > 0) PutChar('+');
+    }
 }
 
 /**
- * Konwertuje wielomian na tekst w formacie opisanym w dokumentacji funkcji
- * correctPoly().
+ * Wypisuje wielomian, zakończony znakiem nowej linii, na zadany strumień
+ * w formacie opisanym w dokumentacji funkcji ParsePoly().
  * @param[in] p : wielomian
- * @return tekst będący wynikiem konwersji
+ * @param[in] stream : strumień wyjściowy
  */
-char* PolyToStr(const Poly *p) {
-    return PolyToStrPair(p).string;
+void PrintPoly(const Poly *p, FILE *stream) {
+    output.stream = stream;
+    PutPoly(p);
+    PutChar('\n');
+    FlushOutput();
 }
 
 /**
@@ -392,7 +536,7 @@ char* PolyToStr(const Poly *p) {
  * @return jeśli na stosie jest co najmniej @p n wielomianów - polecenie
  * z zadaną opcją @p option; w przeciwnym wypadku - polecenie z opcją <error>
  */
-static Command CheckUnderflow(Stack stack, size_t n, Option option,
+static Command CheckUnderflow(const Stack *stack, size_t n, Option option,
                               size_t verse_num) {
     if (hasnElements(stack, n)) {
         return (Command) {.opt = option};
@@ -411,21 +555,20 @@ static Command CheckUnderflow(Stack stack, size_t n, Option option,
  * Możliwe błędy to nieprawidłowy argument i zbyt mało wielomianów na stosie.
  * @param[in] stack : stos wielomianów
  * @param[in] input : tekst polecenia
+ * @param[in] len : długość tekstu polecenia
  * @param[in] verse_num : numer wiersza standardowego wejścia, w którym zostało
  * podane polecenie
  * @return jeśli wystąpiły błędy - polecenie z opcją <error>; w przeciwnym
  * wypadku - polecenie z opcją <DEG_BY> i argumentem podanym w @p input
  */
-static Command CheckDegErr(Stack stack, const char *input, size_t verse_num) {
+static Command CheckDegErr(const Stack *stack, const char *input, size_t len,
+                           size_t verse_num) {
     size_t deg_len = 7;
     const char *arg = input + deg_len;
-    if (correctDegArg(arg)) {
+    unsigned long deg_arg;
+    if (correctDegArg(arg, input + len, &deg_arg)) {
         Command res = CheckUnderflow(stack, 1, DEG_BY, verse_num);
-        if (res.opt != error) {
-            char *endptr;
-            unsigned long deg_arg = strtoul(arg, &endptr, 10);
-            res.deg_arg = deg_arg;
-        }
+        if (res.opt != error) res.deg_arg = deg_arg;
         return res;
     }
     else {
@@ -442,21 +585,20 @@ static Command CheckDegErr(Stack stack, const char *input, size_t verse_num) {
  * Możliwe błędy to nieprawidłowy argument i zbyt mało wielomianów na stosie.
  * @param[in] stack : stos wielomianów
  * @param[in] input : tekst polecenia
+ * @param[in] len : długość tekstu polecenia
  * @param[in] verse_num : numer wiersza standardowego wejścia, w którym zostało
  * podane polecenie
  * @return jeśli wystąpiły błędy - polecenie z opcją <error>; w przeciwnym
  * wypadku - polecenie z opcją <AT> i argumentem podanym w @p input
  */
-static Command CheckAtErr(Stack stack, const char *input, size_t verse_num) {
+static Command CheckAtErr(const Stack *stack, const char *input, size_t len,
+                          size_t verse_num) {
     size_t at_len = 3;
     char const *arg = input + at_len;
-    if (correctAtArg(arg)) {
+    long at_arg;
+    if (correctAtArg(arg, input + len, &at_arg)) {
         Command res = CheckUnderflow(stack, 1, AT, verse_num);
-        if (res.opt != error) {
-            char *endptr;
-            long at_arg = strtol(arg, &endptr, 10);
-            res.at_arg = at_arg;
-        }
+        if (res.opt != error) res.at_arg = at_arg;
         return res;
     }
     else {
@@ -465,6 +607,108 @@ static Command CheckAtErr(Stack stack, const char *input, size_t verse_num) {
     }
 }
 
+/**
+ * Wczytuje argumenty polecenia z opcją <AT_MULTI>: jedną lub więcej liczb
+ * w formacie argumentu polecenia z opcją <AT>, oddzielonych pojedynczymi
+ * spacjami.
+ * @param[in] input : tekst argumentów
+ * @param[in] end : koniec tekstu argumentów
+ * @param[out] res : wczytane argumenty; tablica punktów jest przydzielana
+ * tylko wtedy, gdy argumenty są poprawne
+ * @return Czy argumenty są poprawne?
+ */
+static bool ParseAtMultiArgs(const char *input, const char *end,
+                             AtMultiArg *res) {
+    size_t capacity = INITIAL_SIZE;
+    res->count = 0;
+    res->points = malloc(capacity * sizeof(poly_coeff_t));
+    if (res->points == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    PolyParser parser = {.cursor = input, .end = end};
+    while (true) {
+        long point;
+        if (!ParseNumber(&parser, &point)) break;
+        if (Peek(&parser) != ' ' && Peek(&parser) != EOF) break;
+        if (res->count == capacity) {
+            capacity *= 2;
+            res->points = realloc(res->points, capacity * sizeof(poly_coeff_t));
+            if (res->points == NULL) exit(1); // Błąd podczas alokacji pamięci.
+        }
+        res->points[res->count++] = point;
+        if (Peek(&parser) == EOF) return true;
+        parser.cursor++;
+    }
+    free(res->points);
+    return false;
+}
+
+/**
+ * Sprawdza czy wystąpiły błędy przy identyfikacji polecenia "AT_MULTI".
+ * Jeśli wystąpiły błędy, wypisuje na standardowe wyjście diagnostyczne
+ * komunikat o błędzie i zwraca polecenie z opcją <error>. Jeśli nie wystąpiły
+ * błędy, zwraca polecenie z opcją <AT_MULTI> i argumentami podanymi
+ * w @p input. Możliwe błędy to nieprawidłowe argumenty i zbyt mało
+ * wielomianów na stosie.
+ * @param[in] stack : stos wielomianów
+ * @param[in] input : tekst polecenia
+ * @param[in] len : długość tekstu polecenia
+ * @param[in] verse_num : numer wiersza standardowego wejścia, w którym zostało
+ * podane polecenie
+ * @return jeśli wystąpiły błędy - polecenie z opcją <error>; w przeciwnym
+ * wypadku - polecenie z opcją <AT_MULTI> i argumentami podanymi w @p input
+ */
+static Command CheckAtMultiErr(const Stack *stack, const char *input,
+                               size_t len, size_t verse_num) {
+    size_t at_multi_len = 9;
+    AtMultiArg arg;
+    if (ParseAtMultiArgs(input + at_multi_len, input + len, &arg)) {
+        Command res = CheckUnderflow(stack, 1, AT_MULTI, verse_num);
+        if (res.opt != error) res.at_multi_arg = arg;
+        else free(arg.points);
+        return res;
+    }
+    else {
+        fprintf(stderr, "ERROR %zu AT_MULTI WRONG VALUE\n", verse_num);
+        return (Command) {.opt = error};
+    }
+}
+
+/**
+ * Sprawdza czy wystąpiły błędy przy identyfikacji polecenia "EVAL_BATCH".
+ * Jeśli wystąpiły błędy, wypisuje na standardowe wyjście diagnostyczne
+ * komunikat o błędzie i zwraca polecenie z opcją <error>. Jeśli nie wystąpiły
+ * błędy, zwraca polecenie z opcją <EVAL_BATCH> i argumentem podanym
+ * w @p input. Możliwe błędy to brak ścieżki pliku i zbyt mało wielomianów na
+ * stosie. Dla argumentu "-" brak wielomianu na stosie zgłaszany jest dopiero
+ * przy wykonaniu polecenia, żeby wiersze z punktami nie zostały potraktowane
+ * jako polecenia.
+ * @param[in] stack : stos wielomianów
+ * @param[in] input : tekst polecenia
+ * @param[in] len : długość tekstu polecenia
+ * @param[in] verse_num : numer wiersza standardowego wejścia, w którym zostało
+ * podane polecenie
+ * @return jeśli wystąpiły błędy - polecenie z opcją <error>; w przeciwnym
+ * wypadku - polecenie z opcją <EVAL_BATCH> i argumentem podanym w @p input
+ */
+static Command CheckEvalBatchErr(const Stack *stack, const char *input,
+                                 size_t len, size_t verse_num) {
+    size_t eval_batch_len = 11;
+    char const *arg = input + eval_batch_len;
+    size_t arg_len = len - eval_batch_len;
+    if (arg_len == 0) {
+        fprintf(stderr, "ERROR %zu EVAL_BATCH WRONG FILE\n", verse_num);
+        return (Command) {.opt = error};
+    }
+    if (isWord(arg, arg_len, "-")) {
+        return (Command) {.opt = EVAL_BATCH, .eval_batch_arg = {.path = NULL}};
+    }
+    Command res = CheckUnderflow(stack, 1, EVAL_BATCH, verse_num);
+    if (res.opt != error) {
+        res.eval_batch_arg.path = strndup(arg, arg_len);
+        if (res.eval_batch_arg.path == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    }
+    return res;
+}
+
 /**
  * Sprawdza czy wystąpiły błędy przy identyfikacji polecenia "COMPOSE". Jeśli
  * wystąpiły błędy, wypisuje na standardowe wyjście diagnostyczne komunikat
@@ -473,18 +717,21 @@ static Command CheckAtErr(Stack stack, const char *input, size_t verse_num) {
  * Możliwe błędy to nieprawidłowy argument i zbyt mało wielomianów na stosie.
  * @param[in] stack : stos wielomianów
  * @param[in] input : tekst polecenia
+ * @param[in] len : długość tekstu polecenia
  * @param[in] verse_num : numer wiersza standardowego wejścia, w którym zostało
  * podane polecenie
  * @return jeśli wystąpiły błędy - polecenie z opcją <error>; w przeciwnym
  * wypadku - polecenie z opcją <COMPOSE> i argumentem podanym w @p input
  */
-static Command CheckComposeErr(Stack stack, const char *input, size_t verse_num) {
+static Command CheckComposeErr(const Stack *stack, const char *input,
+                               size_t len, size_t verse_num) {
     size_t compose_len = 8;
     char const *arg = input + compose_len;
-    if (correctComposeArg(arg)) {
-        char *endptr;
-        size_t k = strtoul(arg, &endptr, 10);
-        Command res = CheckUnderflow(stack, k, COMPOSE, verse_num);
+    unsigned long k;
+    if (correctComposeArg(arg, input + len, &k)) {
+        // Złożenie zdejmuje ze stosu wielomian i [k] wielomianów pod nim.
+        size_t needed = k < SIZE_MAX ? k + 1 : k;
+        Command res = CheckUnderflow(stack, needed, COMPOSE, verse_num);
         if (res.opt != error) res.compose_arg = k;
         return res;
     }
@@ -494,16 +741,172 @@ static Command CheckComposeErr(Stack stack, const char *input, size_t verse_num)
     }
 }
 
+/**
+ * Sprawdza czy wystąpiły błędy przy identyfikacji polecenia "ROT" lub "PICK".
+ * Jeśli wystąpiły błędy, wypisuje na standardowe wyjście diagnostyczne
+ * komunikat o błędzie i zwraca polecenie z opcją <error>. Jeśli nie wystąpiły
+ * błędy, zwraca polecenie z opcją @p option i argumentem @f$n@f$ podanym
+ * w @p input. Możliwe błędy to nieprawidłowy argument (dla <ROT> także
+ * @f$n = 0@f$) i zbyt mało wielomianów na stosie: <ROT> wymaga @f$n@f$
+ * wielomianów, a <PICK> - @f$n + 1@f$.
+ * @param[in] stack : stos wielomianów
+ * @param[in] input : tekst polecenia
+ * @param[in] len : długość tekstu polecenia
+ * @param[in] option : <ROT> lub <PICK>
+ * @param[in] verse_num : numer wiersza standardowego wejścia, w którym zostało
+ * podane polecenie
+ * @return jeśli wystąpiły błędy - polecenie z opcją <error>; w przeciwnym
+ * wypadku - polecenie z opcją @p option i argumentem podanym w @p input
+ */
+static Command CheckStackArgErr(const Stack *stack, const char *input,
+                                size_t len, Option option, size_t verse_num) {
+    const char *name = option == ROT ? "ROT" : "PICK";
+    char const *arg = input + strlen(name) + 1;
+    unsigned long n;
+    if (correctStackArg(arg, input + len, &n)) {
+        // Wielomiany liczone są od 1, więc nie można przenieść zerowego.
+        if (option == PICK || n > 0) {
+            size_t needed = option == ROT || n == SIZE_MAX ? n : n + 1;
+            Command res = CheckUnderflow(stack, needed, option, verse_num);
+            if (res.opt != error) res.stack_arg = n;
+            return res;
+        }
+    }
+    fprintf(stderr, "ERROR %zu %s WRONG PARAMETER\n", verse_num, name);
+    return (Command) {.opt = error};
+}
+
+/**
+ * Sprawdza czy wystąpiły błędy przy identyfikacji polecenia "SAVE" lub
+ * "LOAD". Jeśli wystąpiły błędy, wypisuje na standardowe wyjście
+ * diagnostyczne komunikat o błędzie i zwraca polecenie z opcją <error>. Jeśli
+ * nie wystąpiły błędy, zwraca polecenie z opcją @p option i ścieżką pliku
+ * podaną w @p input. Możliwe błędy to brak ścieżki pliku (także ścieżka
+ * złożona z samych białych znaków) i, dla <SAVE>, zbyt mało wielomianów na
+ * stosie.
+ * @param[in] stack : stos wielomianów
+ * @param[in] input : tekst polecenia
+ * @param[in] len : długość tekstu polecenia
+ * @param[in] option : <SAVE> lub <LOAD>
+ * @param[in] verse_num : numer wiersza standardowego wejścia, w którym zostało
+ * podane polecenie
+ * @return jeśli wystąpiły błędy - polecenie z opcją <error>; w przeciwnym
+ * wypadku - polecenie z opcją @p option i argumentem podanym w @p input
+ */
+static Command CheckFileErr(const Stack *stack, const char *input, size_t len,
+                            Option option, size_t verse_num) {
+    const char *name = option == SAVE ? "SAVE" : "LOAD";
+    char const *arg = input + strlen(name) + 1;
+    const char *c = arg, *end = input + len;
+    while (c < end && isspace((unsigned char) *c)) c++;
+    // Ścieżka nie może być pusta ani składać się z samych białych znaków.
+    if (c == end) {
+        fprintf(stderr, "ERROR %zu %s WRONG FILE\n", verse_num, name);
+        return (Command) {.opt = error};
+    }
+    Command res = CheckUnderflow(stack, option == SAVE ? 1 : 0, option,
+                                 verse_num);
+    if (res.opt != error) {
+        res.file_arg.path = strndup(arg, (size_t) (end - arg));
+        if (res.file_arg.path == NULL) exit(1); // Błąd podczas alokacji pamięci.
+        res.file_arg.verse_num = verse_num;
+    }
+    return res;
+}
+
+/**
+ * Sprawdza czy wystąpiły błędy przy identyfikacji polecenia "POW". Jeśli
+ * wystąpiły błędy, wypisuje na standardowe wyjście diagnostyczne komunikat
+ * o błędzie i zwraca polecenie z opcją <error>. Jeśli nie wystąpiły błędy,
+ * zwraca polecenie z opcją <POW> i argumentem podanym w @p input. Możliwe
+ * błędy to nieprawidłowy argument (wykładnik musi mieścić się w typie
+ * poly_exp_t) i pusty stos.
+ * @param[in] stack : stos wielomianów
+ * @param[in] input : tekst polecenia
+ * @param[in] len : długość tekstu polecenia
+ * @param[in] verse_num : numer wiersza standardowego wejścia, w którym zostało
+ * podane polecenie
+ * @return jeśli wystąpiły błędy - polecenie z opcją <error>; w przeciwnym
+ * wypadku - polecenie z opcją <POW> i argumentem podanym w @p input
+ */
+static Command CheckPowErr(const Stack *stack, const char *input, size_t len,
+                           size_t verse_num) {
+    size_t pow_len = 4;
+    char const *arg = input + pow_len;
+    unsigned long exp;
+    if (correctPowArg(arg, input + len, &exp)) {
+        if (exp <= INT_MAX) {
+            Command res = CheckUnderflow(stack, 1, POW, verse_num);
+            if (res.opt != error) {
+                res.pow_arg = (PowArg) {.exp = (poly_exp_t) exp,
+                                        .verse_num = verse_num};
+            }
+            return res;
+        }
+    }
+    fprintf(stderr, "ERROR %zu POW WRONG PARAMETER\n", verse_num);
+    return (Command) {.opt = error};
+}
+
+/**
+ * Sprawdza czy wystąpiły błędy przy identyfikacji polecenia "DIV" lub "GCD".
+ * Jeśli na stosie jest zbyt mało wielomianów, wypisuje na standardowe wyjście
+ * diagnostyczne komunikat o błędzie i zwraca polecenie z opcją <error>.
+ * W przeciwnym wypadku zwraca polecenie z opcją @p option, zapamiętując numer
+ * wiersza do komunikatów o błędach przy jego wykonaniu.
+ * @param[in] stack : stos wielomianów
+ * @param[in] option : <DIV> lub <GCD>
+ * @param[in] verse_num : numer wiersza standardowego wejścia, w którym zostało
+ * podane polecenie
+ * @return jeśli wystąpiły błędy - polecenie z opcją <error>; w przeciwnym
+ * wypadku - polecenie z opcją @p option
+ */
+static Command CheckVerseErr(const Stack *stack, Option option,
+                             size_t verse_num) {
+    Command res = CheckUnderflow(stack, 2, option, verse_num);
+    if (res.opt != error) res.verse_arg = verse_num;
+    return res;
+}
+
+/**
+ * Sprawdza czy wystąpiły błędy przy identyfikacji polecenia "MOD". Jeśli
+ * wystąpiły błędy, wypisuje na standardowe wyjście diagnostyczne komunikat
+ * o błędzie i zwraca polecenie z opcją <error>. Jeśli nie wystąpiły błędy,
+ * zwraca polecenie z opcją <MOD> i argumentem podanym w @p input. Jedynym
+ * możliwym błędem jest nieprawidłowy argument: poprawny moduł to 0 lub liczba
+ * z przedziału @f$[2, MOD\_MAX]@f$.
+ * @param[in] input : tekst polecenia
+ * @param[in] len : długość tekstu polecenia
+ * @param[in] verse_num : numer wiersza standardowego wejścia, w którym zostało
+ * podane polecenie
+ * @return jeśli wystąpiły błędy - polecenie z opcją <error>; w przeciwnym
+ * wypadku - polecenie z opcją <MOD> i argumentem podanym w @p input
+ */
+static Command CheckModErr(const char *input, size_t len, size_t verse_num) {
+    size_t mod_len = 4;
+    char const *arg = input + mod_len;
+    unsigned long mod;
+    if (correctModArg(arg, input + len, &mod)) {
+        if (mod == 0 || (mod >= 2 && mod <= MOD_MAX)) {
+            return (Command) {.opt = MOD, .mod_arg = (poly_coeff_t) mod};
+        }
+    }
+    fprintf(stderr, "ERROR %zu MOD WRONG VALUE\n", verse_num);
+    return (Command) {.opt = error};
+}
+
 /**
  * Sprawdza, czy tekst polecenia reprezentuje jedno ze słownych poleceń
- * z argumentem: "DEG_BY", "AT" lub "COMPOSE" oraz czy nie wystąpił błąd przy
- * ich przetwarzaniu. Jeśli tekst polecenia nie reprezentuje jednego ze słownych
- * poleceń z argumentem lub wystąpił błąd przy przetwarzaniu tych poleceń,
- * wypisuje komunikat o błędzie na standardowe wyjście diagnostyczne i zwraca
- * polecenie z opcją <error>. W przeciwnym wypadku zwraca polecenie z opcją mu
- * odpowiadającą i argumentem podanym w @p input.
+ * z argumentem: "DEG_BY", "AT", "AT_MULTI", "EVAL_BATCH", "COMPOSE", "MOD",
+ * "ROT", "PICK", "SAVE", "LOAD" lub "POW" oraz czy nie wystąpił błąd przy
+ * ich przetwarzaniu. Jeśli tekst polecenia nie reprezentuje jednego ze
+ * słownych poleceń z argumentem lub wystąpił błąd przy przetwarzaniu tych
+ * poleceń, wypisuje komunikat o błędzie na standardowe wyjście diagnostyczne
+ * i zwraca polecenie z opcją <error>. W przeciwnym wypadku zwraca polecenie
+ * z opcją mu odpowiadającą i argumentem podanym w @p input.
  * @param[in] stack : stos wielomianów
  * @param[in] input : tekst polecenia
+ * @param[in] len : długość tekstu polecenia
  * @param[in] verse_num : numer wiersza standardowego wejścia, w którym został
  * podany słowny zapis polecenia (@p input)
  * @return jeśli tekst polecenia nie reprezentuje jednego ze słownych
@@ -511,28 +914,77 @@ static Command CheckComposeErr(Stack stack, const char *input, size_t verse_num)
  * polecenie z opcją <error>; w przeciwnym wypadku polecenie z odpowiednią opcją
  * i argumentem podanym w @p input.
  */
-static Command IdentifyArgCommand(Stack stack, const char *input, size_t verse_num) {
-    if (startsWith(input, "DEG_BY ")) {
-        return CheckDegErr(stack, input, verse_num);
+static Command IdentifyArgCommand(const Stack *stack, const char *input,
+                                  size_t len, size_t verse_num) {
+    if (startsWith(input, len, "DEG_BY ")) {
+        return CheckDegErr(stack, input, len, verse_num);
+    }
+    else if (startsWith(input, len, "AT ")) {
+        return CheckAtErr(stack, input, len, verse_num);
     }
-    else if (startsWith(input, "AT ")) {
-        return CheckAtErr(stack, input, verse_num);
+    else if (startsWith(input, len, "AT_MULTI ")) {
+        return CheckAtMultiErr(stack, input, len, verse_num);
     }
-    else if (startsWith(input, "COMPOSE ")) {
-        return CheckComposeErr(stack, input, verse_num);
+    else if (startsWith(input, len, "EVAL_BATCH ")) {
+        return CheckEvalBatchErr(stack, input, len, verse_num);
+    }
+    else if (startsWith(input, len, "COMPOSE ")) {
+        return CheckComposeErr(stack, input, len, verse_num);
+    }
+    else if (startsWith(input, len, "MOD ")) {
+        return CheckModErr(input, len, verse_num);
+    }
+    else if (startsWith(input, len, "ROT ")) {
+        return CheckStackArgErr(stack, input, len, ROT, verse_num);
+    }
+    else if (startsWith(input, len, "PICK ")) {
+        return CheckStackArgErr(stack, input, len, PICK, verse_num);
+    }
+    else if (startsWith(input, len, "SAVE ")) {
+        return CheckFileErr(stack, input, len, SAVE, verse_num);
+    }
+    else if (startsWith(input, len, "LOAD ")) {
+        return CheckFileErr(stack, input, len, LOAD, verse_num);
+    }
+    else if (startsWith(input, len, "POW ")) {
+        return CheckPowErr(stack, input, len, verse_num);
     }
     else {
-        if (startsWith(input, "DEG_BY")) {
+        if (startsWith(input, len, "DEG_BY")) {
             fprintf(stderr, "ERROR %zu DEG BY WRONG VARIABLE\n",
                     verse_num);
         }
-        else if (startsWith(input, "AT")) {
+        else if (startsWith(input, len, "AT_MULTI")) {
+            fprintf(stderr, "ERROR %zu AT_MULTI WRONG VALUE\n", verse_num);
+        }
+        else if (startsWith(input, len, "AT")) {
             fprintf(stderr, "ERROR %zu AT WRONG VALUE\n", verse_num);
         }
-        else if (startsWith(input, "COMPOSE")) {
+        else if (startsWith(input, len, "EVAL_BATCH")) {
+            fprintf(stderr, "ERROR %zu EVAL_BATCH WRONG FILE\n", verse_num);
+        }
+        else if (startsWith(input, len, "COMPOSE")) {
             fprintf(stderr, "ERROR %zu COMPOSE WRONG PARAMETER\n",
                     verse_num);
         }
+        else if (startsWith(input, len, "MOD")) {
+            fprintf(stderr, "ERROR %zu MOD WRONG VALUE\n", verse_num);
+        }
+        else if (startsWith(input, len, "ROT")) {
+            fprintf(stderr, "ERROR %zu ROT WRONG PARAMETER\n", verse_num);
+        }
+        else if (startsWith(input, len, "PICK")) {
+            fprintf(stderr, "ERROR %zu PICK WRONG PARAMETER\n", verse_num);
+        }
+        else if (startsWith(input, len, "SAVE")) {
+            fprintf(stderr, "ERROR %zu SAVE WRONG FILE\n", verse_num);
+        }
+        else if (startsWith(input, len, "LOAD")) {
+            fprintf(stderr, "ERROR %zu LOAD WRONG FILE\n", verse_num);
+        }
+        else if (startsWith(input, len, "POW")) {
+            fprintf(stderr, "ERROR %zu POW WRONG PARAMETER\n", verse_num);
+        }
         else {
             fprintf(stderr, "ERROR %zu WRONG COMMAND\n", verse_num);
         }
@@ -549,31 +1001,37 @@ static Command IdentifyArgCommand(Stack stack, const char *input, size_t verse_n
  * polecenie z opcją <error>.
  * @param[in] stack : stos wielomianów
  * @param[in] input : tekst polecenia
+ * @param[in] len : długość tekstu polecenia
  * @param[in] verse_num : numer wiersza standardowego wejścia, w którym został
  * podany słowny zapis polecenia (@p input)
  * @return polecenie reprezentowane przez @p input lub polecenie z opcją
  * <error> w przypadku błędu
  */
-Command IdentifyCommand(Stack stack, const char *input, size_t verse_num) {
-    assert(input && input[0] != '#' && input[strlen(input) - 1] != '\n');
-    if (isalpha(input[0])) { // Przetwarzanie słownego polecenia.
-        if (strcmp(input, "ZERO") == 0) return (Command) {.opt = ZERO};
-        else if (strcmp(input, "IS_COEFF") == 0) return CheckUnderflow(stack, 1, IS_COEFF, verse_num);
-        else if (strcmp(input, "IS_ZERO") == 0) return CheckUnderflow(stack, 1, IS_ZERO, verse_num);
-        else if (strcmp(input, "CLONE") == 0) return CheckUnderflow(stack, 1, CLONE, verse_num);
-        else if (strcmp(input, "ADD") == 0) return CheckUnderflow(stack, 2, ADD, verse_num);
-        else if (strcmp(input, "MUL") == 0) return CheckUnderflow(stack, 2, MUL, verse_num);
-        else if (strcmp(input, "NEG") == 0) return CheckUnderflow(stack, 1, NEG, verse_num);
-        else if (strcmp(input, "SUB") == 0) return CheckUnderflow(stack, 2, SUB, verse_num);
-        else if (strcmp(input, "IS_EQ") == 0) return CheckUnderflow(stack, 2, IS_EQ, verse_num);
-        else if (strcmp(input, "DEG") == 0) return CheckUnderflow(stack, 1, DEG, verse_num);
-        else if (strcmp(input, "PRINT") == 0) return CheckUnderflow(stack, 1, PRINT, verse_num);
-        else if (strcmp(input, "POP") == 0) return CheckUnderflow(stack, 1, POP, verse_num);
-        else return IdentifyArgCommand(stack, input, verse_num);
+Command IdentifyCommand(const Stack *stack, const char *input, size_t len,
+                        size_t verse_num) {
+    assert(input && len > 0 && input[0] != '#' && input[len - 1] != '\n');
+    if (isalpha((unsigned char) input[0])) { // Przetwarzanie słownego polecenia.
+        if (isWord(input, len, "ZERO")) return (Command) {.opt = ZERO};
+        else if (isWord(input, len, "IS_COEFF")) return CheckUnderflow(stack, 1, IS_COEFF, verse_num);
+        else if (isWord(input, len, "IS_ZERO")) return CheckUnderflow(stack, 1, IS_ZERO, verse_num);
+        else if (isWord(input, len, "CLONE")) return CheckUnderflow(stack, 1, CLONE, verse_num);
+        else if (isWord(input, len, "ADD")) return CheckUnderflow(stack, 2, ADD, verse_num);
+        else if (isWord(input, len, "MUL")) return CheckUnderflow(stack, 2, MUL, verse_num);
+        else if (isWord(input, len, "NEG")) return CheckUnderflow(stack, 1, NEG, verse_num);
+        else if (isWord(input, len, "SUB")) return CheckUnderflow(stack, 2, SUB, verse_num);
+        else if (isWord(input, len, "IS_EQ")) return CheckUnderflow(stack, 2, IS_EQ, verse_num);
+        else if (isWord(input, len, "DEG")) return CheckUnderflow(stack, 1, DEG, verse_num);
+        else if (isWord(input, len, "PRINT")) return CheckUnderflow(stack, 1, PRINT, verse_num);
+        else if (isWord(input, len, "POP")) return CheckUnderflow(stack, 1, POP, verse_num);
+        else if (isWord(input, len, "SWAP")) return CheckUnderflow(stack, 2, SWAP, verse_num);
+        else if (isWord(input, len, "DIV")) return CheckVerseErr(stack, DIV, verse_num);
+        else if (isWord(input, len, "GCD")) return CheckVerseErr(stack, GCD, verse_num);
+        else if (isWord(input, len, "STATS")) return (Command) {.opt = STATS};
+        else return IdentifyArgCommand(stack, input, len, verse_num);
     }
     else {
-        if (correctPoly(input)) { // Polecenie dodania wielomianu.
-            Poly p = StrToPoly(input);
+        Poly p;
+        if (ReadPolyText(input, len, &p)) { // Polecenie dodania wielomianu.
             return (Command) {.opt = add_poly, .p = p};
         }
         else {
@@ -589,7 +1047,7 @@ Command IdentifyCommand(Stack stack, const char *input, size_t verse_num) {
  * @param[in] command : polecenie
  */
 void Compose(Stack *stack, Command command) {
-    Poly p, q[command.compose_arg];
+    Poly p, *q = ScratchAlloc(command.compose_arg * sizeof(Poly));
     p = pop(stack);
     for (size_t i = command.compose_arg; i-- > 0;) {
         q[i] = pop(stack);
@@ -602,100 +1060,616 @@ void Compose(Stack *stack, Command command) {
     }
 }
 
+/**
+ * Wylicza wartości wielomianu z wierzchołka stosu w punktach podanych
+ * w poleceniu, usuwa go ze stosu i wstawia na stos kolejne wyniki.
+ * @param[in,out] stack : stos wielomianów
+ * @param[in] command : polecenie z opcją <AT_MULTI>
+ */
+void AtMulti(Stack *stack, Command command) {
+    AtMultiArg arg = command.at_multi_arg;
+    Poly p = pop(stack);
+    Poly *values = ScratchAlloc(arg.count * sizeof(Poly));
+    PolyAtMulti(&p, arg.count, arg.points, values);
+    for (size_t i = 0; i < arg.count; i++) {
+        push(stack, values[i]);
+    }
+    PolyDestroy(&p);
+    free(arg.points);
+}
+
+/**
+ * Wczytuje współrzędne punktu polecenia "EVAL_BATCH": jedną lub więcej liczb
+ * w formacie argumentu polecenia z opcją <AT>, oddzielonych pojedynczymi
+ * spacjami. Brakujące współrzędne są równe 0, a współrzędne o indeksach nie
+ * mniejszych od @p nvars są sprawdzane i pomijane.
+ * @param[in] input : wiersz z punktem
+ * @param[in] len : długość wiersza
+ * @param[in] nvars : liczba zapisywanych współrzędnych
+ * @param[out] point : współrzędne punktu
+ * @return Czy punkt jest poprawny?
+ */
+static bool ParsePoint(const char *input, size_t len, size_t nvars,
+                       poly_coeff_t point[]) {
+    for (size_t i = 0; i < nvars; i++) point[i] = 0;
+    PolyParser parser = {.cursor = input, .end = input + len};
+    for (size_t i = 0; true; i++) {
+        long x;
+        if (!ParseNumber(&parser, &x)) return false;
+        if (Peek(&parser) != ' ' && Peek(&parser) != EOF) return false;
+        if (i < nvars) point[i] = x;
+        if (Peek(&parser) == EOF) return true;
+        parser.cursor++;
+    }
+}
+
+/**
+ * Wylicza wartości w @p count punktach, wypisuje je na standardowe wyjście
+ * i usuwa z pamięci.
+ * @param[in] plan : skompilowany wielomian
+ * @param[in] count : liczba punktów
+ * @param[in] points : współrzędne punktów
+ * @param[in] values : tablica na wartości
+ */
+static void EvalBatchChunk(const EvalPlan *plan, size_t count,
+                           const poly_coeff_t points[], Poly values[]) {
+    PolyEvalBatch(plan, count, points, values);
+    output.stream = stdout;
+    for (size_t i = 0; i < count; i++) {
+        PutPoly(&values[i]);
+        PutChar('\n');
+        PolyDestroy(&values[i]);
+    }
+    FlushOutput();
+}
+
+/**
+ * Wykonuje polecenie "EVAL_BATCH": wylicza wartości wielomianu z wierzchołka
+ * stosu w punktach wczytanych z pliku lub z kolejnych wierszy źródła poleceń
+ * (aż do wiersza "END") i wypisuje je na standardowe wyjście. Punkty przetwarzane
+ * są porcjami, więc ich liczba nie jest ograniczona pamięcią. Puste wiersze
+ * i wiersze zaczynające się od '#' są pomijane; dla niepoprawnego punktu
+ * wypisywany jest komunikat o błędzie i punkt jest pomijany.
+ * @param[in,out] stack : stos wielomianów
+ * @param[in] command : polecenie z opcją <EVAL_BATCH>
+ */
+void EvalBatch(Stack *stack, Command command) {
+    EvalBatchArg arg = command.eval_batch_arg;
+    size_t command_verse = arg.input->verse_num;
+    LineReader file, *in = arg.input;
+    if (arg.path != NULL) {
+        bool opened = LineReaderOpen(&file, arg.path);
+        free(arg.path);
+        if (!opened) {
+            fprintf(stderr, "ERROR %zu EVAL_BATCH WRONG FILE\n", command_verse);
+            return;
+        }
+        in = &file;
+    }
+    // Dla punktów ze standardowego wejścia brak wielomianu sprawdzany jest
+    // dopiero tutaj, żeby pominąć wiersze z punktami.
+    bool underflow = !hasnElements(stack, 1);
+    if (underflow) {
+        fprintf(stderr, "ERROR %zu STACK UNDERFLOW\n", command_verse);
+    }
+    EvalPlan *plan = NULL;
+    size_t nvars = 0, count = 0;
+    poly_coeff_t *points = NULL;
+    Poly *values = NULL;
+    if (!underflow) {
+        Poly top = nthElement(stack, 0);
+        nvars = PolyEvalVars(&top);
+        plan = PolyEvalCompile(&top, nvars);
+        points = malloc(EVAL_BATCH_CHUNK * (nvars > 0 ? nvars : 1)
+                        * sizeof(poly_coeff_t));
+        values = malloc(EVAL_BATCH_CHUNK * sizeof(Poly));
+        if (points == NULL || values == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    }
+
+    const char *line;
+    size_t line_len;
+    while (LineReaderNext(in, &line, &line_len)) {
+        size_t verse_num = in == arg.input ? in->verse_num : command_verse;
+        if (in == arg.input && isWord(line, line_len, "END")) break;
+        if (underflow || line_len == 0 || line[0] == '#') continue;
+        if (!ParsePoint(line, line_len, nvars, points + count * nvars)) {
+            fprintf(stderr, "ERROR %zu EVAL_BATCH WRONG POINT\n", verse_num);
+            continue;
+        }
+        if (++count == EVAL_BATCH_CHUNK) {
+            EvalBatchChunk(plan, count, points, values);
+            count = 0;
+        }
+    }
+    if (in != arg.input) LineReaderClose(in);
+    if (!underflow) {
+        EvalBatchChunk(plan, count, points, values);
+        PolyEvalPlanDestroy(plan);
+        free(points);
+        free(values);
+    }
+}
+
+/**
+ * Ustawia moduł, modulo który liczone są współczynniki wielomianów, i redukuje
+ * modulo wszystkie wielomiany na stosie.
+ * @param[in,out] stack : stos wielomianów
+ * @param[in] command : polecenie z opcją <MOD>
+ */
+void SetModulus(Stack *stack, Command command) {
+    PolySetModulus(command.mod_arg);
+    for (size_t i = 0; i < stack->size; i++) {
+        Poly reduced = PolyReduce(&stack->polys[i]);
+        PolyDestroy(&stack->polys[i]);
+        stack->polys[i] = reduced;
+    }
+}
+
+/**
+ * Wykonuje polecenie "SAVE": zapisuje wielomian z wierzchołka stosu do pliku
+ * w postaci binarnej. Jeśli nie udało się zapisać pliku, wypisuje komunikat
+ * o błędzie.
+ * @param[in] stack : stos wielomianów
+ * @param[in] command : polecenie z opcją <SAVE>
+ */
+void Save(const Stack *stack, Command command) {
+    FileArg arg = command.file_arg;
+    if (!PolySave(nthElementPtr(stack, 0), arg.path)) {
+        fprintf(stderr, "ERROR %zu SAVE WRONG FILE\n", arg.verse_num);
+    }
+    free(arg.path);
+}
+
+/**
+ * Wykonuje polecenie "LOAD": wstawia na wierzchołek stosu wielomian z pliku
+ * zapisanego poleceniem "SAVE". Plik jest odwzorowywany w pamięci,
+ * a wielomian tworzony bezpośrednio z jego widoku (patrz: poly_view.h). Jeśli
+ * nie udało się otworzyć pliku lub nie zawiera on poprawnego zapisu,
+ * wypisuje komunikat o błędzie.
+ * @param[in,out] stack : stos wielomianów
+ * @param[in] command : polecenie z opcją <LOAD>
+ */
+void Load(Stack *stack, Command command) {
+    FileArg arg = command.file_arg;
+    PolyFile file;
+    if (PolyFileOpen(&file, arg.path)) {
+        push(stack, PolyViewToPoly(file.root));
+        PolyFileClose(&file);
+    }
+    else {
+        fprintf(stderr, "ERROR %zu LOAD WRONG FILE\n", arg.verse_num);
+    }
+    free(arg.path);
+}
+
+/**
+ * Wykonuje polecenie "POW": podnosi wielomian z wierzchołka stosu do potęgi
+ * (patrz: PolyPow()), usuwa go i wstawia na stos wynik. Jeśli wykładniki
+ * wyniku nie mieszczą się w typie poly_exp_t, wypisuje komunikat o błędzie
+ * i nie zmienia stosu.
+ * @param[in,out] stack : stos wielomianów
+ * @param[in] command : polecenie z opcją <POW>
+ */
+void Pow(Stack *stack, Command command) {
+    PowArg arg = command.pow_arg;
+    const Poly *top = nthElementPtr(stack, 0);
+    size_t nvars = PolyEvalVars(top);
+    for (size_t i = 0; i < nvars && arg.exp > 0; i++) {
+        if (PolyDegBy(top, i) > INT_MAX / arg.exp) {
+            fprintf(stderr, "ERROR %zu POW WRONG PARAMETER\n", arg.verse_num);
+            return;
+        }
+    }
+    Poly p = pop(stack);
+    push(stack, PolyPow(&p, arg.exp));
+    PolyDestroy(&p);
+}
+
+/**
+ * Wykonuje polecenie "DIV": dzieli wielomian z wierzchołka stosu przez
+ * wielomian pod wierzchołkiem (patrz: PolyDivExact()), usuwa je i wstawia na
+ * stos iloraz. Jeśli dzielnik jest zerem lub dzielenie nie jest wykonalne,
+ * wypisuje komunikat o błędzie i nie zmienia stosu.
+ * @param[in,out] stack : stos wielomianów
+ * @param[in] command : polecenie z opcją <DIV>
+ */
+void Div(Stack *stack, Command command) {
+    const Poly *p = nthElementPtr(stack, 0), *q = nthElementPtr(stack, 1);
+    Poly quot;
+    if (PolyIsZero(q) || !PolyDivExact(p, q, &quot)) {
+        fprintf(stderr, "ERROR %zu DIV WRONG DIVISOR\n", command.verse_arg);
+        return;
+    }
+    Poly top1 = pop(stack), top2 = pop(stack);
+    PolyDestroy(&top1);
+    PolyDestroy(&top2);
+    push(stack, quot);
+}
+
+/**
+ * Wykonuje polecenie "GCD": usuwa dwa wielomiany z wierzchu stosu i wstawia
+ * na stos ich największy wspólny dzielnik (patrz: PolyGcd()). Jeśli
+ * współczynniki liczone są modulo liczba złożona, wypisuje komunikat
+ * o błędzie i nie zmienia stosu.
+ * @param[in,out] stack : stos wielomianów
+ * @param[in] command : polecenie z opcją <GCD>
+ */
+void Gcd(Stack *stack, Command command) {
+    Poly gcd;
+    if (!PolyGcd(nthElementPtr(stack, 0), nthElementPtr(stack, 1), &gcd)) {
+        fprintf(stderr, "ERROR %zu GCD WRONG MODULUS\n", command.verse_arg);
+        return;
+    }
+    Poly top1 = pop(stack), top2 = pop(stack);
+    PolyDestroy(&top1);
+    PolyDestroy(&top2);
+    push(stack, gcd);
+}
+
+/** Czy polecenia <ADD>, <SUB> i <MUL> używają rozłożonej reprezentacji? */
+static bool flat_engine = false;
+
+/**
+ * Włącza lub wyłącza wykonywanie poleceń <ADD>, <SUB> i <MUL> w rozłożonej
+ * reprezentacji wielomianów ze spakowanymi wykładnikami (patrz: poly_flat.h).
+ * @param[in] enabled : czy używać rozłożonej reprezentacji
+ */
+void UseFlatEngine(bool enabled) {
+    flat_engine = enabled;
+}
+
+/** Czy polecenia <ADD>, <SUB>, <MUL> i <NEG> są wykonywane leniwie? */
+static bool lazy_evaluation = false;
+
+/**
+ * Włącza lub wyłącza leniwe wykonywanie poleceń <ADD>, <SUB>, <MUL> i <NEG>:
+ * na stos trafiają wyrażenia (patrz: poly_expr.h), obliczane dopiero przez
+ * polecenia odczytujące wartość wielomianu, np. <PRINT>.
+ * @param[in] enabled : czy wykonywać polecenia leniwie
+ */
+void UseLazyEvaluation(bool enabled) {
+    lazy_evaluation = enabled;
+}
+
+/**
+ * To jest tablica nieobliczonych wyrażeń elementów stosu w trybie leniwym,
+ * indeksowana tak jak tablica wielomianów stosu, od dna. Element
+ * z wyrażeniem przechowuje na stosie wielomian zerowy. Elementy spoza
+ * tablicy i elementy z wartością NULL są zwykłymi wielomianami. Elementy
+ * nad wierzchołkiem stosu mają zawsze wartość NULL, bo polecenia zwykłego
+ * trybu zdejmują ze stosu jedynie obliczone elementy.
+ */
+static PolyExpr **lazy_exprs = NULL;
+/** To jest pojemność tablicy nieobliczonych wyrażeń. */
+static size_t lazy_capacity = 0;
+
+/**
+ * Zwraca wyrażenie @p n -tego elementu stosu. Elementy indeksowane są od
+ * @f$0@f$, począwszy od wierzchołka.
+ * @param[in] stack : stos wielomianów
+ * @param[in] n : indeks elementu, mniejszy od liczby elementów stosu
+ * @return wyrażenie lub NULL, jeśli element jest wielomianem
+ */
+static PolyExpr* nthExpr(const Stack *stack, size_t n) {
+    assert(n < stack->size);
+    size_t i = stack->size - 1 - n;
+    return i < lazy_capacity ? lazy_exprs[i] : NULL;
+}
+
+/**
+ * Powiększa tablicę nieobliczonych wyrażeń tak, aby obejmowała co najmniej
+ * @p n elementów stosu. Nowe elementy tablicy mają wartość NULL.
+ * @param[in] n : liczba elementów
+ */
+static void reserveExprs(size_t n) {
+    if (n <= lazy_capacity) return;
+    size_t capacity = lazy_capacity == 0 ? INITIAL_SIZE : 2 * lazy_capacity;
+    if (capacity < n) capacity = n;
+    lazy_exprs = realloc(lazy_exprs, capacity * sizeof(PolyExpr*));
+    if (lazy_exprs == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    for (size_t i = lazy_capacity; i < capacity; i++) {
+        lazy_exprs[i] = NULL;
+    }
+    lazy_capacity = capacity;
+}
+
+/**
+ * Dodaje nieobliczone wyrażenie na wierzch stosu. Przejmuje referencję do
+ * wyrażenia.
+ * @param[in,out] stack : stos wielomianów
+ * @param[in] e : wyrażenie
+ */
+static void pushExpr(Stack *stack, PolyExpr *e) {
+    reserveExprs(stack->size + 1);
+    lazy_exprs[stack->size] = e;
+    push(stack, PolyZero());
+}
+
+/**
+ * Zwraca wierzchni element stosu jako wyrażenie i usuwa go ze stosu.
+ * Wielomian jest zamieniany na wyrażenie (patrz: ExprLeaf()).
+ * @param[in,out] stack : stos wielomianów
+ * @return wyrażenie wierzchniego elementu, z przekazaną referencją
+ */
+static PolyExpr* popExpr(Stack *stack) {
+    PolyExpr *e = nthExpr(stack, 0);
+    Poly p = pop(stack);
+    if (e == NULL) return ExprLeaf(p);
+    lazy_exprs[stack->size] = NULL;
+    return e;
+}
+
+/**
+ * Oblicza wyrażenia @p n elementów z wierzchu stosu i zastępuje je ich
+ * wartościami.
+ * @param[in,out] stack : stos wielomianów
+ * @param[in] n : liczba elementów, nie większa od liczby elementów stosu
+ */
+static void materialize(Stack *stack, size_t n) {
+    assert(hasnElements(stack, n));
+    for (size_t i = 0; i < n; i++) {
+        PolyExpr *e = nthExpr(stack, i);
+        if (e != NULL) {
+            *nthElementPtr(stack, i) = ExprEval(e);
+            ExprRelease(e);
+            lazy_exprs[stack->size - 1 - i] = NULL;
+        }
+    }
+}
+
+/**
+ * Przenosi wyrażenie @p n -tego elementu stosu na wierzchołek, tak jak
+ * rotate() przenosi wielomian.
+ * @param[in] stack : stos wielomianów
+ * @param[in] n : indeks elementu, mniejszy od liczby elementów stosu
+ */
+static void rotateExprs(const Stack *stack, size_t n) {
+    assert(n < stack->size);
+    size_t i = stack->size - 1 - n;
+    if (i >= lazy_capacity) return; // Żaden z przesuwanych elementów nie
+    // jest wyrażeniem.
+    reserveExprs(stack->size);
+    PolyExpr *e = lazy_exprs[i];
+    memmove(&lazy_exprs[i], &lazy_exprs[i + 1], n * sizeof(PolyExpr*));
+    lazy_exprs[stack->size - 1] = e;
+}
+
+/**
+ * Usuwa nieobliczone wyrażenia elementów stosu i zwalnia ich tablicę.
+ * Wielomiany stosu pozostają na nim.
+ */
+static void releaseExprs(void) {
+    for (size_t i = 0; i < lazy_capacity; i++) {
+        if (lazy_exprs[i] != NULL) ExprRelease(lazy_exprs[i]);
+    }
+    free(lazy_exprs);
+    lazy_exprs = NULL;
+    lazy_capacity = 0;
+}
+
+/**
+ * Wykonuje polecenie w trybie leniwym. Polecenia <ADD>, <SUB>, <MUL> i <NEG>
+ * tworzą wyrażenia, a <POP>, <CLONE>, <PICK>, <SWAP> i <ROT> operują na
+ * wyrażeniach bez ich obliczania. Przed innymi poleceniami oblicza wyrażenia
+ * elementów stosu, których wartości odczytuje polecenie.
+ * @param[in,out] stack : stos wielomianów
+ * @param[in] command : polecenie
+ * @return Czy polecenie zostało wykonane? Jeśli nie, należy je wykonać
+ * zwykłym trybem.
+ */
+static bool ExecuteLazy(Stack *stack, Command command) {
+    PolyExpr *left, *right, *e;
+    switch (command.opt) {
+        case ADD:
+        case SUB:
+        case MUL: ;
+            ExprKind kind = command.opt == ADD ? EXPR_ADD
+                            : command.opt == SUB ? EXPR_SUB : EXPR_MUL;
+            left = popExpr(stack);
+            right = popExpr(stack);
+            pushExpr(stack, ExprBinary(kind, left, right));
+            return true;
+        case NEG:
+            pushExpr(stack, ExprNeg(popExpr(stack)));
+            return true;
+        case POP:
+            if (nthExpr(stack, 0) == NULL) return false;
+            ExprRelease(popExpr(stack));
+            return true;
+        case CLONE:
+        case PICK:
+            e = nthExpr(stack, command.opt == CLONE ? 0 : command.stack_arg);
+            if (e == NULL) return false;
+            pushExpr(stack, ExprRetain(e));
+            return true;
+        case SWAP:
+            rotateExprs(stack, 1);
+            return false;
+        case ROT:
+            rotateExprs(stack, command.stack_arg - 1);
+            return false;
+        case IS_COEFF:
+        case IS_ZERO:
+        case DEG:
+        case DEG_BY:
+        case AT:
+        case AT_MULTI:
+        case PRINT:
+        case SAVE:
+        case POW:
+            materialize(stack, 1);
+            return false;
+        case EVAL_BATCH:
+            // Dla punktów ze standardowego wejścia stos może być pusty - brak
+            // wielomianu zgłasza dopiero EvalBatch().
+            if (hasnElements(stack, 1)) materialize(stack, 1);
+            return false;
+        case IS_EQ:
+        case DIV:
+        case GCD:
+            materialize(stack, 2);
+            return false;
+        case COMPOSE:
+            materialize(stack, command.compose_arg + 1);
+            return false;
+        case MOD:
+            materialize(stack, stack->size);
+            return false;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Wykonuje działanie na dwóch wielomianach w rozłożonej reprezentacji
+ * i usuwa je z pamięci.
+ * @param[in] op : działanie (PolyFlatAdd(), PolyFlatSub() lub PolyFlatMul())
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return wynik działania
+ */
+static Poly FlatOwn(Poly (*op)(const Poly *, const Poly *), Poly *p, Poly *q) {
+    Poly res = op(p, q);
+    PolyDestroy(p);
+    PolyDestroy(q);
+    return res;
+}
+
 /**
  * Wykonuje zadane polecenie wykonując operacje na stosie wielomianów i/lub
- * wypisując wynik operacji na standardowe wyjście.
+ * wypisując wynik operacji na standardowe wyjście. Po wykonaniu polecenia
+ * zwalnia pamięć tymczasową przydzieloną w jego trakcie i zapisuje czas jego
+ * wykonania (patrz: calc_stats.h).
  * @param[in,out] stack : stos wielomianów
  * @param[in] command : polecenie
  */
 void Execute(Stack *stack, Command command) {
     Poly top, top1, top2;
+    uint64_t start = StatsNow();
+    if (lazy_evaluation && ExecuteLazy(stack, command)) {
+        ScratchReset();
+        StatsRecord(command.opt, StatsNow() - start);
+        return;
+    }
     switch (command.opt) {
         case ZERO: ;
             Poly p = PolyZero();
             push(stack, p);
             break;
         case IS_COEFF: ;
-            top = nthElement(*stack, 0);
+            top = nthElement(stack, 0);
             printf("%d\n", PolyIsCoeff(&top));
             break;
         case IS_ZERO: ;
-            top = nthElement(*stack, 0);
+            top = nthElement(stack, 0);
             printf("%d\n", PolyIsZero(&top));
             break;
         case CLONE: ;
-            top = nthElement(*stack, 0);
+            top = nthElement(stack, 0);
             Poly clone = PolyClone(&top);
             push(stack, clone);
             break;
         case ADD:   ;
             top1 = pop(stack), top2 = pop(stack);
-            Poly add = PolyAdd(&top1, &top2);
-            push(stack, add);
-            PolyDestroy(&top1);
-            PolyDestroy(&top2);
+            push(stack, flat_engine ? FlatOwn(PolyFlatAdd, &top1, &top2)
+                                    : PolyAddOwn(&top1, &top2));
             break;
         case MUL: ;
             top1 = pop(stack), top2 = pop(stack);
-            Poly mul = PolyMul(&top1, &top2);
-            push(stack, mul);
-            PolyDestroy(&top1);
-            PolyDestroy(&top2);
+            push(stack, flat_engine ? FlatOwn(PolyFlatMul, &top1, &top2)
+                                    : PolyMulOwn(&top1, &top2));
             break;
         case NEG: ;
             top = pop(stack);
-            Poly neg = PolyNeg(&top);
-            push(stack, neg);
-            PolyDestroy(&top);
+            push(stack, PolyNegOwn(&top));
             break;
         case SUB: ;
             top1 = pop(stack), top2 = pop(stack);
-            Poly sub = PolySub(&top1, &top2);
-            push(stack, sub);
-            PolyDestroy(&top1);
-            PolyDestroy(&top2);
+            push(stack, flat_engine ? FlatOwn(PolyFlatSub, &top1, &top2)
+                                    : PolySubOwn(&top1, &top2));
             break;
         case IS_EQ: ;
-            top1 = nthElement(*stack, 0), top2 = nthElement(*stack, 1);
+            top1 = nthElement(stack, 0), top2 = nthElement(stack, 1);
             printf("%d\n", PolyIsEq(&top1, &top2));
             break;
         case DEG: ;
-            top = nthElement(*stack, 0);
+            top = nthElement(stack, 0);
             printf("%d\n", PolyDeg(&top));
             break;
         case PRINT: ;
-            top = nthElement(*stack, 0);
-            char *poly = PolyToStr(&top);
-            printf("%s\n", poly);
-            free(poly);
+            top = nthElement(stack, 0);
+            PrintPoly(&top, stdout);
             break;
         case POP: ;
             top = pop(stack);
             PolyDestroy(&top);
             break;
         case DEG_BY: ;
-            top = nthElement(*stack, 0);
+            top = nthElement(stack, 0);
             printf("%d\n", PolyDegBy(&top, command.deg_arg));
             break;
         case AT: ;
             top = pop(stack);
-            Poly at = PolyAt(&top, command.at_arg);
-            push(stack, at);
-            PolyDestroy(&top);
+            push(stack, PolyAtOwn(&top, command.at_arg));
+            break;
+        case AT_MULTI:
+            AtMulti(stack, command);
+            break;
+        case EVAL_BATCH:
+            EvalBatch(stack, command);
             break;
         case COMPOSE:
             Compose(stack, command);
             break;
+        case MOD:
+            SetModulus(stack, command);
+            break;
+        case SWAP:
+            rotate(stack, 1);
+            break;
+        case ROT:
+            assert(command.stack_arg > 0);
+            rotate(stack, command.stack_arg - 1);
+            break;
+        case PICK:
+            push(stack, PolyClone(nthElementPtr(stack, command.stack_arg)));
+            break;
+        case SAVE:
+            Save(stack, command);
+            break;
+        case LOAD:
+            Load(stack, command);
+            break;
+        case POW:
+            Pow(stack, command);
+            break;
+        case DIV:
+            Div(stack, command);
+            break;
+        case GCD:
+            Gcd(stack, command);
+            break;
+        case STATS:
+            StatsPrint(stdout);
+            break;
         case add_poly:
-            push(stack, command.p);
+            if (ModEnabled()) {
+                push(stack, PolyReduce(&command.p));
+                PolyDestroy(&command.p);
+            }
+            else {
+                push(stack, command.p);
+            }
             break;
         case error:
             break;
     }
+    ScratchReset();
+    StatsRecord(command.opt, StatsNow() - start);
 }
 
 /**
- * Wczytuje kolejne wiersze ze standardowego wejścia, sprawdza jakie polecenie
+ * Wczytuje kolejne wiersze z podanego źródła, sprawdza jakie polecenie
  * jest zawarte w każdym wierszu, a następnie wykonuje to polecenie, wykonując
  * operacje na stosie wielomianów i/lub wypisując wynik operacji na standardowe
  * wyjście. Stos wielomianów jest pusty na początku programu i jest modyfikowany
@@ -703,31 +1677,29 @@ void Execute(Stack *stack, Command command) {
  * nieprawidłowej nazwy polecenia, nieprawidłowego argumentu lub gdy polecenie
  * nie może zostać wykonane ze względu na zbyt małą liczbę wielomianów na stosie,
  * na standardowe wyjście diagnostyczne wypisywany jest komunikat o błędzie.
+ * @param[in,out] input : źródło poleceń (standardowe wejście lub skrypt)
  */
-void GetInput(void) {
+void GetInput(LineReader *input) {
     Stack stack = create();
-    char *input = NULL;
-    size_t verse_num = 1, getline_size = 0;
-    long getline_out = getline(&input, &getline_size, stdin);
-    // Wczytywanie wierszy.
-    while (getline_out != -1) {
+    const char *line;
+    size_t line_len;
+    // Wczytywanie wierszy. Wiersze są już pozbawione końcowego znaku '\n'
+    // i nie muszą być zakończone znakiem '\0'.
+    while (LineReaderNext(input, &line, &line_len)) {
         // Puste wiersze i wiersze zaczynające się od '#' są ignorowane.
-        if (input[0] != '#' && input[0] != '\n') {
-            // Zmieniamy ostatni znak z '\n' na '\0', żeby uprościć [input].
-            if (input[getline_out - 1] == '\n') input[getline_out - 1] = '\0';
+        if (line_len != 0 && line[0] != '#') {
             // Wykonujemy polecenie.
-            Command command = IdentifyCommand(stack, input, verse_num);
+            Command command = IdentifyCommand(&stack, line, line_len,
+                                              input->verse_num);
+            if (command.opt == EVAL_BATCH) {
+                command.eval_batch_arg.input = input;
+            }
             if (command.opt != error) {
                 Execute(&stack, command);
             }
         }
-        getline_out = getline(&input, &getline_size, stdin);
-        verse_num++;
-    }
-    free(input);
-    // Usuwamy ze stosu wielomiany, które zostały.
-    while (hasnElements(stack, 1)) {
-        Poly top = pop(&stack);
-        PolyDestroy(&top);
     }
-}
\ No newline at end of file
+    // Usuwamy ze stosu wyrażenia i wielomiany, które zostały.
+    releaseExprs();
+    destroy(&stack);
+}
@@ -8,6 +8,9 @@
 #ifndef GAMMA_CALC_PARSE_H
 #define GAMMA_CALC_PARSE_H
 
+#include <stdio.h>
+
+#include "line_reader.h"
 #include "poly.h"
 #include "stack.h"
 
@@ -43,6 +46,15 @@ typedef enum Option{
     AT,         ///< wylicza wartość wielomianu w punkcie podanym jako argument,
                 ///< usuwa wielomian z wierzchołka i wstawia na stos wynik
                 ///< operacji
+    AT_MULTI,   ///< wylicza wartości wielomianu w punktach podanych jako
+                ///< argumenty, usuwa wielomian z wierzchołka i wstawia na
+                ///< stos kolejne wyniki (wartość w ostatnim punkcie trafia na
+                ///< wierzchołek)
+    EVAL_BATCH, ///< wylicza wartości wielomianu z wierzchołka stosu
+                ///< w punktach wczytanych z pliku podanego jako argument lub,
+                ///< dla argumentu "-", z kolejnych wierszy standardowego
+                ///< wejścia aż do wiersza "END", i wypisuje je na standardowe
+                ///< wyjście, każdą w osobnym wierszu
     PRINT,      ///< wypisuje na standardowe wyjście wielomian z wierzchołka
                 ///< stosu
     POP,        ///< usuwa wielomian z wierzchołka stosu
@@ -52,16 +64,79 @@ typedef enum Option{
                 ///< wierzchołek stosu (więcej o operacji złożenia wielomianów
                 ///< przeczytasz w dokumentacji funkcji PolyCompose() z pliku
                 ///< poly.h)
+    MOD,        ///< ustawia moduł podany jako argument, modulo który liczone
+                ///< są odtąd współczynniki wielomianów, i redukuje modulo
+                ///< wielomiany na stosie (0 przywraca obliczenia dokładne)
+    SWAP,       ///< zamienia miejscami dwa wielomiany z wierzchu stosu
+    ROT,        ///< przenosi na wierzchołek stosu @f$n@f$-ty od góry
+                ///< wielomian (liczony od 1), gdzie @f$n \geq 1@f$ jest podane
+                ///< jako argument, przesuwając wielomiany nad nim o jedno
+                ///< miejsce w dół
+    PICK,       ///< wstawia na stos kopię wielomianu o indeksie podanym jako
+                ///< argument (wierzchołek ma indeks 0)
+    SAVE,       ///< zapisuje wielomian z wierzchołka stosu do pliku podanego
+                ///< jako argument w postaci binarnej (patrz: poly_view.h)
+    LOAD,       ///< wstawia na wierzchołek stosu wielomian wczytany z pliku
+                ///< podanego jako argument, zapisanego poleceniem <SAVE>
+    POW,        ///< podnosi wielomian z wierzchołka stosu do potęgi podanej
+                ///< jako argument, usuwa go i wstawia na wierzchołek stosu
+                ///< wynik (patrz: PolyPow())
+    DIV,        ///< dzieli wielomian z wierzchołka przez wielomian pod
+                ///< wierzchołkiem, usuwa je i wstawia na wierzchołek stosu
+                ///< iloraz, jeśli dzielenie jest wykonalne (patrz:
+                ///< PolyDivExact())
+    GCD,        ///< usuwa dwa wielomiany z wierzchu stosu i wstawia na
+                ///< wierzchołek stosu ich największy wspólny dzielnik (patrz:
+                ///< PolyGcd())
+    STATS,      ///< wypisuje na standardowe wyjście statystyki wykonania
+                ///< poleceń (patrz: calc_stats.h)
     add_poly,   ///< dodaje wielomian podany jako argument w odpowiednim
-                ///< formacie (patrz: correctPoly()) na wierzchołek stosu
+                ///< formacie (patrz: ParsePoly()) na wierzchołek stosu
     error       ///< nie wykonuje żadnych akcji
 } Option;
 
+/**
+ * To jest struktura przechowująca argument polecenia z opcją <AT_MULTI>.
+ */
+typedef struct AtMultiArg {
+    size_t count;           ///< liczba punktów
+    poly_coeff_t *points;   ///< punkty, przydzielone przez malloc()
+} AtMultiArg;
+
+/**
+ * To jest struktura przechowująca argument polecenia z opcją <EVAL_BATCH>.
+ */
+typedef struct EvalBatchArg {
+    char *path;         ///< ścieżka pliku z punktami, przydzielona przez
+                        ///< malloc(), lub NULL dla standardowego wejścia
+    LineReader *input;  ///< źródło poleceń kalkulatora, z którego czytane są
+                        ///< punkty, jeśli [path] jest równe NULL
+} EvalBatchArg;
+
+/**
+ * To jest struktura przechowująca argument polecenia z opcją <SAVE> lub
+ * <LOAD>.
+ */
+typedef struct FileArg {
+    char *path;         ///< ścieżka pliku, przydzielona przez malloc()
+    size_t verse_num;   ///< numer wiersza, w którym zostało podane polecenie
+} FileArg;
+
+/**
+ * To jest struktura przechowująca argument polecenia z opcją <POW>.
+ */
+typedef struct PowArg {
+    poly_exp_t exp;     ///< wykładnik potęgi
+    size_t verse_num;   ///< numer wiersza, w którym zostało podane polecenie
+} PowArg;
+
 /**
  * To jest struktura reprezentująca polecenie. Polecenie składa się z opcji
- * polecenia i, opcjonalnie, z argumentu. Polecenia z opcją <AT>, <DEG_BY>,
- * <COMPOSE> oraz <add_poly> są poleceniami z argumentem. Pozostałe polecenia
- * są bezargumentowe.
+ * polecenia i, opcjonalnie, z argumentu. Polecenia z opcją <AT>, <AT_MULTI>,
+ * <DEG_BY>, <COMPOSE>, <MOD>, <ROT>, <PICK>, <SAVE>, <LOAD>, <POW> oraz
+ * <add_poly> są poleceniami z argumentem. Polecenia z opcją <DIV> i <GCD>
+ * przechowują numer wiersza, w którym zostały podane. Pozostałe polecenia są
+ * bezargumentowe.
  */
 typedef struct Command {
     Option opt; ///< opcja polecenia
@@ -70,14 +145,44 @@ typedef struct Command {
      */
     union {
         poly_coeff_t at_arg;        ///< argument polecenia z opcją <AT>
+        AtMultiArg at_multi_arg;    ///< argument polecenia z opcją <AT_MULTI>
+        EvalBatchArg eval_batch_arg;///< argument polecenia z opcją
+                                    ///< <EVAL_BATCH>
         unsigned long deg_arg;      ///< argument polecenia z opcją <DEG_BY>
         unsigned long compose_arg;  ///< argument polecenia z opcją <COMPOSE>
+        poly_coeff_t mod_arg;       ///< argument polecenia z opcją <MOD>
+        unsigned long stack_arg;    ///< argument polecenia z opcją <ROT>
+                                    ///< lub <PICK>
+        FileArg file_arg;           ///< argument polecenia z opcją <SAVE>
+                                    ///< lub <LOAD>
+        PowArg pow_arg;             ///< argument polecenia z opcją <POW>
+        size_t verse_arg;           ///< numer wiersza, w którym zostało
+                                    ///< podane polecenie z opcją <DIV>
+                                    ///< lub <GCD>
         Poly p;                     ///< argument polecenia z opcją <add_poly>
     };
 } Command;
 
 /**
- * Wczytuje kolejne wiersze ze standardowego wejścia, sprawdza jakie polecenie
+ * Konwertuje zadany tekst na wielomian w jednym przejściu, jednocześnie
+ * sprawdzając jego poprawność.
+ * @param[in] input : tekst zakończony znakiem '\0'
+ * @param[out] res : wielomian - wynik konwersji
+ * @return 1, jeśli zadany tekst można zinterpretować jako wielomian;
+ * 0 w przeciwnym wypadku
+ */
+bool ReadPoly(const char *input, Poly *res);
+
+/**
+ * Wypisuje wielomian, zakończony znakiem nowej linii, na zadany strumień
+ * w formacie, który wczytuje ReadPoly().
+ * @param[in] p : wielomian
+ * @param[in] stream : strumień wyjściowy
+ */
+void PrintPoly(const Poly *p, FILE *stream);
+
+/**
+ * Wczytuje kolejne wiersze z podanego źródła, sprawdza jakie polecenie
  * jest zawarte w każdym wierszu, a następnie wykonuje to polecenie, wykonując
  * operacje na stosie wielomianów i/lub wypisując wynik operacji na standardowe
  * wyjście. Stos wielomianów jest pusty na początku programu i jest modyfikowany
@@ -85,7 +190,23 @@ typedef struct Command {
  * nieprawidłowej nazwy polecenia, nieprawidłowego argumentu lub gdy polecenie
  * nie może zostać wykonane ze względu na zbyt małą liczbę wielomianów na stosie,
  * na standardowe wyjście diagnostyczne wypisywany jest komunikat o błędzie.
+ * @param[in,out] input : źródło poleceń (standardowe wejście lub skrypt)
+ */
+void GetInput(LineReader *input);
+
+/**
+ * Włącza lub wyłącza wykonywanie poleceń <ADD>, <SUB> i <MUL> w rozłożonej
+ * reprezentacji wielomianów ze spakowanymi wykładnikami (patrz: poly_flat.h).
+ * @param[in] enabled : czy używać rozłożonej reprezentacji
+ */
+void UseFlatEngine(bool enabled);
+
+/**
+ * Włącza lub wyłącza leniwe wykonywanie poleceń <ADD>, <SUB>, <MUL> i <NEG>:
+ * na stos trafiają wyrażenia (patrz: poly_expr.h), obliczane dopiero przez
+ * polecenia odczytujące wartość wielomianu, np. <PRINT>.
+ * @param[in] enabled : czy wykonywać polecenia leniwie
  */
-void GetInput(void);
+void UseLazyEvaluation(bool enabled);
 
 #endif //GAMMA_CALC_PARSE_H
\ No newline at end of file
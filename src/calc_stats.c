@@ -0,0 +1,108 @@
+/** @file
+  Implementacja statystyk wykonania poleceń kalkulatora
+
+  @authors Izabela Ożdżeńska <io417924@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#define _GNU_SOURCE
+
+#include <time.h>
+#include "calc_stats.h"
+
+/** Liczba opcji poleceń. */
+#define OPTION_COUNT ((size_t) error + 1)
+
+/** To są nazwy opcji poleceń wypisywane przez StatsPrint(). */
+static const char *const OPTION_NAMES[OPTION_COUNT] = {
+    [ZERO] = "ZERO", [IS_COEFF] = "IS_COEFF", [IS_ZERO] = "IS_ZERO",
+    [CLONE] = "CLONE", [ADD] = "ADD", [MUL] = "MUL", [NEG] = "NEG",
+    [SUB] = "SUB", [IS_EQ] = "IS_EQ", [DEG] = "DEG", [DEG_BY] = "DEG_BY",
+    [AT] = "AT", [AT_MULTI] = "AT_MULTI", [EVAL_BATCH] = "EVAL_BATCH",
+    [PRINT] = "PRINT", [POP] = "POP", [COMPOSE] = "COMPOSE", [MOD] = "MOD",
+    [SWAP] = "SWAP", [ROT] = "ROT", [PICK] = "PICK", [SAVE] = "SAVE",
+    [LOAD] = "LOAD", [POW] = "POW", [DIV] = "DIV", [GCD] = "GCD",
+    [STATS] = "STATS", [add_poly] = "POLY", [error] = "ERROR"
+};
+
+/** To są statystyki wykonania poleceń kolejnych opcji. */
+static CommandStats stats[OPTION_COUNT];
+
+/** Czy zliczanie działań biblioteki jest włączone? */
+static bool counters_enabled = false;
+
+/**
+ * Daje aktualny czas zegara monotonicznego.
+ * @return czas w nanosekundach
+ */
+uint64_t StatsNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * Daje przedział histogramu, do którego należy czas wykonania.
+ * @param[in] ns : czas wykonania w nanosekundach
+ * @return przedział @f$\lfloor \log_2 ns \rfloor@f$, ograniczony do
+ * ostatniego przedziału
+ */
+static size_t Bucket(uint64_t ns) {
+    size_t bucket = 0;
+    while (bucket + 1 < STATS_BUCKETS && (ns >> (bucket + 1)) != 0) bucket++;
+    return bucket;
+}
+
+/**
+ * Zapisuje wykonanie polecenia z zadaną opcją.
+ * @param[in] opt : opcja polecenia
+ * @param[in] ns : czas wykonania w nanosekundach
+ */
+void StatsRecord(Option opt, uint64_t ns) {
+    CommandStats *s = &stats[opt];
+    s->calls++;
+    s->total_ns += ns;
+    if (ns > s->max_ns) s->max_ns = ns;
+    s->histogram[Bucket(ns)]++;
+}
+
+/**
+ * Włącza zliczanie działań biblioteki (patrz: PolySetCounting()).
+ */
+void StatsEnableCounters(void) {
+    counters_enabled = true;
+    PolySetCounting(true);
+}
+
+/**
+ * Wypisuje statystyki na zadany strumień: dla każdej wykonanej opcji wiersz
+ * "STATS <opcja> calls=<n> total_us=<t> max_us=<m> hist=<g>:<k>,...", gdzie
+ * <k> to liczba wykonań trwających krócej niż <g> nanosekund (i nie krócej
+ * niż @f$g / 2@f$), a następnie, jeśli zliczanie działań jest włączone,
+ * wiersz "COUNTERS monos=<j> mul_calls=<m> sorts=<s>".
+ * @param[in] stream : strumień wyjściowy
+ */
+void StatsPrint(FILE *stream) {
+    for (size_t opt = 0; opt < OPTION_COUNT; opt++) {
+        const CommandStats *s = &stats[opt];
+        if (s->calls == 0) continue;
+        fprintf(stream, "STATS %s calls=%zu total_us=%llu max_us=%llu hist=",
+                OPTION_NAMES[opt], s->calls,
+                (unsigned long long) (s->total_ns / 1000),
+                (unsigned long long) (s->max_ns / 1000));
+        bool first = true;
+        for (size_t b = 0; b < STATS_BUCKETS; b++) {
+            if (s->histogram[b] == 0) continue;
+            fprintf(stream, "%s%llu:%zu", first ? "" : ",",
+                    (unsigned long long) 1 << (b + 1), s->histogram[b]);
+            first = false;
+        }
+        fputc('\n', stream);
+    }
+    if (counters_enabled) {
+        PolyCounters counters = PolyGetCounters();
+        fprintf(stream, "COUNTERS monos=%zu mul_calls=%zu sorts=%zu\n",
+                counters.monos, counters.mul_calls, counters.sorts);
+    }
+    fflush(stream);
+}
@@ -0,0 +1,67 @@
+/** @file
+  Interfejs statystyk wykonania poleceń kalkulatora
+
+  Dla każdej opcji polecenia (patrz: Option) zliczana jest liczba wykonań,
+  łączny i największy czas wykonania oraz histogram czasów wykonania
+  o przedziałach rosnących wykładniczo: przedział @f$b@f$ obejmuje czasy
+  z przedziału @f$[2^b, 2^{b+1})@f$ nanosekund. Pomiar polecenia kosztuje dwa
+  odczyty zegara, więc statystyki poleceń zbierane są zawsze. Liczniki działań
+  biblioteki (patrz: PolyCounters) zbierane są dopiero po wywołaniu
+  StatsEnableCounters().
+
+  @authors Izabela Ożdżeńska <io417924@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#ifndef GAMMA_CALC_STATS_H
+#define GAMMA_CALC_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "calc_parse.h"
+
+/** Liczba przedziałów histogramu czasów wykonania. */
+#define STATS_BUCKETS 40
+
+/**
+ * To jest struktura przechowująca statystyki wykonania poleceń z jedną opcją.
+ */
+typedef struct CommandStats {
+    size_t calls;                       ///< liczba wykonań
+    uint64_t total_ns;                  ///< łączny czas wykonania
+    uint64_t max_ns;                    ///< największy czas wykonania
+    size_t histogram[STATS_BUCKETS];    ///< liczby wykonań w przedziałach
+                                        ///< czasu; ostatni przedział obejmuje
+                                        ///< także dłuższe czasy
+} CommandStats;
+
+/**
+ * Daje aktualny czas zegara monotonicznego.
+ * @return czas w nanosekundach
+ */
+uint64_t StatsNow(void);
+
+/**
+ * Zapisuje wykonanie polecenia z zadaną opcją.
+ * @param[in] opt : opcja polecenia
+ * @param[in] ns : czas wykonania w nanosekundach
+ */
+void StatsRecord(Option opt, uint64_t ns);
+
+/**
+ * Włącza zliczanie działań biblioteki (patrz: PolySetCounting()).
+ */
+void StatsEnableCounters(void);
+
+/**
+ * Wypisuje statystyki na zadany strumień: dla każdej wykonanej opcji wiersz
+ * "STATS <opcja> calls=<n> total_us=<t> max_us=<m> hist=<g>:<k>,...", gdzie
+ * <k> to liczba wykonań trwających krócej niż <g> nanosekund (i nie krócej
+ * niż @f$g / 2@f$), a następnie, jeśli zliczanie działań jest włączone,
+ * wiersz "COUNTERS monos=<j> mul_calls=<m> sorts=<s>".
+ * @param[in] stream : strumień wyjściowy
+ */
+void StatsPrint(FILE *stream);
+
+#endif //GAMMA_CALC_STATS_H
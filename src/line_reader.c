@@ -0,0 +1,143 @@
+/** @file
+  Implementacja wczytywania kolejnych wierszy poleceń kalkulatora
+
+  @authors Izabela Ożdżeńska <io417924@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "line_reader.h"
+
+/**
+ * Liczba przetworzonych bajtów odwzorowania, po której są one oddawane
+ * systemowi.
+ */
+#define LINE_READER_RELEASE_BYTES ((size_t) 1 << 26)
+
+/**
+ * Rozpoczyna wczytywanie wierszy z otwartego strumienia.
+ * @param[out] reader : stan wczytywania
+ * @param[in] stream : strumień
+ */
+void LineReaderFromStream(LineReader *reader, FILE *stream) {
+    *reader = (LineReader) {.stream = stream};
+}
+
+/**
+ * Otwiera plik do wczytywania wierszy. Zwykły plik jest odwzorowywany
+ * w pamięci, a inny (np. potok nazwany) jest czytany jako strumień.
+ * @param[out] reader : stan wczytywania
+ * @param[in] path : ścieżka pliku
+ * @return Czy udało się otworzyć plik?
+ */
+bool LineReaderOpen(LineReader *reader, const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) return false;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        *reader = (LineReader) {.stream = NULL};
+        if (st.st_size == 0) {
+            close(fd);
+            return true;
+        }
+        void *map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE,
+                         fd, 0);
+        if (map != MAP_FAILED) {
+            close(fd);
+            madvise(map, (size_t) st.st_size, MADV_SEQUENTIAL);
+            reader->map = map;
+            reader->map_size = (size_t) st.st_size;
+            return true;
+        }
+    }
+    FILE *stream = fdopen(fd, "r");
+    if (stream == NULL) {
+        close(fd);
+        return false;
+    }
+    LineReaderFromStream(reader, stream);
+    reader->own_stream = true;
+    return true;
+}
+
+/**
+ * Oddaje systemowi przetworzone strony odwzorowania leżące przed @p end.
+ * @param[in,out] reader : stan wczytywania
+ * @param[in] end : pozycja w odwzorowaniu, od której dane są jeszcze używane
+ */
+static void ReleaseMapped(LineReader *reader, size_t end) {
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    end -= end % page;
+    if (end <= reader->released) return;
+    madvise((char*) reader->map + reader->released, end - reader->released,
+            MADV_DONTNEED);
+    reader->released = end;
+}
+
+/**
+ * Wczytuje kolejny wiersz odwzorowania. Znak nowej linii wyszukiwany jest
+ * funkcją memchr(), która przegląda wiele bajtów jednocześnie. Odwzorowanie
+ * nie jest modyfikowane: wiersz wskazuje na nie i nie jest zakończony znakiem
+ * '\0'.
+ * @param[in,out] reader : stan wczytywania
+ * @param[out] line : wiersz
+ * @param[out] len : długość wiersza bez znaku nowej linii
+ * @return Czy wczytano wiersz?
+ */
+static bool NextMapped(LineReader *reader, const char **line, size_t *len) {
+    if (reader->pos >= reader->map_size) return false;
+    if (reader->pos - reader->released >= LINE_READER_RELEASE_BYTES) {
+        ReleaseMapped(reader, reader->pos);
+    }
+    const char *begin = reader->map + reader->pos;
+    size_t rest = reader->map_size - reader->pos;
+    const char *newline = memchr(begin, '\n', rest);
+    // Ostatni wiersz może nie mieć znaku nowej linii.
+    *len = newline != NULL ? (size_t) (newline - begin) : rest;
+    *line = begin;
+    reader->pos += newline != NULL ? *len + 1 : rest;
+    return true;
+}
+
+/**
+ * Wczytuje kolejny wiersz. Wiersz nie zawiera znaku nowej linii, nie musi być
+ * zakończony znakiem '\0' i pozostaje ważny do następnego wywołania funkcji.
+ * @param[in,out] reader : stan wczytywania
+ * @param[out] line : wiersz
+ * @param[out] len : długość wiersza bez znaku nowej linii
+ * @return Czy wczytano wiersz (fałsz na końcu danych)?
+ */
+bool LineReaderNext(LineReader *reader, const char **line, size_t *len) {
+    if (reader->stream == NULL) {
+        if (!NextMapped(reader, line, len)) return false;
+    }
+    else {
+        long read = getline(&reader->buffer, &reader->buffer_size,
+                            reader->stream);
+        if (read == -1) return false;
+        *line = reader->buffer;
+        *len = (size_t) read;
+        if (*len > 0 && reader->buffer[*len - 1] == '\n') (*len)--;
+    }
+    reader->verse_num++;
+    return true;
+}
+
+/**
+ * Kończy wczytywanie wierszy i zwalnia zasoby. Strumień przekazany do
+ * LineReaderFromStream() nie jest zamykany.
+ * @param[in,out] reader : stan wczytywania
+ */
+void LineReaderClose(LineReader *reader) {
+    if (reader->map != NULL) munmap((char*) reader->map, reader->map_size);
+    if (reader->own_stream) fclose(reader->stream);
+    free(reader->buffer);
+    *reader = (LineReader) {.stream = NULL};
+}
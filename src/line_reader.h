@@ -0,0 +1,70 @@
+/** @file
+  Interfejs wczytywania kolejnych wierszy poleceń kalkulatora
+
+  Zwykłe pliki są odwzorowywane w pamięci (mmap) tylko do odczytu i dzielone
+  na wiersze bez kopiowania: wiersz przekazywany jest jako wskaźnik do
+  odwzorowania razem ze swoją długością i nie jest zakończony znakiem '\0'.
+  Strony, które zostały już przetworzone, są oddawane systemowi, więc zużycie
+  pamięci nie rośnie z długością pliku. Potoki i inne strumienie, których nie
+  można odwzorować, czytane są funkcją getline().
+
+  @authors Izabela Ożdżeńska <io417924@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#ifndef GAMMA_LINE_READER_H
+#define GAMMA_LINE_READER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * To jest struktura przechowująca stan wczytywania wierszy.
+ */
+typedef struct LineReader {
+    FILE *stream;       ///< czytany strumień lub NULL dla odwzorowania
+    bool own_stream;    ///< czy strumień został otwarty przez LineReaderOpen()
+    char *buffer;       ///< bufor wiersza czytanego ze strumienia
+    size_t buffer_size; ///< rozmiar bufora
+    const char *map;    ///< odwzorowany plik lub NULL
+    size_t map_size;    ///< rozmiar odwzorowanego pliku
+    size_t pos;         ///< pozycja początku kolejnego wiersza w odwzorowaniu
+    size_t released;    ///< długość początku odwzorowania oddanego systemowi
+    size_t verse_num;   ///< numer ostatnio wczytanego wiersza (od 1)
+} LineReader;
+
+/**
+ * Otwiera plik do wczytywania wierszy. Zwykły plik jest odwzorowywany
+ * w pamięci, a inny (np. potok nazwany) jest czytany jako strumień.
+ * @param[out] reader : stan wczytywania
+ * @param[in] path : ścieżka pliku
+ * @return Czy udało się otworzyć plik?
+ */
+bool LineReaderOpen(LineReader *reader, const char *path);
+
+/**
+ * Rozpoczyna wczytywanie wierszy z otwartego strumienia.
+ * @param[out] reader : stan wczytywania
+ * @param[in] stream : strumień
+ */
+void LineReaderFromStream(LineReader *reader, FILE *stream);
+
+/**
+ * Wczytuje kolejny wiersz. Wiersz nie zawiera znaku nowej linii, nie musi być
+ * zakończony znakiem '\0' i pozostaje ważny do następnego wywołania funkcji.
+ * @param[in,out] reader : stan wczytywania
+ * @param[out] line : wiersz
+ * @param[out] len : długość wiersza bez znaku nowej linii
+ * @return Czy wczytano wiersz (fałsz na końcu danych)?
+ */
+bool LineReaderNext(LineReader *reader, const char **line, size_t *len);
+
+/**
+ * Kończy wczytywanie wierszy i zwalnia zasoby. Strumień przekazany do
+ * LineReaderFromStream() nie jest zamykany.
+ * @param[in,out] reader : stan wczytywania
+ */
+void LineReaderClose(LineReader *reader);
+
+#endif //GAMMA_LINE_READER_H
@@ -0,0 +1,99 @@
+/** @file
+  Implementacja arytmetyki współczynników modulo
+
+  @authors Izabela Ożdżeńska <io417924@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#include "mod_arith.h"
+
+/** To jest moduł, modulo który liczone są współczynniki. */
+ModArith mod_arith;
+
+/**
+ * Ustawia moduł, modulo który liczone są współczynniki, i wylicza stałe
+ * redukcji Barretta.
+ * @param[in] mod : moduł z przedziału @f$[2, MOD\_MAX]@f$ lub 0, aby
+ * przywrócić obliczenia dokładne
+ * @return Czy moduł jest poprawny?
+ */
+bool ModSetModulus(poly_coeff_t mod) {
+    if (mod != 0 && (mod < 2 || mod > MOD_MAX)) return false;
+    mod_arith = (ModArith) {.mod = (unsigned long) mod};
+    if (mod == 0) return true;
+    while ((unsigned long) mod >> mod_arith.bits != 0) mod_arith.bits++;
+#ifdef __SIZEOF_INT128__
+    mod_arith.mu = (unsigned long) (((unsigned __int128) 1 << (2 * mod_arith.bits))
+                                    / (unsigned long) mod);
+#endif
+    return true;
+}
+
+/**
+ * Podnosi resztę do potęgi modulo moduł, podnosząc ją kolejno do kwadratu.
+ * @param[in] base : reszta z przedziału @f$[0, mod)@f$
+ * @param[in] exp : wykładnik
+ * @return @f$base^{exp} \bmod mod@f$
+ */
+static poly_coeff_t ModPow(poly_coeff_t base, unsigned long exp) {
+    poly_coeff_t res = 1;
+    for (; exp > 0; exp >>= 1) {
+        if (exp & 1) res = ModMulReduced(res, base);
+        base = ModMulReduced(base, base);
+    }
+    return res;
+}
+
+/**
+ * Sprawdza, czy ustawiony moduł jest liczbą pierwszą, testem Millera-Rabina.
+ * Dla liczb mniejszych od @f$3 \cdot 10^{24}@f$ świadkami wystarczy
+ * dwanaście pierwszych liczb pierwszych, więc test jest deterministyczny.
+ * @return Czy moduł jest liczbą pierwszą?
+ */
+bool ModIsPrime(void) {
+    static const poly_coeff_t witnesses[] = {2, 3, 5, 7, 11, 13, 17, 19, 23,
+                                             29, 31, 37};
+    size_t count = sizeof(witnesses) / sizeof(witnesses[0]);
+    unsigned long mod = mod_arith.mod;
+    for (size_t i = 0; i < count; i++) {
+        if (mod == (unsigned long) witnesses[i]) return true;
+        if (mod % (unsigned long) witnesses[i] == 0) return false;
+    }
+    // mod - 1 = d * 2^s, gdzie d jest nieparzyste.
+    unsigned long d = mod - 1;
+    unsigned s = 0;
+    while (d % 2 == 0) {
+        d /= 2;
+        s++;
+    }
+    poly_coeff_t minus_one = (poly_coeff_t) mod - 1;
+    for (size_t i = 0; i < count; i++) {
+        poly_coeff_t x = ModPow(witnesses[i], d);
+        if (x == 1 || x == minus_one) continue;
+        unsigned j = 1;
+        for (; j < s && x != minus_one; j++) x = ModMulReduced(x, x);
+        if (x != minus_one) return false;
+    }
+    return true;
+}
+
+/**
+ * Daje odwrotność liczby modulo moduł, wyliczaną rozszerzonym algorytmem
+ * Euklidesa. Współczynniki Bézouta są co do wartości bezwzględnej
+ * ograniczone przez moduł, więc obliczenia nie przepełniają się.
+ * @param[in] a : liczba @f$a@f$
+ * @return @f$a^{-1} \bmod mod@f$ lub 0, jeśli @f$a@f$ nie jest odwracalna
+ */
+poly_coeff_t ModInverse(poly_coeff_t a) {
+    poly_coeff_t r0 = (poly_coeff_t) mod_arith.mod, r1 = ModReduce(a);
+    poly_coeff_t t0 = 0, t1 = 1;
+    while (r1 != 0) {
+        poly_coeff_t q = r0 / r1, r = r0 - q * r1, t = t0 - q * t1;
+        r0 = r1;
+        r1 = r;
+        t0 = t1;
+        t1 = t;
+    }
+    if (r0 != 1) return 0;
+    return t0 < 0 ? t0 + (poly_coeff_t) mod_arith.mod : t0;
+}
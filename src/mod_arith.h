@@ -0,0 +1,137 @@
+/** @file
+  Interfejs arytmetyki współczynników modulo
+
+  Po ustawieniu modułu (patrz: PolySetModulus()) wszystkie działania na
+  współczynnikach wielomianów wykonywane są modulo ten moduł, a współczynniki
+  przechowywane są jako reszty z przedziału @f$[0, mod)@f$. Mnożenie reszt
+  korzysta z redukcji Barretta, więc nie wymaga dzielenia.
+
+  Moduł jest jeden: kalkulator nie ma trybu, w którym całe obliczenie
+  wykonywane jest równolegle modulo kilka liczb pierwszych, a dokładny wynik
+  odtwarzany jest z reszt (chińskie twierdzenie o resztach). Odtwarzanie
+  z reszt algorytmem Garnera wykonuje wewnętrznie tylko mnożenie wielomianów
+  jednej zmiennej przez NTT (patrz: poly.c). Jego wynik jest dokładny (także
+  jako duże współczynniki, patrz: big_coeff.h) lub redukowany modulo
+  ustawiony moduł.
+
+  @authors Izabela Ożdżeńska <io417924@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#ifndef GAMMA_MOD_ARITH_H
+#define GAMMA_MOD_ARITH_H
+
+#include <limits.h>
+#include <stdbool.h>
+#include "poly.h"
+
+/**
+ * Największy dopuszczalny moduł. Suma dwóch reszt mieści się w typie
+ * poly_coeff_t.
+ */
+#define MOD_MAX (LONG_MAX >> 1)
+
+/**
+ * To jest struktura przechowująca moduł, modulo który liczone są
+ * współczynniki, razem ze stałymi redukcji Barretta.
+ */
+typedef struct ModArith {
+    unsigned long mod; ///< moduł lub 0, jeśli obliczenia są dokładne
+    unsigned long mu;  ///< stała redukcji Barretta: @f$\lfloor 4^{bits} / mod \rfloor@f$
+    unsigned bits;     ///< liczba bitów modułu
+} ModArith;
+
+/** To jest moduł, modulo który liczone są współczynniki. */
+extern ModArith mod_arith;
+
+/**
+ * Ustawia moduł, modulo który liczone są współczynniki.
+ * @param[in] mod : moduł z przedziału @f$[2, MOD\_MAX]@f$ lub 0, aby
+ * przywrócić obliczenia dokładne
+ * @return Czy moduł jest poprawny?
+ */
+bool ModSetModulus(poly_coeff_t mod);
+
+/**
+ * Sprawdza, czy ustawiony moduł jest liczbą pierwszą.
+ * @return Czy moduł jest liczbą pierwszą?
+ */
+bool ModIsPrime(void);
+
+/**
+ * Daje odwrotność liczby modulo moduł.
+ * @param[in] a : liczba @f$a@f$
+ * @return @f$a^{-1} \bmod mod@f$ lub 0, jeśli @f$a@f$ nie jest odwracalna
+ */
+poly_coeff_t ModInverse(poly_coeff_t a);
+
+/**
+ * Sprawdza, czy współczynniki liczone są modulo.
+ * @return Czy moduł jest ustawiony?
+ */
+static inline bool ModEnabled(void) {
+    return mod_arith.mod != 0;
+}
+
+/**
+ * Daje resztę z dzielenia liczby przez moduł.
+ * @param[in] c : liczba
+ * @return @f$c \bmod mod@f$, z przedziału @f$[0, mod)@f$
+ */
+static inline poly_coeff_t ModReduce(poly_coeff_t c) {
+    if ((unsigned long) c < mod_arith.mod) return c;
+    poly_coeff_t res = c % (poly_coeff_t) mod_arith.mod;
+    return res < 0 ? res + (poly_coeff_t) mod_arith.mod : res;
+}
+
+/**
+ * Mnoży dwie reszty modulo moduł. Dla kompilatorów obsługujących liczby
+ * 128-bitowe używa redukcji Barretta, a w przeciwnym wypadku mnożenia
+ * przez kolejne bity.
+ * @param[in] a : reszta z przedziału @f$[0, mod)@f$
+ * @param[in] b : reszta z przedziału @f$[0, mod)@f$
+ * @return @f$a b \bmod mod@f$
+ */
+static inline poly_coeff_t ModMulReduced(poly_coeff_t a, poly_coeff_t b) {
+    unsigned long mod = mod_arith.mod;
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 x = (unsigned __int128) a * (unsigned long) b;
+    // Iloraz szacowany jest z dołu z błędem co najwyżej 2.
+    unsigned __int128 q = (x >> (mod_arith.bits - 1)) * mod_arith.mu
+                          >> (mod_arith.bits + 1);
+    unsigned long r = (unsigned long) (x - q * mod);
+    while (r >= mod) r -= mod;
+    return (poly_coeff_t) r;
+#else
+    unsigned long res = 0, x = (unsigned long) a;
+    for (unsigned long y = (unsigned long) b; y > 0; y >>= 1) {
+        if (y & 1) res = res + x >= mod ? res + x - mod : res + x;
+        x = x + x >= mod ? x + x - mod : x + x;
+    }
+    return (poly_coeff_t) res;
+#endif
+}
+
+/**
+ * Dodaje dwie liczby modulo moduł.
+ * @param[in] a : liczba @f$a@f$
+ * @param[in] b : liczba @f$b@f$
+ * @return @f$(a + b) \bmod mod@f$
+ */
+static inline poly_coeff_t ModAdd(poly_coeff_t a, poly_coeff_t b) {
+    poly_coeff_t res = ModReduce(a) + ModReduce(b);
+    return res >= (poly_coeff_t) mod_arith.mod ?
+           res - (poly_coeff_t) mod_arith.mod : res;
+}
+
+/**
+ * Mnoży dwie liczby modulo moduł.
+ * @param[in] a : liczba @f$a@f$
+ * @param[in] b : liczba @f$b@f$
+ * @return @f$a b \bmod mod@f$
+ */
+static inline poly_coeff_t ModMul(poly_coeff_t a, poly_coeff_t b) {
+    return ModMulReduced(ModReduce(a), ModReduce(b));
+}
+
+#endif //GAMMA_MOD_ARITH_H
@@ -0,0 +1,401 @@
+/** @file
+  Implementacja alokatora tablic jednomianów
+
+  @authors Izabela Ożdżeńska <io417924@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mono_alloc.h"
+
+/**
+ * Liczba klas rozmiaru obsługiwanych przez pule. Klasa @f$c@f$ mieści
+ * @f$2^c@f$ jednomianów.
+ */
+#define SIZE_CLASSES 11
+
+/**
+ * To jest klasa rozmiaru bloków przydzielanych bezpośrednio przez alokator
+ * systemowy, ponieważ nie mieszczą się w żadnej puli.
+ */
+#define LARGE_CLASS SIZE_CLASSES
+
+/**
+ * Rozmiar płyty, z której wycinane są bloki pul.
+ */
+#define SLAB_SIZE ((size_t) 1 << 18)
+
+/**
+ * Domyślny rozmiar fragmentu areny pamięci tymczasowej.
+ */
+#define SCRATCH_CHUNK_SIZE ((size_t) 1 << 16)
+
+/**
+ * Wyrównanie pamięci przydzielanej przez alokator.
+ */
+#define ALIGNMENT ((size_t) 16)
+
+/**
+ * Zaokrągla @p n w górę do wielokrotności ALIGNMENT.
+ */
+#define ALIGN_UP(n) (((n) + ALIGNMENT - 1) & ~(ALIGNMENT - 1))
+
+/**
+ * To jest nagłówek płyty, z której wycinane są bloki pul.
+ */
+typedef struct Slab {
+    struct Slab *next; ///< kolejna płyta
+} Slab;
+
+/**
+ * To jest fragment areny pamięci tymczasowej.
+ */
+typedef struct ScratchChunk {
+    struct ScratchChunk *next; ///< kolejny fragment areny
+    size_t size;               ///< rozmiar danych fragmentu
+    max_align_t data[];        ///< dane fragmentu
+} ScratchChunk;
+
+/** To są listy wolnych bloków wątku dla kolejnych klas rozmiaru. */
+static _Thread_local MonoBlock *free_lists[SIZE_CLASSES];
+/** To jest lista wszystkich przydzielonych płyt (wspólna dla wątków). */
+static Slab *slabs = NULL;
+/**
+ * To są listy wolnych bloków oddanych przez zakończone wątki, wspólne dla
+ * wątków. Modyfikowane pod blokadą listy płyt.
+ */
+static _Atomic(MonoBlock*) shared_free_lists[SIZE_CLASSES];
+/** To jest blokada listy płyt i wspólnych list wolnych bloków. */
+static pthread_mutex_t slabs_lock = PTHREAD_MUTEX_INITIALIZER;
+/** To jest początek wolnej części aktualnej płyty wątku. */
+static _Thread_local char *slab_pos = NULL;
+/** To jest koniec aktualnej płyty wątku. */
+static _Thread_local char *slab_end = NULL;
+
+/** To jest lista fragmentów areny pamięci tymczasowej wątku. */
+static _Thread_local ScratchChunk *scratch_chunks = NULL;
+/** To jest aktualny fragment areny (NULL przed pierwszym przydziałem). */
+static _Thread_local ScratchChunk *scratch_current = NULL;
+/** To jest zajęta część aktualnego fragmentu areny. */
+static _Thread_local size_t scratch_used = 0;
+
+/** To jest liczba tablic jednomianów przydzielonych przez wątek. */
+static _Thread_local size_t alloc_count = 0;
+
+/**
+ * Daje tablicę jednomianów przechowywaną w bloku.
+ * @param[in] block : blok
+ * @return tablica jednomianów
+ */
+static inline Mono* BlockArr(MonoBlock *block) {
+    return (Mono*) ((char*) block + MONO_BLOCK_HEADER_SIZE);
+}
+
+/**
+ * Daje najmniejszą klasę rozmiaru mieszczącą @p count jednomianów.
+ * @param[in] count : liczba jednomianów
+ * @return klasa rozmiaru lub LARGE_CLASS
+ */
+static size_t SizeClass(size_t count) {
+    size_t size_class = 0;
+    while (size_class < SIZE_CLASSES && ((size_t) 1 << size_class) < count) {
+        size_class++;
+    }
+    return size_class;
+}
+
+/**
+ * Wycina z aktualnej płyty blok zadanej klasy rozmiaru. Jeśli płyta jest
+ * pełna, przydziela nową.
+ * @param[in] size_class : klasa rozmiaru
+ * @return nowy blok
+ */
+static MonoBlock* CarveBlock(size_t size_class) {
+    size_t bytes = ALIGN_UP(MONO_BLOCK_HEADER_SIZE + ((size_t) 1 << size_class) * sizeof(Mono));
+    if (slab_pos == NULL || (size_t) (slab_end - slab_pos) < bytes) {
+        Slab *slab = malloc(SLAB_SIZE);
+        if (slab == NULL) exit(1); // Błąd podczas alokacji pamięci.
+        pthread_mutex_lock(&slabs_lock);
+        slab->next = slabs;
+        slabs = slab;
+        pthread_mutex_unlock(&slabs_lock);
+        slab_pos = (char*) slab + ALIGN_UP(sizeof(Slab));
+        slab_end = (char*) slab + SLAB_SIZE;
+    }
+    MonoBlock *block = (MonoBlock*) slab_pos;
+    slab_pos += bytes;
+    block->size_class = size_class;
+    return block;
+}
+
+/**
+ * Przejmuje wspólną listę wolnych bloków zadanej klasy rozmiaru jako listę
+ * wolnych bloków wątku. Lista wątku musi być pusta.
+ * @param[in] size_class : klasa rozmiaru
+ * @return Czy przejęto niepustą listę?
+ */
+static bool TakeSharedFreeList(size_t size_class) {
+    assert(free_lists[size_class] == NULL);
+    // Wspólne listy są zwykle puste, więc sprawdzamy je bez blokady.
+    if (atomic_load_explicit(&shared_free_lists[size_class],
+                             memory_order_relaxed) == NULL) {
+        return false;
+    }
+    pthread_mutex_lock(&slabs_lock);
+    free_lists[size_class] = atomic_load_explicit(&shared_free_lists[size_class],
+                                                  memory_order_relaxed);
+    atomic_store_explicit(&shared_free_lists[size_class], NULL,
+                          memory_order_relaxed);
+    pthread_mutex_unlock(&slabs_lock);
+    return free_lists[size_class] != NULL;
+}
+
+/**
+ * Przydziela tablicę mieszczącą co najmniej @p count jednomianów, z jednym
+ * odwołaniem do niej. W przypadku braku pamięci program kończy działanie.
+ * @param[in] count : liczba jednomianów, @f$count > 0@f$
+ * @return wskaźnik na tablicę jednomianów
+ */
+Mono* MonoArrAlloc(size_t count) {
+    assert(count > 0);
+    alloc_count++;
+    size_t size_class = SizeClass(count);
+    MonoBlock *block;
+    if (size_class == LARGE_CLASS) {
+        block = malloc(MONO_BLOCK_HEADER_SIZE + count * sizeof(Mono));
+        if (block == NULL) exit(1); // Błąd podczas alokacji pamięci.
+        block->size_class = LARGE_CLASS;
+    }
+    else if (free_lists[size_class] != NULL || TakeSharedFreeList(size_class)) {
+        block = free_lists[size_class];
+        // Wolny blok przechowuje wskaźnik na kolejny wolny blok w miejscu
+        // tablicy jednomianów.
+        free_lists[size_class] = *(MonoBlock**) BlockArr(block);
+    }
+    else {
+        block = CarveBlock(size_class);
+    }
+    atomic_init(&block->refs, 1);
+    return BlockArr(block);
+}
+
+/**
+ * Zmniejsza tablicę jednomianów tak, aby mieściła @p count jednomianów.
+ * Jeśli @p count należy do tej samej klasy rozmiaru co tablica, zwraca
+ * tę samą tablicę. W przeciwnym przypadku przenosi pierwsze @p count
+ * jednomianów do mniejszego bloku i zwalnia poprzedni.
+ * @param[in] arr : tablica jednomianów przydzielona przez MonoArrAlloc()
+ * @param[in] count : nowa liczba jednomianów, @f$count > 0@f$
+ * @return wskaźnik na zmniejszoną tablicę jednomianów
+ */
+Mono* MonoArrShrink(Mono *arr, size_t count) {
+    assert(arr != NULL && count > 0);
+    assert(!MonoArrIsShared(arr));
+    MonoBlock *block = MonoArrBlock(arr);
+    size_t size_class = SizeClass(count);
+    assert(size_class <= block->size_class);
+    if (size_class == block->size_class && size_class != LARGE_CLASS) {
+        return arr;
+    }
+    else if (size_class == LARGE_CLASS) {
+        block = realloc(block, MONO_BLOCK_HEADER_SIZE + count * sizeof(Mono));
+        if (block == NULL) exit(1); // Błąd podczas alokacji pamięci.
+        return BlockArr(block);
+    }
+    else {
+        Mono *new_arr = MonoArrAlloc(count);
+        memcpy(new_arr, arr, count * sizeof(Mono));
+        MonoArrFree(arr);
+        return new_arr;
+    }
+}
+
+/**
+ * Powiększa tablicę jednomianów tak, aby mieściła @p count jednomianów.
+ * Zachowuje dotychczasową zawartość tablicy.
+ * @param[in] arr : tablica jednomianów przydzielona przez MonoArrAlloc()
+ * @param[in] count : nowa liczba jednomianów
+ * @return wskaźnik na powiększoną tablicę jednomianów
+ */
+Mono* MonoArrGrow(Mono *arr, size_t count) {
+    assert(arr != NULL);
+    assert(!MonoArrIsShared(arr));
+    MonoBlock *block = MonoArrBlock(arr);
+    size_t size_class = SizeClass(count);
+    assert(size_class >= block->size_class);
+    if (size_class == block->size_class && size_class != LARGE_CLASS) {
+        return arr;
+    }
+    else if (block->size_class == LARGE_CLASS) {
+        block = realloc(block, MONO_BLOCK_HEADER_SIZE + count * sizeof(Mono));
+        if (block == NULL) exit(1); // Błąd podczas alokacji pamięci.
+        return BlockArr(block);
+    }
+    else {
+        // Blok puli jest w całości zajęty przez tablicę o jego pojemności.
+        Mono *new_arr = MonoArrAlloc(count);
+        memcpy(new_arr, arr, ((size_t) 1 << block->size_class) * sizeof(Mono));
+        MonoArrFree(arr);
+        return new_arr;
+    }
+}
+
+/**
+ * Zwalnia tablicę jednomianów przydzieloną przez MonoArrAlloc(). Nie zwalnia
+ * jednomianów przechowywanych w tablicy.
+ * @param[in] arr : tablica jednomianów lub NULL
+ */
+void MonoArrFree(Mono *arr) {
+    if (arr == NULL) return;
+    MonoBlock *block = MonoArrBlock(arr);
+    if (block->size_class == LARGE_CLASS) {
+        free(block);
+    }
+    else {
+        *(MonoBlock**) arr = free_lists[block->size_class];
+        free_lists[block->size_class] = block;
+    }
+}
+
+/**
+ * Daje liczbę tablic jednomianów przydzielonych przez wywołujący wątek
+ * funkcją MonoArrAlloc() (także przy zmianie rozmiaru tablicy) od początku
+ * jego działania.
+ * @return liczba przydzielonych tablic jednomianów
+ */
+size_t MonoAllocCount(void) {
+    return alloc_count;
+}
+
+/**
+ * Zwalnia arenę pamięci tymczasowej wątku i oddaje jego listy wolnych bloków
+ * na wspólne listy, z których korzystają pozostałe wątki. Płyty, z których
+ * pochodzą bloki, pozostają przydzielone, ponieważ bloki mogą być nadal
+ * używane przez inne wątki. Wywoływana przez każdy wątek pomocniczy przed
+ * jego zakończeniem.
+ */
+void MonoAllocThreadExit(void) {
+    slab_pos = slab_end = NULL;
+    pthread_mutex_lock(&slabs_lock);
+    for (size_t i = 0; i < SIZE_CLASSES; i++) {
+        if (free_lists[i] == NULL) continue;
+        // Doklejamy wspólną listę na koniec listy wątku.
+        MonoBlock *last = free_lists[i];
+        while (*(MonoBlock**) BlockArr(last) != NULL) {
+            last = *(MonoBlock**) BlockArr(last);
+        }
+        *(MonoBlock**) BlockArr(last) =
+            atomic_load_explicit(&shared_free_lists[i], memory_order_relaxed);
+        atomic_store_explicit(&shared_free_lists[i], free_lists[i],
+                              memory_order_relaxed);
+        free_lists[i] = NULL;
+    }
+    pthread_mutex_unlock(&slabs_lock);
+    while (scratch_chunks != NULL) {
+        ScratchChunk *next = scratch_chunks->next;
+        free(scratch_chunks);
+        scratch_chunks = next;
+    }
+    scratch_current = NULL;
+    scratch_used = 0;
+}
+
+/**
+ * Zwalnia całą pamięć przechowywaną przez pule i arenę. Wolno ją wywołać
+ * dopiero wtedy, gdy żadna tablica przydzielona przez MonoArrAlloc() nie jest
+ * już używana, a wszystkie wątki pomocnicze zostały zakończone.
+ */
+void MonoAllocCleanup(void) {
+    MonoAllocThreadExit();
+    pthread_mutex_lock(&slabs_lock);
+    for (size_t i = 0; i < SIZE_CLASSES; i++) {
+        atomic_store_explicit(&shared_free_lists[i], NULL, memory_order_relaxed);
+    }
+    while (slabs != NULL) {
+        Slab *next = slabs->next;
+        free(slabs);
+        slabs = next;
+    }
+    pthread_mutex_unlock(&slabs_lock);
+}
+
+/**
+ * Tworzy nowy fragment areny o danych rozmiaru co najmniej @p bytes bajtów.
+ * @param[in] bytes : wymagany rozmiar danych
+ * @return nowy fragment areny
+ */
+static ScratchChunk* NewScratchChunk(size_t bytes) {
+    size_t size = bytes > SCRATCH_CHUNK_SIZE ? bytes : SCRATCH_CHUNK_SIZE;
+    ScratchChunk *chunk = malloc(sizeof(ScratchChunk) + size);
+    if (chunk == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    chunk->size = size;
+    chunk->next = NULL;
+    return chunk;
+}
+
+/**
+ * Przydziela @p bytes bajtów pamięci tymczasowej. Pamięć pozostaje ważna do
+ * wywołania ScratchRelease() ze stanem zapamiętanym przed jej przydzieleniem
+ * lub do wywołania ScratchReset().
+ * @param[in] bytes : liczba bajtów
+ * @return wskaźnik na przydzieloną pamięć
+ */
+void* ScratchAlloc(size_t bytes) {
+    bytes = ALIGN_UP(bytes);
+    if (scratch_current == NULL || scratch_current->size - scratch_used < bytes) {
+        // Przechodzimy do kolejnego fragmentu areny. Jeśli jest za mały lub
+        // go nie ma, wstawiamy przed nim nowy fragment.
+        ScratchChunk **next = scratch_current == NULL ?
+                              &scratch_chunks : &scratch_current->next;
+        if (*next == NULL || (*next)->size < bytes) {
+            ScratchChunk *chunk = NewScratchChunk(bytes);
+            chunk->next = *next;
+            *next = chunk;
+        }
+        scratch_current = *next;
+        scratch_used = 0;
+    }
+    void *res = (char*) scratch_current->data + scratch_used;
+    scratch_used += bytes;
+    return res;
+}
+
+/**
+ * Zapamiętuje aktualny stan areny pamięci tymczasowej.
+ * @return stan areny
+ */
+ScratchMark ScratchGetMark(void) {
+    return (ScratchMark) {.chunk = scratch_current, .used = scratch_used};
+}
+
+/**
+ * Zwalnia całą pamięć tymczasową przydzieloną po zapamiętaniu stanu @p mark.
+ * @param[in] mark : stan areny zwrócony przez ScratchGetMark()
+ */
+void ScratchRelease(ScratchMark mark) {
+    scratch_current = mark.chunk;
+    scratch_used = mark.used;
+}
+
+/**
+ * Zwalnia całą pamięć tymczasową. Wywoływana po wykonaniu każdego polecenia
+ * kalkulatora.
+ */
+void ScratchReset(void) {
+    ScratchRelease((ScratchMark) {.chunk = NULL, .used = 0});
+    // Zwalniamy ponadwymiarowe fragmenty, aby pojedyncze duże polecenie nie
+    // zajmowało pamięci do końca działania programu.
+    ScratchChunk **chunk = &scratch_chunks;
+    while (*chunk != NULL) {
+        if ((*chunk)->size > SCRATCH_CHUNK_SIZE) {
+            ScratchChunk *big = *chunk;
+            *chunk = big->next;
+            free(big);
+        }
+        else {
+            chunk = &(*chunk)->next;
+        }
+    }
+}
@@ -0,0 +1,211 @@
+/** @file
+  Interfejs alokatora tablic jednomianów
+
+  Tablice jednomianów wielomianów przydzielane są z pul bloków o rozmiarach
+  będących potęgami dwójki. Zwolnione bloki trafiają na listę wolnych bloków
+  swojej klasy i są ponownie wykorzystywane, więc w typowym przebiegu
+  obliczeń alokator systemowy wywoływany jest tylko przy tworzeniu nowych
+  płyt (ang. slab). Pamięć tymczasowa, potrzebna jedynie w trakcie
+  wykonywania pojedynczego polecenia, przydzielana jest z areny
+  (ang. scratch arena), którą zwalnia się w całości po wykonaniu polecenia.
+
+  Listy wolnych bloków i arena są lokalne dla wątku, więc alokator może być
+  używany jednocześnie przez wątki puli (patrz: thread_pool.h) bez
+  synchronizacji. Blok zwolniony przez inny wątek niż ten, który go
+  przydzielił, trafia na listę wolnych bloków zwalniającego wątku. Listy
+  wolnych bloków kończącego się wątku trafiają na wspólne listy, z których
+  pozostałe wątki biorą bloki, zanim wytną nowe z płyty.
+
+  @authors Izabela Ożdżeńska <io417924@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#ifndef GAMMA_MONO_ALLOC_H
+#define GAMMA_MONO_ALLOC_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "poly.h"
+
+/**
+ * Rozmiar miejsca, które alokator zostawia bezpośrednio przed każdą tablicą
+ * jednomianów na dane jej właściciela (patrz: MonoArrPrefix()). Jest
+ * wielokrotnością wyrównania typu max_align_t.
+ */
+#define MONO_ARR_PREFIX_SIZE 48
+
+/**
+ * To jest nagłówek bloku poprzedzający tablicę jednomianów.
+ * Tablica jednomianów może być współdzielona przez wiele wielomianów
+ * (patrz: PolyClone()), także przez różne wątki, więc blok przechowuje
+ * atomowy licznik odwołań do niej.
+ */
+typedef struct MonoBlock {
+    size_t size_class;  ///< klasa rozmiaru bloku
+    atomic_size_t refs; ///< liczba odwołań do tablicy jednomianów
+} MonoBlock;
+
+/**
+ * Rozmiar nagłówka bloku razem z miejscem na dane właściciela tablicy,
+ * zaokrąglony tak, aby tablica jednomianów za nim była odpowiednio
+ * wyrównana.
+ */
+#define MONO_BLOCK_HEADER_SIZE \
+    ((sizeof(MonoBlock) + sizeof(max_align_t) - 1) / sizeof(max_align_t) \
+     * sizeof(max_align_t) + MONO_ARR_PREFIX_SIZE)
+
+/**
+ * Daje nagłówek bloku, w którym przechowywana jest tablica jednomianów.
+ * @param[in] arr : tablica jednomianów przydzielona przez MonoArrAlloc()
+ * @return nagłówek bloku
+ */
+static inline MonoBlock* MonoArrBlock(const Mono *arr) {
+    return (MonoBlock*) ((char*) arr - MONO_BLOCK_HEADER_SIZE);
+}
+
+/**
+ * Daje miejsce na dane właściciela tablicy jednomianów, o rozmiarze
+ * @p MONO_ARR_PREFIX_SIZE bajtów. Alokator nie odczytuje tych danych ani ich
+ * nie inicjuje.
+ * @param[in] arr : tablica jednomianów przydzielona przez MonoArrAlloc()
+ * @return wskaźnik na dane właściciela tablicy
+ */
+static inline void* MonoArrPrefix(const Mono *arr) {
+    return (char*) arr - MONO_ARR_PREFIX_SIZE;
+}
+
+/**
+ * Dodaje odwołanie do tablicy jednomianów.
+ * @param[in] arr : tablica jednomianów przydzielona przez MonoArrAlloc()
+ * @return tablica jednomianów @p arr
+ */
+static inline Mono* MonoArrRetain(Mono *arr) {
+    atomic_fetch_add_explicit(&MonoArrBlock(arr)->refs, 1, memory_order_relaxed);
+    return arr;
+}
+
+/**
+ * Usuwa odwołanie do tablicy jednomianów. Jeśli było to ostatnie odwołanie,
+ * wywołujący odpowiada za usunięcie jednomianów i zwolnienie tablicy funkcją
+ * MonoArrFree().
+ * @param[in] arr : tablica jednomianów przydzielona przez MonoArrAlloc()
+ * @return Czy było to ostatnie odwołanie do tablicy?
+ */
+static inline bool MonoArrRelease(Mono *arr) {
+    // Zwalniający tablicę wątek musi widzieć wszystkie zapisy pozostałych
+    // właścicieli, stąd porządek acquire-release.
+    size_t refs = atomic_fetch_sub_explicit(&MonoArrBlock(arr)->refs, 1,
+                                            memory_order_acq_rel);
+    assert(refs > 0);
+    return refs == 1;
+}
+
+/**
+ * Sprawdza, czy tablica jednomianów jest współdzielona przez kilka
+ * wielomianów.
+ * @param[in] arr : tablica jednomianów przydzielona przez MonoArrAlloc()
+ * @return Czy do tablicy jest więcej niż jedno odwołanie?
+ */
+static inline bool MonoArrIsShared(const Mono *arr) {
+    return atomic_load_explicit(&MonoArrBlock(arr)->refs,
+                                memory_order_relaxed) > 1;
+}
+
+/**
+ * Przydziela tablicę mieszczącą co najmniej @p count jednomianów, z jednym
+ * odwołaniem do niej. W przypadku braku pamięci program kończy działanie.
+ * @param[in] count : liczba jednomianów, @f$count > 0@f$
+ * @return wskaźnik na tablicę jednomianów
+ */
+Mono* MonoArrAlloc(size_t count);
+
+/**
+ * Zmniejsza tablicę jednomianów tak, aby mieściła @p count jednomianów.
+ * Jeśli @p count należy do tej samej klasy rozmiaru co tablica, zwraca
+ * tę samą tablicę. W przeciwnym przypadku przenosi pierwsze @p count
+ * jednomianów do mniejszego bloku i zwalnia poprzedni.
+ * @param[in] arr : tablica jednomianów przydzielona przez MonoArrAlloc()
+ * @param[in] count : nowa liczba jednomianów, @f$count > 0@f$
+ * @return wskaźnik na zmniejszoną tablicę jednomianów
+ */
+Mono* MonoArrShrink(Mono *arr, size_t count);
+
+/**
+ * Powiększa tablicę jednomianów tak, aby mieściła @p count jednomianów.
+ * Zachowuje dotychczasową zawartość tablicy.
+ * @param[in] arr : tablica jednomianów przydzielona przez MonoArrAlloc()
+ * @param[in] count : nowa liczba jednomianów
+ * @return wskaźnik na powiększoną tablicę jednomianów
+ */
+Mono* MonoArrGrow(Mono *arr, size_t count);
+
+/**
+ * Zwalnia tablicę jednomianów przydzieloną przez MonoArrAlloc(). Nie zwalnia
+ * jednomianów przechowywanych w tablicy.
+ * @param[in] arr : tablica jednomianów lub NULL
+ */
+void MonoArrFree(Mono *arr);
+
+/**
+ * Daje liczbę tablic jednomianów przydzielonych przez wywołujący wątek
+ * funkcją MonoArrAlloc() (także przy zmianie rozmiaru tablicy) od początku
+ * jego działania. Różnica dwóch odczytów to liczba przydziałów wykonanych
+ * między nimi (patrz: poly_bench.c).
+ * @return liczba przydzielonych tablic jednomianów
+ */
+size_t MonoAllocCount(void);
+
+/**
+ * Zwalnia arenę pamięci tymczasowej wątku i oddaje jego listy wolnych bloków
+ * na wspólne listy, z których korzystają pozostałe wątki. Płyty, z których
+ * pochodzą bloki, pozostają przydzielone, ponieważ bloki mogą być nadal
+ * używane przez inne wątki. Wywoływana przez każdy wątek pomocniczy przed
+ * jego zakończeniem.
+ */
+void MonoAllocThreadExit(void);
+
+/**
+ * Zwalnia całą pamięć przechowywaną przez pule i arenę. Wolno ją wywołać
+ * dopiero wtedy, gdy żadna tablica przydzielona przez MonoArrAlloc() nie jest
+ * już używana, a wszystkie wątki pomocnicze zostały zakończone.
+ */
+void MonoAllocCleanup(void);
+
+/**
+ * To jest struktura przechowująca stan areny pamięci tymczasowej. Pozwala
+ * zwolnić naraz wszystko, co przydzielono z areny po jej zapamiętaniu.
+ */
+typedef struct ScratchMark {
+    struct ScratchChunk *chunk; ///< aktualny fragment areny
+    size_t used;                ///< zajęta część aktualnego fragmentu
+} ScratchMark;
+
+/**
+ * Przydziela @p bytes bajtów pamięci tymczasowej. Pamięć pozostaje ważna do
+ * wywołania ScratchRelease() ze stanem zapamiętanym przed jej przydzieleniem
+ * lub do wywołania ScratchReset().
+ * @param[in] bytes : liczba bajtów
+ * @return wskaźnik na przydzieloną pamięć
+ */
+void* ScratchAlloc(size_t bytes);
+
+/**
+ * Zapamiętuje aktualny stan areny pamięci tymczasowej.
+ * @return stan areny
+ */
+ScratchMark ScratchGetMark(void);
+
+/**
+ * Zwalnia całą pamięć tymczasową przydzieloną po zapamiętaniu stanu @p mark.
+ * @param[in] mark : stan areny zwrócony przez ScratchGetMark()
+ */
+void ScratchRelease(ScratchMark mark);
+
+/**
+ * Zwalnia całą pamięć tymczasową. Wywoływana po wykonaniu każdego polecenia
+ * kalkulatora.
+ */
+void ScratchReset(void);
+
+#endif //GAMMA_MONO_ALLOC_H
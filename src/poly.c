@@ -5,58 +5,502 @@
   @date 2021
 */
 
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include "big_coeff.h"
+#include "mono_alloc.h"
+#include "poly_eval.h"
 #include "poly.h"
+#include "thread_pool.h"
 
 /**
- * Podnosi liczbę rzeczywistą do potęgi naturalnej. W przypadku, gdy
+ * Czy działania biblioteki są zliczane (patrz: PolySetCounting())? Flagę
+ * odczytują także wątki puli, więc jest atomowa.
+ */
+static atomic_bool counting = false;
+/** To jest liczba jednomianów utworzonych wielomianów. */
+static atomic_size_t count_monos;
+/** To jest liczba wywołań PolyMul(). */
+static atomic_size_t count_mul_calls;
+/** To jest liczba sortowań tablic. */
+static atomic_size_t count_sorts;
+
+/**
+ * Włącza lub wyłącza zliczanie działań biblioteki (patrz: PolyCounters).
+ * Liczniki są wspólne dla wszystkich wątków.
+ * @param[in] enabled : czy zliczać działania
+ */
+void PolySetCounting(bool enabled) {
+    atomic_store_explicit(&counting, enabled, memory_order_relaxed);
+}
+
+/**
+ * Daje wartości liczników działań biblioteki zliczonych od początku
+ * działania programu, gdy zliczanie było włączone.
+ * @return liczniki działań
+ */
+PolyCounters PolyGetCounters(void) {
+    return (PolyCounters) {
+        .monos = atomic_load_explicit(&count_monos, memory_order_relaxed),
+        .mul_calls = atomic_load_explicit(&count_mul_calls,
+                                          memory_order_relaxed),
+        .sorts = atomic_load_explicit(&count_sorts, memory_order_relaxed)};
+}
+
+/**
+ * Zwiększa licznik działań, jeśli zliczanie jest włączone. Ani flaga, ani
+ * licznik nie porządkują żadnych innych zapisów, stąd porządek relaxed.
+ * @param[in,out] counter : licznik
+ * @param[in] n : wartość, o którą zwiększany jest licznik
+ */
+static inline void CountOp(atomic_size_t *counter, size_t n) {
+    if (atomic_load_explicit(&counting, memory_order_relaxed)) {
+        atomic_fetch_add_explicit(counter, n, memory_order_relaxed);
+    }
+}
+
+/**
+ * Podnosi liczbę całkowitą do potęgi naturalnej. Wynik, który nie mieści się
+ * w typie poly_coeff_t, jest dużym współczynnikiem. W przypadku, gdy
  * @f$exp < 0@f$, program kończy działanie.
  * @param[in] x : podstawa potęgi @f$x@f$
  * @param[in] exp : wykładnik @f$exp@f$
  * @return @f$x^{exp}@f$
  */
-static poly_coeff_t power(poly_coeff_t x, poly_exp_t exp) {
+static Poly power(poly_coeff_t x, poly_exp_t exp) {
     assert(exp >= 0);
-    if (exp == 0) return 1;
-    if (exp == 1) return x;
+    if (exp == 0) return PolyFromCoeff(1);
+    if (exp == 1) return PolyFromCoeff(x);
+
+    Poly y = power(x, exp / 2);
+    Poly y_squared = CoeffMul(&y, &y);
+    PolyDestroy(&y);
+
+    if (exp % 2 == 0) return y_squared;
+    Poly base = PolyFromCoeff(x);
+    Poly res = CoeffMul(&base, &y_squared);
+    PolyDestroy(&y_squared);
+    return res;
+}
+
+/**
+ * Liczba początkowych zmiennych wielomianu, dla których w nagłówku tablicy
+ * jednomianów zapamiętywany jest stopień wielomianu ze względu na zmienną.
+ */
+#define POLY_META_LEVELS 3
+
+/**
+ * Bit mapy zmiennych oznaczający, że występuje któraś ze zmiennych
+ * o indeksach od 63 wzwyż.
+ */
+#define POLY_META_HIGH_VARS ((uint64_t) 1 << 63)
+
+/**
+ * To jest struktura przechowująca dane wielomianu wyliczane przy jego
+ * tworzeniu z tablicy jednomianów (patrz: PolySetMeta()). Dane wyliczane są
+ * z danych współczynników jednomianów w czasie proporcjonalnym do liczby
+ * jednomianów.
+ */
+typedef struct PolyMeta {
+    size_t terms;       ///< liczba niezerowych współczynników liczbowych
+                        ///< (nasycana do SIZE_MAX)
+    uint64_t vars;      ///< mapa bitowa zmiennych występujących z dodatnim
+                        ///< wykładnikiem; bit 63 to POLY_META_HIGH_VARS
+    poly_exp_t deg;     ///< stopień wielomianu (patrz: PolyDeg())
+    poly_exp_t deg_by[POLY_META_LEVELS]; ///< stopnie wielomianu ze względu
+                                         ///< na kolejne zmienne
+} PolyMeta;
+
+/**
+ * To jest nagłówek tablicy jednomianów wielomianu, przechowywany przez
+ * alokator bezpośrednio przed tablicą (patrz: MonoArrPrefix()). Nagłówek
+ * wypełnia PolySetMeta(), zanim tablica stanie się tablicą wielomianu.
+ * Pola @p hash i @p interned używane są przez tablicę internowania
+ * wielomianów (patrz: PolySetInterning()).
+ */
+typedef struct PolyHeader {
+    size_t hash;        ///< skrót zawartości tablicy (jeśli jest internowana)
+    bool interned;      ///< czy tablica jest w tablicy internowania
+    PolyMeta meta;      ///< dane wielomianu o tej tablicy jednomianów
+} PolyHeader;
+
+_Static_assert(sizeof(PolyHeader) <= MONO_ARR_PREFIX_SIZE,
+               "Nagłówek wielomianu musi mieścić się przed tablicą.");
+
+/**
+ * Daje nagłówek tablicy jednomianów wielomianu.
+ * @param[in] arr : tablica jednomianów wielomianu
+ * @return nagłówek tablicy
+ */
+static inline PolyHeader* ArrHeader(const Mono *arr) {
+    return MonoArrPrefix(arr);
+}
+
+/**
+ * Początkowa pojemność tablicy internowania.
+ */
+#define INTERN_INITIAL_CAPACITY ((size_t) 1 << 10)
+
+/**
+ * To jest struktura przechowująca element tablicy internowania: internowaną
+ * tablicę jednomianów razem z jej rozmiarem.
+ */
+typedef struct InternEntry {
+    Mono *arr;   ///< internowana tablica jednomianów lub NULL
+    size_t size; ///< liczba jednomianów w tablicy
+} InternEntry;
+
+/**
+ * To jest struktura przechowująca tablicę internowania (ang. hash-consing).
+ * Przechowuje dokładnie jedną tablicę jednomianów dla każdego internowanego
+ * wielomianu niebędącego współczynnikiem. Tablica internowania nie posiada
+ * odwołań do przechowywanych tablic jednomianów - tablica jednomianów jest
+ * z niej usuwana, gdy znika ostatnie odwołanie do niej. Wykorzystuje
+ * adresowanie otwarte z liniowym próbkowaniem.
+ */
+typedef struct InternTable {
+    atomic_bool enabled;   ///< czy nowe wielomiany są internowane; flagę
+                           ///< odczytują bez blokady także wątki puli
+    InternEntry *entries;  ///< elementy tablicy
+    size_t capacity;       ///< pojemność tablicy, potęga dwójki
+    size_t count;          ///< liczba zajętych elementów
+} InternTable;
+
+/** To jest tablica internowania wielomianów. */
+static InternTable intern_table;
+/** To jest blokada tablicy internowania (wielomiany tworzą też wątki puli). */
+static pthread_mutex_t intern_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Włącza lub wyłącza internowanie wielomianów. Gdy internowanie jest włączone,
+ * każdy tworzony wielomian niebędący współczynnikiem, którego wszystkie
+ * współczynniki są internowane, jest zastępowany równym mu, już istniejącym
+ * wielomianem (o ile taki istnieje). Równe internowane wielomiany współdzielą
+ * więc tablicę jednomianów, a ich porównanie sprowadza się do porównania
+ * wskaźników.
+ * @param[in] enabled : czy włączyć internowanie
+ */
+void PolySetInterning(bool enabled) {
+    atomic_store_explicit(&intern_table.enabled, enabled,
+                          memory_order_relaxed);
+}
+
+/**
+ * Sprawdza, czy tablica jednomianów wielomianu jest w tablicy internowania.
+ * @param[in] p : wielomian
+ * @return Czy wielomian jest internowany?
+ */
+bool PolyIsInterned(const Poly *p) {
+    return !PolyIsCoeff(p) && ArrHeader(p->arr)->interned;
+}
+
+/**
+ * Ustawia moduł, modulo który liczone są współczynniki wielomianów
+ * (patrz: mod_arith.h). Istniejące wielomiany trzeba zredukować funkcją
+ * PolyReduce().
+ * @param[in] mod : moduł z przedziału @f$[2, MOD\_MAX]@f$ lub 0, aby
+ * przywrócić obliczenia dokładne
+ * @return Czy moduł jest poprawny?
+ */
+bool PolySetModulus(poly_coeff_t mod) {
+    return ModSetModulus(mod);
+}
+
+/**
+ * Łączy skrót z kolejną wartością.
+ * @param[in] hash : skrót
+ * @param[in] value : wartość
+ * @return nowy skrót
+ */
+static inline size_t HashCombine(size_t hash, size_t value) {
+    return hash ^ (value + (size_t) 0x9e3779b97f4a7c15ULL + (hash << 6)
+                   + (hash >> 2));
+}
 
-    poly_coeff_t y = power(x, exp / 2);
-    y = y * y;
+/**
+ * Sprawdza, czy tablica jednomianów może zostać internowana, czyli czy
+ * wszystkie jej współczynniki niebędące liczbami są internowane, i wylicza
+ * skrót jej zawartości. Skrót zależy jedynie od struktury wielomianu.
+ * @param[in] arr : tablica jednomianów
+ * @param[in] size : liczba jednomianów
+ * @param[out] hash : skrót zawartości tablicy
+ * @return Czy tablica może zostać internowana?
+ */
+static bool InternHash(const Mono arr[], size_t size, size_t *hash) {
+    size_t h = size;
+    for (size_t i = 0; i < size; i++) {
+        h = HashCombine(h, (size_t) arr[i].exp);
+        if (PolyIsCoeff(&arr[i].p)) {
+            h = HashCombine(h, CoeffHash(&arr[i].p));
+        }
+        else {
+            const PolyHeader *child = ArrHeader(arr[i].p.arr);
+            if (!child->interned) return false;
+            h = HashCombine(h, ~child->hash);
+        }
+    }
+    *hash = h;
+    return true;
+}
+
+/**
+ * Sprawdza, czy dwie tablice jednomianów, których współczynniki są
+ * internowane, reprezentują równe wielomiany. Wystarczy porównać wykładniki
+ * oraz współczynniki: liczby (także duże) wartościami, a wielomiany
+ * wskaźnikami.
+ * @param[in] a : tablica jednomianów
+ * @param[in] b : tablica jednomianów
+ * @param[in] size : liczba jednomianów każdej z tablic
+ * @return Czy tablice reprezentują równe wielomiany?
+ */
+static bool InternShallowEq(const Mono a[], const Mono b[], size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        if (a[i].exp != b[i].exp) return false;
+        if (PolyIsCoeff(&a[i].p)) {
+            if (!PolyIsCoeff(&b[i].p) || !CoeffIsEq(&a[i].p, &b[i].p)) {
+                return false;
+            }
+        }
+        else if (a[i].p.arr != b[i].p.arr) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Wstawia element do tablicy internowania, nie zmieniając jej pojemności.
+ * @param[in] entry : element
+ */
+static void InternInsert(InternEntry entry) {
+    size_t mask = intern_table.capacity - 1;
+    size_t idx = ArrHeader(entry.arr)->hash & mask;
+    while (intern_table.entries[idx].arr != NULL) idx = (idx + 1) & mask;
+    intern_table.entries[idx] = entry;
+    intern_table.count++;
+}
+
+/**
+ * Powiększa tablicę internowania dwukrotnie (lub tworzy ją, jeśli nie
+ * istnieje).
+ */
+static void InternGrow(void) {
+    InternEntry *old_entries = intern_table.entries;
+    size_t old_capacity = intern_table.capacity;
+    intern_table.capacity = old_capacity == 0 ?
+                            INTERN_INITIAL_CAPACITY : 2 * old_capacity;
+    intern_table.entries = calloc(intern_table.capacity, sizeof(InternEntry));
+    if (intern_table.entries == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    intern_table.count = 0;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_entries[i].arr != NULL) InternInsert(old_entries[i]);
+    }
+    free(old_entries);
+}
+
+/**
+ * Zastępuje nowo utworzoną tablicę jednomianów równą jej tablicą z tablicy
+ * internowania albo wstawia ją do tablicy internowania, jeśli takiej nie ma.
+ * Jeśli internowanie jest wyłączone lub tablica nie może zostać internowana,
+ * zwraca ją bez zmian.
+ * @param[in] arr : tablica jednomianów, do której jest jedno odwołanie
+ * @param[in] size : liczba jednomianów
+ * @return tablica jednomianów równa @p arr
+ */
+static Mono* Intern(Mono *arr, size_t size) {
+    size_t hash;
+    // Flaga nie porządkuje innych zapisów - tablicę chroni blokada.
+    if (!atomic_load_explicit(&intern_table.enabled, memory_order_relaxed) ||
+        !InternHash(arr, size, &hash)) {
+        return arr;
+    }
+    pthread_mutex_lock(&intern_lock);
+    if (2 * (intern_table.count + 1) > intern_table.capacity) InternGrow();
 
-    if (exp % 2 == 0) return y;
-    else return x * y;
+    Mono *found = NULL;
+    size_t mask = intern_table.capacity - 1;
+    for (size_t idx = hash & mask; intern_table.entries[idx].arr != NULL;
+         idx = (idx + 1) & mask) {
+        InternEntry entry = intern_table.entries[idx];
+        if (entry.size == size && ArrHeader(entry.arr)->hash == hash &&
+            InternShallowEq(entry.arr, arr, size)) {
+            found = MonoArrRetain(entry.arr);
+            break;
+        }
+    }
+    if (found == NULL) {
+        PolyHeader *header = ArrHeader(arr);
+        header->hash = hash;
+        header->interned = true;
+        InternInsert((InternEntry) {.arr = arr, .size = size});
+    }
+    pthread_mutex_unlock(&intern_lock);
+    if (found == NULL) return arr;
+
+    // Usuwanie jednomianów może zwalniać internowane tablice, więc odbywa się
+    // poza blokadą.
+    for (size_t i = 0; i < size; i++) {
+        MonoDestroy(&arr[i]);
+    }
+    MonoArrFree(arr);
+    return found;
+}
+
+/**
+ * Usuwa tablicę jednomianów z tablicy internowania. Elementy następujące po
+ * usuniętym są przesuwane, aby nie przerwać ciągów próbkowania.
+ * @param[in] arr : internowana tablica jednomianów
+ */
+static void InternRemove(Mono *arr) {
+    size_t mask = intern_table.capacity - 1;
+    size_t idx = ArrHeader(arr)->hash & mask;
+    while (intern_table.entries[idx].arr != arr) idx = (idx + 1) & mask;
+    intern_table.count--;
+    for (size_t next = (idx + 1) & mask; intern_table.entries[next].arr != NULL;
+         next = (next + 1) & mask) {
+        size_t home = ArrHeader(intern_table.entries[next].arr)->hash & mask;
+        // Element może zająć zwolnione miejsce, jeśli jego pozycja docelowa
+        // nie leży (cyklicznie) pomiędzy zwolnionym miejscem a nim samym.
+        if (((next - home) & mask) >= ((next - idx) & mask)) {
+            intern_table.entries[idx] = intern_table.entries[next];
+            idx = next;
+        }
+    }
+    intern_table.entries[idx].arr = NULL;
+    ArrHeader(arr)->interned = false;
+    if (intern_table.count == 0) {
+        free(intern_table.entries);
+        intern_table.entries = NULL;
+        intern_table.capacity = 0;
+    }
+}
+
+/**
+ * Usuwa odwołanie do internowanej tablicy jednomianów. Jeśli było to ostatnie
+ * odwołanie, usuwa tablicę z tablicy internowania. Obie czynności wykonywane
+ * są pod blokadą, aby inny wątek nie znalazł w tablicy internowania tablicy
+ * jednomianów, która jest właśnie zwalniana.
+ * @param[in] arr : internowana tablica jednomianów
+ * @return Czy było to ostatnie odwołanie do tablicy?
+ */
+static bool InternRelease(Mono *arr) {
+    pthread_mutex_lock(&intern_lock);
+    bool last = MonoArrRelease(arr);
+    if (last) InternRemove(arr);
+    pthread_mutex_unlock(&intern_lock);
+    return last;
 }
 
 /**
- * Usuwa wielomian z pamięci.
+ * Usuwa wielomian z pamięci. Tablica jednomianów wielomianu może być
+ * współdzielona z innymi wielomianami, więc usuwane jest jedynie odwołanie do
+ * niej. Tablica jest zwalniana razem z zawartością, gdy było to ostatnie
+ * odwołanie.
  * @param[in] p : wielomian
  */
 void PolyDestroy(Poly *p) {
     assert(p != NULL);
     // Nie było zaalokowanej pamięci, więc nie ma nic do zwolnienia.
-    if (PolyIsCoeff(p)) return;
+    if (p->arr == NULL) return;
+    if (PolyIsBigCoeff(p)) {
+        BigCoeffDestroy(p);
+        return;
+    }
+    if (ArrHeader(p->arr)->interned) {
+        if (!InternRelease(p->arr)) return;
+    }
+    else if (!MonoArrRelease(p->arr)) {
+        return;
+    }
     for (size_t i = 0; i < p->size; i++) {
         MonoDestroy(&p->arr[i]);
     }
-    free(p->arr);
+    MonoArrFree(p->arr);
 }
 
 /**
- * Robi pełną, głęboką kopię wielomianu.
+ * Robi kopię wielomianu. Tablice jednomianów są modyfikowane po utworzeniu
+ * wielomianu tylko przez funkcje przejmujące wielomian na własność i tylko
+ * wtedy, gdy nikt inny się do nich nie odwołuje (patrz: PolyAddOwn()), więc
+ * kopia współdzieli tablicę jednomianów z oryginałem, a jej wykonanie
+ * zwiększa jedynie licznik odwołań do tablicy.
  * @param[in] p : wielomian
  * @return skopiowany wielomian
  */
 Poly PolyClone(const Poly *p) {
     assert(p != NULL);
-    if (PolyIsCoeff(p)) return *p;
+    if (p->arr == NULL) return *p;
+    if (PolyIsBigCoeff(p)) return BigCoeffClone(p);
+    return (Poly) {.size = p->size, .arr = MonoArrRetain(p->arr)};
+}
 
-    Poly q = (Poly) {.size = p->size};
-    q.arr = malloc(p->size * sizeof(Mono));
-    if (q.arr == NULL) exit(1); // Błąd podczas alokacji pamięci.
-    for (size_t i = 0; i < p->size; i++) {
-        q.arr[i] = MonoClone(&p->arr[i]);
+/**
+ * Daje dane wielomianu niebędącego współczynnikiem, zapamiętane w nagłówku
+ * jego tablicy jednomianów.
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @return dane wielomianu
+ */
+static inline const PolyMeta* PolyGetMeta(const Poly *p) {
+    assert(!PolyIsCoeff(p));
+    return &ArrHeader(p->arr)->meta;
+}
+
+/**
+ * Sprawdza, czy w mapie zmiennych jest zmienna o zadanym indeksie. Dla
+ * indeksów od 63 wzwyż odpowiedź może być fałszywie pozytywna.
+ * @param[in] vars : mapa bitowa zmiennych (patrz: PolyMeta)
+ * @param[in] var_idx : indeks zmiennej
+ * @return Czy zmienna może występować?
+ */
+static inline bool MetaHasVar(uint64_t vars, size_t var_idx) {
+    if (var_idx >= 63) return (vars & POLY_META_HIGH_VARS) != 0;
+    return (vars >> var_idx & 1) != 0;
+}
+
+/**
+ * Wylicza dane wielomianu z danych współczynników jego jednomianów
+ * i zapisuje je w nagłówku tablicy jednomianów. Tablica nie jest jeszcze
+ * internowana.
+ * @param[in,out] arr : lista jednomianów
+ * @param[in] size : liczba jednomianów
+ */
+static void PolySetMeta(Mono arr[], size_t size) {
+    CountOp(&count_monos, size);
+    PolyMeta meta = {.terms = 0, .vars = 0, .deg = -1};
+    for (size_t l = 0; l < POLY_META_LEVELS; l++) meta.deg_by[l] = -1;
+    // Dane niezerowego współczynnika liczbowego.
+    PolyMeta coeff_meta = {.terms = 1, .vars = 0, .deg = 0};
+    for (size_t i = 0; i < size; i++) {
+        const Poly *p = &arr[i].p;
+        if (PolyIsZero(p)) continue;
+        const PolyMeta *child = PolyIsCoeff(p) ? &coeff_meta : PolyGetMeta(p);
+        poly_exp_t exp = arr[i].exp;
+        meta.terms = child->terms > SIZE_MAX - meta.terms ?
+                     SIZE_MAX : meta.terms + child->terms;
+        // Zmienne współczynnika mają indeksy większe o jeden.
+        meta.vars |= child->vars << 1;
+        if ((child->vars & (POLY_META_HIGH_VARS | POLY_META_HIGH_VARS >> 1))
+            != 0) {
+            meta.vars |= POLY_META_HIGH_VARS;
+        }
+        if (exp > 0) meta.vars |= 1;
+        // Stopień jednomianu może przekroczyć zakres poly_exp_t, więc jest
+        // nasycany do INT_MAX.
+        poly_exp_t deg = child->deg > INT_MAX - exp ? INT_MAX
+                                                    : child->deg + exp;
+        if (deg > meta.deg) meta.deg = deg;
+        if (exp > meta.deg_by[0]) meta.deg_by[0] = exp;
+        for (size_t l = 1; l < POLY_META_LEVELS; l++) {
+            if (child->deg_by[l - 1] > meta.deg_by[l]) {
+                meta.deg_by[l] = child->deg_by[l - 1];
+            }
+        }
     }
-    return q;
+    *ArrHeader(arr) = (PolyHeader) {.hash = 0, .interned = false,
+                                    .meta = meta};
 }
 
 /**
@@ -69,9 +513,10 @@ static Poly ExtendPoly(const Poly *p) {
     assert(p != NULL);
     assert(PolyIsCoeff(p));
     assert(!PolyIsZero(p));
-    Poly p_mod = (Poly) {.size = 1, .arr = malloc(sizeof(Mono))};
-    if (p_mod.arr == NULL) exit(1); // Błąd podczas alokacji pamięci.
-    p_mod.arr[0] = MonoFromPoly(p, 0);
+    Poly p_mod = (Poly) {.size = 1, .arr = MonoArrAlloc(1)};
+    Poly coeff = PolyClone(p);
+    p_mod.arr[0] = MonoFromPoly(&coeff, 0);
+    PolySetMeta(p_mod.arr, 1);
     return p_mod;
 }
 
@@ -113,7 +558,9 @@ static Poly PolyFromArr(Mono arr[], size_t size) {
 /**
  * Tworzy wielomian z listy jednomianów. Jeśli suma jednomianów z @p arr
  * redukuje się do wielomianu będącego współczynnikiem, zwraca ów współczynnik.
- * W przeciwnym wypadku zwraca wielomian z zadanymi parametrami @p arr i @p size.
+ * W przeciwnym wypadku zwraca wielomian z zadanymi parametrami @p arr i @p size
+ * (lub równy mu wielomian z tablicy internowania), wyliczając jego dane
+ * (patrz: PolyMeta).
  * @param[in] arr : lista jednomianów
  * @param[in] size : liczba jednomianów
  * @return jeśli suma jednomianów z @p arr redukuje się do współczynnika
@@ -126,18 +573,42 @@ static Poly PolyFromArrSimplify(Mono arr[], size_t size) {
     Poly res;
     if (size == 0) {
         res = PolyZero();
-        free(arr);
+        MonoArrFree(arr);
     }
     else if (size == 1 && arr[0].exp == 0 && PolyIsCoeff(&arr[0].p)) {
         res = arr[0].p;
-        free(arr);
+        MonoArrFree(arr);
     }
     else {
-        res = PolyFromArr(arr, size);
+        // Dane wyliczane są przed internowaniem, bo tablicę z tablicy
+        // internowania mogą od razu odczytywać inne wątki.
+        PolySetMeta(arr, size);
+        res = PolyFromArr(Intern(arr, size), size);
     }
     return res;
 }
 
+/**
+ * Redukuje współczynniki wielomianu modulo ustawiony moduł. Jeśli moduł nie
+ * jest ustawiony, zwraca kopię wielomianu.
+ * @param[in] p : wielomian
+ * @return wielomian @p p o współczynnikach zredukowanych modulo
+ */
+Poly PolyReduce(const Poly *p) {
+    assert(p != NULL);
+    if (!ModEnabled()) return PolyClone(p);
+    if (PolyIsCoeff(p)) return PolyFromCoeff(BigCoeffMod(p));
+    Mono *arr = MonoArrAlloc(p->size);
+    size_t arr_size = 0;
+    for (size_t i = 0; i < p->size; i++) {
+        Poly coeff = PolyReduce(&p->arr[i].p);
+        if (PolyIsZero(&coeff)) continue;
+        arr[arr_size++] = MonoFromPoly(&coeff, p->arr[i].exp);
+    }
+    if (arr_size != 0) arr = MonoArrShrink(arr, arr_size);
+    return PolyFromArrSimplify(arr, arr_size);
+}
+
 /**
  * Zwraca sumę jednomianów @p m1 i @p m2, jeśli mają te same wykładniki lub
  * jednomian o większym wykładniku w przeciwnym wypadku. Przesuwa indeksy @p idx1
@@ -198,8 +669,7 @@ static Poly PolyAddNonCoeffs(const Poly *p, const Poly *q) {
     /**
      * To jest tablica, która będzie przechowywała zsumowane jednomiany.
      */
-    Mono *arr = malloc((p->size + q->size) * sizeof(Mono));
-    if (arr == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    Mono *arr = MonoArrAlloc(p->size + q->size);
     size_t arr_size = 0, p_idx = 0, q_idx = 0;
     poly_exp_t p_exp, q_exp;
     Mono p_mono, q_mono;
@@ -215,8 +685,7 @@ static Poly PolyAddNonCoeffs(const Poly *p, const Poly *q) {
         }
     }
 
-    if (arr_size != 0) arr = realloc(arr, arr_size * sizeof(Mono));
-    if (arr == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    if (arr_size != 0) arr = MonoArrShrink(arr, arr_size);
     Poly res = PolyFromArrSimplify(arr, arr_size);
     return res;
 }
@@ -230,7 +699,7 @@ static Poly PolyAddNonCoeffs(const Poly *p, const Poly *q) {
 Poly PolyAdd(const Poly *p, const Poly *q) {
     assert(p != NULL && q != NULL);
     if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
-        return PolyFromCoeff(p->coeff + q->coeff);
+        return CoeffAdd(p, q);
     }
     else if (PolyIsCoeff(p)) {
         if (PolyIsZero(p)) return PolyClone(q);
@@ -313,7 +782,8 @@ static void RemoveMonos(Mono *monos, size_t monos_size, const size_t remove[],
  */
 static void RemoveZeros(Mono *monos, size_t count, size_t *new_size) {
     assert(count != 0);
-    size_t remove[count];
+    ScratchMark mark = ScratchGetMark();
+    size_t *remove = ScratchAlloc(count * sizeof(size_t));
     size_t remove_size = 0;
     for (size_t i = 0; i < count; i++) {
         if (PolyIsZero(&monos[i].p)) {
@@ -326,72 +796,104 @@ static void RemoveZeros(Mono *monos, size_t count, size_t *new_size) {
     // do zwolnienia.
     RemoveMonos(monos, count, remove, remove_size, true);
     *new_size = count - remove_size;
+    ScratchRelease(mark);
 }
 
 /**
  * Sumuje jednomiany o tych samych potęgach, aktualizując listę jednomianów.
  * Zaktualizowana lista jednomianów sumuje się do tego samego wielomianu, co
  * początkowa lista jednomianów. Wykładniki jednomianów w zaktualizowanej liście
- * nie powtarzają się. Jeśli @p clone @f$=@f$ <false>, usuwa niepotrzebne
- * jednomiany z pamięci.
+ * nie powtarzają się. Usuwa niepotrzebne jednomiany z pamięci.
  * @param[in,out] monos : lista jednomianów
  * @param[in] count : wielkość listy jednomianów
  * @param[out] new_size : wielkość tablicy jednomianów po złączeniu potęg
- * @param[in] clone : określa czy usuwane z @p monos jednomiany mają być
- * zachowane w pamięci - jeśli równy <false> - usuwa te jednomiany z pamięci
  */
-static void JoinExponents(Mono *monos, size_t count, size_t *new_size,
-                          bool clone) {
+static void JoinExponents(Mono *monos, size_t count, size_t *new_size) {
     assert(count != 0);
-    size_t remove[count], remove_size = 0;
-    size_t last_same = -1; // To jest ostatnia pozycja, na której wykładnik się
-    // powtórzył.
-    if (clone && count == 1) monos[0] = MonoClone(&monos[0]);
+    ScratchMark mark = ScratchGetMark();
+    size_t *remove = ScratchAlloc(count * sizeof(size_t)), remove_size = 0;
     for (size_t i = 1; i < count; i++) {
         // Równe wykładniki mogą znajdować się tylko na sąsiednich pozycjach,
         // ponieważ tablica [monos] jest posortowana.
         if (monos[i].exp == monos[i - 1].exp) {
             Poly add = PolyAdd(&monos[i].p, &monos[i - 1].p);
-            if (!clone || last_same == i - 1) MonoDestroy(&monos[i]);
-            last_same = i;
+            MonoDestroy(&monos[i]);
             // Jednomian na większej pozycji staje się sumą dwóch jednomianów.
             monos[i].p = add;
             // Jednomian na mniejszej pozycji zostaje usunięty.
             remove[remove_size] = i - 1;
             remove_size++;
         }
-        else if (clone) {
-            if (last_same != i - 1) monos[i - 1] = MonoClone(&monos[i - 1]);
-            if (i == count - 1) monos[i] = MonoClone(&monos[i]);
-        }
     }
-    RemoveMonos(monos, count, remove, remove_size, clone);
+    RemoveMonos(monos, count, remove, remove_size, false);
     *new_size = count - remove_size;
+    ScratchRelease(mark);
+}
+
+/**
+ * Sprawdza, czy wykładniki jednomianów z listy są ściśle rosnące.
+ * @param[in] monos : lista jednomianów
+ * @param[in] count : wielkość listy jednomianów
+ * @return Czy wykładniki są ściśle rosnące?
+ */
+static bool MonosAscending(const Mono monos[], size_t count) {
+    for (size_t i = 1; i < count; i++) {
+        if (monos[i - 1].exp >= monos[i].exp) return false;
+    }
+    return true;
+}
+
+/**
+ * Sprawdza, czy wykładniki jednomianów z listy są nierosnące.
+ * @param[in] monos : lista jednomianów
+ * @param[in] count : wielkość listy jednomianów
+ * @return Czy wykładniki są nierosnące?
+ */
+static bool MonosDescending(const Mono monos[], size_t count) {
+    for (size_t i = 1; i < count; i++) {
+        if (monos[i - 1].exp < monos[i].exp) return false;
+    }
+    return true;
+}
+
+/**
+ * Odwraca kolejność jednomianów na liście.
+ * @param[in,out] monos : lista jednomianów
+ * @param[in] count : wielkość listy jednomianów
+ */
+static void ReverseMonos(Mono monos[], size_t count) {
+    for (size_t i = 0, j = count; i + 1 < j; i++, j--) {
+        Mono temp = monos[i];
+        monos[i] = monos[j - 1];
+        monos[j - 1] = temp;
+    }
 }
 
 /**
  * Sumuje listę jednomianów i tworzy z nich wielomian. Przejmuje na własność
- * pamięć wskazywaną przez @p monos. Jeśli @p clone @f$=@f$ <true>, nie
- * modyfikuje zawartości tablicy @p monos i jeśli jest to wymagane, wykonuje
- * pełne kopie jednomianów z tablicy @p monos. Jeśli @p clone @f$=@f$ <false>,
- * przejmuje na własność zawartość tablicy @p monos i może dowolnie modyfikować
- * zawartość tej pamięci.
+ * pamięć wskazywaną przez @p monos, przydzieloną przez MonoArrAlloc(), oraz
+ * jej zawartość i może dowolnie modyfikować zawartość tej pamięci.
  * @param[in] count : liczba jednomianów
  * @param[in] monos : tablica jednomianów
- * @param[in] clone : określa czy zawartość tablicy @p monos jest przejmowana
- * na własność - jeśli <true> - nie jest przejmowana na własność
  * @return wielomian będący sumą jednomianów
  */
-static Poly PolyFromMonos(size_t count, Mono *monos, bool clone) {
+static Poly PolyFromMonos(size_t count, Mono *monos) {
     size_t new_count;
-    // Lista jednomianów jest sortowana malejąco względem wykładników.
-    qsort(monos, count, sizeof(Mono), CompareMonos);
+    // Lista jednomianów jest sortowana malejąco względem wykładników, chyba
+    // że jest już uporządkowana (np. wczytana z wyniku polecenia PRINT).
+    if (MonosAscending(monos, count)) ReverseMonos(monos, count);
+    else if (!MonosDescending(monos, count)) {
+        CountOp(&count_sorts, 1);
+        qsort(monos, count, sizeof(Mono), CompareMonos);
+    }
 
-    JoinExponents(monos, count, &new_count, clone);
+    JoinExponents(monos, count, &new_count);
     assert(new_count != 0);
     count = new_count;
 
     RemoveZeros(monos, count, &new_count);
+    // Oddajemy do puli nadmiarową część tablicy.
+    if (new_count != 0) monos = MonoArrShrink(monos, new_count);
 
     Poly res = PolyFromArrSimplify(monos, new_count);
     return res;
@@ -399,22 +901,16 @@ static Poly PolyFromMonos(size_t count, Mono *monos, bool clone) {
 
 /**
  * Sumuje listę jednomianów i tworzy z nich wielomian. Przejmuje na własność
- * pamięć wskazywaną przez @p monos i jej zawartość. Może dowolnie modyfikować
- * zawartość tej pamięci. Zakładamy, że pamięć wskazywana przez @p monos
- * została zaalokowana na stercie. Jeśli @p count lub @p monos jest równe zeru
- * (NULL), tworzy wielomian tożsamościowo równy zeru.
- * @param[in] count : liczba jednomianów
- * @param[in] monos : tablica jednomianów
+ * tablicę @p arr, przydzieloną przez MonoArrAlloc(), oraz jej zawartość
+ * i może dowolnie modyfikować tę tablicę. Tablica staje się tablicą
+ * jednomianów wyniku bez kopiowania.
+ * @param[in] count : liczba jednomianów, większa od zera
+ * @param[in] arr : tablica jednomianów
  * @return wielomian będący sumą jednomianów
  */
-Poly PolyOwnMonos(size_t count, Mono *monos) {
-    if (count == 0 || !monos) {
-        free(monos);
-        return PolyZero();
-    }
-    else {
-        return PolyFromMonos(count, monos, false);
-    }
+Poly PolyArrMonos(size_t count, Mono *arr) {
+    assert(count > 0 && arr != NULL);
+    return PolyFromMonos(count, arr);
 }
 
 /**
@@ -427,11 +923,10 @@ Poly PolyOwnMonos(size_t count, Mono *monos) {
 Poly PolyAddMonos(size_t count, const Mono monos[]) {
     assert(count == 0 || monos != NULL);
     if (count == 0) return PolyZero();
-    Mono *new_monos = malloc(count * sizeof(Mono));
-    if (!new_monos) exit(1); // Błąd podczas alokacji pamięci.
+    Mono *new_monos = MonoArrAlloc(count);
     CopyMonos(new_monos, monos, count);
 
-    return PolyOwnMonos(count, new_monos);
+    return PolyFromMonos(count, new_monos);
 }
 
 /**
@@ -447,358 +942,3528 @@ Poly PolyCloneMonos(size_t count, const Mono monos[]) {
     if (count == 0 || !monos) {
         return PolyZero();
     }
-    Mono *new_monos = malloc(count * sizeof(Mono));
-    if (!new_monos) exit(1); // Błąd podczas alokacji pamięci.
-    CopyMonos(new_monos, monos, count);
+    // Kopie jednomianów współdzielą tablice jednomianów z oryginałami, więc
+    // ich wykonanie nie wymaga kopiowania całych wielomianów.
+    Mono *new_monos = MonoArrAlloc(count);
+    for (size_t i = 0; i < count; i++) {
+        new_monos[i] = MonoClone(&monos[i]);
+    }
 
-    return PolyFromMonos(count, new_monos, true);
+    return PolyFromMonos(count, new_monos);
 }
 
 /**
- * Mnoży dwa wielomiany.
- * @param[in] p : wielomian @f$p@f$
- * @param[in] q : wielomian @f$q@f$
- * @return @f$p * q@f$
+ * To jest struktura przechowująca element kopca używanego przy mnożeniu
+ * wielomianów. Element reprezentuje iloczyn jednomianów @p p->arr[p_idx]
+ * i @p q->arr[q_idx].
  */
-Poly PolyMul(const Poly *p, const Poly *q) {
-    assert(p != NULL && q != NULL);
-    if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
-        return PolyFromCoeff(p->coeff * q->coeff);
-    }
-    else if (PolyIsCoeff(p)) {
-        if (PolyIsZero(p)) return PolyZero();
-        Poly p_extended = ExtendPoly(p);
-        Poly res = PolyMul(&p_extended, q);
-        PolyDestroy(&p_extended);
-        return res;
-    }
-    else if (PolyIsCoeff(q)) {
-        return PolyMul(q, p);
-    }
-    else {
-        Mono monos[p->size * q->size];
-        // Mnożymy każdy jednomian z [p->arr] z każdym jednomianem z [q->arr]
-        // i dodajemy do siebie wyniki mnożeń.
-        for (size_t i = 0; i < p->size; i++) {
-            for (size_t j = 0; j < q->size; j++) {
-                Poly curr_p = p->arr[i].p, curr_q = q->arr[j].p;
-                Poly poly_mul = PolyMul(&curr_p, &curr_q);
-                poly_exp_t exp_add = p->arr[i].exp + q->arr[j].exp;
-                if (PolyIsZero(&poly_mul)) {
-                    monos[i * q->size + j] = MonoFromPoly(&poly_mul, 0);
-                }
-                else {
-                    monos[i * q->size + j] = MonoFromPoly(&poly_mul, exp_add);
-                }
-            }
-        }
-        return PolyAddMonos(p->size * q->size, monos);
-    }
-}
+typedef struct MulHeapNode {
+    poly_exp_t exp; ///< wykładnik iloczynu jednomianów
+    size_t p_idx;   ///< indeks jednomianu wielomianu @f$p@f$
+    size_t q_idx;   ///< indeks jednomianu wielomianu @f$q@f$
+} MulHeapNode;
 
 /**
- * Zwraca przeciwny wielomian.
- * @param[in] p : wielomian @f$p@f$
- * @return @f$-p@f$
+ * Wstawia element do kopca (typu max względem wykładników).
+ * @param[in,out] heap : kopiec
+ * @param[in,out] heap_size : liczba elementów kopca
+ * @param[in] node : wstawiany element
  */
-Poly PolyNeg(const Poly *p) {
-    assert(p != NULL);
-    Poly neg = PolyFromCoeff(-1);
-    return PolyMul(p, &neg);
+static void MulHeapPush(MulHeapNode heap[], size_t *heap_size,
+                        MulHeapNode node) {
+    size_t idx = (*heap_size)++;
+    while (idx > 0 && heap[(idx - 1) / 2].exp < node.exp) {
+        heap[idx] = heap[(idx - 1) / 2];
+        idx = (idx - 1) / 2;
+    }
+    heap[idx] = node;
 }
 
 /**
- * Odejmuje wielomian od wielomianu.
- * @param[in] p : wielomian @f$p@f$
- * @param[in] q : wielomian @f$q@f$
- * @return @f$p - q@f$
+ * Usuwa z kopca element o największym wykładniku i go zwraca.
+ * @param[in,out] heap : niepusty kopiec
+ * @param[in,out] heap_size : liczba elementów kopca
+ * @return element o największym wykładniku
  */
-Poly PolySub(const Poly *p, const Poly *q) {
-    assert(p != NULL && q != NULL);
-    Poly q_neg = PolyNeg(q);
-    Poly res = PolyAdd(p, &q_neg);
-    PolyDestroy(&q_neg);
-    return res;
+static MulHeapNode MulHeapPop(MulHeapNode heap[], size_t *heap_size) {
+    assert(*heap_size > 0);
+    MulHeapNode top = heap[0], last = heap[--(*heap_size)];
+    size_t idx = 0, child;
+    while ((child = 2 * idx + 1) < *heap_size) {
+        if (child + 1 < *heap_size && heap[child + 1].exp > heap[child].exp) {
+            child++;
+        }
+        if (heap[child].exp <= last.exp) break;
+        heap[idx] = heap[child];
+        idx = child;
+    }
+    heap[idx] = last;
+    return top;
 }
 
 /**
- * Zwraca stopień wielomianu ze względu na zadaną zmienną (-1 dla wielomianu
- * tożsamościowo równego zeru). Zmienne indeksowane są od @p depth.
- * @param[in] p : wielomian
- * @param[in] var_idx : indeks zmiennej
- * @return stopień wielomianu @p p z względu na zmienną o indeksie @p var_idx
+ * Mnoży dwa wielomiany niebędące współczynnikami. Iloczyny jednomianów
+ * generowane są w kolejności malejących wykładników za pomocą kopca
+ * zawierającego co najwyżej jeden iloczyn dla każdego jednomianu @p p
+ * (algorytm Johnsona), a iloczyny o równych wykładnikach są od razu sumowane.
+ * Dzięki temu wynik nie wymaga sortowania, a dodatkowa pamięć jest
+ * proporcjonalna do liczby jednomianów @p p i wyniku. Wielomian @p p może
+ * być fragmentem tablicy jednomianów innego wielomianu.
+ * @param[in] p : wielomian @f$p@f$ niebędący współczynnikiem
+ * @param[in] q : wielomian @f$q@f$ niebędący współczynnikiem
+ * @return @f$p * q@f$
  */
-static poly_exp_t PolyDegByHelper(const Poly *p, size_t var_idx, size_t depth) {
-    if (PolyIsCoeff(p)) {
-        if (PolyIsZero(p)) return -1;
-        else return 0;
-    }
-    else if (depth == var_idx) {
-        // Tablica [p->arr] przechowuje jednomian o największym wykładniku na
-        // pozycji 0, ponieważ jest posortowana malejąco względem wykładników.
-        return p->arr[0].exp;
-    }
-    else {
-        // Stopień wielomianu ze względu na daną zmienną jest równy maksimum ze
-        // stopni tworzących go jednomianów (ze względu na tę zmienną).
-        poly_exp_t max_exp = -1;
-        for (size_t i = 0; i < p->size; i++) {
-            Poly curr_poly = p->arr[i].p;
-            poly_exp_t curr_poly_deg = PolyDegByHelper(&curr_poly, var_idx, depth + 1);
-            if (curr_poly_deg > max_exp) {
-                max_exp = curr_poly_deg;
+static Poly PolyMulHeap(const Poly *p, const Poly *q) {
+    ScratchMark mark = ScratchGetMark();
+    MulHeapNode *heap = ScratchAlloc(p->size * sizeof(MulHeapNode));
+    size_t heap_size = 0;
+    MulHeapPush(heap, &heap_size, (MulHeapNode) {
+        .exp = p->arr[0].exp + q->arr[0].exp, .p_idx = 0, .q_idx = 0});
+
+    size_t arr_size = 0, arr_capacity = p->size + q->size;
+    Mono *arr = MonoArrAlloc(arr_capacity);
+    while (heap_size > 0) {
+        poly_exp_t exp = heap[0].exp;
+        Poly sum = PolyZero();
+        // Sumujemy wszystkie iloczyny jednomianów o wykładniku [exp].
+        while (heap_size > 0 && heap[0].exp == exp) {
+            MulHeapNode node = MulHeapPop(heap, &heap_size);
+            size_t i = node.p_idx, j = node.q_idx;
+            Poly poly_mul = PolyMul(&p->arr[i].p, &q->arr[j].p);
+            if (PolyIsZero(&sum)) {
+                sum = poly_mul;
+            }
+            else {
+                Poly new_sum = PolyAdd(&sum, &poly_mul);
+                PolyDestroy(&sum);
+                PolyDestroy(&poly_mul);
+                sum = new_sum;
+            }
+            // Iloczyn z kolejnym jednomianem [p] może zostać wstawiony do
+            // kopca dopiero teraz, bo nie jest większy od obecnego.
+            if (j == 0 && i + 1 < p->size) {
+                MulHeapPush(heap, &heap_size, (MulHeapNode) {
+                    .exp = p->arr[i + 1].exp + q->arr[0].exp,
+                    .p_idx = i + 1, .q_idx = 0});
+            }
+            if (j + 1 < q->size) {
+                MulHeapPush(heap, &heap_size, (MulHeapNode) {
+                    .exp = p->arr[i].exp + q->arr[j + 1].exp,
+                    .p_idx = i, .q_idx = j + 1});
             }
         }
-        return max_exp;
+        if (PolyIsZero(&sum)) continue;
+        if (arr_size == arr_capacity) {
+            arr_capacity *= 2;
+            arr = MonoArrGrow(arr, arr_capacity);
+        }
+        arr[arr_size] = MonoFromPoly(&sum, exp);
+        arr_size++;
     }
+    ScratchRelease(mark);
+
+    if (arr_size != 0) arr = MonoArrShrink(arr, arr_size);
+    return PolyFromArrSimplify(arr, arr_size);
 }
 
 /**
- * Zwraca stopień wielomianu ze względu na zadaną zmienną (-1 dla wielomianu
- * tożsamościowo równego zeru). Zmienne indeksowane są od 0.
- * Zmienna o indeksie 0 oznacza zmienną główną tego wielomianu.
- * Większe indeksy oznaczają zmienne wielomianów znajdujących się
- * we współczynnikach.
+ * Szacowana liczba operacji, od której mnożenie wielomianów jest dzielone
+ * między wątki puli.
+ */
+#define PARALLEL_MUL_THRESHOLD ((size_t) 1 << 14)
+
+/**
+ * Daje liczbę jednomianów najwyższego poziomu wielomianu, używaną do
+ * szacowania kosztu działań na jego współczynnikach.
  * @param[in] p : wielomian
- * @param[in] var_idx : indeks zmiennej
- * @return stopień wielomianu @p p z względu na zmienną o indeksie @p var_idx
+ * @return liczba jednomianów lub 1 dla współczynnika
  */
-poly_exp_t PolyDegBy(const Poly *p, size_t var_idx) {
-    assert(p != NULL);
-    return PolyDegByHelper(p, var_idx, 0);
+static inline size_t PolyWeight(const Poly *p) {
+    return PolyIsCoeff(p) ? 1 : p->size;
+}
+
+/**
+ * To jest struktura przechowująca dane mnożenia wielomianów dzielonego
+ * między wątki puli. Jednomiany @f$p@f$ podzielone są na @p chunks
+ * fragmentów, a każdy fragment mnożony jest przez @f$q@f$ osobno.
+ */
+typedef struct MulTask {
+    const Poly *p; ///< wielomian @f$p@f$
+    const Poly *q; ///< wielomian @f$q@f$
+    size_t chunks; ///< liczba fragmentów
+    Poly *partial; ///< iloczyny kolejnych fragmentów przez @f$q@f$
+} MulTask;
+
+/**
+ * Mnoży jeden fragment jednomianów @f$p@f$ przez @f$q@f$.
+ * @param[in,out] ctx : dane mnożenia (MulTask)
+ * @param[in] idx : numer fragmentu
+ */
+static void MulChunk(void *ctx, size_t idx) {
+    MulTask *task = ctx;
+    size_t begin = task->p->size * idx / task->chunks;
+    size_t end = task->p->size * (idx + 1) / task->chunks;
+    Poly rows = {.size = end - begin, .arr = task->p->arr + begin};
+    task->partial[idx] = PolyMulHeap(&rows, task->q);
+}
+
+/**
+ * Długość czynników, poniżej której gęste wielomiany mnożone są algorytmem
+ * szkolnym.
+ */
+#define KARATSUBA_THRESHOLD 32
+
+/**
+ * Długość krótszego czynnika, od której gęste wielomiany mnożone są przez
+ * transformatę teorioliczbową (NTT).
+ */
+#define NTT_THRESHOLD 256
+
+/**
+ * Maksymalna długość transformaty teorioliczbowej. Dla każdej z liczb
+ * pierwszych @p ntt_primes liczba @f$p - 1@f$ dzieli się przez nią.
+ */
+#define NTT_MAX_LENGTH ((size_t) 1 << 23)
+
+/**
+ * Maksymalna liczba liczb pierwszych, modulo które liczone są transformaty.
+ */
+#define NTT_MAX_PRIMES 6
+
+/**
+ * Pierwiastek pierwotny modulo każda z liczb pierwszych @p ntt_primes.
+ */
+#define NTT_ROOT 3
+
+/**
+ * Szacowany koszt dodania iloczynu pary współczynników przy mnożeniu
+ * wielomianów jednej zmiennej kopcem (patrz: PolyMulHeap()), wyrażony
+ * w mnożeniach gęstych tablic współczynników.
+ */
+#define HEAP_PAIR_COST 32
+
+/**
+ * Szacowany koszt dodania iloczynu pary współczynników przy mnożeniu
+ * wielomianów jednej zmiennej kopcem, gdy współczynniki iloczynu mogą się nie
+ * mieścić w typie poly_coeff_t (patrz: BigCoeffMul()).
+ */
+#define HEAP_BIG_PAIR_COST 256
+
+/**
+ * Szacowany koszt motylka transformaty teorioliczbowej dla jednej liczby
+ * pierwszej, wyrażony w mnożeniach gęstych tablic współczynników.
+ */
+#define NTT_BUTTERFLY_COST 4
+
+/**
+ * Maksymalna długość gęstej tablicy współczynników iloczynu.
+ */
+#define DENSE_MUL_MAX_LENGTH ((size_t) 1 << 24)
+
+/** To są liczby pierwsze postaci @f$c \cdot 2^{23} + 1@f$, modulo które
+ * liczone są transformaty. Używanych jest tylko tyle pierwszych z nich, ile
+ * potrzeba do odtworzenia współczynników iloczynu. */
+static const uint32_t ntt_primes[NTT_MAX_PRIMES] = {
+    998244353, 167772161, 469762049, 595591169, 645922817, 897581057
+};
+
+/** To są największe liczby bitów wartości bezwzględnej współczynnika
+ * iloczynu, przy których można go odtworzyć z reszt modulo @f$k@f$ pierwszych
+ * liczb z tablicy @p ntt_primes, dla kolejnych @f$k@f$. */
+static const unsigned ntt_max_bits[NTT_MAX_PRIMES + 1] = {
+    0, 28, 56, 85, 114, 143, 173
+};
+
+/**
+ * Mnoży gęste tablice współczynników algorytmem szkolnym. Obliczenia
+ * wykonywane są na liczbach bez znaku, czyli modulo @f$2^{64}@f$, tak samo
+ * jak wszystkie funkcje mnożące gęste tablice współczynników.
+ * @param[in] a : współczynniki @f$a@f$
+ * @param[in] na : liczba współczynników @f$a@f$
+ * @param[in] b : współczynniki @f$b@f$
+ * @param[in] nb : liczba współczynników @f$b@f$
+ * @param[out] res : @f$na + nb - 1@f$ współczynników @f$a * b@f$
+ */
+static void DenseMulBasic(const unsigned long a[], size_t na,
+                          const unsigned long b[], size_t nb,
+                          unsigned long res[]) {
+    memset(res, 0, (na + nb - 1) * sizeof(unsigned long));
+    for (size_t i = 0; i < na; i++) {
+        for (size_t j = 0; j < nb; j++) {
+            res[i + j] += a[i] * b[j];
+        }
+    }
+}
+
+/**
+ * Mnoży gęste tablice współczynników równej długości algorytmem Karatsuby.
+ * Dla @f$a = a_0 + x^m a_1@f$ i @f$b = b_0 + x^m b_1@f$ wylicza
+ * @f$a_0 b_0@f$, @f$a_1 b_1@f$ oraz @f$(a_0 + a_1)(b_0 + b_1)@f$, z których
+ * składa iloczyn.
+ * @param[in] a : współczynniki @f$a@f$
+ * @param[in] b : współczynniki @f$b@f$
+ * @param[in] n : liczba współczynników każdej z tablic
+ * @param[out] res : @f$2n - 1@f$ współczynników @f$a * b@f$
+ */
+static void Karatsuba(const unsigned long a[], const unsigned long b[],
+                      size_t n, unsigned long res[]) {
+    if (n < KARATSUBA_THRESHOLD) {
+        DenseMulBasic(a, n, b, n, res);
+        return;
+    }
+    size_t m = n / 2, h = n - m;
+    ScratchMark mark = ScratchGetMark();
+    unsigned long *sum_a = ScratchAlloc(h * sizeof(unsigned long));
+    unsigned long *sum_b = ScratchAlloc(h * sizeof(unsigned long));
+    unsigned long *mid = ScratchAlloc((2 * h - 1) * sizeof(unsigned long));
+    for (size_t i = 0; i < h; i++) {
+        sum_a[i] = a[m + i] + (i < m ? a[i] : 0);
+        sum_b[i] = b[m + i] + (i < m ? b[i] : 0);
+    }
+    Karatsuba(a, b, m, res);
+    res[2 * m - 1] = 0;
+    Karatsuba(a + m, b + m, h, res + 2 * m);
+    Karatsuba(sum_a, sum_b, h, mid);
+    for (size_t i = 0; i < 2 * m - 1; i++) {
+        mid[i] -= res[i];
+    }
+    for (size_t i = 0; i < 2 * h - 1; i++) {
+        mid[i] -= res[2 * m + i];
+    }
+    for (size_t i = 0; i < 2 * h - 1; i++) {
+        res[m + i] += mid[i];
+    }
+    ScratchRelease(mark);
+}
+
+/**
+ * Mnoży gęste tablice współczynników algorytmem Karatsuby. Dłuższa tablica
+ * dzielona jest na fragmenty długości krótszej.
+ * @param[in] a : współczynniki @f$a@f$
+ * @param[in] na : liczba współczynników @f$a@f$
+ * @param[in] b : współczynniki @f$b@f$
+ * @param[in] nb : liczba współczynników @f$b@f$
+ * @param[out] res : @f$na + nb - 1@f$ współczynników @f$a * b@f$
+ */
+static void DenseMulKaratsuba(const unsigned long a[], size_t na,
+                              const unsigned long b[], size_t nb,
+                              unsigned long res[]) {
+    if (na < nb) {
+        DenseMulKaratsuba(b, nb, a, na, res);
+        return;
+    }
+    if (nb < KARATSUBA_THRESHOLD) {
+        DenseMulBasic(a, na, b, nb, res);
+        return;
+    }
+    ScratchMark mark = ScratchGetMark();
+    unsigned long *part = ScratchAlloc((2 * nb - 1) * sizeof(unsigned long));
+    memset(res, 0, (na + nb - 1) * sizeof(unsigned long));
+    for (size_t begin = 0; begin < na; begin += nb) {
+        size_t len = na - begin < nb ? na - begin : nb;
+        if (len == nb) Karatsuba(a + begin, b, nb, part);
+        else DenseMulKaratsuba(b, nb, a + begin, len, part);
+        for (size_t i = 0; i < len + nb - 1; i++) {
+            res[begin + i] += part[i];
+        }
+    }
+    ScratchRelease(mark);
+}
+
+/**
+ * Podnosi liczbę do potęgi modulo @p mod.
+ * @param[in] base : podstawa
+ * @param[in] exp : wykładnik
+ * @param[in] mod : moduł, @f$mod < 2^{32}@f$
+ * @return @f$base^{exp} \bmod mod@f$
+ */
+static uint32_t PowMod(uint64_t base, uint64_t exp, uint32_t mod) {
+    uint64_t res = 1;
+    base %= mod;
+    while (exp > 0) {
+        if (exp % 2 == 1) res = res * base % mod;
+        base = base * base % mod;
+        exp /= 2;
+    }
+    return (uint32_t) res;
+}
+
+/**
+ * Wylicza w miejscu transformatę teorioliczbową (lub odwrotną transformatę)
+ * tablicy reszt modulo @p mod.
+ * @param[in,out] a : tablica reszt
+ * @param[in] n : długość tablicy, potęga dwójki dzieląca @f$mod - 1@f$
+ * @param[in] mod : liczba pierwsza z tablicy @p ntt_primes
+ * @param[in] invert : czy wyliczyć transformatę odwrotną
+ */
+static void Ntt(uint32_t a[], size_t n, uint32_t mod, bool invert) {
+    for (size_t i = 1, j = 0; i < n; i++) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) {
+            uint32_t temp = a[i];
+            a[i] = a[j];
+            a[j] = temp;
+        }
+    }
+    ScratchMark mark = ScratchGetMark();
+    uint32_t *roots = ScratchAlloc((n / 2 + 1) * sizeof(uint32_t));
+    for (size_t len = 2; len <= n; len <<= 1) {
+        uint32_t root = PowMod(NTT_ROOT, (mod - 1) / len, mod);
+        if (invert) root = PowMod(root, mod - 2, mod);
+        size_t half = len / 2;
+        roots[0] = 1;
+        for (size_t j = 1; j < half; j++) {
+            roots[j] = (uint32_t) ((uint64_t) roots[j - 1] * root % mod);
+        }
+        for (size_t i = 0; i < n; i += len) {
+            for (size_t j = 0; j < half; j++) {
+                uint32_t u = a[i + j];
+                uint32_t v = (uint32_t) ((uint64_t) a[i + j + half] * roots[j] % mod);
+                a[i + j] = u + v < mod ? u + v : u + v - mod;
+                a[i + j + half] = u >= v ? u - v : u + mod - v;
+            }
+        }
+    }
+    ScratchRelease(mark);
+    if (invert) {
+        uint64_t n_inv = PowMod(n, mod - 2, mod);
+        for (size_t i = 0; i < n; i++) {
+            a[i] = (uint32_t) (a[i] * n_inv % mod);
+        }
+    }
+}
+
+/**
+ * To jest struktura przechowująca dane mnożenia gęstych tablic
+ * współczynników przez transformatę teorioliczbową. Splot liczony jest
+ * osobno modulo każda z liczb pierwszych @p ntt_primes.
+ */
+typedef struct NttTask {
+    const unsigned long *a; ///< współczynniki @f$a@f$
+    size_t na;              ///< liczba współczynników @f$a@f$
+    const unsigned long *b; ///< współczynniki @f$b@f$
+    size_t nb;              ///< liczba współczynników @f$b@f$
+    size_t n;               ///< długość transformaty
+    uint32_t *residues;     ///< tablice reszt (po dwie dla każdej liczby pierwszej)
+} NttTask;
+
+/**
+ * Wypełnia tablicę reszt modulo @p mod współczynników interpretowanych jako
+ * liczby ze znakiem, uzupełniając ją zerami.
+ * @param[out] res : tablica reszt długości @p n
+ * @param[in] a : współczynniki
+ * @param[in] na : liczba współczynników
+ * @param[in] n : długość tablicy reszt
+ * @param[in] mod : moduł
+ */
+static void NttResidues(uint32_t res[], const unsigned long a[], size_t na,
+                        size_t n, uint32_t mod) {
+    for (size_t i = 0; i < na; i++) {
+        long r = (long) a[i] % (long) mod;
+        res[i] = (uint32_t) (r < 0 ? r + (long) mod : r);
+    }
+    memset(res + na, 0, (n - na) * sizeof(uint32_t));
+}
+
+/**
+ * Wylicza splot współczynników modulo jedna z liczb pierwszych.
+ * @param[in,out] ctx : dane mnożenia (NttTask)
+ * @param[in] idx : indeks liczby pierwszej w tablicy @p ntt_primes
+ */
+static void NttConvolve(void *ctx, size_t idx) {
+    NttTask *task = ctx;
+    uint32_t mod = ntt_primes[idx];
+    uint32_t *fa = task->residues + 2 * idx * task->n, *fb = fa + task->n;
+    NttResidues(fa, task->a, task->na, task->n, mod);
+    NttResidues(fb, task->b, task->nb, task->n, mod);
+    Ntt(fa, task->n, mod, false);
+    Ntt(fb, task->n, mod, false);
+    for (size_t i = 0; i < task->n; i++) {
+        fa[i] = (uint32_t) ((uint64_t) fa[i] * fb[i] % mod);
+    }
+    Ntt(fa, task->n, mod, true);
+}
+
+/**
+ * Wylicza sploty gęstych tablic współczynników modulo @p primes pierwszych
+ * liczb z tablicy @p ntt_primes (równolegle, jeśli pula wątków jest
+ * uruchomiona).
+ * @param[in] a : współczynniki @f$a@f$
+ * @param[in] na : liczba współczynników @f$a@f$
+ * @param[in] b : współczynniki @f$b@f$
+ * @param[in] nb : liczba współczynników @f$b@f$
+ * @param[in] primes : liczba liczb pierwszych
+ * @param[out] n : długość transformaty
+ * @return tablice reszt przydzielone przez malloc(); splot modulo @f$j@f$-ta
+ * liczba pierwsza zaczyna się od indeksu @f$2 j n@f$
+ */
+static uint32_t* NttResiduesOfProduct(const unsigned long a[], size_t na,
+                                      const unsigned long b[], size_t nb,
+                                      size_t primes, size_t *n) {
+    NttTask task = {.a = a, .na = na, .b = b, .nb = nb, .n = 1};
+    while (task.n < na + nb - 1) task.n <<= 1;
+    task.residues = malloc(2 * primes * task.n * sizeof(uint32_t));
+    if (task.residues == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    PoolParallelFor(primes, NttConvolve, &task);
+    *n = task.n;
+    return task.residues;
+}
+
+/**
+ * To jest struktura przechowująca stałe algorytmu Garnera dla pierwszych
+ * @p primes liczb z tablicy @p ntt_primes. Współczynnik odtwarzany jest
+ * w postaci @f$\sum_i v_i P_i@f$, gdzie @f$P_i = p_0 p_1 \cdots p_{i-1}@f$.
+ */
+typedef struct Garner {
+    size_t primes; ///< liczba liczb pierwszych
+    /// @f$P_i \bmod p_j@f$ dla @f$i \le j@f$
+    uint64_t prefix[NTT_MAX_PRIMES][NTT_MAX_PRIMES];
+    uint64_t inv[NTT_MAX_PRIMES];          ///< odwrotność @f$P_j@f$ modulo @f$p_j@f$
+    unsigned long full[NTT_MAX_PRIMES];    ///< @f$P_i \bmod 2^{64}@f$
+} Garner;
+
+/**
+ * Wylicza stałe algorytmu Garnera.
+ * @param[out] garner : stałe algorytmu
+ * @param[in] primes : liczba liczb pierwszych
+ */
+static void GarnerInit(Garner *garner, size_t primes) {
+    garner->primes = primes;
+    unsigned long full = 1;
+    for (size_t j = 0; j < primes; j++) {
+        uint64_t mod = ntt_primes[j], prod = 1;
+        for (size_t i = 0; i <= j; i++) {
+            garner->prefix[j][i] = prod;
+            prod = prod * ntt_primes[i] % mod;
+        }
+        garner->inv[j] = PowMod(garner->prefix[j][j], mod - 2, (uint32_t) mod);
+        garner->full[j] = full;
+        full *= ntt_primes[j];
+    }
+}
+
+/**
+ * Odtwarza cyfry współczynnika splotu z jego reszt algorytmem Garnera.
+ * Ostatnią cyfrę wybieramy z przedziału symetrycznego względem zera, aby
+ * odtworzyć również ujemne współczynniki.
+ * @param[in] garner : stałe algorytmu
+ * @param[in] residues : tablice reszt (patrz: NttResiduesOfProduct())
+ * @param[in] n : długość transformaty
+ * @param[in] idx : indeks współczynnika
+ * @param[out] digits : cyfry @f$v_0, \ldots, v_{primes-2}@f$
+ * @return ostatnia cyfra @f$v_{primes-1}@f$
+ */
+static long GarnerDigits(const Garner *garner, const uint32_t residues[],
+                         size_t n, size_t idx, uint64_t digits[]) {
+    for (size_t j = 0; j < garner->primes; j++) {
+        uint64_t mod = ntt_primes[j], sum = 0;
+        for (size_t i = 0; i < j; i++) {
+            sum = (sum + digits[i] % mod * garner->prefix[j][i]) % mod;
+        }
+        digits[j] = (residues[2 * j * n + idx] + mod - sum) % mod
+                    * garner->inv[j] % mod;
+    }
+    uint64_t last_mod = ntt_primes[garner->primes - 1];
+    uint64_t last = digits[garner->primes - 1];
+    return last > last_mod / 2 ? (long) last - (long) last_mod : (long) last;
+}
+
+/**
+ * Mnoży gęste tablice współczynników przez transformatę teorioliczbową.
+ * Splot liczony jest modulo @p primes liczb pierwszych, a współczynniki
+ * iloczynu odtwarzane są z chińskiego twierdzenia o resztach algorytmem
+ * Garnera (modulo @f$2^{64}@f$). Wartości bezwzględne współczynników iloczynu
+ * muszą mieć co najwyżej @p ntt_max_bits[primes] bitów.
+ * @param[in] a : współczynniki @f$a@f$
+ * @param[in] na : liczba współczynników @f$a@f$
+ * @param[in] b : współczynniki @f$b@f$
+ * @param[in] nb : liczba współczynników @f$b@f$
+ * @param[in] primes : liczba liczb pierwszych (patrz: NttPrimes())
+ * @param[out] res : @f$na + nb - 1@f$ współczynników @f$a * b@f$
+ */
+static void DenseMulNtt(const unsigned long a[], size_t na,
+                        const unsigned long b[], size_t nb, size_t primes,
+                        unsigned long res[]) {
+    size_t n;
+    uint32_t *residues = NttResiduesOfProduct(a, na, b, nb, primes, &n);
+    Garner garner;
+    GarnerInit(&garner, primes);
+    uint64_t digits[NTT_MAX_PRIMES];
+    for (size_t i = 0; i < na + nb - 1; i++) {
+        long last = GarnerDigits(&garner, residues, n, i, digits);
+        unsigned long value = (unsigned long) last * garner.full[primes - 1];
+        for (size_t j = 0; j + 1 < primes; j++) {
+            value += (unsigned long) digits[j] * garner.full[j];
+        }
+        res[i] = value;
+    }
+    free(residues);
+}
+
+/**
+ * Mnoży gęste tablice współczynników przez transformatę teorioliczbową
+ * (patrz: DenseMulNtt()), odtwarzając współczynniki iloczynu dokładnie,
+ * schematem Hornera na współczynnikach wielomianów. Współczynniki, które nie
+ * mieszczą się w typie poly_coeff_t, stają się duże, a jeśli ustawiony jest
+ * moduł, są redukowane modulo.
+ * @param[in] a : współczynniki @f$a@f$
+ * @param[in] na : liczba współczynników @f$a@f$
+ * @param[in] b : współczynniki @f$b@f$
+ * @param[in] nb : liczba współczynników @f$b@f$
+ * @param[in] primes : liczba liczb pierwszych (patrz: NttPrimes())
+ * @param[out] res : @f$na + nb - 1@f$ współczynników @f$a * b@f$
+ */
+static void DenseMulNttExact(const unsigned long a[], size_t na,
+                             const unsigned long b[], size_t nb, size_t primes,
+                             Poly res[]) {
+    size_t n;
+    uint32_t *residues = NttResiduesOfProduct(a, na, b, nb, primes, &n);
+    Garner garner;
+    GarnerInit(&garner, primes);
+    uint64_t digits[NTT_MAX_PRIMES];
+    for (size_t i = 0; i < na + nb - 1; i++) {
+        Poly value = PolyFromCoeff(GarnerDigits(&garner, residues, n, i, digits));
+        for (size_t j = primes - 1; j-- > 0;) {
+            Poly mod = PolyFromCoeff(ntt_primes[j]);
+            Poly digit = PolyFromCoeff((poly_coeff_t) digits[j]);
+            Poly product = CoeffMul(&value, &mod);
+            PolyDestroy(&value);
+            value = CoeffAdd(&product, &digit);
+            PolyDestroy(&product);
+        }
+        res[i] = value;
+    }
+    free(residues);
+}
+
+/**
+ * Daje liczbę bitów wartości bezwzględnej współczynnika interpretowanego
+ * jako liczba ze znakiem.
+ * @param[in] c : współczynnik
+ * @return liczba bitów
+ */
+static unsigned CoeffBits(unsigned long c) {
+    unsigned long abs = (long) c < 0 ? 0 - c : c;
+    unsigned bits = 0;
+    while (abs > 0) {
+        bits++;
+        abs >>= 1;
+    }
+    return bits;
+}
+
+/**
+ * Daje liczbę bitów największej wartości bezwzględnej współczynników
+ * interpretowanych jako liczby ze znakiem.
+ * @param[in] a : współczynniki
+ * @param[in] n : liczba współczynników
+ * @return liczba bitów
+ */
+static unsigned MaxCoeffBits(const unsigned long a[], size_t n) {
+    unsigned bits = 0;
+    for (size_t i = 0; i < n; i++) {
+        unsigned curr_bits = CoeffBits(a[i]);
+        if (curr_bits > bits) bits = curr_bits;
+    }
+    return bits;
+}
+
+/**
+ * Liczba bitów największej wartości bezwzględnej liczby typu poly_coeff_t.
+ */
+#define COEFF_BITS (sizeof(poly_coeff_t) * CHAR_BIT - 1)
+
+/**
+ * Daje liczbę bitów współczynnika wielomianu. Duży współczynnik ma więcej
+ * niż @p COEFF_BITS bitów.
+ * @param[in] p : współczynnik
+ * @return liczba bitów lub @p COEFF_BITS @f$+ 1@f$ dla dużego współczynnika
+ */
+static unsigned PolyCoeffBits(const Poly *p) {
+    if (PolyIsBigCoeff(p)) return COEFF_BITS + 1;
+    return CoeffBits((unsigned long) p->coeff);
+}
+
+/**
+ * Szacuje liczbę bitów wartości bezwzględnej sumy @p terms iloczynów, z których
+ * każdy ma co najwyżej @p bits bitów.
+ * @param[in] bits : liczba bitów iloczynu
+ * @param[in] terms : liczba iloczynów
+ * @return liczba bitów sumy
+ */
+static unsigned ProductBits(unsigned bits, size_t terms) {
+    while (terms > 1) {
+        bits++;
+        terms = (terms + 1) / 2;
+    }
+    return bits;
+}
+
+/**
+ * Sprawdza, czy gęste tablice współczynników można pomnożyć przez
+ * transformatę teorioliczbową, czyli czy są dostatecznie długie, a wartości
+ * bezwzględne współczynników iloczynu dają się odtworzyć z reszt modulo
+ * liczby pierwsze @p ntt_primes, i wyznacza, ile z nich potrzeba.
+ * @param[in] na : liczba współczynników @f$a@f$
+ * @param[in] nb : liczba współczynników @f$b@f$
+ * @param[in] bits : suma liczb bitów największych wartości bezwzględnych
+ * współczynników @f$a@f$ i @f$b@f$
+ * @return najmniejsza wystarczająca liczba liczb pierwszych lub 0, jeśli nie
+ * można użyć transformaty teorioliczbowej
+ */
+static size_t NttPrimes(size_t na, size_t nb, unsigned bits) {
+    size_t shorter = na < nb ? na : nb;
+    if (shorter < NTT_THRESHOLD || na + nb - 1 > NTT_MAX_LENGTH) return 0;
+    // Współczynnik iloczynu jest sumą co najwyżej [shorter] iloczynów.
+    unsigned product_bits = ProductBits(bits, shorter);
+    for (size_t primes = 1; primes <= NTT_MAX_PRIMES; primes++) {
+        if (product_bits <= ntt_max_bits[primes]) return primes;
+    }
+    return 0;
+}
+
+/**
+ * Szacuje liczbę mnożeń współczynników przy mnożeniu gęstych tablic
+ * współczynników algorytmem Karatsuby (patrz: DenseMulKaratsuba()).
+ * @param[in] na : liczba współczynników @f$a@f$
+ * @param[in] nb : liczba współczynników @f$b@f$
+ * @return szacowana liczba operacji
+ */
+static size_t KaratsubaCost(size_t na, size_t nb) {
+    if (na < nb) return KaratsubaCost(nb, na);
+    // Każdy poziom rekurencji zastępuje mnożenie trzema mnożeniami o połowę
+    // krótszych tablic.
+    size_t n = nb, products = 1;
+    while (n >= KARATSUBA_THRESHOLD) {
+        n -= n / 2;
+        products *= 3;
+    }
+    size_t blocks = (na + nb - 1) / nb;
+    return blocks * products * n * n;
+}
+
+/**
+ * Szacuje liczbę mnożeń współczynników przy mnożeniu gęstych tablic
+ * współczynników przez transformatę teorioliczbową (patrz: DenseMulNtt()).
+ * @param[in] na : liczba współczynników @f$a@f$
+ * @param[in] nb : liczba współczynników @f$b@f$
+ * @param[in] primes : liczba liczb pierwszych
+ * @return szacowana liczba operacji
+ */
+static size_t NttCost(size_t na, size_t nb, size_t primes) {
+    size_t n = 1, log_n = 0;
+    while (n < na + nb - 1) {
+        n <<= 1;
+        log_n++;
+    }
+    // Dla każdej liczby pierwszej liczone są trzy transformaty.
+    return primes * 3 * (n / 2) * log_n * NTT_BUTTERFLY_COST;
+}
+
+/**
+ * Sprawdza, czy iloczyn opłaca się wyliczać funkcją DenseMul() zamiast
+ * mnożyć kolejne pary niezerowych współczynników.
+ * @param[in] na : liczba współczynników gęstej tablicy @f$a@f$
+ * @param[in] nb : liczba współczynników gęstej tablicy @f$b@f$
+ * @param[in] bits : suma liczb bitów największych wartości bezwzględnych
+ * współczynników @f$a@f$ i @f$b@f$
+ * @param[in] pairs : liczba par niezerowych współczynników @f$a@f$ i @f$b@f$
+ * @param[in] pair_cost : koszt pomnożenia jednej pary współczynników
+ * alternatywną metodą, wyrażony w mnożeniach gęstych tablic współczynników
+ * @return Czy opłaca się mnożenie gęstych tablic współczynników?
+ */
+static bool DenseMulWorthwhile(size_t na, size_t nb, unsigned bits,
+                               size_t pairs, size_t pair_cost) {
+    if (na + nb - 1 > DENSE_MUL_MAX_LENGTH) return false;
+    size_t primes = NttPrimes(na, nb, bits);
+    size_t cost = primes > 0 ? NttCost(na, nb, primes) : KaratsubaCost(na, nb);
+    // Gęste tablice trzeba też wypełnić i przejrzeć.
+    cost += 2 * (na + nb);
+    return pairs >= cost / pair_cost;
+}
+
+/**
+ * Mnoży gęste tablice współczynników (modulo @f$2^{64}@f$). Dla krótkich
+ * tablic używa algorytmu szkolnego, dla średnich algorytmu Karatsuby, a dla
+ * długich transformaty teorioliczbowej, o ile współczynniki iloczynu można
+ * odtworzyć z reszt.
+ * @param[in] a : współczynniki @f$a@f$
+ * @param[in] na : liczba współczynników @f$a@f$
+ * @param[in] b : współczynniki @f$b@f$
+ * @param[in] nb : liczba współczynników @f$b@f$
+ * @param[out] res : @f$na + nb - 1@f$ współczynników @f$a * b@f$
+ */
+static void DenseMul(const unsigned long a[], size_t na,
+                     const unsigned long b[], size_t nb, unsigned long res[]) {
+    size_t primes = NttPrimes(na, nb, MaxCoeffBits(a, na) + MaxCoeffBits(b, nb));
+    if (primes > 0) {
+        DenseMulNtt(a, na, b, nb, primes, res);
+    }
+    else {
+        DenseMulKaratsuba(a, na, b, nb, res);
+    }
+}
+
+/**
+ * Daje liczbę bitów największej wartości bezwzględnej współczynników
+ * wielomianu jednej zmiennej o współczynnikach liczbowych.
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @param[out] bits : liczba bitów
+ * @return Czy wszystkie współczynniki @p p są liczbami typu poly_coeff_t?
+ */
+static bool PolyIsUnivariate(const Poly *p, unsigned *bits) {
+    *bits = 0;
+    for (size_t i = 0; i < p->size; i++) {
+        if (!PolyIsCoeff(&p->arr[i].p) || PolyIsBigCoeff(&p->arr[i].p)) {
+            return false;
+        }
+        unsigned curr_bits = CoeffBits((unsigned long) p->arr[i].p.coeff);
+        if (curr_bits > *bits) *bits = curr_bits;
+    }
+    return true;
+}
+
+/**
+ * Sprawdza, czy iloczyn dwóch wielomianów niebędących współczynnikami
+ * opłaca się wyliczyć funkcją PolyMulUnivariate().
+ * @param[in] p : wielomian @f$p@f$ niebędący współczynnikiem
+ * @param[in] q : wielomian @f$q@f$ niebędący współczynnikiem
+ * @param[out] primes : 0, jeśli współczynniki iloczynu mieszczą się w typie
+ * poly_coeff_t, a w przeciwnym razie liczba liczb pierwszych, modulo które
+ * trzeba liczyć transformatę, by odtworzyć je dokładnie
+ * @return Czy @p p i @p q są wielomianami jednej zmiennej o współczynnikach
+ * liczbowych, dla których opłaca się mnożenie gęstych tablic współczynników?
+ */
+static bool UnivariatePlan(const Poly *p, const Poly *q, size_t *primes) {
+    unsigned p_bits, q_bits;
+    if (!PolyIsUnivariate(p, &p_bits) || !PolyIsUnivariate(q, &q_bits)) {
+        return false;
+    }
+    // Tablice jednomianów są posortowane malejąco względem wykładników.
+    size_t np = (size_t) p->arr[0].exp + 1, nq = (size_t) q->arr[0].exp + 1;
+    size_t shorter = p->size < q->size ? p->size : q->size;
+    *primes = 0;
+    size_t pair_cost = HEAP_PAIR_COST;
+    // Gęste tablice mnożone są modulo 2^64, więc gdy współczynniki iloczynu
+    // mogą się nie mieścić w typie poly_coeff_t, można użyć tylko
+    // transformaty z dokładnym odtworzeniem współczynników.
+    if (ProductBits(p_bits + q_bits, shorter) > COEFF_BITS) {
+        *primes = NttPrimes(np, nq, p_bits + q_bits);
+        if (*primes == 0) return false;
+        pair_cost = HEAP_BIG_PAIR_COST;
+    }
+    return DenseMulWorthwhile(np, nq, p_bits + q_bits, p->size * q->size,
+                              pair_cost);
+}
+
+/**
+ * Tworzy wielomian jednej zmiennej z gęstej tablicy jego współczynników.
+ * @param[in] coeffs : współczynniki kolejnych potęg zmiennej; przejmowane na
+ * własność
+ * @param[in] len : liczba współczynników
+ * @return wielomian
+ */
+static Poly PolyFromDense(Poly coeffs[], size_t len) {
+    size_t count = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (!PolyIsZero(&coeffs[i])) count++;
+    }
+    if (count == 0) return PolyZero();
+    Mono *arr = MonoArrAlloc(count);
+    size_t idx = 0;
+    for (size_t exp = len; exp-- > 0;) {
+        if (PolyIsZero(&coeffs[exp])) continue;
+        arr[idx++] = MonoFromPoly(&coeffs[exp], (poly_exp_t) exp);
+    }
+    return PolyFromArrSimplify(arr, count);
+}
+
+/**
+ * Mnoży dwa wielomiany jednej zmiennej o współczynnikach liczbowych,
+ * zamieniając je na gęste tablice współczynników (patrz: DenseMul()). Jeśli
+ * współczynniki iloczynu mogą się nie mieścić w typie poly_coeff_t, są
+ * odtwarzane dokładnie z reszt modulo kilka liczb pierwszych (patrz:
+ * DenseMulNttExact()).
+ * @param[in] p : wielomian @f$p@f$ jednej zmiennej
+ * @param[in] q : wielomian @f$q@f$ jednej zmiennej
+ * @param[in] primes : liczba liczb pierwszych wyznaczona przez
+ * UnivariatePlan()
+ * @return @f$p * q@f$
+ */
+static Poly PolyMulUnivariate(const Poly *p, const Poly *q, size_t primes) {
+    // Tablice jednomianów są posortowane malejąco względem wykładników.
+    size_t np = (size_t) p->arr[0].exp + 1, nq = (size_t) q->arr[0].exp + 1;
+    size_t len = np + nq - 1;
+    unsigned long *a = calloc(np + nq + len, sizeof(unsigned long));
+    if (a == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    unsigned long *b = a + np, *res = b + nq;
+    for (size_t i = 0; i < p->size; i++) {
+        a[p->arr[i].exp] = (unsigned long) p->arr[i].p.coeff;
+    }
+    for (size_t i = 0; i < q->size; i++) {
+        b[q->arr[i].exp] = (unsigned long) q->arr[i].p.coeff;
+    }
+    Poly *coeffs = malloc(len * sizeof(Poly));
+    if (coeffs == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    if (primes > 0) {
+        DenseMulNttExact(a, np, b, nq, primes, coeffs);
+    }
+    else {
+        DenseMul(a, np, b, nq, res);
+        for (size_t i = 0; i < len; i++) {
+            poly_coeff_t c = (poly_coeff_t) res[i];
+            coeffs[i] = PolyFromCoeff(ModEnabled() ? ModReduce(c) : c);
+        }
+    }
+    free(a);
+    Poly product = PolyFromDense(coeffs, len);
+    free(coeffs);
+    return product;
+}
+
+/**
+ * Minimalna liczba par współczynników liczbowych mnożonych wielomianów, od
+ * której opłaca się mnożenie przez podstawienie Kroneckera.
+ */
+#define KRONECKER_MIN_WORK ((size_t) 1 << 10)
+
+/**
+ * Maksymalny rozmiar gęstej tablicy współczynników iloczynu przy mnożeniu
+ * przez podstawienie Kroneckera.
+ */
+#define KRONECKER_MAX_DENSE ((size_t) 1 << 22)
+
+/**
+ * Maksymalny stosunek rozmiaru gęstej tablicy współczynników iloczynu do
+ * liczby par współczynników liczbowych, przy którym mnożenie przez
+ * podstawienie Kroneckera jest tańsze od mnożenia rekurencyjnego.
+ */
+#define KRONECKER_DENSITY 16
+
+/**
+ * To jest struktura przechowująca opis podstawienia Kroneckera dla
+ * wielomianu @f$nvars@f$ zmiennych. Jednomian
+ * @f$c x_0^{e_0} x_1^{e_1} \cdots@f$ przechodzi na jednomian jednej zmiennej
+ * o wykładniku @f$\sum_i e_i \cdot stride_i@f$, gdzie
+ * @f$stride_{nvars-1} = 1@f$ oraz @f$stride_i = stride_{i+1} \cdot
+ * base_{i+1}@f$. Jeśli wykładniki zmiennej @f$x_i@f$ są mniejsze od
+ * @f$base_i@f$, podstawienie jest różnowartościowe, a jego wynik uporządkowany
+ * tak samo jak w rekurencyjnej reprezentacji wielomianu.
+ */
+typedef struct Kronecker {
+    size_t nvars;   ///< liczba zmiennych
+    size_t *base;   ///< ograniczenia wykładników kolejnych zmiennych
+    size_t *stride; ///< wagi wykładników kolejnych zmiennych
+    size_t dense;   ///< rozmiar gęstej tablicy współczynników
+    size_t p_terms; ///< liczba współczynników liczbowych pierwszego czynnika
+    size_t q_terms; ///< liczba współczynników liczbowych drugiego czynnika
+} Kronecker;
+
+/**
+ * Wylicza liczbę poziomów zagnieżdżenia wielomianu, liczbę jego
+ * współczynników liczbowych oraz liczbę bitów największego z nich.
+ * @param[in] p : wielomian
+ * @param[in,out] terms : zwiększana o liczbę współczynników liczbowych @p p
+ * @param[in,out] bits : największa z @p bits i liczb bitów współczynników
+ * liczbowych @p p (patrz: PolyCoeffBits())
+ * @return liczba poziomów zagnieżdżenia (0 dla współczynnika)
+ */
+static size_t PolyDepthAndTerms(const Poly *p, size_t *terms, unsigned *bits) {
+    if (PolyIsCoeff(p)) {
+        (*terms)++;
+        unsigned curr_bits = PolyCoeffBits(p);
+        if (curr_bits > *bits) *bits = curr_bits;
+        return 0;
+    }
+    size_t depth = 0;
+    for (size_t i = 0; i < p->size; i++) {
+        size_t child_depth = PolyDepthAndTerms(&p->arr[i].p, terms, bits);
+        if (child_depth > depth) depth = child_depth;
+    }
+    return depth + 1;
+}
+
+/**
+ * Wylicza największe wykładniki kolejnych zmiennych wielomianu.
+ * @param[in] p : wielomian
+ * @param[in] level : indeks zmiennej wielomianu @p p
+ * @param[in,out] max_exp : największe wykładniki kolejnych zmiennych
+ */
+static void PolyMaxExps(const Poly *p, size_t level, poly_exp_t max_exp[]) {
+    if (PolyIsCoeff(p)) return;
+    // Tablica jednomianów jest posortowana malejąco względem wykładników.
+    if (p->arr[0].exp > max_exp[level]) max_exp[level] = p->arr[0].exp;
+    for (size_t i = 0; i < p->size; i++) {
+        PolyMaxExps(&p->arr[i].p, level + 1, max_exp);
+    }
+}
+
+/**
+ * Sprawdza, czy mnożenie dwóch wielomianów niebędących współczynnikami
+ * opłaca się wykonać przez podstawienie Kroneckera, i jeśli tak, wylicza
+ * parametry podstawienia. Podstawienie opłaca się dla wielomianów wielu
+ * zmiennych, których iloczyn jest na tyle gęsty, że gęsta tablica jego
+ * współczynników nie jest dużo większa od liczby mnożonych par
+ * współczynników, a współczynniki iloczynu mieszczą się w typie poly_coeff_t.
+ * @param[in] p : wielomian @f$p@f$ niebędący współczynnikiem
+ * @param[in] q : wielomian @f$q@f$ niebędący współczynnikiem
+ * @param[out] kron : parametry podstawienia (tablice przydzielone z areny)
+ * @return Czy mnożenie opłaca się wykonać przez podstawienie Kroneckera?
+ */
+static bool KroneckerPlan(const Poly *p, const Poly *q, Kronecker *kron) {
+    // Liczby wyrazów są zapamiętane w danych wielomianów, więc małe iloczyny
+    // odrzucane są bez przechodzenia czynników.
+    size_t p_count = PolyGetMeta(p)->terms, q_count = PolyGetMeta(q)->terms;
+    if (p_count < KRONECKER_MIN_WORK / q_count) return false;
+    size_t p_terms = 0, q_terms = 0;
+    unsigned p_bits = 0, q_bits = 0;
+    size_t p_depth = PolyDepthAndTerms(p, &p_terms, &p_bits);
+    size_t q_depth = PolyDepthAndTerms(q, &q_terms, &q_bits);
+    size_t nvars = p_depth > q_depth ? p_depth : q_depth;
+    // Dla wielomianów jednej zmiennej podstawienie niczego nie zmienia.
+    if (nvars < 2 || p_terms * q_terms < KRONECKER_MIN_WORK) return false;
+    // Gęsta tablica liczona jest modulo 2^64.
+    size_t shorter = p_terms < q_terms ? p_terms : q_terms;
+    if (ProductBits(p_bits + q_bits, shorter) > COEFF_BITS) return false;
+
+    poly_exp_t *p_max = ScratchAlloc(2 * nvars * sizeof(poly_exp_t));
+    poly_exp_t *q_max = p_max + nvars;
+    for (size_t i = 0; i < 2 * nvars; i++) {
+        p_max[i] = 0;
+    }
+    PolyMaxExps(p, 0, p_max);
+    PolyMaxExps(q, 0, q_max);
+    size_t limit = p_terms * q_terms * KRONECKER_DENSITY;
+    if (limit > KRONECKER_MAX_DENSE) limit = KRONECKER_MAX_DENSE;
+
+    kron->nvars = nvars;
+    kron->p_terms = p_terms;
+    kron->q_terms = q_terms;
+    kron->base = ScratchAlloc(2 * nvars * sizeof(size_t));
+    kron->stride = kron->base + nvars;
+    kron->dense = 1;
+    for (size_t i = nvars; i-- > 0;) {
+        // Wykładnik iloczynu jest sumą wykładników czynników.
+        kron->base[i] = (size_t) p_max[i] + (size_t) q_max[i] + 1;
+        kron->stride[i] = kron->dense;
+        if (kron->base[i] > limit / kron->dense) return false;
+        kron->dense *= kron->base[i];
+    }
+    return true;
+}
+
+/**
+ * Dodaje iloczyny współczynników liczbowych @p p i @p q do gęstej tablicy
+ * współczynników iloczynu po podstawieniu Kroneckera. Obliczenia wykonywane
+ * są na liczbach bez znaku (modulo @f$2^{64}@f$), ale ich wynik jest dokładny,
+ * bo KroneckerPlan() dopuszcza tylko iloczyny o współczynnikach mieszczących
+ * się w typie poly_coeff_t.
+ * @param[in] p_idx : wykładniki niezerowych współczynników @f$p@f$ po
+ * podstawieniu
+ * @param[in] p_coeff : niezerowe współczynniki @f$p@f$
+ * @param[in] p_terms : liczba niezerowych współczynników @f$p@f$
+ * @param[in] q_idx : wykładniki niezerowych współczynników @f$q@f$ po
+ * podstawieniu
+ * @param[in] q_coeff : niezerowe współczynniki @f$q@f$
+ * @param[in] q_terms : liczba niezerowych współczynników @f$q@f$
+ * @param[in,out] dense : gęsta tablica współczynników iloczynu
+ */
+static void KroneckerMulDense(const size_t p_idx[], const unsigned long p_coeff[],
+                              size_t p_terms, const size_t q_idx[],
+                              const unsigned long q_coeff[], size_t q_terms,
+                              unsigned long dense[]) {
+    for (size_t i = 0; i < p_terms; i++) {
+        for (size_t j = 0; j < q_terms; j++) {
+            dense[p_idx[i] + q_idx[j]] += p_coeff[i] * q_coeff[j];
+        }
+    }
+}
+
+/**
+ * Wypisuje niezerowe współczynniki liczbowe wielomianu razem z ich
+ * wykładnikami po podstawieniu Kroneckera.
+ * @param[in] p : wielomian
+ * @param[in] kron : parametry podstawienia
+ * @param[in] level : indeks zmiennej wielomianu @p p
+ * @param[in] offset : wykładnik po podstawieniu wyznaczony przez zmienne
+ * o indeksach mniejszych od @p level
+ * @param[out] idx : wykładniki kolejnych współczynników
+ * @param[out] coeff : kolejne współczynniki
+ * @param[in,out] count : liczba wypisanych współczynników
+ */
+static void KroneckerPack(const Poly *p, const Kronecker *kron, size_t level,
+                          size_t offset, size_t idx[], unsigned long coeff[],
+                          size_t *count) {
+    if (PolyIsCoeff(p)) {
+        assert(!PolyIsBigCoeff(p));
+        if (PolyIsZero(p)) return;
+        idx[*count] = offset;
+        coeff[*count] = (unsigned long) p->coeff;
+        (*count)++;
+        return;
+    }
+    for (size_t i = 0; i < p->size; i++) {
+        KroneckerPack(&p->arr[i].p, kron, level + 1,
+                      offset + (size_t) p->arr[i].exp * kron->stride[level],
+                      idx, coeff, count);
+    }
+}
+
+/**
+ * Odtwarza rekurencyjną reprezentację wielomianu z gęstej tablicy jego
+ * współczynników po podstawieniu Kroneckera.
+ * @param[in] dense : gęsta tablica współczynników
+ * @param[in] kron : parametry podstawienia
+ * @param[in] level : indeks zmiennej tworzonego wielomianu
+ * @param[in] offset : wykładnik po podstawieniu wyznaczony przez zmienne
+ * o indeksach mniejszych od @p level
+ * @return wielomian
+ */
+static Poly KroneckerUnpack(const unsigned long dense[], const Kronecker *kron,
+                            size_t level, size_t offset) {
+    if (level == kron->nvars) return PolyFromCoeff((poly_coeff_t) dense[offset]);
+
+    ScratchMark mark = ScratchGetMark();
+    Mono *monos = ScratchAlloc(kron->base[level] * sizeof(Mono));
+    size_t count = 0;
+    // Jednomiany powstają od największego wykładnika, więc są posortowane.
+    for (size_t exp = kron->base[level]; exp-- > 0;) {
+        Poly child = KroneckerUnpack(dense, kron, level + 1,
+                                     offset + exp * kron->stride[level]);
+        if (!PolyIsZero(&child)) {
+            monos[count++] = MonoFromPoly(&child, (poly_exp_t) exp);
+        }
+    }
+    Poly res = PolyZero();
+    if (count > 0) {
+        Mono *arr = MonoArrAlloc(count);
+        CopyMonos(arr, monos, count);
+        res = PolyFromArrSimplify(arr, count);
+    }
+    ScratchRelease(mark);
+    return res;
+}
+
+/**
+ * Mnoży dwa wielomiany niebędące współczynnikami przez podstawienie
+ * Kroneckera: zamienia je na wielomiany jednej zmiennej, mnoży je w gęstej
+ * tablicy współczynników i odtwarza z niej rekurencyjną reprezentację
+ * iloczynu.
+ * @param[in] p : wielomian @f$p@f$ niebędący współczynnikiem
+ * @param[in] q : wielomian @f$q@f$ niebędący współczynnikiem
+ * @param[in] kron : parametry podstawienia wyznaczone przez KroneckerPlan()
+ * @return @f$p * q@f$
+ */
+static Poly PolyMulKronecker(const Poly *p, const Poly *q,
+                             const Kronecker *kron) {
+    size_t terms = kron->p_terms + kron->q_terms;
+    ScratchMark mark = ScratchGetMark();
+    size_t *p_idx = ScratchAlloc(terms * sizeof(size_t));
+    size_t *q_idx = p_idx + kron->p_terms;
+    unsigned long *p_coeff = ScratchAlloc(terms * sizeof(unsigned long));
+    unsigned long *q_coeff = p_coeff + kron->p_terms;
+    size_t p_terms = 0, q_terms = 0;
+    KroneckerPack(p, kron, 0, 0, p_idx, p_coeff, &p_terms);
+    KroneckerPack(q, kron, 0, 0, q_idx, q_coeff, &q_terms);
+
+    unsigned long *dense = calloc(kron->dense, sizeof(unsigned long));
+    if (dense == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    // Po podstawieniu największy wykładnik ma pierwszy współczynnik.
+    size_t np = p_idx[0] + 1, nq = q_idx[0] + 1;
+    if (DenseMulWorthwhile(np, nq, MaxCoeffBits(p_coeff, p_terms)
+                           + MaxCoeffBits(q_coeff, q_terms), p_terms * q_terms,
+                           1)) {
+        unsigned long *a = calloc(np + nq, sizeof(unsigned long));
+        if (a == NULL) exit(1); // Błąd podczas alokacji pamięci.
+        for (size_t i = 0; i < p_terms; i++) {
+            a[p_idx[i]] = p_coeff[i];
+        }
+        for (size_t i = 0; i < q_terms; i++) {
+            a[np + q_idx[i]] = q_coeff[i];
+        }
+        DenseMul(a, np, a + np, nq, dense);
+        free(a);
+    }
+    else {
+        KroneckerMulDense(p_idx, p_coeff, p_terms, q_idx, q_coeff, q_terms,
+                          dense);
+    }
+    ScratchRelease(mark);
+    if (ModEnabled()) {
+        for (size_t i = 0; i < kron->dense; i++) {
+            dense[i] = (unsigned long) ModReduce((poly_coeff_t) dense[i]);
+        }
+    }
+    Poly res = KroneckerUnpack(dense, kron, 0, 0);
+    free(dense);
+    return res;
+}
+
+/**
+ * Mnoży dwa wielomiany niebędące współczynnikami. Gęste wielomiany jednej
+ * zmiennej o współczynnikach liczbowych mnożone są jako gęste tablice
+ * współczynników (patrz: DenseMul()), a gęste wielomiany wielu zmiennych
+ * przez podstawienie Kroneckera (patrz: KroneckerPlan()).
+ * W przeciwnym przypadku, jeśli pula wątków jest uruchomiona, a mnożenie
+ * dostatecznie kosztowne, jednomiany krótszego wielomianu są dzielone na
+ * fragmenty mnożone równolegle, a częściowe iloczyny sumowane są
+ * w ustalonej kolejności. Wynik jest więc taki sam jak
+ * przy mnożeniu sekwencyjnym.
+ * @param[in] p : wielomian @f$p@f$ niebędący współczynnikiem
+ * @param[in] q : wielomian @f$q@f$ niebędący współczynnikiem
+ * @return @f$p * q@f$
+ */
+static Poly PolyMulNonCoeffs(const Poly *p, const Poly *q) {
+    assert(!PolyIsCoeff(p) && !PolyIsCoeff(q));
+    // Kopiec jest tym mniejszy, im mniej jednomianów ma [p].
+    if (p->size > q->size) {
+        const Poly *temp = p;
+        p = q;
+        q = temp;
+    }
+    size_t primes;
+    if (UnivariatePlan(p, q, &primes)) return PolyMulUnivariate(p, q, primes);
+    ScratchMark mark = ScratchGetMark();
+    Kronecker kron;
+    if (KroneckerPlan(p, q, &kron)) {
+        Poly res = PolyMulKronecker(p, q, &kron);
+        ScratchRelease(mark);
+        return res;
+    }
+    ScratchRelease(mark);
+
+    size_t threads = PoolThreads();
+    size_t work = p->size * q->size * PolyWeight(&p->arr[0].p)
+                  * PolyWeight(&q->arr[0].p);
+    if (threads <= 1 || p->size < 2 || work < PARALLEL_MUL_THRESHOLD) {
+        return PolyMulHeap(p, q);
+    }
+
+    MulTask task = {.p = p, .q = q};
+    task.chunks = p->size < threads ? p->size : threads;
+    mark = ScratchGetMark();
+    task.partial = ScratchAlloc(task.chunks * sizeof(Poly));
+    PoolParallelFor(task.chunks, MulChunk, &task);
+    Poly res = task.partial[0];
+    for (size_t i = 1; i < task.chunks; i++) {
+        Poly new_res = PolyAdd(&res, &task.partial[i]);
+        PolyDestroy(&res);
+        PolyDestroy(&task.partial[i]);
+        res = new_res;
+    }
+    ScratchRelease(mark);
+    return res;
+}
+
+/**
+ * Mnoży dwa wielomiany.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p * q@f$
+ */
+Poly PolyMul(const Poly *p, const Poly *q) {
+    assert(p != NULL && q != NULL);
+    CountOp(&count_mul_calls, 1);
+    if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
+        return CoeffMul(p, q);
+    }
+    else if (PolyIsCoeff(p)) {
+        if (PolyIsZero(p)) return PolyZero();
+        Poly p_extended = ExtendPoly(p);
+        Poly res = PolyMul(&p_extended, q);
+        PolyDestroy(&p_extended);
+        return res;
+    }
+    else if (PolyIsCoeff(q)) {
+        return PolyMul(q, p);
+    }
+    else {
+        return PolyMulNonCoeffs(p, q);
+    }
+}
+
+/**
+ * Zwraca przeciwny wielomian.
+ * @param[in] p : wielomian @f$p@f$
+ * @return @f$-p@f$
+ */
+Poly PolyNeg(const Poly *p) {
+    assert(p != NULL);
+    Poly neg = PolyFromCoeff(-1);
+    return PolyMul(p, &neg);
+}
+
+/**
+ * Odejmuje wielomian od wielomianu.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p - q@f$
+ */
+Poly PolySub(const Poly *p, const Poly *q) {
+    assert(p != NULL && q != NULL);
+    Poly q_neg = PolyNeg(q);
+    Poly res = PolyAdd(p, &q_neg);
+    PolyDestroy(&q_neg);
+    return res;
+}
+
+/**
+ * Sprawdza, czy wielomian jest jedynym właścicielem swojej tablicy
+ * jednomianów, czyli czy można ją modyfikować w miejscu. Tablice internowane
+ * nie są modyfikowane, bo mogą zostać w każdej chwili znalezione w tablicy
+ * internowania.
+ * @param[in] p : wielomian
+ * @return Czy tablica jednomianów @p p może być modyfikowana w miejscu?
+ */
+static inline bool PolyIsUnique(const Poly *p) {
+    return !PolyIsCoeff(p) && !ArrHeader(p->arr)->interned &&
+           !MonoArrIsShared(p->arr);
+}
+
+/**
+ * Tworzy wielomian z tablicy jednomianów zmodyfikowanej w miejscu: oddaje do
+ * puli jej nadmiarową część i upraszcza wynik (patrz: PolyFromArrSimplify()).
+ * @param[in] arr : tablica jednomianów, do której jest jedno odwołanie
+ * @param[in] size : liczba jednomianów
+ * @return wielomian złożony z jednomianów @p arr
+ */
+static Poly PolyFromOwnArr(Mono arr[], size_t size) {
+    if (size != 0) arr = MonoArrShrink(arr, size);
+    return PolyFromArrSimplify(arr, size);
+}
+
+/**
+ * Usuwa z tablicy jednomianów jednomiany o zerowych współczynnikach,
+ * zachowując kolejność pozostałych.
+ * @param[in,out] arr : tablica jednomianów
+ * @param[in] size : liczba jednomianów
+ * @return liczba pozostałych jednomianów
+ */
+static size_t DropZeroMonos(Mono arr[], size_t size) {
+    size_t new_size = 0;
+    for (size_t i = 0; i < size; i++) {
+        if (!PolyIsZero(&arr[i].p)) arr[new_size++] = arr[i];
+    }
+    return new_size;
+}
+
+/**
+ * Dodaje współczynnik do wielomianu, modyfikując w miejscu jego tablicę
+ * jednomianów. Przejmuje na własność oba wielomiany.
+ * @param[in] p : wielomian @f$p@f$, którego tablica może być modyfikowana
+ * @param[in] c : współczynnik @f$c@f$
+ * @return @f$p + c@f$
+ */
+static Poly PolyAddCoeffOwn(Poly *p, Poly *c) {
+    if (PolyIsZero(c)) return *p;
+    Mono *arr = p->arr;
+    size_t size = p->size;
+    // Tablica jednomianów jest posortowana malejąco względem wykładników.
+    if (arr[size - 1].exp == 0) {
+        Poly sum = PolyAddOwn(&arr[size - 1].p, c);
+        if (PolyIsZero(&sum)) size--;
+        else arr[size - 1].p = sum;
+    }
+    else {
+        arr = MonoArrGrow(arr, size + 1);
+        arr[size++] = MonoFromPoly(c, 0);
+    }
+    if (size == 0) {
+        MonoArrFree(arr);
+        return PolyZero();
+    }
+    return PolyFromOwnArr(arr, size);
+}
+
+/**
+ * Dodaje dwa wielomiany niebędące współczynnikami, scalając jednomiany
+ * @p q z jednomianami @p p w powiększonej tablicy @p p. Jednomiany scalane są
+ * od końca, czyli od najmniejszych wykładników, więc zapisywane miejsca nigdy
+ * nie nachodzą na nieprzetworzone jednomiany @p p. Jednomiany @p q są
+ * przenoszone, jeśli @p q jest jedynym właścicielem swojej tablicy,
+ * a w przeciwnym wypadku kopiowane. Przejmuje na własność oba wielomiany.
+ * @param[in] p : wielomian @f$p@f$, którego tablica może być modyfikowana
+ * @param[in] q : wielomian @f$q@f$ niebędący współczynnikiem
+ * @return @f$p + q@f$
+ */
+static Poly PolyMergeOwn(Poly *p, Poly *q) {
+    bool q_unique = PolyIsUnique(q);
+    size_t total = p->size + q->size;
+    Mono *arr = MonoArrGrow(p->arr, total);
+    size_t i = p->size, j = q->size, w = total;
+    while (j > 0) {
+        const Mono *q_mono = &q->arr[j - 1];
+        if (i > 0 && arr[i - 1].exp < q_mono->exp) {
+            arr[--w] = arr[--i];
+            continue;
+        }
+        Mono m = q_unique ? *q_mono : MonoClone(q_mono);
+        j--;
+        if (i > 0 && arr[i - 1].exp == m.exp) {
+            i--;
+            Poly sum = PolyAddOwn(&arr[i].p, &m.p);
+            if (!PolyIsZero(&sum)) arr[--w] = MonoFromPoly(&sum, m.exp);
+        }
+        else {
+            arr[--w] = m;
+        }
+    }
+    // Jednomiany [arr[0..i)] są na swoich miejscach; scalone jednomiany
+    // przesuwamy tuż za nie.
+    memmove(arr + i, arr + w, (total - w) * sizeof(Mono));
+    size_t size = i + (total - w);
+
+    if (q_unique) MonoArrFree(q->arr);
+    else PolyDestroy(q);
+    if (size == 0) {
+        MonoArrFree(arr);
+        return PolyZero();
+    }
+    return PolyFromOwnArr(arr, size);
+}
+
+/**
+ * Dodaje dwa wielomiany, przejmując je na własność: po wywołaniu nie należy
+ * ich używać ani usuwać. Jeśli któryś z wielomianów jest jedynym właścicielem
+ * swojej tablicy jednomianów, wynik powstaje w tej tablicy, a przenoszone są
+ * całe poddrzewa jednomianów, zamiast kopiowania ich i usuwania oryginałów.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p + q@f$
+ */
+Poly PolyAddOwn(Poly *p, Poly *q) {
+    assert(p != NULL && q != NULL);
+    if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
+        Poly res = CoeffAdd(p, q);
+        PolyDestroy(p);
+        PolyDestroy(q);
+        return res;
+    }
+    if (PolyIsCoeff(p) || (!PolyIsUnique(p) && PolyIsUnique(q))) {
+        return PolyAddOwn(q, p);
+    }
+    if (!PolyIsUnique(p)) {
+        Poly res = PolyAdd(p, q);
+        PolyDestroy(p);
+        PolyDestroy(q);
+        return res;
+    }
+    if (PolyIsCoeff(q)) return PolyAddCoeffOwn(p, q);
+    return PolyMergeOwn(p, q);
+}
+
+/**
+ * Mnoży dwa wielomiany, przejmując je na własność: po wywołaniu nie należy
+ * ich używać ani usuwać. Mnożenie przez współczynnik wielomianu, który jest
+ * jedynym właścicielem swojej tablicy jednomianów, odbywa się w miejscu.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p * q@f$
+ */
+Poly PolyMulOwn(Poly *p, Poly *q) {
+    assert(p != NULL && q != NULL);
+    if (PolyIsCoeff(p) && !PolyIsCoeff(q)) return PolyMulOwn(q, p);
+    if (!PolyIsCoeff(q) || PolyIsZero(q) || !PolyIsUnique(p)) {
+        Poly res = PolyMul(p, q);
+        PolyDestroy(p);
+        PolyDestroy(q);
+        return res;
+    }
+    for (size_t i = 0; i < p->size; i++) {
+        Poly c = PolyClone(q);
+        p->arr[i].p = PolyMulOwn(&p->arr[i].p, &c);
+    }
+    PolyDestroy(q);
+    // Modulo liczba złożona iloczyn niezerowych współczynników może być zerem.
+    size_t size = DropZeroMonos(p->arr, p->size);
+    if (size == 0) {
+        MonoArrFree(p->arr);
+        return PolyZero();
+    }
+    return PolyFromOwnArr(p->arr, size);
+}
+
+/**
+ * Zwraca przeciwny wielomian, przejmując @p p na własność: po wywołaniu nie
+ * należy go używać ani usuwać. Jeśli @p p jest jedynym właścicielem swojej
+ * tablicy jednomianów, współczynniki negowane są w miejscu.
+ * @param[in] p : wielomian @f$p@f$
+ * @return @f$-p@f$
+ */
+Poly PolyNegOwn(Poly *p) {
+    assert(p != NULL);
+    Poly neg = PolyFromCoeff(-1);
+    if (!PolyIsUnique(p)) return PolyMulOwn(p, &neg);
+    // Negacja nie zeruje niezerowych współczynników, także modulo.
+    for (size_t i = 0; i < p->size; i++) {
+        p->arr[i].p = PolyNegOwn(&p->arr[i].p);
+    }
+    return *p;
+}
+
+/**
+ * Odejmuje wielomian od wielomianu, przejmując oba na własność: po wywołaniu
+ * nie należy ich używać ani usuwać (patrz: PolyAddOwn()).
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p - q@f$
+ */
+Poly PolySubOwn(Poly *p, Poly *q) {
+    assert(p != NULL && q != NULL);
+    Poly q_neg = PolyNegOwn(q);
+    return PolyAddOwn(p, &q_neg);
+}
+
+/**
+ * Zwraca stopień wielomianu ze względu na zadaną zmienną (-1 dla wielomianu
+ * tożsamościowo równego zeru). Dla pierwszych POLY_META_LEVELS zmiennych
+ * stopień jest zapamiętany w danych wielomianu (patrz: PolyMeta). Dla
+ * dalszych zmiennych przechodzone są tylko poddrzewa, w których zmienna
+ * może występować.
+ * @param[in] p : wielomian
+ * @param[in] var_idx : indeks zmiennej
+ * @return stopień wielomianu @p p z względu na zmienną o indeksie @p var_idx
+ */
+static poly_exp_t PolyDegByHelper(const Poly *p, size_t var_idx) {
+    if (PolyIsCoeff(p)) {
+        if (PolyIsZero(p)) return -1;
+        else return 0;
+    }
+    const PolyMeta *meta = PolyGetMeta(p);
+    if (var_idx < POLY_META_LEVELS) return meta->deg_by[var_idx];
+    if (!MetaHasVar(meta->vars, var_idx)) return 0;
+    // Stopień wielomianu ze względu na daną zmienną jest równy maksimum ze
+    // stopni tworzących go jednomianów (ze względu na tę zmienną).
+    poly_exp_t max_exp = -1;
+    for (size_t i = 0; i < p->size; i++) {
+        poly_exp_t curr_poly_deg = PolyDegByHelper(&p->arr[i].p, var_idx - 1);
+        if (curr_poly_deg > max_exp) {
+            max_exp = curr_poly_deg;
+        }
+    }
+    return max_exp;
+}
+
+/**
+ * Zwraca stopień wielomianu ze względu na zadaną zmienną (-1 dla wielomianu
+ * tożsamościowo równego zeru). Zmienne indeksowane są od 0.
+ * Zmienna o indeksie 0 oznacza zmienną główną tego wielomianu.
+ * Większe indeksy oznaczają zmienne wielomianów znajdujących się
+ * we współczynnikach.
+ * @param[in] p : wielomian
+ * @param[in] var_idx : indeks zmiennej
+ * @return stopień wielomianu @p p z względu na zmienną o indeksie @p var_idx
+ */
+poly_exp_t PolyDegBy(const Poly *p, size_t var_idx) {
+    assert(p != NULL);
+    return PolyDegByHelper(p, var_idx);
 }
 
 /**
  * Zwraca stopień wielomianu (-1 dla wielomianu tożsamościowo równego zeru).
+ * Stopień przekraczający zakres typu poly_exp_t jest nasycany do INT_MAX.
+ * Stopień jest zapamiętany w danych wielomianu (patrz: PolyMeta).
  * @param[in] p : wielomian
  * @return stopień wielomianu @p p
  */
-poly_exp_t PolyDeg(const Poly *p) {
+poly_exp_t PolyDeg(const Poly *p) {
+    assert(p != NULL);
+    if (PolyIsCoeff(p)) {
+        if (PolyIsZero(p)) return -1;
+        else return 0;
+    }
+    return PolyGetMeta(p)->deg;
+}
+
+/**
+ * Zwraca liczbę niezerowych współczynników liczbowych wielomianu, czyli
+ * liczbę jego wyrazów po rozwinięciu (nasycaną do SIZE_MAX).
+ * @param[in] p : wielomian
+ * @return liczba wyrazów wielomianu @p p
+ */
+size_t PolyTermCount(const Poly *p) {
+    assert(p != NULL);
+    if (PolyIsCoeff(p)) return PolyIsZero(p) ? 0 : 1;
+    return PolyGetMeta(p)->terms;
+}
+
+/**
+ * Sprawdza, czy zmienna o zadanym indeksie występuje w wielomianie
+ * z dodatnim wykładnikiem.
+ * @param[in] p : wielomian
+ * @param[in] var_idx : indeks zmiennej
+ * @return Czy zmienna występuje w wielomianie @p p?
+ */
+bool PolyHasVar(const Poly *p, size_t var_idx) {
+    assert(p != NULL);
+    if (PolyIsCoeff(p)) return false;
+    if (var_idx < 63) return MetaHasVar(PolyGetMeta(p)->vars, var_idx);
+    return PolyDegBy(p, var_idx) > 0;
+}
+
+static bool MonoIsEq(const Mono *m, const Mono *n);
+
+/**
+ * Sprawdza równość dwóch wielomianów.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p = q@f$
+ */
+bool PolyIsEq(const Poly *p, const Poly *q) {
+    assert(p != NULL && q != NULL);
+    if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
+        return CoeffIsEq(p, q);
+    }
+    else if (!PolyIsCoeff(p) && !PolyIsCoeff(q)) {
+        if (p->size != q->size) return false;
+        if (p->arr == q->arr) return true;
+        // Równe wielomiany mają równe dane.
+        const PolyMeta *p_meta = PolyGetMeta(p), *q_meta = PolyGetMeta(q);
+        if (p_meta->deg != q_meta->deg || p_meta->terms != q_meta->terms ||
+            p_meta->vars != q_meta->vars) {
+            return false;
+        }
+        // Równe internowane wielomiany współdzielą tablicę jednomianów.
+        if (ArrHeader(p->arr)->interned && ArrHeader(q->arr)->interned) {
+            return false;
+        }
+        for (size_t i = 0; i < p->size; i++) {
+            if (!MonoIsEq(&p->arr[i], &q->arr[i])) return false;
+        }
+        return true;
+    }
+    else {
+        return false;
+    }
+}
+
+/**
+ * Sprawdza równość dwóch jednomianów.
+ * @param[in] m : jednomian @f$m@f$
+ * @param[in] n : jednomian @f$n@f$
+ * @return @f$m = n@f$
+ */
+static bool MonoIsEq(const Mono *m, const Mono *n) {
+    assert(m != NULL && n != NULL);
+    if (m->exp != n->exp) return false;
+    return PolyIsEq(&m->p, &n->p);
+}
+
+/**
+ * Minimalna liczba jednomianów powstających przy wyliczaniu wartości
+ * wielomianu, od której praca jest dzielona między wątki puli.
+ */
+#define PARALLEL_AT_THRESHOLD ((size_t) 1 << 10)
+
+/**
+ * Mnoży wielomian przez współczynnik, mnożąc kolejno jego współczynniki
+ * liczbowe.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] c : współczynnik @f$c@f$
+ * @return @f$c p@f$
+ */
+static Poly PolyScale(const Poly *p, const Poly *c) {
+    if (PolyIsCoeff(p)) return CoeffMul(p, c);
+    Mono *arr = MonoArrAlloc(p->size);
+    size_t arr_size = 0;
+    for (size_t i = 0; i < p->size; i++) {
+        Poly scaled = PolyScale(&p->arr[i].p, c);
+        // Iloczyn może być zerem tylko przy obliczeniach modulo.
+        if (PolyIsZero(&scaled)) continue;
+        arr[arr_size++] = MonoFromPoly(&scaled, p->arr[i].exp);
+    }
+    if (arr_size != 0) arr = MonoArrShrink(arr, arr_size);
+    return PolyFromArrSimplify(arr, arr_size);
+}
+
+/**
+ * Zastępuje zmienną o indeksie 0 liczbami @p xs w jednomianach @p p od
+ * @p begin do @p end - 1. Współczynniki liczbowe sumowane są schematem
+ * Hornera, przechodząc jednomiany malejąco względem wykładników, więc
+ * potęgowane są tylko różnice kolejnych wykładników. Współczynniki niebędące
+ * liczbami przechodzone są rosnąco względem wykładników i mnożone przez
+ * potęgę @f$x@f$ wyliczaną z poprzedniej, a powstałe jednomiany zapisywane
+ * są w tablicach @p monos.
+ * @param[in] p : wielomian @f$p@f$ niebędący współczynnikiem
+ * @param[in] begin : indeks pierwszego jednomianu
+ * @param[in] end : indeks za ostatnim jednomianem
+ * @param[in] k : liczba punktów
+ * @param[in] xs : wartości argumentu @f$x@f$
+ * @param[out] monos : tablice na powstałe (niezredukowane) jednomiany,
+ * osobne dla kolejnych punktów, każda o co najmniej tylu elementach, ile
+ * wynosi suma wag (PolyWeight()) współczynników jednomianów
+ * @param[out] count : liczba jednomianów zapisanych w każdej z tablic
+ */
+static void AtMonos(const Poly *p, size_t begin, size_t end, size_t k,
+                    const poly_coeff_t xs[], Mono *monos[], size_t count[]) {
+    for (size_t t = 0; t < k; t++) {
+        count[t] = 0;
+    }
+    // Schemat Hornera dla współczynników liczbowych.
+    size_t last = end;
+    for (size_t i = begin; i < end; i++) {
+        const Poly *coeff = &p->arr[i].p;
+        if (!PolyIsCoeff(coeff)) continue;
+        for (size_t t = 0; t < k; t++) {
+            Poly *acc = &monos[t][count[t]].p;
+            if (last == end) {
+                *acc = PolyClone(coeff);
+                continue;
+            }
+            Poly x_pow = power(xs[t], p->arr[last].exp - p->arr[i].exp);
+            Poly scaled = CoeffMul(acc, &x_pow);
+            PolyDestroy(acc);
+            PolyDestroy(&x_pow);
+            *acc = CoeffAdd(&scaled, coeff);
+            PolyDestroy(&scaled);
+        }
+        last = i;
+    }
+    if (last != end) {
+        for (size_t t = 0; t < k; t++) {
+            Poly *acc = &monos[t][count[t]].p;
+            if (p->arr[last].exp > 0) {
+                Poly x_pow = power(xs[t], p->arr[last].exp);
+                Poly scaled = CoeffMul(acc, &x_pow);
+                PolyDestroy(acc);
+                PolyDestroy(&x_pow);
+                *acc = scaled;
+            }
+            monos[t][count[t]].exp = 0;
+            count[t]++;
+        }
+    }
+
+    // Współczynniki niebędące liczbami, od najmniejszego wykładnika.
+    ScratchMark mark = ScratchGetMark();
+    Poly *x_pow = ScratchAlloc(k * sizeof(Poly));
+    last = end;
+    for (size_t i = end; i-- > begin;) {
+        const Poly *coeff = &p->arr[i].p;
+        if (PolyIsCoeff(coeff)) continue;
+        for (size_t t = 0; t < k; t++) {
+            if (last == end) {
+                x_pow[t] = power(xs[t], p->arr[i].exp);
+            }
+            else {
+                Poly step = power(xs[t], p->arr[i].exp - p->arr[last].exp);
+                Poly new_pow = CoeffMul(&x_pow[t], &step);
+                PolyDestroy(&step);
+                PolyDestroy(&x_pow[t]);
+                x_pow[t] = new_pow;
+            }
+            if (PolyIsZero(&x_pow[t])) continue;
+            for (size_t j = 0; j < coeff->size; j++) {
+                Poly scaled = PolyScale(&coeff->arr[j].p, &x_pow[t]);
+                if (PolyIsZero(&scaled)) continue;
+                monos[t][count[t]++] = MonoFromPoly(&scaled, coeff->arr[j].exp);
+            }
+        }
+        last = i;
+    }
+    if (last != end) {
+        for (size_t t = 0; t < k; t++) {
+            PolyDestroy(&x_pow[t]);
+        }
+    }
+    ScratchRelease(mark);
+}
+
+/**
+ * To jest struktura przechowująca dane wyliczania wartości wielomianu
+ * dzielonego między wątki puli. Przy wyliczaniu wartości w jednym punkcie
+ * jednomiany @f$p@f$ podzielone są na @p chunks fragmentów przetwarzanych
+ * osobno, a przy wyliczaniu wartości w wielu punktach między fragmenty
+ * dzielone są punkty.
+ */
+typedef struct AtTask {
+    const Poly *p;          ///< wielomian @f$p@f$
+    size_t k;               ///< liczba punktów
+    const poly_coeff_t *xs; ///< wartości argumentu
+    size_t chunks;          ///< liczba fragmentów
+    Mono **monos;           ///< tablice na powstałe jednomiany
+    size_t *count;          ///< liczby jednomianów w tablicach
+} AtTask;
+
+/**
+ * Przetwarza jeden fragment jednomianów przy wyliczaniu wartości wielomianu
+ * w jednym punkcie. Niewykorzystane miejsca fragmentu w tablicy jednomianów
+ * wypełnia jednomianami zerowymi.
+ * @param[in,out] ctx : dane wyliczania (AtTask)
+ * @param[in] idx : numer fragmentu
+ */
+static void AtChunk(void *ctx, size_t idx) {
+    AtTask *task = ctx;
+    size_t begin = task->p->size * idx / task->chunks;
+    size_t end = task->p->size * (idx + 1) / task->chunks;
+    // Jednomiany fragmentu trafiają do [monos] za jednomianami powstałymi
+    // z wcześniejszych fragmentów.
+    size_t offset = 0, weight = 0;
+    for (size_t i = 0; i < begin; i++) {
+        offset += PolyWeight(&task->p->arr[i].p);
+    }
+    for (size_t i = begin; i < end; i++) {
+        weight += PolyWeight(&task->p->arr[i].p);
+    }
+    Mono *monos = task->monos[0] + offset;
+    size_t count;
+    AtMonos(task->p, begin, end, 1, task->xs, &monos, &count);
+    for (size_t i = count; i < weight; i++) {
+        Poly zero = PolyZero();
+        monos[i] = MonoFromPoly(&zero, 0);
+    }
+}
+
+/**
+ * Wylicza wartości wielomianu w jednym fragmencie punktów.
+ * @param[in,out] ctx : dane wyliczania (AtTask)
+ * @param[in] idx : numer fragmentu
+ */
+static void AtPointsChunk(void *ctx, size_t idx) {
+    AtTask *task = ctx;
+    size_t begin = task->k * idx / task->chunks;
+    size_t end = task->k * (idx + 1) / task->chunks;
+    AtMonos(task->p, 0, task->p->size, end - begin, task->xs + begin,
+            task->monos + begin, task->count + begin);
+}
+
+/**
+ * Daje wartość wielomianu w punkcie 0, czyli jego wyraz wolny względem
+ * zmiennej o indeksie 0.
+ * @param[in] p : wielomian @f$p@f$
+ * @return @f$p(0, x_0, x_1, \ldots)@f$
+ */
+static Poly PolyAtZero(const Poly *p) {
+    if (PolyIsCoeff(p)) return PolyClone(p);
+    // Tablica jednomianów jest posortowana malejąco względem wykładników.
+    const Mono *last = &p->arr[p->size - 1];
+    return last->exp == 0 ? PolyClone(&last->p) : PolyZero();
+}
+
+/**
+ * Wylicza wartość wielomianu w punkcie @p x.
+ * Wstawia pod pierwszą zmienną wielomianu wartość @p x.
+ * W wyniku może powstać wielomian, jeśli współczynniki są wielomianami.
+ * Wtedy zmniejszane są o jeden indeksy zmiennych w takim wielomianie.
+ * Formalnie dla wielomianu @f$p(x_0, x_1, x_2, \ldots)@f$ wynikiem jest
+ * wielomian @f$p(x, x_0, x_1, \ldots)@f$.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] x : wartość argumentu @f$x@f$
+ * @return @f$p(x, x_0, x_1, \ldots)@f$
+ */
+Poly PolyAt(const Poly *p, poly_coeff_t x) {
+    assert(p != NULL);
+    if (x == 0 || PolyIsCoeff(p)) return PolyAtZero(p);
+    size_t monos_size = 0; // To jest zmienna przechowująca górne ograniczenie
+    // liczby jednomianów po zastąpieniu zmiennych o indeksie 0 przez liczby.
+    for (size_t i = 0; i < p->size; i++) {
+        monos_size += PolyWeight(&p->arr[i].p);
+    }
+    ScratchMark mark = ScratchGetMark();
+    // To jest lista jednomianów, z których zostanie stworzony wynikowy
+    // wielomian.
+    Mono *monos = ScratchAlloc(monos_size * sizeof(Mono));
+    size_t threads = PoolThreads();
+    if (threads > 1 && p->size > 1 && monos_size >= PARALLEL_AT_THRESHOLD) {
+        AtTask task = {.p = p, .k = 1, .xs = &x, .monos = &monos};
+        task.chunks = p->size < threads ? p->size : threads;
+        PoolParallelFor(task.chunks, AtChunk, &task);
+    }
+    else {
+        AtMonos(p, 0, p->size, 1, &x, &monos, &monos_size);
+    }
+    Poly res = PolyAddMonos(monos_size, monos);
+    ScratchRelease(mark);
+    return res;
+}
+
+/**
+ * Wylicza wartość wielomianu w punkcie @p x (patrz: PolyAt()), przejmując
+ * @p p na własność: po wywołaniu nie należy go używać ani usuwać. Jeśli @p p
+ * jest jedynym właścicielem swojej tablicy jednomianów, wyraz wolny (dla
+ * @f$x = 0@f$) lub współczynnik jedynego jednomianu są przenoszone do wyniku
+ * zamiast kopiowania.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] x : wartość argumentu @f$x@f$
+ * @return @f$p(x, x_0, x_1, \ldots)@f$
+ */
+Poly PolyAtOwn(Poly *p, poly_coeff_t x) {
     assert(p != NULL);
+    if (PolyIsCoeff(p)) return *p;
+    if (!PolyIsUnique(p) || (x != 0 && p->size > 1)) {
+        Poly res = PolyAt(p, x);
+        PolyDestroy(p);
+        return res;
+    }
+    // Tablica jednomianów jest posortowana malejąco względem wykładników.
+    Mono last = p->arr[p->size - 1];
+    for (size_t i = 0; i + 1 < p->size; i++) {
+        MonoDestroy(&p->arr[i]);
+    }
+    MonoArrFree(p->arr);
+    if (x == 0) {
+        if (last.exp == 0) return last.p;
+        MonoDestroy(&last);
+        return PolyZero();
+    }
+    Poly pw = power(x, last.exp);
+    return PolyMulOwn(&last.p, &pw);
+}
+
+/**
+ * Wylicza wartości wielomianu w punktach @p xs w jednym przejściu po jego
+ * jednomianach (patrz: PolyAt()). Jeśli pula wątków jest uruchomiona,
+ * punkty dzielone są między wątki.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] k : liczba punktów
+ * @param[in] xs : wartości argumentu: @f$x_0, x_1, \ldots, x_{k-1}@f$
+ * @param[out] res : wartości @f$p(x_0, \ldots), p(x_1, \ldots), \ldots,
+ * p(x_{k-1}, \ldots)@f$
+ */
+void PolyAtMulti(const Poly *p, size_t k, const poly_coeff_t xs[], Poly res[]) {
+    assert(p != NULL && (k == 0 || (xs != NULL && res != NULL)));
     if (PolyIsCoeff(p)) {
-        if (PolyIsZero(p)) return -1;
-        else return 0;
+        for (size_t t = 0; t < k; t++) {
+            res[t] = PolyClone(p);
+        }
+        return;
+    }
+    size_t monos_size = 0;
+    for (size_t i = 0; i < p->size; i++) {
+        monos_size += PolyWeight(&p->arr[i].p);
+    }
+    ScratchMark mark = ScratchGetMark();
+    Mono **monos = ScratchAlloc(k * sizeof(Mono*));
+    size_t *count = ScratchAlloc(k * sizeof(size_t));
+    for (size_t t = 0; t < k; t++) {
+        monos[t] = ScratchAlloc(monos_size * sizeof(Mono));
+    }
+    size_t threads = PoolThreads();
+    if (threads > 1 && k > 1 && k * monos_size >= PARALLEL_AT_THRESHOLD) {
+        AtTask task = {.p = p, .k = k, .xs = xs, .monos = monos,
+                       .count = count};
+        task.chunks = k < threads ? k : threads;
+        PoolParallelFor(task.chunks, AtPointsChunk, &task);
+    }
+    else {
+        AtMonos(p, 0, p->size, k, xs, monos, count);
+    }
+    for (size_t t = 0; t < k; t++) {
+        res[t] = PolyAddMonos(count[t], monos[t]);
+    }
+    ScratchRelease(mark);
+}
+
+/**
+ * Największy stosunek liczby wyrazów wielomianu do liczby wyrazów wielomianu
+ * gęstego o tych samych stopniach ze względu na zmienne, przy którym PolyPow()
+ * używa metod dla wielomianów rzadkich.
+ */
+#define POW_SPARSE_DENSITY 0.25
+
+/**
+ * Największa liczba jednomianów wielomianu jednej zmiennej, dla której
+ * PolyPow() używa rekurencji Millera. Koszt wyliczenia każdego współczynnika
+ * potęgi jest proporcjonalny do liczby jednomianów.
+ */
+#define POW_MILLER_MAX_TERMS 16
+
+/**
+ * Najmniejszy wykładnik, dla którego PolyPow() używa metod dla wielomianów
+ * rzadkich jednej zmiennej. Dla mniejszych wykładników szybsze jest
+ * podnoszenie do kwadratu.
+ */
+#define POW_UNI_SPARSE_MIN_EXP 4
+
+/**
+ * Podnosi wielomian do potęgi naturalnej przez podnoszenie do kwadratu.
+ * Wykładnik przetwarzany jest od najstarszego bitu, więc jedynym czynnikiem
+ * oprócz kwadratów jest sam wielomian @p p, a kwadraty nie są kopiowane.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] n : wykładnik @f$n > 0@f$
+ * @return @f$p^n@f$
+ */
+static Poly PowSquaring(const Poly *p, poly_exp_t n) {
+    assert(n > 0);
+    int bit = 0;
+    while ((n >> bit) > 1) bit++;
+    Poly res = PolyClone(p);
+    while (bit-- > 0) {
+        Poly squared = PolyMul(&res, &res);
+        PolyDestroy(&res);
+        res = squared;
+        if ((n >> bit & 1) != 0) {
+            Poly new_res = PolyMul(&res, p);
+            PolyDestroy(&res);
+            res = new_res;
+        }
+    }
+    return res;
+}
+
+/**
+ * Sprawdza, czy wielomian ma mało wyrazów w porównaniu z wielomianem gęstym
+ * o tych samych stopniach ze względu na kolejne zmienne.
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @return Czy wielomian jest rzadki?
+ */
+static bool PolyIsSparse(const Poly *p) {
+    uint64_t vars = PolyGetMeta(p)->vars;
+    if ((vars & POLY_META_HIGH_VARS) != 0) return false;
+    double dense_terms = 1;
+    for (size_t i = 0; vars >> i != 0; i++) {
+        dense_terms *= (double) PolyDegBy(p, i) + 1;
+    }
+    return (double) PolyTermCount(p) <= POW_SPARSE_DENSITY * dense_terms;
+}
+
+/**
+ * Daje największy wspólny dzielnik dwóch liczb naturalnych.
+ * @param[in] a : liczba @f$a@f$
+ * @param[in] b : liczba @f$b@f$
+ * @return @f$\gcd(a, b)@f$
+ */
+static poly_exp_t ExpGcd(poly_exp_t a, poly_exp_t b) {
+    while (b != 0) {
+        poly_exp_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+/**
+ * Podnosi wielomian jednej zmiennej do potęgi naturalnej rekurencją Millera.
+ * Wielomian ma postać @f$x^s a(x^g)@f$, gdzie @f$a(y) = \sum_{i=0}^{d} a_i y^i@f$
+ * i @f$a_0 \neq 0@f$. Współczynniki @f$b_k@f$ potęgi @f$a^n@f$ spełniają
+ * @f$b_0 = a_0^n@f$ i @f$k a_0 b_k = \sum_{i=1}^{\min(k, d)}
+ * ((n + 1) i - k) a_i b_{k-i}@f$, więc każdy z nich wyliczany jest
+ * z jednomianów @p p i poprzednich współczynników, bez mnożenia wielomianów.
+ * Dzielenie jest dokładne, dlatego współczynniki nie mogą być liczone modulo.
+ * @param[in] p : wielomian zmiennej @f$x_0@f$ o co najmniej dwóch
+ * jednomianach i współczynnikach liczbowych; współczynnik najniższego
+ * jednomianu nie jest duży i jego wartość bezwzględna mieści się
+ * w typie uint32_t
+ * @param[in] n : wykładnik @f$n > 1@f$
+ * @return @f$p^n@f$
+ */
+static Poly PowMiller(const Poly *p, poly_exp_t n) {
+    assert(!ModEnabled() && p->size >= 2);
+    const Mono *low = &p->arr[p->size - 1];
+    poly_exp_t shift = low->exp, step = 0;
+    for (size_t j = 0; j + 1 < p->size; j++) {
+        step = ExpGcd(p->arr[j].exp - shift, step);
+    }
+    poly_coeff_t a0 = low->p.coeff;
+    // Zakres współczynnika sprawdza MillerWorthwhile(), więc -a0 nie
+    // przekracza zakresu typu.
+    assert(a0 >= -(poly_coeff_t) UINT32_MAX && a0 <= (poly_coeff_t) UINT32_MAX);
+    uint32_t a0_abs = (uint32_t) (a0 < 0 ? -a0 : a0);
+    size_t len = (size_t) n * (size_t) ((p->arr[0].exp - shift) / step) + 1;
+    Poly *b = malloc(len * sizeof(Poly));
+    if (b == NULL) exit(1); // Błąd podczas alokacji pamięci.
+
+    b[0] = power(a0, n);
+    for (size_t k = 1; k < len; k++) {
+        Poly sum = PolyZero();
+        // Jednomiany przeglądane są od najniższego, czyli rosnąco względem [i].
+        for (size_t j = p->size - 1; j-- > 0;) {
+            size_t i = (size_t) ((p->arr[j].exp - shift) / step);
+            if (i > k) break;
+            poly_coeff_t factor = ((poly_coeff_t) n + 1) * (poly_coeff_t) i
+                                  - (poly_coeff_t) k;
+            if (factor == 0 || PolyIsZero(&b[k - i])) continue;
+            Poly factor_poly = PolyFromCoeff(factor);
+            Poly scaled = CoeffMul(&factor_poly, &p->arr[j].p);
+            Poly term = CoeffMul(&scaled, &b[k - i]);
+            Poly new_sum = CoeffAdd(&sum, &term);
+            PolyDestroy(&scaled);
+            PolyDestroy(&term);
+            PolyDestroy(&sum);
+            sum = new_sum;
+        }
+        Poly quotient = BigCoeffDivExact(&sum, (uint32_t) k);
+        b[k] = BigCoeffDivExact(&quotient, a0_abs);
+        PolyDestroy(&sum);
+        PolyDestroy(&quotient);
+        if (a0 < 0) b[k] = PolyNegOwn(&b[k]);
+    }
+
+    size_t count = 0;
+    for (size_t k = 0; k < len; k++) {
+        if (!PolyIsZero(&b[k])) count++;
+    }
+    Mono *arr = MonoArrAlloc(count);
+    count = 0;
+    for (size_t k = len; k-- > 0;) {
+        if (!PolyIsZero(&b[k])) {
+            arr[count++] = MonoFromPoly(&b[k], shift * n
+                                               + step * (poly_exp_t) k);
+        }
+    }
+    free(b);
+    return PolyArrMonos(count, arr);
+}
+
+/**
+ * Sprawdza, czy wielomian można podnieść do potęgi rekurencją Millera
+ * (patrz: PowMiller()) i czy jest to opłacalne.
+ * @param[in] p : wielomian o co najmniej dwóch jednomianach
+ * @return Czy użyć rekurencji Millera?
+ */
+static bool MillerWorthwhile(const Poly *p) {
+    if (ModEnabled() || PolyGetMeta(p)->vars != 1 ||
+        p->size > POW_MILLER_MAX_TERMS || !PolyIsSparse(p)) {
+        return false;
+    }
+    const Poly *a0 = &p->arr[p->size - 1].p;
+    return !PolyIsBigCoeff(a0) && a0->coeff >= -(poly_coeff_t) UINT32_MAX &&
+           a0->coeff <= (poly_coeff_t) UINT32_MAX;
+}
+
+/**
+ * Dopisuje jednomiany wielomianu do powiększanej tablicy jednomianów
+ * i usuwa go z pamięci.
+ * @param[in,out] monos : tablica jednomianów przydzielona przez MonoArrAlloc()
+ * @param[in,out] count : liczba jednomianów w tablicy
+ * @param[in,out] capacity : pojemność tablicy
+ * @param[in] p : wielomian
+ */
+static void AppendMonos(Mono **monos, size_t *count, size_t *capacity,
+                        Poly *p) {
+    if (PolyIsZero(p)) return;
+    size_t size = PolyIsCoeff(p) ? 1 : p->size;
+    if (*count + size > *capacity) {
+        while (*count + size > *capacity) *capacity *= 2;
+        *monos = MonoArrGrow(*monos, *capacity);
+    }
+    if (PolyIsCoeff(p)) {
+        (*monos)[(*count)++] = MonoFromPoly(p, 0);
+        return;
+    }
+    for (size_t i = 0; i < p->size; i++) {
+        (*monos)[(*count)++] = MonoClone(&p->arr[i]);
+    }
+    PolyDestroy(p);
+}
+
+/**
+ * Podnosi wielomian do potęgi naturalnej, rozwijając dwumian
+ * @f$(m + r)^n = \sum_{j=0}^{n} \binom{n}{j} m^{n-j} r^j@f$, gdzie
+ * @f$m = a x_0^e@f$ jest najwyższym jednomianem @p p, a @f$r@f$ - resztą
+ * wielomianu. Potęgi @f$r@f$ wyliczane są kolejnym mnożeniem przez @f$r@f$,
+ * co dla wielomianów rzadkich jest tańsze niż podnoszenie do kwadratu,
+ * a mnożenie przez @f$m^{n-j}@f$ jest mnożeniem przez jeden jednomian.
+ * Jednomiany wszystkich składników sumowane są naraz. Współczynniki
+ * dwumianowe wyliczane są z dzieleniem, więc nie mogą być liczone modulo.
+ * @param[in] p : wielomian o co najmniej dwóch jednomianach
+ * @param[in] n : wykładnik @f$n > 1@f$
+ * @return @f$p^n@f$
+ */
+static Poly PowBinomial(const Poly *p, poly_exp_t n) {
+    assert(!ModEnabled() && p->size >= 2);
+    const Poly *a = &p->arr[0].p;
+    poly_exp_t e = p->arr[0].exp;
+    Mono *rest = MonoArrAlloc(p->size - 1);
+    for (size_t i = 1; i < p->size; i++) rest[i - 1] = MonoClone(&p->arr[i]);
+    Poly r = PolyArrMonos(p->size - 1, rest);
+
+    // Potęgi [a] od zerowej do n-tej.
+    Poly *a_pow = malloc(((size_t) n + 1) * sizeof(Poly));
+    if (a_pow == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    a_pow[0] = PolyFromCoeff(1);
+    for (size_t k = 1; k <= (size_t) n; k++) a_pow[k] = PolyMul(&a_pow[k - 1], a);
+
+    size_t count = 0, capacity = 16;
+    Mono *monos = MonoArrAlloc(capacity);
+    Poly binom = PolyFromCoeff(1), r_pow = PolyFromCoeff(1);
+    for (poly_exp_t j = 0; j <= n; j++) {
+        // Składnik binom * a^{n-j} x_0^{e(n-j)} * r^j.
+        Mono *lead = MonoArrAlloc(1);
+        Poly c = PolyMul(&binom, &a_pow[n - j]);
+        lead[0] = MonoFromPoly(&c, e * (n - j));
+        Poly m_pow = PolyArrMonos(1, lead);
+        Poly term = PolyMul(&m_pow, &r_pow);
+        PolyDestroy(&m_pow);
+        AppendMonos(&monos, &count, &capacity, &term);
+        if (j == n) break;
+
+        Poly new_r_pow = PolyMul(&r_pow, &r);
+        PolyDestroy(&r_pow);
+        r_pow = new_r_pow;
+        Poly factor = PolyFromCoeff(n - j);
+        Poly product = CoeffMul(&binom, &factor);
+        PolyDestroy(&binom);
+        binom = BigCoeffDivExact(&product, (uint32_t) j + 1);
+        PolyDestroy(&product);
+    }
+    PolyDestroy(&binom);
+    PolyDestroy(&r_pow);
+    PolyDestroy(&r);
+    for (size_t k = 0; k <= (size_t) n; k++) PolyDestroy(&a_pow[k]);
+    free(a_pow);
+    // Składnik dla j = 0 jest niezerowy, więc tablica nie jest pusta.
+    return PolyArrMonos(count, monos);
+}
+
+/**
+ * Podnosi wielomian do potęgi naturalnej. Dla wielomianów gęstych używa
+ * podnoszenia do kwadratu, a dla rzadkich (o mało wyrazach w porównaniu
+ * z wielomianem gęstym tych samych stopni): rekurencji Millera dla
+ * wielomianów jednej zmiennej i rozwinięcia dwumianu najwyższego jednomianu
+ * i reszty dla pozostałych.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] n : wykładnik @f$n \geq 0@f$; @f$n@f$ razy stopień @p p ze
+ * względu na każdą zmienną mieści się w typie poly_exp_t
+ * @return @f$p^n@f$
+ */
+Poly PolyPow(const Poly *p, poly_exp_t n) {
+    assert(p != NULL && n >= 0);
+    if (n == 0) return PolyFromCoeff(1);
+    if (n == 1) return PolyClone(p);
+    if (PolyIsCoeff(p)) {
+        return PolyIsBigCoeff(p) ? PowSquaring(p, n) : power(p->coeff, n);
+    }
+    if (p->size == 1) {
+        // (a x_0^e)^n = a^n x_0^{en}.
+        Poly a_pow = PolyPow(&p->arr[0].p, n);
+        if (PolyIsZero(&a_pow)) return a_pow; // Modulo liczba złożona.
+        Mono *arr = MonoArrAlloc(1);
+        arr[0] = MonoFromPoly(&a_pow, p->arr[0].exp * n);
+        return PolyArrMonos(1, arr);
+    }
+    if (PolyGetMeta(p)->vars == 1 && n < POW_UNI_SPARSE_MIN_EXP) {
+        return PowSquaring(p, n);
+    }
+    if (MillerWorthwhile(p)) return PowMiller(p, n);
+    if (!ModEnabled() && PolyIsSparse(p)) return PowBinomial(p, n);
+    return PowSquaring(p, n);
+}
+
+/**
+ * To jest struktura przechowująca potęgi jednego z wielomianów @f$q_i@f$
+ * potrzebne podczas złożenia. Najpierw zbierane są wykładniki, potem potęgi
+ * wyliczane są jednokrotnie i od tej pory są tylko odczytywane, także
+ * równolegle przez wątki puli.
+ */
+typedef struct PowerCache {
+    size_t count;       ///< liczba wykładników
+    size_t capacity;    ///< pojemność tablicy wykładników
+    poly_exp_t *exps;   ///< wykładniki, po wyliczeniu potęg posortowane
+                        ///< rosnąco i bez powtórzeń
+    Poly *powers;       ///< potęgi o kolejnych wykładnikach
+} PowerCache;
+
+/**
+ * To jest struktura przechowująca dane jednego złożenia.
+ */
+typedef struct ComposeCtx {
+    size_t k;           ///< liczba wielomianów @f$q_i@f$
+    const Poly *q;      ///< lista wielomianów @f$q_i@f$
+    PowerCache *cache;  ///< potęgi kolejnych wielomianów @f$q_i@f$
+} ComposeCtx;
+
+/**
+ * Minimalna liczba jednomianów wielomianu, od której złożenia jego
+ * współczynników są wyliczane równolegle przez wątki puli.
+ */
+#define PARALLEL_COMPOSE_THRESHOLD 8
+
+/**
+ * Początkowa pojemność tablicy wykładników potęg.
+ */
+#define POWER_CACHE_INITIAL_CAPACITY 16
+
+/**
+ * Dopisuje wykładnik potrzebnej potęgi.
+ * @param[in,out] cache : potęgi wielomianu
+ * @param[in] exp : wykładnik
+ */
+static void PowerCacheAdd(PowerCache *cache, poly_exp_t exp) {
+    if (exp == 0) return;
+    if (cache->count == cache->capacity) {
+        cache->capacity = cache->capacity == 0 ? POWER_CACHE_INITIAL_CAPACITY
+                                               : 2 * cache->capacity;
+        cache->exps = realloc(cache->exps,
+                              cache->capacity * sizeof(poly_exp_t));
+        if (cache->exps == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    }
+    cache->exps[cache->count++] = exp;
+}
+
+/**
+ * Sprawdza, czy w wielomianie, którego zmienne indeksowane są od @p depth,
+ * występuje któraś ze zmiennych @f$x_{depth}, \ldots, x_{k-1}@f$, pod które
+ * podstawiane są wielomiany @f$q_i@f$ (patrz: PolyMeta).
+ * @param[in] ctx : dane złożenia
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @param[in] depth : liczba, od której indeksowane są zmienne w @p p
+ * @return Czy w @p p występuje zmienna, pod którą podstawiany jest
+ * wielomian?
+ */
+static bool HasSubstitutedVars(const ComposeCtx *ctx, const Poly *p,
+                               size_t depth) {
+    if (depth >= ctx->k) return false;
+    size_t count = ctx->k - depth;
+    uint64_t vars = PolyGetMeta(p)->vars;
+    return count >= 64 || (vars & (((uint64_t) 1 << count) - 1)) != 0;
+}
+
+/**
+ * Daje wyraz wolny wielomianu, czyli jego wartość, gdy pod wszystkie
+ * zmienne podstawione jest zero.
+ * @param[in] p : wielomian
+ * @return @f$p(0, 0, \ldots)@f$
+ */
+static Poly PolyConstTerm(const Poly *p) {
+    // Tablice jednomianów są posortowane malejąco względem wykładników.
+    while (!PolyIsCoeff(p)) {
+        const Mono *last = &p->arr[p->size - 1];
+        if (last->exp != 0) return PolyZero();
+        p = &last->p;
+    }
+    return PolyClone(p);
+}
+
+/**
+ * Zbiera wykładniki potęg wielomianów @f$q_i@f$, przez które mnożone są
+ * wyniki pośrednie podczas złożenia wielomianu @p p, którego zmienne
+ * indeksowane są od @p depth (patrz: ComposeRec()).
+ * @param[in,out] ctx : dane złożenia
+ * @param[in] p : wielomian
+ * @param[in] depth : liczba, od której indeksowane są zmienne w @p p
+ */
+static void CollectPowers(const ComposeCtx *ctx, const Poly *p, size_t depth) {
+    if (PolyIsCoeff(p) || !HasSubstitutedVars(ctx, p, depth)) return;
+    const Mono *last = &p->arr[p->size - 1];
+    if (depth >= ctx->k) {
+        if (last->exp == 0) CollectPowers(ctx, &last->p, depth + 1);
+        return;
+    }
+    PowerCache *cache = &ctx->cache[depth];
+    for (size_t i = 1; i < p->size; i++) {
+        PowerCacheAdd(cache, p->arr[i - 1].exp - p->arr[i].exp);
+    }
+    PowerCacheAdd(cache, last->exp);
+    for (size_t i = 0; i < p->size; i++) {
+        CollectPowers(ctx, &p->arr[i].p, depth + 1);
+    }
+}
+
+/**
+ * Porównuje wykładniki.
+ * @param[in] fst : wskaźnik na pierwszy wykładnik
+ * @param[in] snd : wskaźnik na drugi wykładnik
+ * @return liczba ujemna, zero lub dodatnia, jeśli pierwszy wykładnik jest
+ * odpowiednio mniejszy, równy lub większy od drugiego
+ */
+static int CompareExps(const void *fst, const void *snd) {
+    poly_exp_t a = *(const poly_exp_t*) fst, b = *(const poly_exp_t*) snd;
+    return (a > b) - (a < b);
+}
+
+/**
+ * Wylicza potęgi wielomianu o zebranych wykładnikach. Każda potęga jest
+ * iloczynem potęg @f$q^{2^j}@f$, które wyliczane są tylko raz.
+ * @param[in,out] cache : potęgi wielomianu
+ * @param[in] q : wielomian
+ */
+static void PowerCacheFill(PowerCache *cache, const Poly *q) {
+    if (cache->count == 0) return;
+    CountOp(&count_sorts, 1);
+    qsort(cache->exps, cache->count, sizeof(poly_exp_t), CompareExps);
+    size_t unique = 1;
+    for (size_t i = 1; i < cache->count; i++) {
+        if (cache->exps[i] != cache->exps[unique - 1]) {
+            cache->exps[unique++] = cache->exps[i];
+        }
+    }
+    cache->count = unique;
+    cache->powers = malloc(cache->count * sizeof(Poly));
+    if (cache->powers == NULL) exit(1); // Błąd podczas alokacji pamięci.
+
+    // Potęgi q^(2^j) dla 2^j nie większych od największego wykładnika.
+    poly_exp_t max_exp = cache->exps[cache->count - 1];
+    size_t bits = 0;
+    while (bits < sizeof(poly_exp_t) * CHAR_BIT - 1 && (max_exp >> bits) > 1) {
+        bits++;
+    }
+    Poly squares[sizeof(poly_exp_t) * CHAR_BIT];
+    squares[0] = PolyClone(q);
+    for (size_t j = 1; j <= bits; j++) {
+        squares[j] = PolyMul(&squares[j - 1], &squares[j - 1]);
+    }
+    for (size_t i = 0; i < cache->count; i++) {
+        Poly res = PolyZero();
+        bool empty = true;
+        for (size_t j = 0; j <= bits; j++) {
+            if (!((cache->exps[i] >> j) & 1)) continue;
+            if (empty) {
+                res = PolyClone(&squares[j]);
+                empty = false;
+            }
+            else {
+                Poly new_res = PolyMul(&res, &squares[j]);
+                PolyDestroy(&res);
+                res = new_res;
+            }
+        }
+        cache->powers[i] = res;
+    }
+    for (size_t j = 0; j <= bits; j++) {
+        PolyDestroy(&squares[j]);
+    }
+}
+
+/**
+ * Zwraca zapamiętaną potęgę wielomianu.
+ * @param[in] cache : potęgi wielomianu
+ * @param[in] exp : wykładnik potęgi, zebrany przez CollectPowers()
+ * @return wskaźnik na potęgę o wykładniku @p exp
+ */
+static const Poly* PowerCacheGet(const PowerCache *cache, poly_exp_t exp) {
+    size_t begin = 0, end = cache->count;
+    while (end - begin > 1) {
+        size_t mid = begin + (end - begin) / 2;
+        if (cache->exps[mid] <= exp) begin = mid;
+        else end = mid;
+    }
+    assert(cache->exps[begin] == exp);
+    return &cache->powers[begin];
+}
+
+/**
+ * Usuwa z pamięci zapamiętane potęgi wielomianu.
+ * @param[in] cache : potęgi wielomianu
+ */
+static void PowerCacheDestroy(PowerCache *cache) {
+    if (cache->powers != NULL) {
+        for (size_t i = 0; i < cache->count; i++) {
+            PolyDestroy(&cache->powers[i]);
+        }
+    }
+    free(cache->powers);
+    free(cache->exps);
+}
+
+/**
+ * Mnoży wielomian przez zapamiętaną potęgę @f$q_{depth}@f$ i usuwa go
+ * z pamięci.
+ * @param[in] ctx : dane złożenia
+ * @param[in] p : wielomian
+ * @param[in] depth : indeks wielomianu @f$q_{depth}@f$
+ * @param[in] exp : wykładnik potęgi
+ * @return @f$p \cdot q_{depth}^{exp}@f$
+ */
+static Poly MulByPower(const ComposeCtx *ctx, Poly p, size_t depth,
+                       poly_exp_t exp) {
+    if (exp == 0) return p;
+    Poly res = PolyMul(&p, PowerCacheGet(&ctx->cache[depth], exp));
+    PolyDestroy(&p);
+    return res;
+}
+
+static Poly ComposeRec(const ComposeCtx *ctx, const Poly *p, size_t depth);
+
+/**
+ * To jest struktura przechowująca dane równoległego wyliczania złożeń
+ * współczynników wielomianu.
+ */
+typedef struct ComposeTask {
+    const ComposeCtx *ctx;  ///< dane złożenia
+    const Poly *p;          ///< wielomian @f$p@f$
+    size_t depth;           ///< liczba, od której indeksowane są zmienne
+                            ///< w @f$p@f$
+    Poly *coeffs;           ///< złożenia kolejnych współczynników @f$p@f$
+} ComposeTask;
+
+/**
+ * Wylicza złożenie jednego współczynnika wielomianu.
+ * @param[in,out] ctx : dane wyliczania (ComposeTask)
+ * @param[in] idx : indeks jednomianu
+ */
+static void ComposeCoeff(void *ctx, size_t idx) {
+    ComposeTask *task = ctx;
+    task->coeffs[idx] = ComposeRec(task->ctx, &task->p->arr[idx].p,
+                                   task->depth + 1);
+}
+
+/**
+ * Sprawdza, czy któryś ze współczynników wielomianu nie jest stałą.
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @return Czy któryś ze współczynników @p p nie jest stałą?
+ */
+static bool HasPolyCoeffs(const Poly *p) {
+    for (size_t i = 0; i < p->size; i++) {
+        if (!PolyIsCoeff(&p->arr[i].p)) return true;
+    }
+    return false;
+}
+
+/**
+ * Zwraca złożenie wielomianu @p p z wielomianami @f$q_{depth}, q_{depth+1},
+ * \ldots@f$. Zachowuje się tak jak PolyCompose() poza tym, że zmienne
+ * wielomianu @p p są indeksowane od @p depth. Wynik liczony jest schematem
+ * Hornera: wynik pośredni mnożony jest przez potęgę @f$q_{depth}@f$ równą
+ * różnicy kolejnych wykładników i dodawane jest do niego złożenie kolejnego
+ * współczynnika, więc żaden jednomian nie jest osobno mnożony przez pełną
+ * potęgę @f$q_{depth}@f$. Jeśli pula wątków jest uruchomiona, złożenia
+ * współczynników niebędących stałymi wyliczane są najpierw równolegle.
+ * @param[in] ctx : dane złożenia
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] depth : liczba, od której indeksowane są zmienne w @p p
+ * @return @f$p(q_{depth}, q_{depth+1}, …)@f$
+ */
+static Poly ComposeRec(const ComposeCtx *ctx, const Poly *p, size_t depth) {
+    if (PolyIsCoeff(p)) return PolyClone(p);
+    // Pod pozostałe zmienne podstawiane jest zero, więc zostaje tylko wyraz
+    // wolny.
+    if (!HasSubstitutedVars(ctx, p, depth)) return PolyConstTerm(p);
+    const Mono *last = &p->arr[p->size - 1];
+    ScratchMark mark = ScratchGetMark();
+    ComposeTask task = {.ctx = ctx, .p = p, .depth = depth, .coeffs = NULL};
+    if (PoolThreads() > 1 && p->size >= PARALLEL_COMPOSE_THRESHOLD
+        && HasPolyCoeffs(p)) {
+        task.coeffs = ScratchAlloc(p->size * sizeof(Poly));
+        PoolParallelFor(p->size, ComposeCoeff, &task);
+    }
+    Poly res = task.coeffs != NULL ? task.coeffs[0]
+                                   : ComposeRec(ctx, &p->arr[0].p, depth + 1);
+    for (size_t i = 1; i < p->size; i++) {
+        res = MulByPower(ctx, res, depth, p->arr[i - 1].exp - p->arr[i].exp);
+        Poly c = task.coeffs != NULL ? task.coeffs[i]
+                                     : ComposeRec(ctx, &p->arr[i].p, depth + 1);
+        Poly sum = PolyAdd(&res, &c);
+        PolyDestroy(&res);
+        PolyDestroy(&c);
+        res = sum;
+    }
+    ScratchRelease(mark);
+    return MulByPower(ctx, res, depth, last->exp);
+}
+
+/**
+ * Zwraca złożenie wielomianu @p p z wielomianami @f$q_0, q_1, \ldots@f$ .
+ * Niech @f$l@f$ oznacza liczbę zmiennych wielomianu @p p i niech te zmienne
+ * są oznaczone odpowiednio @f$x_0, x_1, …, x_{l−1}@f$. Wynikiem złożenia jest
+ * wielomian @f$p(q_0,q_1,q_2,…)@f$, czyli wielomian powstający przez podstawienie
+ * w wielomianie @p p pod zmienną @f$x_i@f$ wielomianu @f$q_i@f$
+ * dla @f$i=0,1,2,…,min(k,l)−1@f$. Jeśli @f$k<l@f$, to pod zmienne @f$x_k, …,
+ * x_{l−1}@f$ podstawiane są zera. Potęgi wielomianów @f$q_i@f$ wyliczane są
+ * raz na całe złożenie i współdzielone przez wszystkie poziomy zagnieżdżenia.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] k : liczba wielomianów @f$q_i@f$
+ * @param[in] q : lista wielomianów: @f$q_0, q_1, \ldots, q_{k-1}@f$
+ * @return @f$p(q_0, q_1, q_2, …)@f$
+ */
+Poly PolyCompose(const Poly *p, size_t k, const Poly q[]) {
+    ComposeCtx ctx = {.k = k, .q = q};
+    ctx.cache = calloc(k > 0 ? k : 1, sizeof(PowerCache));
+    if (ctx.cache == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    CollectPowers(&ctx, p, 0);
+    for (size_t i = 0; i < k; i++) {
+        PowerCacheFill(&ctx.cache[i], &q[i]);
+    }
+    Poly res = ComposeRec(&ctx, p, 0);
+    for (size_t i = 0; i < k; i++) {
+        PowerCacheDestroy(&ctx.cache[i]);
+    }
+    free(ctx.cache);
+    return res;
+}
+
+/**
+ * Daje stopień wielomianu ze względu na zmienną o indeksie 0.
+ * @param[in] p : wielomian @f$p@f$
+ * @return stopień @f$p@f$ względem @f$x_0@f$ (-1 dla wielomianu zerowego)
+ */
+static poly_exp_t PolyDegX0(const Poly *p) {
+    if (PolyIsZero(p)) return -1;
+    return PolyIsCoeff(p) ? 0 : p->arr[0].exp;
+}
+
+/**
+ * Daje współczynnik liczbowy wielomianu przy jego największym jednomianie
+ * w porządku leksykograficznym, w którym wykładniki zmiennych porównywane są
+ * kolejno od zmiennej @f$x_0@f$.
+ * @param[in] p : niezerowy wielomian @f$p@f$
+ * @return współczynnik wiodący @f$p@f$
+ */
+static const Poly* PolyLeadingCoeff(const Poly *p) {
+    while (!PolyIsCoeff(p)) p = &p->arr[0].p;
+    return p;
+}
+
+/**
+ * Sprawdza, czy współczynnik jest ujemny.
+ * @param[in] p : współczynnik
+ * @return @f$p < 0@f$
+ */
+static bool CoeffIsNegative(const Poly *p) {
+    if (!PolyIsBigCoeff(p)) return p->coeff < 0;
+    bool negative;
+    const uint32_t *digits;
+    BigCoeffDigits(p, &negative, &digits);
+    return negative;
+}
+
+/**
+ * Zagnieżdża wielomian o zadaną liczbę poziomów, tak aby jego zmienna
+ * o indeksie 0 stała się zmienną o indeksie @p levels. Przejmuje @p p na
+ * własność.
+ * @param[in] p : wielomian @f$p(x_0, x_1, \ldots)@f$
+ * @param[in] levels : liczba poziomów
+ * @return @f$p(x_{levels}, x_{levels + 1}, \ldots)@f$
+ */
+static Poly PolyWrap(Poly p, size_t levels) {
+    if (PolyIsCoeff(&p)) return p;
+    for (; levels > 0; levels--) {
+        Mono *arr = MonoArrAlloc(1);
+        arr[0] = MonoFromPoly(&p, 0);
+        p = PolyFromArrSimplify(arr, 1);
+    }
+    return p;
+}
+
+/**
+ * Dzieli współczynnik przez niezerowy współczynnik, jeśli iloraz jest
+ * współczynnikiem. W obliczeniach modulo mnoży przez odwrotność dzielnika.
+ * @param[in] p : współczynnik @f$p@f$
+ * @param[in] q : niezerowy współczynnik @f$q@f$
+ * @param[out] res : iloraz @f$p / q@f$, jeśli dzielenie jest wykonalne
+ * @return Czy dzielenie jest wykonalne?
+ */
+static bool CoeffDivExact(const Poly *p, const Poly *q, Poly *res) {
+    if (ModEnabled()) {
+        poly_coeff_t inv = ModInverse(q->coeff);
+        if (inv == 0) return false;
+        *res = PolyFromCoeff(ModMul(p->coeff, inv));
+        return true;
+    }
+    // Dzielenie LONG_MIN przez -1 wychodzi poza typ poly_coeff_t.
+    if (!PolyIsBigCoeff(p) && !PolyIsBigCoeff(q) && q->coeff != -1) {
+        if (p->coeff % q->coeff != 0) return false;
+        *res = PolyFromCoeff(p->coeff / q->coeff);
+        return true;
+    }
+    Poly rem;
+    *res = BigCoeffDivRem(p, q, &rem);
+    if (PolyIsZero(&rem)) return true;
+    PolyDestroy(&rem);
+    PolyDestroy(res);
+    return false;
+}
+
+/**
+ * Dzieli wielomian przez niezerowy współczynnik, jeśli dzielą się przez niego
+ * wszystkie współczynniki liczbowe wielomianu.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] c : niezerowy współczynnik @f$c@f$
+ * @param[out] res : iloraz @f$p / c@f$, jeśli dzielenie jest wykonalne
+ * @return Czy dzielenie jest wykonalne?
+ */
+static bool PolyDivByCoeff(const Poly *p, const Poly *c, Poly *res) {
+    if (PolyIsCoeff(p)) return CoeffDivExact(p, c, res);
+    Mono *arr = MonoArrAlloc(p->size);
+    for (size_t i = 0; i < p->size; i++) {
+        Poly coeff;
+        if (!PolyDivByCoeff(&p->arr[i].p, c, &coeff)) {
+            for (size_t j = 0; j < i; j++) MonoDestroy(&arr[j]);
+            MonoArrFree(arr);
+            return false;
+        }
+        // Iloraz niezerowego współczynnika przez współczynnik jest niezerowy.
+        arr[i] = MonoFromPoly(&coeff, p->arr[i].exp);
     }
-    else {
-        // Stopień wielomianu jest równy maksimum ze stopni tworzących go
-        // jednomianów. Stopień jednomianu jest równy sumie jego wykładnika
-        // i stopnia jego wielomianu.
-        poly_exp_t max_exp = -1;
-        for (size_t i = 0; i < p->size; i++) {
-            Mono curr_mono = p->arr[i];
-            poly_exp_t curr_poly_deg = PolyDeg(&curr_mono.p) + curr_mono.exp;
-            if (curr_poly_deg > max_exp) {
-                max_exp = curr_poly_deg;
+    *res = PolyFromArrSimplify(arr, p->size);
+    return true;
+}
+
+static bool PolyDivExactRec(const Poly *p, const Poly *q, Poly *res);
+
+/**
+ * Dzieli wielomian przez wielomian, wyznaczając jednomiany ilorazu od
+ * największego wykładnika zmiennej @f$x_0@f$. Iloczyny wyznaczonych już
+ * jednomianów ilorazu z kolejnymi jednomianami dzielnika odejmowane są
+ * leniwie, w kolejności wyznaczanej przez kopiec (jak w PolyMulHeap()), więc
+ * pamięć pomocnicza jest proporcjonalna do liczby jednomianów ilorazu.
+ * Współczynniki ilorazu wyznaczane są rekurencyjnie.
+ * @param[in] p : wielomian @f$p@f$ niebędący współczynnikiem
+ * @param[in] q : wielomian @f$q@f$ niebędący współczynnikiem
+ * @param[out] res : iloraz @f$p / q@f$, jeśli dzielenie jest wykonalne
+ * @return Czy @f$q@f$ dzieli @f$p@f$?
+ */
+static bool PolyDivHeap(const Poly *p, const Poly *q, Poly *res) {
+    poly_exp_t lead_exp = q->arr[0].exp;
+    // Skrajne jednomiany dzielnej są iloczynami skrajnych jednomianów
+    // ilorazu i dzielnika.
+    if (p->arr[0].exp < lead_exp
+        || p->arr[p->size - 1].exp < q->arr[q->size - 1].exp) return false;
+    ScratchMark mark = ScratchGetMark();
+    size_t heap_size = 0, heap_capacity = p->size;
+    MulHeapNode *heap = ScratchAlloc(heap_capacity * sizeof(MulHeapNode));
+    size_t arr_size = 0, arr_capacity = p->size;
+    Mono *arr = MonoArrAlloc(arr_capacity);
+    size_t p_idx = 0;
+    bool exact = true;
+    while (exact && (p_idx < p->size || heap_size > 0)) {
+        poly_exp_t exp = p_idx < p->size ? p->arr[p_idx].exp : -1;
+        if (heap_size > 0 && heap[0].exp > exp) exp = heap[0].exp;
+        Poly rest = PolyZero();
+        if (p_idx < p->size && p->arr[p_idx].exp == exp) {
+            rest = PolyClone(&p->arr[p_idx++].p);
+        }
+        while (heap_size > 0 && heap[0].exp == exp) {
+            MulHeapNode node = MulHeapPop(heap, &heap_size);
+            Poly product = PolyMul(&arr[node.p_idx].p, &q->arr[node.q_idx].p);
+            rest = PolySubOwn(&rest, &product);
+            if (++node.q_idx < q->size) {
+                node.exp = arr[node.p_idx].exp + q->arr[node.q_idx].exp;
+                MulHeapPush(heap, &heap_size, node);
             }
         }
-        return max_exp;
+        if (PolyIsZero(&rest)) continue;
+        Poly coeff;
+        exact = exp >= lead_exp && PolyDivExactRec(&rest, &q->arr[0].p, &coeff);
+        PolyDestroy(&rest);
+        if (!exact) break;
+        if (arr_size == arr_capacity) {
+            arr_capacity *= 2;
+            arr = MonoArrGrow(arr, arr_capacity);
+        }
+        arr[arr_size] = MonoFromPoly(&coeff, exp - lead_exp);
+        if (q->size > 1) {
+            if (heap_size == heap_capacity) {
+                // Poprzedni kopiec zostaje w arenie do końca dzielenia.
+                MulHeapNode *new_heap = ScratchAlloc(2 * heap_capacity
+                                                     * sizeof(MulHeapNode));
+                memcpy(new_heap, heap, heap_size * sizeof(MulHeapNode));
+                heap = new_heap;
+                heap_capacity *= 2;
+            }
+            MulHeapPush(heap, &heap_size, (MulHeapNode) {
+                .exp = exp - lead_exp + q->arr[1].exp, .p_idx = arr_size,
+                .q_idx = 1});
+        }
+        arr_size++;
+    }
+    ScratchRelease(mark);
+    if (!exact) {
+        for (size_t i = 0; i < arr_size; i++) MonoDestroy(&arr[i]);
+        MonoArrFree(arr);
+        return false;
     }
+    if (arr_size != 0) arr = MonoArrShrink(arr, arr_size);
+    *res = PolyFromArrSimplify(arr, arr_size);
+    return true;
 }
 
-static bool MonoIsEq(const Mono *m, const Mono *n);
-
 /**
- * Sprawdza równość dwóch wielomianów.
+ * Dzieli wielomian przez niezerowy wielomian (patrz: PolyDivExact()).
  * @param[in] p : wielomian @f$p@f$
- * @param[in] q : wielomian @f$q@f$
- * @return @f$p = q@f$
+ * @param[in] q : niezerowy wielomian @f$q@f$
+ * @param[out] res : iloraz @f$p / q@f$, jeśli dzielenie jest wykonalne
+ * @return Czy @f$q@f$ dzieli @f$p@f$?
  */
-bool PolyIsEq(const Poly *p, const Poly *q) {
-    assert(p != NULL && q != NULL);
-    if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
-        return p->coeff == q->coeff;
+static bool PolyDivExactRec(const Poly *p, const Poly *q, Poly *res) {
+    if (PolyIsZero(p)) {
+        *res = PolyZero();
+        return true;
     }
-    else if (!PolyIsCoeff(p) && !PolyIsCoeff(q)) {
-        if (p->size != q->size) return false;
-        for (size_t i = 0; i < p->size; i++) {
-            if (!MonoIsEq(&p->arr[i], &q->arr[i])) return false;
-        }
+    if (PolyIsCoeff(q)) return PolyDivByCoeff(p, q, res);
+    if (PolyIsCoeff(p)) return false;
+    if (PolyIsEq(p, q)) {
+        *res = PolyFromCoeff(1);
         return true;
     }
-    else {
-        return false;
+    return PolyDivHeap(p, q, res);
+}
+
+/**
+ * Dzieli wielomian przez wielomian, jeśli iloraz jest wielomianem. Przy
+ * obliczeniach modulo współczynniki dzielone są przez mnożenie przez
+ * odwrotność, więc dla modułu złożonego dzielenie może się nie udać mimo
+ * istnienia ilorazu.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : niezerowy wielomian @f$q@f$
+ * @param[out] res : iloraz @f$p / q@f$, jeśli dzielenie jest wykonalne
+ * @return Czy @f$q@f$ dzieli @f$p@f$?
+ */
+bool PolyDivExact(const Poly *p, const Poly *q, Poly *res) {
+    assert(p != NULL && q != NULL && res != NULL && !PolyIsZero(q));
+    return PolyDivExactRec(p, q, res);
+}
+
+/**
+ * Pseudo-dzieli wielomian przez wielomian względem zmiennej @f$x_0@f$,
+ * klasycznym algorytmem usuwającym kolejno wiodący wyraz reszty.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : niezerowy wielomian @f$q@f$
+ * @param[out] quot : pseudo-iloraz lub NULL, jeśli nie jest potrzebny
+ * @param[out] rem : pseudo-reszta
+ */
+static void PseudoDivide(const Poly *p, const Poly *q, Poly *quot, Poly *rem) {
+    poly_exp_t deg = PolyDegX0(q);
+    Poly lead = PolyWrap(PolyClone(PolyIsCoeff(q) ? q : &q->arr[0].p), 1);
+    poly_exp_t steps = PolyDegX0(p) - deg + 1;
+    Poly r = PolyClone(p), res = PolyZero();
+    for (; !PolyIsZero(&r) && PolyDegX0(&r) >= deg; steps--) {
+        Mono *arr = MonoArrAlloc(1);
+        Poly coeff = PolyClone(PolyIsCoeff(&r) ? &r : &r.arr[0].p);
+        arr[0] = MonoFromPoly(&coeff, PolyDegX0(&r) - deg);
+        Poly term = PolyFromArrSimplify(arr, 1);
+        Poly scaled = PolyMul(&lead, &r), product = PolyMul(&term, q);
+        PolyDestroy(&r);
+        r = PolySubOwn(&scaled, &product);
+        if (quot != NULL) {
+            Poly scaled_res = PolyMul(&lead, &res);
+            PolyDestroy(&res);
+            res = PolyAddOwn(&scaled_res, &term);
+        }
+        else {
+            PolyDestroy(&term);
+        }
+    }
+    if (steps > 0) {
+        Poly power = PolyPow(&lead, steps);
+        if (quot != NULL) {
+            Poly scaled_res = PolyMul(&power, &res);
+            PolyDestroy(&res);
+            res = scaled_res;
+        }
+        r = PolyMulOwn(&r, &power);
     }
+    PolyDestroy(&lead);
+    *rem = r;
+    if (quot != NULL) *quot = res;
 }
 
 /**
- * Sprawdza równość dwóch jednomianów.
- * @param[in] m : jednomian @f$m@f$
- * @param[in] n : jednomian @f$n@f$
- * @return @f$m = n@f$
+ * Pseudo-dzieli wielomian @p p przez niezerowy wielomian @p q względem zmiennej
+ * @f$x_0@f$: wyznacza wielomiany @f$Q@f$ i @f$R@f$ takie, że
+ * @f$l^{\delta} p = Q q + R@f$, gdzie @f$l@f$ jest współczynnikiem przy
+ * najwyższej potędze @f$x_0@f$ w @p q, @f$m@f$ jest stopniem @p q względem
+ * @f$x_0@f$, @f$\delta = \max(\deg_{x_0} p - m + 1, 0)@f$, a stopień @f$R@f$
+ * względem @f$x_0@f$ jest mniejszy od @f$m@f$.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : niezerowy wielomian @f$q@f$
+ * @param[out] quot : pseudo-iloraz @f$Q@f$
+ * @param[out] rem : pseudo-reszta @f$R@f$
  */
-static bool MonoIsEq(const Mono *m, const Mono *n) {
-    assert(m != NULL && n != NULL);
-    if (m->exp != n->exp) return false;
-    return PolyIsEq(&m->p, &n->p);
+void PolyDivRem(const Poly *p, const Poly *q, Poly *quot, Poly *rem) {
+    assert(p != NULL && q != NULL && quot != NULL && rem != NULL);
+    assert(!PolyIsZero(q));
+    PseudoDivide(p, q, quot, rem);
 }
 
 /**
- * Wylicza wartość wielomianu w punkcie @p x.
- * Wstawia pod pierwszą zmienną wielomianu wartość @p x.
- * W wyniku może powstać wielomian, jeśli współczynniki są wielomianami.
- * Wtedy zmniejszane są o jeden indeksy zmiennych w takim wielomianie.
- * Formalnie dla wielomianu @f$p(x_0, x_1, x_2, \ldots)@f$ wynikiem jest
- * wielomian @f$p(x, x_0, x_1, \ldots)@f$.
+ * Normalizuje największy wspólny dzielnik: przy obliczeniach modulo dzieli
+ * go przez współczynnik wiodący (patrz: PolyLeadingCoeff()), a przy
+ * obliczeniach dokładnych zmienia jego znak tak, by współczynnik wiodący był
+ * dodatni. Przejmuje @p p na własność.
  * @param[in] p : wielomian @f$p@f$
- * @param[in] x : wartość argumentu @f$x@f$
- * @return @f$p(x, x_0, x_1, \ldots)@f$
+ * @return znormalizowany wielomian @f$p@f$
  */
-Poly PolyAt(const Poly *p, poly_coeff_t x) {
-    assert(p != NULL);
-    if (x == 0) return PolyZero();
+static Poly GcdNormalize(Poly p) {
+    if (PolyIsZero(&p)) return p;
+    const Poly *lead = PolyLeadingCoeff(&p);
+    if (!ModEnabled()) return CoeffIsNegative(lead) ? PolyNegOwn(&p) : p;
+    if (lead->coeff == 1) return p;
+    Poly inv = PolyFromCoeff(ModInverse(lead->coeff));
+    Poly res = PolyScale(&p, &inv);
+    PolyDestroy(&p);
+    return res;
+}
+
+/**
+ * Sprawdza, czy wielomian jest równy jeden.
+ * @param[in] p : wielomian @f$p@f$
+ * @return @f$p = 1@f$
+ */
+static inline bool PolyIsOne(const Poly *p) {
+    return PolyIsCoeff(p) && !PolyIsBigCoeff(p) && p->coeff == 1;
+}
+
+/**
+ * Wylicza największy wspólny dzielnik liczby i współczynników liczbowych
+ * wielomianu. Przejmuje @p g na własność.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] g : nieujemna liczba @f$g@f$
+ * @return nieujemny NWD @f$g@f$ i współczynników @f$p@f$
+ */
+static Poly PolyIntContent(const Poly *p, Poly g) {
     if (PolyIsCoeff(p)) {
-        return *p;
+        Poly res = BigCoeffGcd(&g, p);
+        PolyDestroy(&g);
+        return res;
     }
-    else {
-        size_t monos_size = 0; // To jest zmienna przechowująca liczbę jednomianów
-        // (niezredukowanych) po zastąpieniu zmiennych o indeksie 0 przez liczby.
-        // Obliczanie [monos_size].
-        for (size_t i = 0; i < p->size; i++) {
-            Poly curr_poly = p->arr[i].p;
-            if (PolyIsCoeff(&curr_poly)) {
-                monos_size += 1;
-            }
-            else {
-                monos_size += curr_poly.size;
-            }
-        }
-        Mono monos[monos_size]; // To jest lista jednomianów, z których zostanie
-        // stworzony wynikowy wielomian.
-        size_t monos_idx = 0;
-        for (size_t i = 0; i < p->size; i++) {
-            Poly curr_poly = p->arr[i].p;
-            if (PolyIsCoeff(&curr_poly)) {
-                Poly p_mul = PolyFromCoeff(curr_poly.coeff * power(x, p->arr[i].exp));
-                monos[monos_idx] = MonoFromPoly(&p_mul, 0);
-                monos_idx++;
-            }
-            else {
-                for (size_t j = 0; j < curr_poly.size; j++) {
-                    Poly curr_p = curr_poly.arr[j].p;
-                    Poly x_to_power = PolyFromCoeff(power(x, p->arr[i].exp));
-                    Poly p_mul = PolyMul(&curr_p, &x_to_power);
-                    if (PolyIsZero(&p_mul)) {
-                        monos[monos_idx] = MonoFromPoly(&p_mul, 0);
-                    }
-                    else {
-                        monos[monos_idx] = MonoFromPoly(&p_mul,
-                                                        curr_poly.arr[j].exp);
-                    }
-                    monos_idx++;
-                    PolyDestroy(&x_to_power);
-                }
-            }
-        }
-        return PolyAddMonos(monos_size, monos);
+    for (size_t i = 0; i < p->size && !PolyIsOne(&g); i++) {
+        g = PolyIntContent(&p->arr[i].p, g);
     }
+    return g;
 }
 
+static Poly GcdRec(const Poly *p, const Poly *q);
+
 /**
- * Podnosi wielomian do potęgi naturalnej.
- * @param p : wielomian @f$p@f$
- * @param n : potęga @f$n@f$
- * @return @f$p^n@f$
+ * Wylicza zawartość wielomianu względem zmiennej @f$x_0@f$, czyli NWD jego
+ * współczynników (wielomianów zmiennych @f$x_1, x_2, \ldots@f$).
+ * @param[in] p : wielomian @f$p@f$ niebędący współczynnikiem
+ * @return znormalizowana zawartość @f$p@f$ jako wielomian, w którym zmienna
+ * @f$x_1@f$ ma indeks 0
  */
-Poly PolyPower(const Poly *p, poly_exp_t n) {
-    assert(n >= 0);
-    if (n == 0) return PolyFromCoeff(1);
-    if (n == 1) return PolyClone(p);
+static Poly PrsContent(const Poly *p) {
+    Poly res = PolyClone(&p->arr[0].p);
+    for (size_t i = 1; i < p->size && !PolyIsOne(&res); i++) {
+        Poly g = GcdRec(&res, &p->arr[i].p);
+        PolyDestroy(&res);
+        res = g;
+    }
+    return GcdNormalize(res);
+}
+
+/**
+ * Dzieli współczynniki wielomianu (wielomiany zmiennych @f$x_1, x_2,
+ * \ldots@f$) przez ich wspólny dzielnik.
+ * @param[in] p : wielomian @f$p@f$ niebędący współczynnikiem
+ * @param[in] c : dzielnik współczynników @f$p@f$, w którym zmienna
+ * @f$x_1@f$ ma indeks 0
+ * @return @f$p / c@f$
+ */
+static Poly PrsDivCoeffs(const Poly *p, const Poly *c) {
+    Mono *arr = MonoArrAlloc(p->size);
+    for (size_t i = 0; i < p->size; i++) {
+        Poly coeff;
+        bool exact = PolyDivExactRec(&p->arr[i].p, c, &coeff);
+        assert(exact);
+        (void) exact;
+        arr[i] = MonoFromPoly(&coeff, p->arr[i].exp);
+    }
+    return PolyFromArrSimplify(arr, p->size);
+}
 
-    Poly q = PolyPower(p, n / 2);
-    Poly q_squared = PolyMul(&q, &q);
-    PolyDestroy(&q);
+/**
+ * Wylicza część pierwotną wielomianu względem zmiennej @f$x_0@f$.
+ * Przejmuje @p p na własność.
+ * @param[in] p : niezerowy wielomian @f$p@f$
+ * @return @f$p@f$ podzielony przez swoją zawartość względem @f$x_0@f$
+ */
+static Poly PrsPrimitivePart(Poly p) {
+    if (PolyIsCoeff(&p)) {
+        PolyDestroy(&p);
+        return PolyFromCoeff(1);
+    }
+    Poly content = PrsContent(&p);
+    Poly res = PrsDivCoeffs(&p, &content);
+    PolyDestroy(&content);
+    PolyDestroy(&p);
+    return res;
+}
 
-    if (n % 2 == 0) {
-        return q_squared;
+/**
+ * Wylicza NWD wielomianów podresultantowym ciągiem pseudo-reszt względem
+ * zmiennej @f$x_0@f$: pseudo-reszty dzielone są przez czynniki, o które
+ * wiadomo, że je dzielą, więc stopnie współczynników rosną liniowo, a część
+ * pierwotna wyliczana jest tylko raz, na końcu. Metoda nie wymaga punktów
+ * interpolacji, więc jest rezerwą dla algorytmu Browna (patrz: ModGcd()),
+ * gdy modułu nie wystarcza na wybór punktów.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return znormalizowany (patrz: GcdNormalize()) NWD @f$p@f$ i @f$q@f$
+ */
+static Poly GcdPrs(const Poly *p, const Poly *q) {
+    if (PolyIsZero(p)) return GcdNormalize(PolyClone(q));
+    if (PolyIsZero(q)) return GcdNormalize(PolyClone(p));
+    if (PolyIsCoeff(p) || PolyIsCoeff(q)) {
+        if (ModEnabled()) return PolyFromCoeff(1);
+        return PolyIntContent(PolyIsCoeff(p) ? q : p,
+                              PolyIntContent(PolyIsCoeff(p) ? p : q,
+                                             PolyZero()));
+    }
+    Poly cp = PrsContent(p), cq = PrsContent(q);
+    Poly content = GcdRec(&cp, &cq);
+    Poly a = PrsDivCoeffs(p, &cp), b = PrsDivCoeffs(q, &cq);
+    PolyDestroy(&cp);
+    PolyDestroy(&cq);
+    if (PolyDegX0(&a) < PolyDegX0(&b)) {
+        Poly tmp = a;
+        a = b;
+        b = tmp;
+    }
+    Poly g = PolyFromCoeff(1), h = PolyFromCoeff(1);
+    while (PolyDegX0(&b) > 0) {
+        poly_exp_t delta = PolyDegX0(&a) - PolyDegX0(&b);
+        Poly rem;
+        PseudoDivide(&a, &b, NULL, &rem);
+        PolyDestroy(&a);
+        a = b;
+        if (PolyIsZero(&rem)) {
+            b = rem;
+            break;
+        }
+        Poly h_pow = PolyPow(&h, delta), divisor = PolyMul(&g, &h_pow);
+        bool exact = PolyDivExactRec(&rem, &divisor, &b);
+        assert(exact);
+        PolyDestroy(&rem);
+        PolyDestroy(&divisor);
+        PolyDestroy(&g);
+        g = PolyWrap(PolyClone(&a.arr[0].p), 1);
+        if (delta > 0) {
+            // h = g^delta / h^(delta - 1)
+            Poly g_pow = PolyPow(&g, delta), new_h;
+            PolyDestroy(&h_pow);
+            h_pow = PolyPow(&h, delta - 1);
+            exact = PolyDivExactRec(&g_pow, &h_pow, &new_h);
+            assert(exact);
+            PolyDestroy(&g_pow);
+            PolyDestroy(&h);
+            h = new_h;
+        }
+        PolyDestroy(&h_pow);
+        (void) exact;
+    }
+    PolyDestroy(&g);
+    PolyDestroy(&h);
+    // Niezerowa reszta stopnia 0 oznacza, że części pierwotne są względnie
+    // pierwsze.
+    if (PolyIsZero(&b)) {
+        b = PrsPrimitivePart(a);
     }
     else {
-        Poly res = PolyMul(p, &q_squared);
-        PolyDestroy(&q_squared);
-        return res;
+        PolyDestroy(&a);
+        PolyDestroy(&b);
+        b = PolyFromCoeff(1);
+    }
+    Poly wrapped = PolyWrap(content, 1);
+    Poly res = PolyMulOwn(&wrapped, &b);
+    return GcdNormalize(res);
+}
+
+/**
+ * Ustawia moduł, modulo który liczone są współczynniki.
+ * @param[in] mod : liczba pierwsza nie większa od @f$MOD\_MAX@f$
+ * @return poprzednie ustawienia modułu, do przywrócenia przez przypisanie
+ * do mod_arith
+ */
+static ModArith ModSwitch(poly_coeff_t mod) {
+    ModArith saved = mod_arith;
+    bool valid = ModSetModulus(mod);
+    assert(valid);
+    (void) valid;
+    return saved;
+}
+
+/**
+ * Daje największą liczbę pierwszą mniejszą od zadanej.
+ * @param[in] bound : nieparzysta liczba lub @f$MOD\_MAX + 1@f$, większa od 3
+ * @return największa liczba pierwsza mniejsza od @p bound
+ */
+static poly_coeff_t PrevPrime(poly_coeff_t bound) {
+    ModArith saved = mod_arith;
+    poly_coeff_t n = bound % 2 == 0 ? bound - 1 : bound - 2;
+    while (ModSetModulus(n), !ModIsPrime()) n -= 2;
+    mod_arith = saved;
+    return n;
+}
+
+/**
+ * To jest typ funkcji przekształcającej liście wielomianu (patrz: MapLeaves()).
+ * @param[in] leaf : liść
+ * @param[in] levels : liczba poziomów, o którą należy zagnieździć wynik
+ * niebędący liczbą (patrz: PolyWrap())
+ * @param[in] ctx : dane przekształcenia
+ * @return przekształcony liść
+ */
+typedef Poly (*LeafMap)(const Poly *leaf, size_t levels, const void *ctx);
+
+/**
+ * Przekształca liście wielomianu, czyli jego współczynniki na głębokości
+ * @p depth (wielomiany zmiennej @f$x_{depth}@f$) lub liczby na mniejszej
+ * głębokości. Pomija jednomiany, których współczynniki stają się zerami.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] depth : głębokość liści
+ * @param[in] map : przekształcenie liści
+ * @param[in] ctx : dane przekształcenia
+ * @return wielomian o przekształconych liściach
+ */
+static Poly MapLeaves(const Poly *p, size_t depth, LeafMap map,
+                      const void *ctx) {
+    if (depth == 0 || PolyIsCoeff(p)) return map(p, depth, ctx);
+    Mono *arr = MonoArrAlloc(p->size);
+    size_t arr_size = 0;
+    for (size_t i = 0; i < p->size; i++) {
+        Poly coeff = MapLeaves(&p->arr[i].p, depth - 1, map, ctx);
+        if (PolyIsZero(&coeff)) continue;
+        arr[arr_size++] = MonoFromPoly(&coeff, p->arr[i].exp);
     }
+    if (arr_size != 0) arr = MonoArrShrink(arr, arr_size);
+    return PolyFromArrSimplify(arr, arr_size);
 }
 
-Poly MonoComposeHelper(const Mono *m, size_t k, const Poly q[], size_t depth, poly_exp_t *last_pow, Poly *last_pow_p);
+/**
+ * Wylicza wartość liścia w punkcie (patrz: LeafMap).
+ * @param[in] leaf : liść
+ * @param[in] levels : liczba poziomów
+ * @param[in] ctx : wskaźnik na wartość argumentu
+ * @return wartość liścia
+ */
+static Poly EvalLeaf(const Poly *leaf, size_t levels, const void *ctx) {
+    (void) levels;
+    return PolyAt(leaf, *(const poly_coeff_t*) ctx);
+}
 
 /**
- * Zwraca złożenie wielomianu @p p z wielomianami @f$q_{depth}, q_{depth+1},
- * \ldots@f$. Zachowuje się tak jak PolyCompose() poza tym, że zmienne wielomianu
- * @p p są indeksowane od @p depth. Po dokładniejsze wytłumaczenie działania funkcji
- * zajrzyj do dokumentacji funkcji PolyCompose().
+ * Mnoży liść przez wielomian jednej zmiennej (patrz: LeafMap).
+ * @param[in] leaf : liść
+ * @param[in] levels : liczba poziomów
+ * @param[in] ctx : wskaźnik na wielomian
+ * @return iloczyn liścia i wielomianu
+ */
+static Poly MulLeaf(const Poly *leaf, size_t levels, const void *ctx) {
+    return PolyWrap(PolyMul(leaf, ctx), levels);
+}
+
+/**
+ * Dzieli liść przez jego dzielnik, wielomian jednej zmiennej (patrz: LeafMap).
+ * @param[in] leaf : liść
+ * @param[in] levels : liczba poziomów
+ * @param[in] ctx : wskaźnik na dzielnik
+ * @return iloraz liścia i dzielnika
+ */
+static Poly DivLeaf(const Poly *leaf, size_t levels, const void *ctx) {
+    Poly res;
+    bool exact = PolyDivExactRec(leaf, ctx, &res);
+    assert(exact);
+    (void) exact;
+    return PolyWrap(res, levels);
+}
+
+/**
+ * Wylicza NWD wielomianów jednej zmiennej modulo liczba pierwsza algorytmem
+ * Euklidesa.
  * @param[in] p : wielomian @f$p@f$
- * @param[in] k : liczba wielomianów @f$q_i@f$
- * @param[in] q : lista wielomianów: @f$q_0, q_1, \ldots, q_{k-1}@f$
- * @param[in] depth : liczba, od której indeksowane są zmienne w @p p
- * @return @f$p(q_{depth}, q_{depth+1}, …)@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return unormowany NWD @f$p@f$ i @f$q@f$
  */
-Poly PolyComposeHelper(const Poly *p, size_t k, const Poly q[], size_t depth) {
-    if (PolyIsCoeff(p)) return *p;
-    else {
-        Poly res = PolyZero();
-        poly_exp_t last_pow = 0; // To jest ostatnia potęga, do której podnoszone
-        // było [q[depth]]
-        Poly last_pow_p = PolyFromCoeff(1); // To jest [q[depth]] podniesione
-        // do potęgi [last_pow]
-        for (size_t i = p->size; i-- > 0;) { // [i] maleje, aby [q[depth]]
-            // podnoszone było do coraz wyższych potęg.
-            Poly temp = MonoComposeHelper(&p->arr[i], k, q, depth, &last_pow, &last_pow_p);
-            Poly new_res = PolyAdd(&res, &temp);
-            PolyDestroy(&temp);
-            PolyDestroy(&res);
-            res = new_res;
+static Poly UniGcd(const Poly *p, const Poly *q) {
+    Poly a = GcdNormalize(PolyClone(p)), b = GcdNormalize(PolyClone(q));
+    while (!PolyIsZero(&b)) {
+        if (PolyIsCoeff(&b)) {
+            PolyDestroy(&a);
+            return PolyFromCoeff(1);
         }
-        PolyDestroy(&last_pow_p);
+        Poly rem;
+        // Dzielnik jest unormowany, więc pseudo-reszta jest resztą.
+        PseudoDivide(&a, &b, NULL, &rem);
+        PolyDestroy(&a);
+        a = b;
+        b = GcdNormalize(rem);
+    }
+    return a;
+}
+
+/**
+ * Wylicza NWD liści wielomianu (patrz: MapLeaves()) i wielomianu jednej
+ * zmiennej modulo liczba pierwsza. Przejmuje @p g na własność.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] depth : głębokość liści
+ * @param[in] g : unormowany wielomian jednej zmiennej @f$g@f$
+ * @return unormowany NWD @f$g@f$ i liści @f$p@f$
+ */
+static Poly LeafContent(const Poly *p, size_t depth, Poly g) {
+    if (depth == 0 || PolyIsCoeff(p)) {
+        Poly res = UniGcd(&g, p);
+        PolyDestroy(&g);
         return res;
     }
+    for (size_t i = 0; i < p->size && !PolyIsOne(&g); i++) {
+        g = LeafContent(&p->arr[i].p, depth - 1, g);
+    }
+    return g;
 }
 
 /**
- * Podstawia @f$q_{depth}@f$ pod zmienną @f$x_{depth}@f$ jednomianu @p m oraz
- * podstawia wynik funkcji PolyComposeHelper() działającą na wielomian będący
- * współczynnikiem jednomianu @p m pod ten wielomian, przy czym zmienne tego
- * wielomianu indeksowane są od @p depth @f$+ 1@f$.
- * @param[in] m : jednomian @f$p*x_{depth}^{exp}@f$
- * @param[in] k : @param[in] k : liczba wielomianów @f$q_i@f$
- * @param[in] q : lista wielomianów: @f$q_0, q_1, \ldots, q_{k-1}@f$
- * @param[in] depth : indeks zmiennej jednomianu
- * @param[in,out] last_pow : ostatnia potęga, do której podnoszone było
- * @p q[depth]
- * @param[in,out] last_pow_p : @p q[depth] podniesione do potęgi @p last_pow
- * @return @f$p(q_{depth+1}, q_{depth+2}, \ldots)*q_{depth}^{exp}@f$
+ * Daje liść wielomianu na ścieżce jego największych wykładników.
+ * @param[in] p : niezerowy wielomian @f$p@f$
+ * @param[in] depth : głębokość liści
+ * @return wiodący liść @f$p@f$
+ */
+static const Poly* LeadingLeaf(const Poly *p, size_t depth) {
+    for (; depth > 0 && !PolyIsCoeff(p); depth--) p = &p->arr[0].p;
+    return p;
+}
+
+/**
+ * Wyznacza wykładniki zmiennych @f$x_0, \ldots, x_{k-1}@f$ największego
+ * w porządku leksykograficznym jednomianu wielomianu.
+ * @param[in] p : niezerowy wielomian @f$p@f$
+ * @param[in] k : liczba zmiennych
+ * @param[out] exps : wykładniki
  */
-Poly MonoComposeHelper(const Mono *m, size_t k, const Poly q[], size_t depth, poly_exp_t *last_pow, Poly *last_pow_p) {
-    if (depth >= k) {
-        if (m->exp != 0) return PolyZero();
-        else return PolyComposeHelper(&m->p, k, q, depth + 1);
+static void LeadingExps(const Poly *p, size_t k, poly_exp_t exps[]) {
+    for (size_t i = 0; i < k; i++) {
+        exps[i] = PolyIsCoeff(p) ? 0 : p->arr[0].exp;
+        if (!PolyIsCoeff(p)) p = &p->arr[0].p;
     }
-    else {
-        Poly pow_1 = PolyPower(&q[depth],(m->exp - *last_pow));
-        Poly pow_2 = PolyMul(last_pow_p, &pow_1);
-        PolyDestroy(&pow_1);
-        PolyDestroy(last_pow_p);
-        *last_pow_p = pow_2;
-        *last_pow = m->exp;
-        Poly p = PolyComposeHelper(&m->p, k, q, depth + 1);
-
-        Poly res = PolyMul(&pow_2, &p);
-        PolyDestroy(&p);
-        return res;
+}
+
+/**
+ * Porównuje leksykograficznie ciągi wykładników.
+ * @param[in] a : wykładniki @f$a@f$
+ * @param[in] b : wykładniki @f$b@f$
+ * @param[in] k : długość ciągów
+ * @return liczba ujemna, zero lub dodatnia, gdy @f$a@f$ jest odpowiednio
+ * mniejszy, równy lub większy od @f$b@f$
+ */
+static int CompareExpVectors(const poly_exp_t a[], const poly_exp_t b[],
+                             size_t k) {
+    for (size_t i = 0; i < k; i++) {
+        if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
     }
+    return 0;
 }
 
 /**
- * Zwraca złożenie wielomianu @p p z wielomianami @f$q_0, q_1, \ldots@f$ .
- * Niech @f$l@f$ oznacza liczbę zmiennych wielomianu @p p i niech te zmienne
- * są oznaczone odpowiednio @f$x_0, x_1, …, x_{l−1}@f$. Wynikiem złożenia jest
- * wielomian @f$p(q_0,q_1,q_2,…)@f$, czyli wielomian powstający przez podstawienie
- * w wielomianie @p p pod zmienną @f$x_i@f$ wielomianu @f$q_i@f$
- * dla @f$i=0,1,2,…,min(k,l)−1@f$. Jeśli @f$k<l@f$, to pod zmienne @f$x_k, …,
- * x_{l−1}@f$ podstawiane są zera.
+ * Tworzy wielomian @f$x_0 - x@f$ modulo liczba pierwsza.
+ * @param[in] x : reszta @f$x@f$
+ * @return @f$x_0 - x@f$
+ */
+static Poly LinearFactor(poly_coeff_t x) {
+    Mono monos[2] = {{.p = PolyFromCoeff(1), .exp = 1},
+                     {.p = PolyFromCoeff(ModReduce(-x)), .exp = 0}};
+    return PolyAddMonos(x == 0 ? 1 : 2, monos);
+}
+
+/**
+ * Sprawdza kandydata na NWD uzyskanego interpolacją: dzieli go przez
+ * zawartość liści i sprawdza, czy dzieli oba wielomiany.
+ * @param[in] interp : kandydat
+ * @param[in] a : wielomian @f$a@f$ o liściach względnie pierwszych
+ * @param[in] b : wielomian @f$b@f$ o liściach względnie pierwszych
+ * @param[in] v : głębokość liści
+ * @param[in] content : NWD zawartości liści wielomianów wejściowych
+ * @param[out] res : NWD, jeśli kandydat jest poprawny
+ * @return Czy kandydat jest poprawny?
+ */
+static bool BrownCheck(const Poly *interp, const Poly *a, const Poly *b,
+                       size_t v, const Poly *content, Poly *res) {
+    Poly leaf_content = LeafContent(interp, v, PolyZero());
+    Poly cand = MapLeaves(interp, v, DivLeaf, &leaf_content);
+    PolyDestroy(&leaf_content);
+    Poly quot;
+    bool divides = PolyDivExactRec(a, &cand, &quot);
+    if (divides) {
+        PolyDestroy(&quot);
+        divides = PolyDivExactRec(b, &cand, &quot);
+        if (divides) PolyDestroy(&quot);
+    }
+    if (divides) *res = GcdNormalize(MapLeaves(&cand, v, MulLeaf, content));
+    PolyDestroy(&cand);
+    return divides;
+}
+
+/**
+ * Wylicza NWD niezerowych wielomianów modulo liczba pierwsza algorytmem
+ * Browna: podstawia punkty pod ostatnią zmienną, wylicza rekurencyjnie NWD
+ * obrazów, odrzuca obrazy o zbyt dużym jednomianie wiodącym i odtwarza wynik
+ * interpolacją Newtona. Interpolacja kończy się wcześniej, gdy kolejny punkt
+ * nie zmienia kandydata, który dzieli oba wielomiany.
+ * @param[in] p : niezerowy wielomian @f$p@f$
+ * @param[in] q : niezerowy wielomian @f$q@f$
+ * @param[in] k : liczba zmiennych, od których mogą zależeć wielomiany
+ * @param[out] res : unormowany NWD @f$p@f$ i @f$q@f$
+ * @return Czy udało się wybrać dość punktów (czy wynik jest wyliczony)?
+ */
+static bool ModGcd(const Poly *p, const Poly *q, size_t k, Poly *res) {
+    if (PolyIsCoeff(p) || PolyIsCoeff(q)) {
+        *res = PolyFromCoeff(1);
+        return true;
+    }
+    while (k > 1 && !PolyHasVar(p, k - 1) && !PolyHasVar(q, k - 1)) k--;
+    if (k == 1) {
+        *res = UniGcd(p, q);
+        return true;
+    }
+    size_t v = k - 1;
+    Poly content_p = LeafContent(p, v, PolyZero());
+    Poly content_q = LeafContent(q, v, PolyZero());
+    Poly content = UniGcd(&content_p, &content_q);
+    Poly a = MapLeaves(p, v, DivLeaf, &content_p);
+    Poly b = MapLeaves(q, v, DivLeaf, &content_q);
+    PolyDestroy(&content_p);
+    PolyDestroy(&content_q);
+    const Poly *lead_a = LeadingLeaf(&a, v), *lead_b = LeadingLeaf(&b, v);
+    Poly lead_gcd = UniGcd(lead_a, lead_b);
+    poly_exp_t deg_a = PolyDegBy(&a, v), deg_b = PolyDegBy(&b, v);
+    // Stopień NWD (z dołączonym dzielnikiem współczynników wiodących)
+    // względem x_v jest ograniczony, więc tyle punktów wystarcza.
+    size_t bound = (size_t) PolyDeg(&lead_gcd)
+                   + (size_t) (deg_a < deg_b ? deg_a : deg_b);
+    poly_exp_t *lead = malloc(2 * v * sizeof(poly_exp_t));
+    if (lead == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    poly_exp_t *exps = lead + v;
+    Poly interp = PolyZero(), basis = PolyFromCoeff(1);
+    size_t points = 0;
+    // Punktów nie wystarczy na interpolację, jeśli moduł nie przekracza
+    // ograniczenia stopnia.
+    bool tested = false, found = false, failed = bound >= mod_arith.mod;
+    for (poly_coeff_t x = 0; !found && !failed
+                             && (unsigned long) x < mod_arith.mod; x++) {
+        Poly lead_a_x = PolyAt(lead_a, x), lead_b_x = PolyAt(lead_b, x);
+        if (PolyIsZero(&lead_a_x) || PolyIsZero(&lead_b_x)) continue;
+        Poly a_x = MapLeaves(&a, v, EvalLeaf, &x);
+        Poly b_x = MapLeaves(&b, v, EvalLeaf, &x);
+        Poly image;
+        failed = !ModGcd(&a_x, &b_x, v, &image);
+        PolyDestroy(&a_x);
+        PolyDestroy(&b_x);
+        if (failed) break;
+        if (PolyIsCoeff(&image)) {
+            // Wielomiany a i b są względnie pierwsze.
+            *res = PolyWrap(PolyClone(&content), v);
+            found = true;
+            break;
+        }
+        LeadingExps(&image, v, exps);
+        int cmp = points == 0 ? -1 : CompareExpVectors(exps, lead, v);
+        if (cmp > 0) {
+            PolyDestroy(&image);
+            continue;
+        }
+        Poly lead_gcd_x = PolyAt(&lead_gcd, x);
+        Poly scaled = PolyScale(&image, &lead_gcd_x);
+        PolyDestroy(&image);
+        bool changed = true;
+        if (cmp < 0) {
+            PolyDestroy(&interp);
+            PolyDestroy(&basis);
+            interp = scaled;
+            basis = PolyFromCoeff(1);
+            points = 0;
+            memcpy(lead, exps, v * sizeof(poly_exp_t));
+        }
+        else {
+            Poly old = MapLeaves(&interp, v, EvalLeaf, &x);
+            Poly delta = PolySubOwn(&scaled, &old);
+            changed = !PolyIsZero(&delta);
+            if (changed) {
+                Poly basis_x = PolyAt(&basis, x);
+                Poly inv = PolyFromCoeff(ModInverse(basis_x.coeff));
+                Poly step = PolyScale(&basis, &inv);
+                Poly lifted = MapLeaves(&delta, v, MulLeaf, &step);
+                interp = PolyAddOwn(&interp, &lifted);
+                PolyDestroy(&step);
+            }
+            PolyDestroy(&delta);
+        }
+        Poly linear = LinearFactor(x);
+        basis = PolyMulOwn(&basis, &linear);
+        points++;
+        if (changed) tested = false;
+        if (points > bound || (!changed && !tested)) {
+            tested = true;
+            found = BrownCheck(&interp, &a, &b, v, &content, res);
+        }
+    }
+    free(lead);
+    PolyDestroy(&interp);
+    PolyDestroy(&basis);
+    PolyDestroy(&lead_gcd);
+    PolyDestroy(&a);
+    PolyDestroy(&b);
+    PolyDestroy(&content);
+    return found;
+}
+
+/**
+ * Zastępuje współczynniki liczbowe wielomianu ich resztami z dzielenia przez
+ * @p m z przedziału @f$(-m/2, m/2]@f$.
+ * @param[in] p : wielomian @f$p@f$ o współczynnikach z przedziału
+ * @f$(-m/2, m)@f$
+ * @param[in] m : dodatni moduł @f$m@f$
+ * @return @f$p@f$ o współczynnikach zredukowanych symetrycznie modulo @p m
+ */
+static Poly SymmetricMod(const Poly *p, const Poly *m) {
+    if (PolyIsCoeff(p)) {
+        Poly twice = CoeffAdd(p, p);
+        Poly diff = PolySub(&twice, m);
+        bool above = !PolyIsZero(&diff) && !CoeffIsNegative(&diff);
+        PolyDestroy(&twice);
+        PolyDestroy(&diff);
+        return above ? PolySub(p, m) : PolyClone(p);
+    }
+    Mono *arr = MonoArrAlloc(p->size);
+    for (size_t i = 0; i < p->size; i++) {
+        Poly coeff = SymmetricMod(&p->arr[i].p, m);
+        arr[i] = MonoFromPoly(&coeff, p->arr[i].exp);
+    }
+    return PolyFromArrSimplify(arr, p->size);
+}
+
+/**
+ * Sprawdza kandydata na NWD uzyskanego chińskim twierdzeniem o resztach:
+ * dzieli go przez zawartość całkowitą i sprawdza, czy dzieli oba wielomiany.
+ * @param[in] interp : kandydat
+ * @param[in] a : wielomian @f$a@f$ o względnie pierwszych współczynnikach
+ * @param[in] b : wielomian @f$b@f$ o względnie pierwszych współczynnikach
+ * @param[in] content : NWD zawartości całkowitych wielomianów wejściowych
+ * @param[out] res : NWD, jeśli kandydat jest poprawny
+ * @return Czy kandydat jest poprawny?
+ */
+static bool CrtCheck(const Poly *interp, const Poly *a, const Poly *b,
+                     const Poly *content, Poly *res) {
+    Poly int_content = PolyIntContent(interp, PolyZero());
+    Poly cand;
+    bool divides = PolyDivByCoeff(interp, &int_content, &cand);
+    assert(divides);
+    PolyDestroy(&int_content);
+    cand = GcdNormalize(cand);
+    Poly quot;
+    divides = PolyDivExactRec(a, &cand, &quot);
+    if (divides) {
+        PolyDestroy(&quot);
+        divides = PolyDivExactRec(b, &cand, &quot);
+        if (divides) PolyDestroy(&quot);
+    }
+    if (divides) *res = PolyScale(&cand, content);
+    PolyDestroy(&cand);
+    return divides;
+}
+
+/**
+ * Wylicza NWD wielomianów o współczynnikach całkowitych: wylicza obrazy NWD
+ * modulo kolejne duże liczby pierwsze (patrz: ModGcd()), przeskalowane przez
+ * NWD współczynników wiodących, i składa je chińskim twierdzeniem o resztach,
+ * aż kolejna liczba pierwsza nie zmieni wyniku, który dzieli oba wielomiany.
+ * @param[in] p : wielomian @f$p@f$ niebędący współczynnikiem
+ * @param[in] q : wielomian @f$q@f$ niebędący współczynnikiem
+ * @return NWD @f$p@f$ i @f$q@f$ o dodatnim współczynniku wiodącym
+ */
+static Poly GcdModular(const Poly *p, const Poly *q) {
+    Poly content_p = PolyIntContent(p, PolyZero());
+    Poly content_q = PolyIntContent(q, PolyZero());
+    Poly content = BigCoeffGcd(&content_p, &content_q);
+    Poly a, b;
+    bool divides = PolyDivByCoeff(p, &content_p, &a)
+                   && PolyDivByCoeff(q, &content_q, &b);
+    assert(divides);
+    (void) divides;
+    PolyDestroy(&content_p);
+    PolyDestroy(&content_q);
+    const Poly *lead_a = PolyLeadingCoeff(&a), *lead_b = PolyLeadingCoeff(&b);
+    Poly lead_gcd = BigCoeffGcd(lead_a, lead_b);
+    size_t k = PolyEvalVars(&a), k_b = PolyEvalVars(&b);
+    if (k_b > k) k = k_b;
+    poly_exp_t *lead = malloc(2 * k * sizeof(poly_exp_t));
+    if (lead == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    poly_exp_t *exps = lead + k;
+    Poly interp = PolyZero(), modulus = PolyZero(), res = PolyZero();
+    bool found = false;
+    for (poly_coeff_t prime = MOD_MAX + 1; !found;) {
+        prime = PrevPrime(prime);
+        ModArith saved = ModSwitch(prime);
+        if (BigCoeffMod(lead_a) == 0 || BigCoeffMod(lead_b) == 0) {
+            mod_arith = saved;
+            continue;
+        }
+        Poly a_mod = PolyReduce(&a), b_mod = PolyReduce(&b), image;
+        bool computed = ModGcd(&a_mod, &b_mod, k, &image);
+        PolyDestroy(&a_mod);
+        PolyDestroy(&b_mod);
+        assert(computed);
+        (void) computed;
+        if (PolyIsCoeff(&image)) {
+            mod_arith = saved;
+            res = PolyClone(&content);
+            break;
+        }
+        LeadingExps(&image, k, exps);
+        int cmp = PolyIsZero(&modulus) ? -1
+                                        : CompareExpVectors(exps, lead, k);
+        if (cmp > 0) {
+            PolyDestroy(&image);
+            mod_arith = saved;
+            continue;
+        }
+        Poly lead_gcd_mod = PolyFromCoeff(BigCoeffMod(&lead_gcd));
+        Poly scaled = PolyScale(&image, &lead_gcd_mod);
+        PolyDestroy(&image);
+        if (cmp < 0) {
+            mod_arith = saved;
+            PolyDestroy(&interp);
+            PolyDestroy(&modulus);
+            modulus = PolyFromCoeff(prime);
+            interp = SymmetricMod(&scaled, &modulus);
+            PolyDestroy(&scaled);
+            memcpy(lead, exps, k * sizeof(poly_exp_t));
+            continue;
+        }
+        // Poprawka T = (obraz - interp) / modulus modulo prime.
+        Poly old = PolyReduce(&interp);
+        Poly delta = PolySubOwn(&scaled, &old);
+        Poly inv = PolyFromCoeff(ModInverse(BigCoeffMod(&modulus)));
+        Poly step = PolyScale(&delta, &inv);
+        PolyDestroy(&delta);
+        mod_arith = saved;
+        if (PolyIsZero(&step)) {
+            found = CrtCheck(&interp, &a, &b, &content, &res);
+            continue;
+        }
+        Poly prime_poly = PolyFromCoeff(prime);
+        Poly new_modulus = CoeffMul(&modulus, &prime_poly);
+        Poly shift = PolyScale(&step, &modulus);
+        PolyDestroy(&step);
+        Poly sum = PolyAddOwn(&interp, &shift);
+        interp = SymmetricMod(&sum, &new_modulus);
+        PolyDestroy(&sum);
+        PolyDestroy(&modulus);
+        modulus = new_modulus;
+    }
+    free(lead);
+    PolyDestroy(&interp);
+    PolyDestroy(&modulus);
+    PolyDestroy(&lead_gcd);
+    PolyDestroy(&a);
+    PolyDestroy(&b);
+    PolyDestroy(&content);
+    return res;
+}
+
+/**
+ * Wylicza największy wspólny dzielnik dwóch wielomianów, wybierając metodę:
+ * przy obliczeniach dokładnych algorytm modularny (patrz: GcdModular()), a przy
+ * obliczeniach modulo liczba pierwsza algorytm Browna (patrz: ModGcd()) lub,
+ * jeśli moduł jest za mały, ciąg pseudo-reszt (patrz: GcdPrs()).
  * @param[in] p : wielomian @f$p@f$
- * @param[in] k : liczba wielomianów @f$q_i@f$
- * @param[in] q : lista wielomianów: @f$q_0, q_1, \ldots, q_{k-1}@f$
- * @return @f$p(q_0, q_1, q_2, …)@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return znormalizowany (patrz: GcdNormalize()) NWD @f$p@f$ i @f$q@f$
  */
-Poly PolyCompose(const Poly *p, size_t k, const Poly q[]) {
-    return PolyComposeHelper(p, k, q, 0);
-}
\ No newline at end of file
+static Poly GcdRec(const Poly *p, const Poly *q) {
+    if (PolyIsCoeff(p) || PolyIsCoeff(q)) return GcdPrs(p, q);
+    if (PolyIsEq(p, q)) return GcdNormalize(PolyClone(p));
+    if (!ModEnabled()) return GcdModular(p, q);
+    size_t k = PolyEvalVars(p), k_q = PolyEvalVars(q);
+    Poly res;
+    if (ModGcd(p, q, k > k_q ? k : k_q, &res)) return res;
+    return GcdPrs(p, q);
+}
+
+/**
+ * Wylicza największy wspólny dzielnik dwóch wielomianów. Przy obliczeniach
+ * dokładnych NWD ma dodatni współczynnik wiodący (patrz: PolyLeadingCoeff()),
+ * a przy obliczeniach modulo liczba pierwsza jest unormowany. NWD dwóch zer
+ * jest zerem.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @param[out] res : NWD @f$p@f$ i @f$q@f$
+ * @return Czy NWD jest określony, czyli czy obliczenia są dokładne lub
+ * modulo liczba pierwsza?
+ */
+bool PolyGcd(const Poly *p, const Poly *q, Poly *res) {
+    assert(p != NULL && q != NULL && res != NULL);
+    if (ModEnabled() && !ModIsPrime()) return false;
+    *res = GcdRec(p, q);
+    return true;
+}
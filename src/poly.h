@@ -12,6 +12,7 @@
 #include <assert.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 /** To jest typ reprezentujący współczynniki. */
 typedef long poly_coeff_t;
@@ -21,10 +22,20 @@ typedef int poly_exp_t;
 
 struct Mono;
 
+/**
+ * Znacznik ustawiany w najmłodszym bicie wskaźnika @p arr wielomianu będącego
+ * dużym współczynnikiem. Tablice jednomianów są wyrównane, więc najmłodszy
+ * bit wskaźnika na nie jest zawsze zerowy.
+ */
+#define POLY_BIG_COEFF_TAG ((uintptr_t) 1)
+
 /**
  * To jest struktura przechowująca wielomian.
  * Wielomian jest albo liczbą całkowitą, czyli wielomianem stałym
  * (wtedy `arr == NULL`), albo niepustą listą jednomianów (wtedy `arr != NULL`).
+ * Liczba całkowita, która nie mieści się w typie poly_coeff_t, jest dużym
+ * współczynnikiem: wtedy `arr` jest wskaźnikiem na jej reprezentację
+ * oznaczonym znacznikiem @p POLY_BIG_COEFF_TAG (patrz: big_coeff.h).
  */
 typedef struct Poly {
     /**
@@ -98,7 +109,17 @@ static inline Mono MonoFromPoly(const Poly *p, poly_exp_t n) {
  * @return Czy wielomian jest współczynnikiem?
  */
 static inline bool PolyIsCoeff(const Poly *p) {
-    return p->arr == NULL;
+    return p->arr == NULL || ((uintptr_t) p->arr & POLY_BIG_COEFF_TAG) != 0;
+}
+
+/**
+ * Sprawdza, czy wielomian jest dużym współczynnikiem, czyli liczbą całkowitą
+ * niemieszczącą się w typie poly_coeff_t.
+ * @param[in] p : wielomian
+ * @return Czy wielomian jest dużym współczynnikiem?
+ */
+static inline bool PolyIsBigCoeff(const Poly *p) {
+    return ((uintptr_t) p->arr & POLY_BIG_COEFF_TAG) != 0;
 }
 
 /**
@@ -107,7 +128,8 @@ static inline bool PolyIsCoeff(const Poly *p) {
  * @return Czy wielomian jest równy zeru?
  */
 static inline bool PolyIsZero(const Poly *p) {
-    return PolyIsCoeff(p) && p->coeff == 0;
+    // Duży współczynnik nigdy nie jest zerem.
+    return p->arr == NULL && p->coeff == 0;
 }
 
 /**
@@ -125,14 +147,16 @@ static inline void MonoDestroy(Mono *m) {
 }
 
 /**
- * Robi pełną, głęboką kopię wielomianu.
+ * Robi kopię wielomianu; kopia współdzieli niemodyfikowalną tablicę
+ * jednomianów z oryginałem, więc jej wykonanie zajmuje stały czas.
  * @param[in] p : wielomian
  * @return skopiowany wielomian
  */
 Poly PolyClone(const Poly *p);
 
 /**
- * Robi pełną, głęboką kopię jednomianu.
+ * Robi kopię jednomianu; kopia współdzieli tablicę jednomianów
+ * współczynnika z oryginałem.
  * @param[in] m : jednomian
  * @return skopiowany jednomian
  */
@@ -149,25 +173,24 @@ static inline Mono MonoClone(const Mono *m) {
 Poly PolyAdd(const Poly *p, const Poly *q);
 
 /**
- * Sumuje listę jednomianów i tworzy z nich wielomian.
- * Przejmuje na własność zawartość tablicy @p monos.
- * @param[in] count : liczba jednomianów
- * @param[in] monos : tablica jednomianów
- * @return wielomian będący sumą jednomianów
+ * Dodaje dwa wielomiany, przejmując je na własność: po wywołaniu nie należy
+ * ich używać ani usuwać. Jeśli któryś z wielomianów jest jedynym właścicielem
+ * swojej tablicy jednomianów, wynik powstaje w tej tablicy, a przenoszone są
+ * całe poddrzewa jednomianów, zamiast kopiowania ich i usuwania oryginałów.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p + q@f$
  */
-Poly PolyAddMonos(size_t count, const Mono monos[]);
+Poly PolyAddOwn(Poly *p, Poly *q);
 
 /**
- * Sumuje listę jednomianów i tworzy z nich wielomian. Przejmuje na własność
- * pamięć wskazywaną przez @p monos i jej zawartość. Może dowolnie modyfikować
- * zawartość tej pamięci. Zakładamy, że pamięć wskazywana przez @p monos
- * została zaalokowana na stercie. Jeśli @p count lub @p monos jest równe zeru
- * (NULL), tworzy wielomian tożsamościowo równy zeru.
+ * Sumuje listę jednomianów i tworzy z nich wielomian.
+ * Przejmuje na własność zawartość tablicy @p monos.
  * @param[in] count : liczba jednomianów
  * @param[in] monos : tablica jednomianów
  * @return wielomian będący sumą jednomianów
  */
-Poly PolyOwnMonos(size_t count, Mono *monos);
+Poly PolyAddMonos(size_t count, const Mono monos[]);
 
 /**
  * Sumuje listę jednomianów i tworzy z nich wielomian. Nie modyfikuje zawartości
@@ -180,6 +203,17 @@ Poly PolyOwnMonos(size_t count, Mono *monos);
  */
 Poly PolyCloneMonos(size_t count, const Mono monos[]);
 
+/**
+ * Sumuje listę jednomianów i tworzy z nich wielomian. Przejmuje na własność
+ * tablicę @p arr, przydzieloną przez MonoArrAlloc() (patrz: mono_alloc.h),
+ * oraz jej zawartość i może dowolnie modyfikować tę tablicę. Tablica staje
+ * się tablicą jednomianów wyniku bez kopiowania.
+ * @param[in] count : liczba jednomianów, większa od zera
+ * @param[in] arr : tablica jednomianów
+ * @return wielomian będący sumą jednomianów
+ */
+Poly PolyArrMonos(size_t count, Mono *arr);
+
 /**
  * Mnoży dwa wielomiany.
  * @param[in] p : wielomian @f$p@f$
@@ -188,6 +222,27 @@ Poly PolyCloneMonos(size_t count, const Mono monos[]);
  */
 Poly PolyMul(const Poly *p, const Poly *q);
 
+/**
+ * Mnoży dwa wielomiany, przejmując je na własność: po wywołaniu nie należy
+ * ich używać ani usuwać. Mnożenie przez współczynnik wielomianu, który jest
+ * jedynym właścicielem swojej tablicy jednomianów, odbywa się w miejscu.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p * q@f$
+ */
+Poly PolyMulOwn(Poly *p, Poly *q);
+
+/**
+ * Podnosi wielomian do potęgi naturalnej. Metoda zależy od liczby wyrazów
+ * wielomianu: wielomiany gęste podnoszone są do kwadratu, a rzadkie -
+ * metodami, których koszt zależy od liczby wyrazów wyniku.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] n : wykładnik @f$n \geq 0@f$; @f$n@f$ razy stopień @p p ze
+ * względu na każdą zmienną mieści się w typie poly_exp_t
+ * @return @f$p^n@f$
+ */
+Poly PolyPow(const Poly *p, poly_exp_t n);
+
 /**
  * Zwraca przeciwny wielomian.
  * @param[in] p : wielomian @f$p@f$
@@ -195,6 +250,15 @@ Poly PolyMul(const Poly *p, const Poly *q);
  */
 Poly PolyNeg(const Poly *p);
 
+/**
+ * Zwraca przeciwny wielomian, przejmując @p p na własność: po wywołaniu nie
+ * należy go używać ani usuwać. Jeśli @p p jest jedynym właścicielem swojej
+ * tablicy jednomianów, współczynniki negowane są w miejscu.
+ * @param[in] p : wielomian @f$p@f$
+ * @return @f$-p@f$
+ */
+Poly PolyNegOwn(Poly *p);
+
 /**
  * Odejmuje wielomian od wielomianu.
  * @param[in] p : wielomian @f$p@f$
@@ -203,6 +267,57 @@ Poly PolyNeg(const Poly *p);
  */
 Poly PolySub(const Poly *p, const Poly *q);
 
+/**
+ * Odejmuje wielomian od wielomianu, przejmując oba na własność: po wywołaniu
+ * nie należy ich używać ani usuwać (patrz: PolyAddOwn()).
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p - q@f$
+ */
+Poly PolySubOwn(Poly *p, Poly *q);
+
+/**
+ * Dzieli wielomian przez wielomian, jeśli iloraz jest wielomianem.
+ * Jednomiany ilorazu wyznaczane są od największego wykładnika zmiennej
+ * @f$x_0@f$, a ich współczynniki - rekurencyjnie. Przy obliczeniach modulo
+ * złożony moduł dzielenie może się nie udać mimo istnienia ilorazu.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : niezerowy wielomian @f$q@f$
+ * @param[out] res : iloraz @f$p / q@f$, jeśli dzielenie jest wykonalne
+ * @return Czy @f$q@f$ dzieli @f$p@f$?
+ */
+bool PolyDivExact(const Poly *p, const Poly *q, Poly *res);
+
+/**
+ * Pseudo-dzieli wielomian @p p przez niezerowy wielomian @p q względem zmiennej
+ * @f$x_0@f$: wyznacza wielomiany @f$Q@f$ i @f$R@f$ takie, że
+ * @f$l^{\delta} p = Q q + R@f$, gdzie @f$l@f$ jest współczynnikiem przy
+ * najwyższej potędze @f$x_0@f$ w @p q, @f$m@f$ jest stopniem @p q względem
+ * @f$x_0@f$, @f$\delta = \max(\deg_{x_0} p - m + 1, 0)@f$, a stopień @f$R@f$
+ * względem @f$x_0@f$ jest mniejszy od @f$m@f$.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : niezerowy wielomian @f$q@f$
+ * @param[out] quot : pseudo-iloraz @f$Q@f$
+ * @param[out] rem : pseudo-reszta @f$R@f$
+ */
+void PolyDivRem(const Poly *p, const Poly *q, Poly *quot, Poly *rem);
+
+/**
+ * Wylicza największy wspólny dzielnik dwóch wielomianów algorytmem
+ * modularnym: przy obliczeniach dokładnych z obrazów modulo duże liczby
+ * pierwsze składanych chińskim twierdzeniem o resztach, a w każdym obrazie -
+ * interpolacją kolejnych zmiennych (algorytm Browna). Przy obliczeniach
+ * dokładnych NWD ma dodatni współczynnik wiodący, a modulo liczba pierwsza
+ * jest unormowany (współczynnikiem wiodącym jest największy leksykograficznie
+ * jednomian). NWD dwóch zer jest zerem.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @param[out] res : NWD @f$p@f$ i @f$q@f$
+ * @return Czy NWD jest określony, czyli czy obliczenia są dokładne lub
+ * modulo liczba pierwsza?
+ */
+bool PolyGcd(const Poly *p, const Poly *q, Poly *res);
+
 /**
  * Zwraca stopień wielomianu ze względu na zadaną zmienną (-1 dla wielomianu
  * tożsamościowo równego zeru). Zmienne indeksowane są od 0.
@@ -217,11 +332,31 @@ poly_exp_t PolyDegBy(const Poly *p, size_t var_idx);
 
 /**
  * Zwraca stopień wielomianu (-1 dla wielomianu tożsamościowo równego zeru).
+ * Stopień przekraczający zakres typu poly_exp_t jest nasycany do INT_MAX.
  * @param[in] p : wielomian
  * @return stopień wielomianu @p p
  */
 poly_exp_t PolyDeg(const Poly *p);
 
+/**
+ * Zwraca liczbę niezerowych współczynników liczbowych wielomianu, czyli
+ * liczbę jego wyrazów po rozwinięciu (nasycaną do SIZE_MAX). Wymaga stałego
+ * czasu.
+ * @param[in] p : wielomian
+ * @return liczba wyrazów wielomianu @p p
+ */
+size_t PolyTermCount(const Poly *p);
+
+/**
+ * Sprawdza, czy zmienna o zadanym indeksie występuje w wielomianie
+ * z dodatnim wykładnikiem. Dla indeksów mniejszych od 63 wymaga stałego
+ * czasu.
+ * @param[in] p : wielomian
+ * @param[in] var_idx : indeks zmiennej
+ * @return Czy zmienna występuje w wielomianie @p p?
+ */
+bool PolyHasVar(const Poly *p, size_t var_idx);
+
 /**
  * Sprawdza równość dwóch wielomianów.
  * @param[in] p : wielomian @f$p@f$
@@ -243,6 +378,29 @@ bool PolyIsEq(const Poly *p, const Poly *q);
  */
 Poly PolyAt(const Poly *p, poly_coeff_t x);
 
+/**
+ * Wylicza wartość wielomianu w punkcie @p x (patrz: PolyAt()), przejmując
+ * @p p na własność: po wywołaniu nie należy go używać ani usuwać. Jeśli @p p
+ * jest jedynym właścicielem swojej tablicy jednomianów, wyraz wolny (dla
+ * @f$x = 0@f$) lub współczynnik jedynego jednomianu są przenoszone do wyniku
+ * zamiast kopiowania.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] x : wartość argumentu @f$x@f$
+ * @return @f$p(x, x_0, x_1, \ldots)@f$
+ */
+Poly PolyAtOwn(Poly *p, poly_coeff_t x);
+
+/**
+ * Wylicza wartości wielomianu w wielu punktach, przechodząc jego jednomiany
+ * tylko raz (patrz: PolyAt()).
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] k : liczba punktów
+ * @param[in] xs : wartości argumentu: @f$x_0, x_1, \ldots, x_{k-1}@f$
+ * @param[out] res : wartości @f$p(x_0, \ldots), p(x_1, \ldots), \ldots,
+ * p(x_{k-1}, \ldots)@f$
+ */
+void PolyAtMulti(const Poly *p, size_t k, const poly_coeff_t xs[], Poly res[]);
+
 /**
  * Zwraca złożenie wielomianu @p p z wielomianami @f$q_0, q_1, \ldots@f$ .
  * Niech @f$l@f$ oznacza liczbę zmiennych wielomianu @p p i niech te zmienne
@@ -258,4 +416,62 @@ Poly PolyAt(const Poly *p, poly_coeff_t x);
  */
 Poly PolyCompose(const Poly *p, size_t k, const Poly q[]);
 
+/**
+ * Włącza lub wyłącza internowanie wielomianów. Gdy internowanie jest włączone,
+ * równe wielomiany niebędące współczynnikami są przechowywane w pamięci tylko
+ * raz, a PolyIsEq() porównuje je w stałym czasie.
+ * @param[in] enabled : czy włączyć internowanie
+ */
+void PolySetInterning(bool enabled);
+
+/**
+ * Sprawdza, czy wielomian jest internowany, czyli czy współdzieli tablicę
+ * jednomianów z każdym równym mu internowanym wielomianem. Współczynniki nie
+ * są internowane.
+ * @param[in] p : wielomian
+ * @return Czy wielomian jest internowany?
+ */
+bool PolyIsInterned(const Poly *p);
+
+/**
+ * Ustawia moduł, modulo który liczone są współczynniki wielomianów. Po jego
+ * ustawieniu współczynniki wyników wszystkich działań są resztami
+ * z przedziału @f$[0, mod)@f$.
+ * @param[in] mod : moduł z przedziału @f$[2, 2^{62})@f$ lub 0, aby
+ * przywrócić obliczenia dokładne
+ * @return Czy moduł jest poprawny?
+ */
+bool PolySetModulus(poly_coeff_t mod);
+
+/**
+ * Redukuje współczynniki wielomianu modulo ustawiony moduł
+ * (patrz: PolySetModulus()).
+ * @param[in] p : wielomian
+ * @return wielomian @p p o współczynnikach zredukowanych modulo
+ */
+Poly PolyReduce(const Poly *p);
+
+/**
+ * To jest struktura przechowująca liczniki działań biblioteki.
+ */
+typedef struct PolyCounters {
+    size_t monos;       ///< liczba jednomianów utworzonych wielomianów
+    size_t mul_calls;   ///< liczba wywołań PolyMul(), także rekurencyjnych
+    size_t sorts;       ///< liczba sortowań tablic jednomianów i wykładników
+} PolyCounters;
+
+/**
+ * Włącza lub wyłącza zliczanie działań biblioteki (patrz: PolyCounters).
+ * Gdy zliczanie jest wyłączone, liczniki nie są zwiększane.
+ * @param[in] enabled : czy zliczać działania
+ */
+void PolySetCounting(bool enabled);
+
+/**
+ * Daje wartości liczników działań biblioteki zliczonych od początku
+ * działania programu, gdy zliczanie było włączone.
+ * @return liczniki działań
+ */
+PolyCounters PolyGetCounters(void);
+
 #endif /* __POLY_H__ */
\ No newline at end of file
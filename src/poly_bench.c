@@ -0,0 +1,680 @@
+/** @file
+  Pomiary wydajności biblioteki wielomianów
+
+  Program mierzy czas działania wszystkich funkcji interfejsu poly.h oraz
+  wczytywania (ReadPoly()) i wypisywania (PrintPoly()) wielomianów. Wielomiany
+  generowane są pseudolosowo z zadanego ziarna, więc kolejne uruchomienia
+  (także różnych wersji programu) mierzą te same dane. Generowane są
+  wielomiany gęste i rzadkie, jednej zmiennej, kilku zmiennych (płytkie) oraz
+  wielu zmiennych (głębokie), o liczbie wyrazów z kolejnych rozmiarów
+  @p SIZES.
+
+  Wyniki wypisywane są na standardowe wyjście w formacie JSON: dla każdej
+  funkcji, rodzaju i rozmiaru wielomianu średni czas wywołania w nanosekundach,
+  średnia liczba tablic jednomianów przydzielonych z pul alokatora
+  (pool_allocs_per_op, patrz: MonoAllocCount()) oraz szczytowe zużycie pamięci
+  procesu w kilobajtach. Liczba przydziałów nie obejmuje pozostałej pamięci,
+  np. dużych współczynników (big_coeff.h) i areny pamięci tymczasowej.
+
+  Użycie: poly_bench [--seed n] [--min-time ms] [--filter napis]
+
+  @authors Izabela Ożdżeńska <io417924@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include "calc_parse.h"
+#include "mono_alloc.h"
+#include "poly.h"
+
+/** Domyślne ziarno generatora liczb pseudolosowych. */
+#define DEFAULT_SEED 2021
+
+/** Domyślny minimalny czas pomiaru jednej funkcji w milisekundach. */
+#define DEFAULT_MIN_TIME_MS 50
+
+/** Największa liczba wywołań mierzonych jednym odczytem zegara. */
+#define MAX_BATCH 64
+
+/** Największa liczba zmiennych generowanych wielomianów. */
+#define MAX_VARS 8
+
+/** Współczynniki generowanych wielomianów należą do @f$[-C, C]@f$. */
+#define COEFF_RANGE 1000
+
+/**
+ * Największa różnica kolejnych wykładników jednomianów wielomianu rzadkiego.
+ */
+#define SPARSE_GAP 64
+
+/** Moduł, modulo który mierzone jest PolyReduce(). */
+#define BENCH_MODULUS 1000003
+
+/** Wykładnik, do którego podnosi PolyPow(). */
+#define BENCH_POW_EXP 3
+
+/**
+ * Największy rozmiar danych, dla których wyliczany jest iloczyn @f$pq@f$,
+ * dzielna PolyDivExact() i PolyDivRem() oraz argument PolyGcd().
+ */
+#define PRODUCT_MAX_SIZE 64
+
+/** Liczba punktów, w których wylicza wartości PolyAtMulti(). */
+#define AT_MULTI_POINTS 3
+
+/** Rozmiary (liczby wyrazów) generowanych wielomianów. */
+static const size_t SIZES[] = {16, 64, 256, 1024};
+
+/**
+ * To jest struktura opisująca rodzaj generowanych wielomianów.
+ */
+typedef struct Shape {
+    const char *name;   ///< nazwa rodzaju
+    size_t vars;        ///< liczba zmiennych
+    bool dense;         ///< czy kolejne wykładniki różnią się o jeden
+} Shape;
+
+/** Rodzaje generowanych wielomianów. */
+static const Shape SHAPES[] = {
+    {"dense-uni", 1, true},
+    {"sparse-uni", 1, false},
+    {"dense-shallow", 3, true},
+    {"sparse-shallow", 3, false},
+    {"dense-deep", MAX_VARS, true},
+    {"sparse-deep", MAX_VARS, false},
+};
+
+/**
+ * To jest struktura przechowująca stan generatora liczb pseudolosowych
+ * (xorshift64*).
+ */
+typedef struct Rng {
+    uint64_t state; ///< stan generatora, różny od zera
+} Rng;
+
+/**
+ * Tworzy generator liczb pseudolosowych. Różne pary (@p seed, @p stream)
+ * dają niezależne ciągi liczb.
+ * @param[in] seed : ziarno
+ * @param[in] stream : numer ciągu
+ * @return generator
+ */
+static Rng RngCreate(uint64_t seed, uint64_t stream) {
+    // Mieszanie splitmix64 rozprasza podobne ziarna.
+    uint64_t z = seed + (stream + 1) * 0x9E3779B97F4A7C15u;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9u;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBu;
+    z ^= z >> 31;
+    return (Rng) {.state = z != 0 ? z : 1};
+}
+
+/**
+ * Daje kolejną liczbę pseudolosową z przedziału @f$[0, n)@f$.
+ * @param[in,out] rng : generator
+ * @param[in] n : górna granica, @f$n > 0@f$
+ * @return liczba pseudolosowa
+ */
+static uint64_t RngBelow(Rng *rng, uint64_t n) {
+    rng->state ^= rng->state >> 12;
+    rng->state ^= rng->state << 25;
+    rng->state ^= rng->state >> 27;
+    return (rng->state * 0x2545F4914F6CDD1Du) % n;
+}
+
+/**
+ * Daje najmniejszą liczbę jednomianów @f$k@f$ taką, że @f$k^{vars}@f$
+ * jest nie mniejsze od @p terms.
+ * @param[in] terms : liczba wyrazów
+ * @param[in] vars : liczba zmiennych
+ * @return liczba jednomianów
+ */
+static size_t Fanout(size_t terms, size_t vars) {
+    size_t k = 1;
+    while (true) {
+        size_t power = 1;
+        for (size_t i = 0; i < vars && power < terms; i++) power *= k;
+        if (power >= terms) return k;
+        k++;
+    }
+}
+
+/**
+ * Generuje wielomian zmiennych od @f$x_{var\_idx}@f$ do ostatniej zmiennej
+ * rodzaju @p shape, o około @p terms wyrazach.
+ * @param[in,out] rng : generator
+ * @param[in] shape : rodzaj wielomianu
+ * @param[in] var_idx : indeks pierwszej zmiennej
+ * @param[in] terms : liczba wyrazów
+ * @return wielomian
+ */
+static Poly RandPoly(Rng *rng, const Shape *shape, size_t var_idx,
+                     size_t terms) {
+    if (var_idx == shape->vars) {
+        poly_coeff_t c = (poly_coeff_t) RngBelow(rng, 2 * COEFF_RANGE)
+                         - COEFF_RANGE;
+        return PolyFromCoeff(c >= 0 ? c + 1 : c);
+    }
+    size_t count = Fanout(terms, shape->vars - var_idx);
+    size_t child_terms = (terms + count - 1) / count;
+    Mono *monos = malloc(count * sizeof(Mono));
+    if (monos == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    poly_exp_t exp = 0;
+    for (size_t i = 0; i < count; i++) {
+        Poly p = RandPoly(rng, shape, var_idx + 1, child_terms);
+        monos[i] = MonoFromPoly(&p, exp);
+        exp += shape->dense ? 1 : 1 + (poly_exp_t) RngBelow(rng, SPARSE_GAP);
+    }
+    Poly res = PolyAddMonos(count, monos);
+    free(monos);
+    return res;
+}
+
+/**
+ * Tworzy wielomian @f$x_{var\_idx}@f$.
+ * @param[in] var_idx : indeks zmiennej
+ * @return wielomian
+ */
+static Poly PolyVar(size_t var_idx) {
+    // Wielomian w postaci "((...((1,1),0)...),0)".
+    char text[4 * MAX_VARS + 8];
+    size_t len = 0;
+    for (size_t i = 0; i < var_idx; i++) text[len++] = '(';
+    memcpy(text + len, "(1,1)", 5);
+    len += 5;
+    for (size_t i = 0; i < var_idx; i++) {
+        memcpy(text + len, ",0)", 3);
+        len += 3;
+    }
+    text[len] = '\0';
+    Poly res;
+    bool correct = ReadPoly(text, &res);
+    assert(correct);
+    (void) correct;
+    return res;
+}
+
+/**
+ * To jest struktura przechowująca dane, na których mierzone są funkcje.
+ */
+typedef struct Fixture {
+    const Shape *shape;         ///< rodzaj wielomianów
+    size_t size;                ///< zadana liczba wyrazów
+    Poly p;                     ///< pierwszy argument
+    Poly q;                     ///< drugi argument
+    Poly p_copy;                ///< wielomian równy [p], o osobnych tablicach
+    Poly product;               ///< iloczyn [p] i [q] lub zero dla rozmiarów
+                                ///< większych od @p PRODUCT_MAX_SIZE
+    Poly vars[MAX_VARS];        ///< zmienne, argumenty PolyCompose()
+    char *text;                 ///< zapis wielomianu [p]
+    FILE *sink;                 ///< strumień, do którego wypisuje PrintPoly()
+} Fixture;
+
+/**
+ * Tworzy dane pomiarów dla zadanego rodzaju i rozmiaru wielomianów.
+ * @param[in] shape : rodzaj wielomianów
+ * @param[in] size : liczba wyrazów
+ * @param[in] seed : ziarno generatora
+ * @param[in] sink : strumień, do którego wypisuje PrintPoly()
+ * @return dane pomiarów
+ */
+static Fixture FixtureCreate(const Shape *shape, size_t size, uint64_t seed,
+                             FILE *sink) {
+    Fixture f = {.shape = shape, .size = size, .sink = sink};
+    uint64_t stream = (uint64_t) (shape - SHAPES) * 1000 + size;
+    Rng rng = RngCreate(seed, 2 * stream);
+    Rng rng_copy = rng;
+    f.p = RandPoly(&rng, shape, 0, size);
+    f.p_copy = RandPoly(&rng_copy, shape, 0, size);
+    rng = RngCreate(seed, 2 * stream + 1);
+    f.q = RandPoly(&rng, shape, 0, size);
+    f.product = size <= PRODUCT_MAX_SIZE ? PolyMul(&f.p, &f.q) : PolyZero();
+    for (size_t i = 0; i < shape->vars; i++) f.vars[i] = PolyVar(i);
+
+    size_t text_size;
+    FILE *text_stream = open_memstream(&f.text, &text_size);
+    if (text_stream == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    PrintPoly(&f.p, text_stream);
+    if (fclose(text_stream) != 0) exit(1); // Błąd podczas alokacji pamięci.
+    // ReadPoly() wczytuje wiersz bez znaku nowej linii.
+    f.text[text_size - 1] = '\0';
+    return f;
+}
+
+/**
+ * Usuwa z pamięci dane pomiarów.
+ * @param[in] f : dane pomiarów
+ */
+static void FixtureDestroy(Fixture *f) {
+    PolyDestroy(&f->p);
+    PolyDestroy(&f->q);
+    PolyDestroy(&f->p_copy);
+    PolyDestroy(&f->product);
+    for (size_t i = 0; i < f->shape->vars; i++) PolyDestroy(&f->vars[i]);
+    free(f->text);
+}
+
+/**
+ * Kopiuje jednomiany wielomianu do zadanej tablicy.
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @param[out] monos : tablica na @p p->size jednomianów
+ */
+static void CloneMonosInto(const Poly *p, Mono monos[]) {
+    for (size_t i = 0; i < p->size; i++) monos[i] = MonoClone(&p->arr[i]);
+}
+
+/** Mierzy PolyClone(). */
+static Poly BenchClone(const Fixture *f) {
+    return PolyClone(&f->p);
+}
+
+/** Tworzy wielomian, którego usunięcie mierzy przypadek "PolyDestroy". */
+static Poly BenchDestroy(const Fixture *f) {
+    return PolyAdd(&f->p, &f->q);
+}
+
+/** Mierzy PolyAdd(). */
+static Poly BenchAdd(const Fixture *f) {
+    return PolyAdd(&f->p, &f->q);
+}
+
+/** Mierzy PolyAddOwn(). */
+static Poly BenchAddOwn(const Fixture *f) {
+    Poly p = PolyClone(&f->p), q = PolyClone(&f->q);
+    return PolyAddOwn(&p, &q);
+}
+
+/** Mierzy PolyAddMonos(). */
+static Poly BenchAddMonos(const Fixture *f) {
+    Mono *monos = malloc(f->p.size * sizeof(Mono));
+    if (monos == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    CloneMonosInto(&f->p, monos);
+    Poly res = PolyAddMonos(f->p.size, monos);
+    free(monos);
+    return res;
+}
+
+/** Mierzy PolyCloneMonos(). */
+static Poly BenchCloneMonos(const Fixture *f) {
+    return PolyCloneMonos(f->p.size, f->p.arr);
+}
+
+/** Mierzy PolyArrMonos(). */
+static Poly BenchArrMonos(const Fixture *f) {
+    Mono *arr = MonoArrAlloc(f->p.size);
+    CloneMonosInto(&f->p, arr);
+    return PolyArrMonos(f->p.size, arr);
+}
+
+/** Mierzy PolyMul(). */
+static Poly BenchMul(const Fixture *f) {
+    return PolyMul(&f->p, &f->q);
+}
+
+/** Mierzy PolyMulOwn(). */
+static Poly BenchMulOwn(const Fixture *f) {
+    Poly p = PolyClone(&f->p), q = PolyClone(&f->q);
+    return PolyMulOwn(&p, &q);
+}
+
+/** Mierzy PolyPow(). */
+static Poly BenchPow(const Fixture *f) {
+    return PolyPow(&f->p, BENCH_POW_EXP);
+}
+
+/** Mierzy PolyDivExact(), dzieląc iloczyn @f$pq@f$ przez @f$q@f$. */
+static Poly BenchDivExact(const Fixture *f) {
+    Poly res;
+    bool exact = PolyDivExact(&f->product, &f->q, &res);
+    assert(exact);
+    (void) exact;
+    return res;
+}
+
+/**
+ * Mierzy PolyDivRem(), dzieląc iloczyn @f$pq@f$ przez @f$q@f$. Wynikiem jest
+ * pseudo-iloraz, a pseudo-reszta jest usuwana. Mierzona tylko dla wielomianów
+ * gęstych: dla rzadkich wykładnik @f$\delta@f$ jest duży, więc wyniki rosną
+ * jak potęga @f$l^{\delta}@f$ współczynnika wiodącego.
+ */
+static Poly BenchDivRem(const Fixture *f) {
+    Poly quot, rem;
+    PolyDivRem(&f->product, &f->q, &quot, &rem);
+    PolyDestroy(&rem);
+    return quot;
+}
+
+/** Mierzy PolyGcd() iloczynu @f$pq@f$ i @f$q@f$. */
+static Poly BenchGcd(const Fixture *f) {
+    Poly res;
+    bool defined = PolyGcd(&f->product, &f->q, &res);
+    assert(defined);
+    (void) defined;
+    return res;
+}
+
+/** Mierzy PolyNeg(). */
+static Poly BenchNeg(const Fixture *f) {
+    return PolyNeg(&f->p);
+}
+
+/** Mierzy PolyNegOwn(). */
+static Poly BenchNegOwn(const Fixture *f) {
+    Poly p = PolyClone(&f->p);
+    return PolyNegOwn(&p);
+}
+
+/** Mierzy PolySub(). */
+static Poly BenchSub(const Fixture *f) {
+    return PolySub(&f->p, &f->q);
+}
+
+/** Mierzy PolySubOwn(). */
+static Poly BenchSubOwn(const Fixture *f) {
+    Poly p = PolyClone(&f->p), q = PolyClone(&f->q);
+    return PolySubOwn(&p, &q);
+}
+
+/** Mierzy PolyDegBy() dla ostatniej zmiennej. */
+static Poly BenchDegBy(const Fixture *f) {
+    return PolyFromCoeff(PolyDegBy(&f->p, f->shape->vars - 1));
+}
+
+/** Mierzy PolyDeg(). */
+static Poly BenchDeg(const Fixture *f) {
+    return PolyFromCoeff(PolyDeg(&f->p));
+}
+
+/** Mierzy PolyTermCount(). */
+static Poly BenchTermCount(const Fixture *f) {
+    return PolyFromCoeff((poly_coeff_t) PolyTermCount(&f->p));
+}
+
+/** Mierzy PolyHasVar() dla ostatniej zmiennej. */
+static Poly BenchHasVar(const Fixture *f) {
+    return PolyFromCoeff(PolyHasVar(&f->p, f->shape->vars - 1));
+}
+
+/** Mierzy PolyIsEq() dla równych wielomianów o osobnych tablicach. */
+static Poly BenchIsEq(const Fixture *f) {
+    return PolyFromCoeff(PolyIsEq(&f->p, &f->p_copy));
+}
+
+/** Mierzy PolyAt(). */
+static Poly BenchAt(const Fixture *f) {
+    // Punkt -1 nie powoduje wzrostu współczynników wyniku.
+    return PolyAt(&f->p, -1);
+}
+
+/** Mierzy PolyAtOwn(). */
+static Poly BenchAtOwn(const Fixture *f) {
+    Poly p = PolyClone(&f->p);
+    return PolyAtOwn(&p, -1);
+}
+
+/** Mierzy PolyAtMulti(). */
+static Poly BenchAtMulti(const Fixture *f) {
+    static const poly_coeff_t xs[AT_MULTI_POINTS] = {-1, 0, 1};
+    Poly res[AT_MULTI_POINTS];
+    PolyAtMulti(&f->p, AT_MULTI_POINTS, xs, res);
+    for (size_t i = 1; i < AT_MULTI_POINTS; i++) PolyDestroy(&res[i]);
+    return res[0];
+}
+
+/** Mierzy PolyCompose() z podstawieniem @f$x_i@f$ pod @f$x_i@f$. */
+static Poly BenchCompose(const Fixture *f) {
+    return PolyCompose(&f->p, f->shape->vars, f->vars);
+}
+
+/** Mierzy PolyReduce(). */
+static Poly BenchReduce(const Fixture *f) {
+    return PolyReduce(&f->p);
+}
+
+/** Mierzy ReadPoly(). */
+static Poly BenchParse(const Fixture *f) {
+    Poly res;
+    bool correct = ReadPoly(f->text, &res);
+    assert(correct);
+    (void) correct;
+    return res;
+}
+
+/** Mierzy PrintPoly(). */
+static Poly BenchPrint(const Fixture *f) {
+    PrintPoly(&f->p, f->sink);
+    return PolyZero();
+}
+
+/**
+ * To jest struktura opisująca mierzoną funkcję.
+ */
+typedef struct BenchCase {
+    const char *name;                   ///< nazwa funkcji
+    Poly (*op)(const Fixture *f);       ///< mierzone wywołanie
+    size_t max_size;                    ///< największy mierzony rozmiar
+    bool time_destroy;                  ///< czy mierzyć usuwanie wyniku
+                                        ///< zamiast wywołania [op]
+    bool modular;                       ///< czy mierzyć z ustawionym modułem
+    bool dense_only;                    ///< czy mierzyć tylko dla wielomianów
+                                        ///< gęstych
+} BenchCase;
+
+/** Mierzone funkcje. */
+static const BenchCase CASES[] = {
+    {"PolyClone", BenchClone, SIZE_MAX, false, false, false},
+    {"PolyDestroy", BenchDestroy, SIZE_MAX, true, false, false},
+    {"PolyAdd", BenchAdd, SIZE_MAX, false, false, false},
+    {"PolyAddOwn", BenchAddOwn, SIZE_MAX, false, false, false},
+    {"PolyAddMonos", BenchAddMonos, SIZE_MAX, false, false, false},
+    {"PolyCloneMonos", BenchCloneMonos, SIZE_MAX, false, false, false},
+    {"PolyArrMonos", BenchArrMonos, SIZE_MAX, false, false, false},
+    {"PolyMul", BenchMul, 256, false, false, false},
+    {"PolyMulOwn", BenchMulOwn, 256, false, false, false},
+    {"PolyPow", BenchPow, 64, false, false, false},
+    {"PolyDivExact", BenchDivExact, PRODUCT_MAX_SIZE, false, false, false},
+    {"PolyDivRem", BenchDivRem, PRODUCT_MAX_SIZE, false, false, true},
+    {"PolyGcd", BenchGcd, PRODUCT_MAX_SIZE, false, false, false},
+    {"PolyGcdMod", BenchGcd, PRODUCT_MAX_SIZE, false, true, false},
+    {"PolyNeg", BenchNeg, SIZE_MAX, false, false, false},
+    {"PolyNegOwn", BenchNegOwn, SIZE_MAX, false, false, false},
+    {"PolySub", BenchSub, SIZE_MAX, false, false, false},
+    {"PolySubOwn", BenchSubOwn, SIZE_MAX, false, false, false},
+    {"PolyDegBy", BenchDegBy, SIZE_MAX, false, false, false},
+    {"PolyDeg", BenchDeg, SIZE_MAX, false, false, false},
+    {"PolyTermCount", BenchTermCount, SIZE_MAX, false, false, false},
+    {"PolyHasVar", BenchHasVar, SIZE_MAX, false, false, false},
+    {"PolyIsEq", BenchIsEq, SIZE_MAX, false, false, false},
+    {"PolyAt", BenchAt, SIZE_MAX, false, false, false},
+    {"PolyAtOwn", BenchAtOwn, SIZE_MAX, false, false, false},
+    {"PolyAtMulti", BenchAtMulti, SIZE_MAX, false, false, false},
+    {"PolyCompose", BenchCompose, 256, false, false, false},
+    {"PolyReduce", BenchReduce, SIZE_MAX, false, true, false},
+    {"ReadPoly", BenchParse, SIZE_MAX, false, false, false},
+    {"PrintPoly", BenchPrint, SIZE_MAX, false, false, false},
+};
+
+/**
+ * To jest struktura przechowująca opcje programu.
+ */
+typedef struct BenchOptions {
+    uint64_t seed;          ///< ziarno generatora
+    uint64_t min_time_ns;   ///< minimalny czas pomiaru jednej funkcji
+    const char *filter;     ///< napis, który musi zawierać nazwa funkcji
+                            ///< lub rodzaju wielomianów, lub NULL
+} BenchOptions;
+
+/**
+ * Daje aktualny czas zegara monotonicznego.
+ * @return czas w nanosekundach
+ */
+static uint64_t NowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * Daje szczytowe zużycie pamięci procesu.
+ * @return zużycie pamięci w kilobajtach
+ */
+static long PeakRssKb(void) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+    return usage.ru_maxrss;
+}
+
+/**
+ * Mierzy funkcję na zadanych danych i wypisuje wynik pomiaru jako obiekt
+ * JSON. Wywołania wykonywane są porcjami rosnącymi do @p MAX_BATCH, aż
+ * łączny czas pomiaru osiągnie @p options->min_time_ns. Wyniki wywołań są
+ * usuwane poza pomiarem (albo mierzone jest tylko ich usuwanie, jeśli
+ * @p c->time_destroy).
+ * @param[in] c : mierzona funkcja
+ * @param[in] f : dane pomiarów
+ * @param[in] options : opcje programu
+ * @param[in] first : czy jest to pierwszy wypisywany wynik
+ */
+static void RunCase(const BenchCase *c, const Fixture *f,
+                    const BenchOptions *options, bool first) {
+    if (c->modular) PolySetModulus(BENCH_MODULUS);
+    Poly results[MAX_BATCH];
+    // Rozgrzewka: pierwsze wywołanie wypełnia pule alokatora.
+    results[0] = c->op(f);
+    PolyDestroy(&results[0]);
+
+    uint64_t elapsed = 0;
+    size_t iterations = 0, pool_allocs = 0, batch = 1;
+    do {
+        if (c->time_destroy) {
+            for (size_t i = 0; i < batch; i++) results[i] = c->op(f);
+        }
+        size_t allocs_before = MonoAllocCount();
+        uint64_t start = NowNs();
+        for (size_t i = 0; i < batch; i++) {
+            if (c->time_destroy) PolyDestroy(&results[i]);
+            else results[i] = c->op(f);
+        }
+        elapsed += NowNs() - start;
+        pool_allocs += MonoAllocCount() - allocs_before;
+        iterations += batch;
+        if (!c->time_destroy) {
+            for (size_t i = 0; i < batch; i++) PolyDestroy(&results[i]);
+        }
+        if (batch < MAX_BATCH) batch *= 2;
+    } while (elapsed < options->min_time_ns);
+    if (c->modular) PolySetModulus(0);
+
+    printf("%s\n    {\"function\": \"%s\", \"shape\": \"%s\", \"vars\": %zu, "
+           "\"size\": %zu, \"terms\": %zu, \"iterations\": %zu, "
+           "\"ns_per_op\": %.1f, \"pool_allocs_per_op\": %.2f, "
+           "\"peak_rss_kb\": %ld}",
+           first ? "" : ",", c->name, f->shape->name, f->shape->vars, f->size,
+           PolyTermCount(&f->p), iterations, (double) elapsed / iterations,
+           (double) pool_allocs / iterations, PeakRssKb());
+    fflush(stdout);
+}
+
+/**
+ * Sprawdza, czy pomiar funkcji na wielomianach zadanego rodzaju jest wybrany
+ * opcją "--filter".
+ * @param[in] options : opcje programu
+ * @param[in] c : mierzona funkcja
+ * @param[in] shape : rodzaj wielomianów
+ * @return Czy pomiar jest wybrany?
+ */
+static bool Selected(const BenchOptions *options, const BenchCase *c,
+                     const Shape *shape) {
+    return options->filter == NULL || strstr(c->name, options->filter) != NULL
+           || strstr(shape->name, options->filter) != NULL;
+}
+
+/**
+ * Zamienia napis na nieujemną liczbę całkowitą.
+ * @param[in] str : napis
+ * @param[out] value : liczba
+ * @return Czy napis jest poprawną liczbą?
+ */
+static bool ParseUnsigned(const char *str, uint64_t *value) {
+    char *end;
+    unsigned long long res = strtoull(str, &end, 10);
+    if (str[0] < '0' || str[0] > '9' || *end != '\0') return false;
+    *value = res;
+    return true;
+}
+
+/**
+ * Wczytuje opcje programu: "--seed n" - ziarno generatora, "--min-time ms" -
+ * minimalny czas pomiaru jednej funkcji, "--filter napis" - mierzy tylko
+ * funkcje lub rodzaje wielomianów, których nazwa zawiera @p napis; a następnie
+ * mierzy wybrane funkcje dla wszystkich rodzajów i rozmiarów wielomianów.
+ * @param[in] argc : liczba argumentów wiersza poleceń
+ * @param[in] argv : argumenty wiersza poleceń
+ * @return 0, jeśli program zakończył się prawidłowo; 1, jeśli wystąpił błąd
+ */
+int main(int argc, char *argv[]) {
+    BenchOptions options = {.seed = DEFAULT_SEED,
+                            .min_time_ns = DEFAULT_MIN_TIME_MS * 1000000u,
+                            .filter = NULL};
+    for (int i = 1; i < argc; i++) {
+        uint64_t value;
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc &&
+            ParseUnsigned(argv[i + 1], &value)) {
+            options.seed = value;
+            i++;
+        }
+        else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc &&
+                 ParseUnsigned(argv[i + 1], &value)) {
+            options.min_time_ns = value * 1000000u;
+            i++;
+        }
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            options.filter = argv[++i];
+        }
+        else {
+            fprintf(stderr, "Usage: %s [--seed n] [--min-time ms] "
+                            "[--filter name]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    FILE *sink = fopen("/dev/null", "w");
+    if (sink == NULL) {
+        fprintf(stderr, "Cannot open /dev/null\n");
+        return 1;
+    }
+    printf("{\n  \"seed\": %llu,\n  \"min_time_ms\": %llu,\n  \"results\": [",
+           (unsigned long long) options.seed,
+           (unsigned long long) (options.min_time_ns / 1000000u));
+    bool first = true;
+    for (size_t s = 0; s < sizeof(SHAPES) / sizeof(SHAPES[0]); s++) {
+        for (size_t z = 0; z < sizeof(SIZES) / sizeof(SIZES[0]); z++) {
+            Fixture f = {0};
+            bool created = false;
+            for (size_t c = 0; c < sizeof(CASES) / sizeof(CASES[0]); c++) {
+                if (SIZES[z] > CASES[c].max_size ||
+                    (CASES[c].dense_only && !SHAPES[s].dense) ||
+                    !Selected(&options, &CASES[c], &SHAPES[s])) {
+                    continue;
+                }
+                if (!created) {
+                    f = FixtureCreate(&SHAPES[s], SIZES[z], options.seed, sink);
+                    created = true;
+                }
+                RunCase(&CASES[c], &f, &options, first);
+                first = false;
+            }
+            if (created) FixtureDestroy(&f);
+        }
+    }
+    printf("\n  ]\n}\n");
+    fclose(sink);
+    MonoAllocCleanup();
+    return 0;
+}
@@ -0,0 +1,520 @@
+/** @file
+  Implementacja wsadowego wyliczania wartości wielomianów
+
+  @authors Izabela Ożdżeńska <io417924@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#include <stdlib.h>
+#include "big_coeff.h"
+#include "mod_arith.h"
+#include "mono_alloc.h"
+#include "poly_eval.h"
+#include "thread_pool.h"
+
+/**
+ * Liczba punktów wyliczanych jednocześnie przez jeden przebieg programu.
+ */
+#define EVAL_BLOCK 256
+
+/**
+ * Początkowa pojemność tablicy instrukcji programu.
+ */
+#define EVAL_INITIAL_CAPACITY 16
+
+/**
+ * Oszacowanie wartości bezwzględnej wyniku, poniżej którego wynik obliczeń
+ * na liczbach 64-bitowych jest dokładny. Jest dwukrotnie mniejsze od
+ * @f$2^{63}@f$, co z zapasem pokrywa błędy zaokrągleń oszacowania.
+ */
+#define EVAL_SAFE_BOUND 4611686018427387904.0
+
+/**
+ * To jest typ reprezentujący rodzaj instrukcji programu. Program operuje na
+ * stosie rejestrów, z których każdy przechowuje wartości dla wszystkich
+ * punktów bloku.
+ */
+typedef enum EvalOp {
+    EVAL_PUSH,      ///< wstawia na stos rejestr równy współczynnikowi
+    EVAL_ADD_CONST, ///< dodaje współczynnik do rejestru na wierzchołku stosu
+    EVAL_ADD,       ///< dodaje rejestr z wierzchołka stosu do rejestru pod nim
+                    ///< i usuwa go ze stosu
+    EVAL_MUL_POW    ///< mnoży rejestr na wierzchołku stosu przez potęgę
+                    ///< zmiennej
+} EvalOp;
+
+/**
+ * To jest struktura przechowująca instrukcję programu.
+ */
+typedef struct EvalInstr {
+    EvalOp op;       ///< rodzaj instrukcji
+    size_t var;      ///< indeks zmiennej (dla <EVAL_MUL_POW>)
+    poly_exp_t exp;  ///< wykładnik potęgi zmiennej (dla <EVAL_MUL_POW>)
+    Poly coeff;      ///< współczynnik (dla <EVAL_PUSH> i <EVAL_ADD_CONST>)
+} EvalInstr;
+
+/**
+ * To jest struktura przechowująca skompilowany program wyliczający wartość
+ * wielomianu.
+ */
+struct EvalPlan {
+    size_t nvars;     ///< liczba współrzędnych punktów
+    size_t depth;     ///< największa liczba rejestrów na stosie
+    bool has_big;     ///< czy któryś ze współczynników jest duży
+    size_t size;      ///< liczba instrukcji
+    size_t capacity;  ///< pojemność tablicy instrukcji
+    EvalInstr *code;  ///< instrukcje
+};
+
+/**
+ * Zwraca liczbę zmiennych, od których może zależeć wielomian, czyli
+ * największą głębokość zagnieżdżenia jego współczynników. Wartość wielomianu
+ * nie zależy od współrzędnych punktu o indeksach nie mniejszych od wyniku.
+ * @param[in] p : wielomian @f$p@f$
+ * @return liczba zmiennych wielomianu
+ */
+size_t PolyEvalVars(const Poly *p) {
+    if (PolyIsCoeff(p)) return 0;
+    size_t res = 0;
+    for (size_t i = 0; i < p->size; i++) {
+        size_t vars = PolyEvalVars(&p->arr[i].p);
+        if (vars > res) res = vars;
+    }
+    return res + 1;
+}
+
+/**
+ * Dopisuje instrukcję na koniec programu.
+ * @param[in,out] plan : program
+ * @param[in] instr : instrukcja
+ */
+static void Emit(EvalPlan *plan, EvalInstr instr) {
+    if (plan->size == plan->capacity) {
+        plan->capacity *= 2;
+        plan->code = realloc(plan->code, plan->capacity * sizeof(EvalInstr));
+        if (plan->code == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    }
+    if (PolyIsBigCoeff(&instr.coeff)) plan->has_big = true;
+    plan->code[plan->size++] = instr;
+}
+
+/**
+ * Dopisuje instrukcję operującą na współczynniku.
+ * @param[in,out] plan : program
+ * @param[in] op : <EVAL_PUSH> lub <EVAL_ADD_CONST>
+ * @param[in] coeff : współczynnik
+ */
+static void EmitCoeff(EvalPlan *plan, EvalOp op, const Poly *coeff) {
+    Emit(plan, (EvalInstr) {.op = op, .coeff = PolyClone(coeff)});
+}
+
+/**
+ * Dopisuje instrukcję mnożącą rejestr przez potęgę zmiennej.
+ * @param[in,out] plan : program
+ * @param[in] var : indeks zmiennej
+ * @param[in] exp : wykładnik potęgi
+ */
+static void EmitMulPow(EvalPlan *plan, size_t var, poly_exp_t exp) {
+    Emit(plan, (EvalInstr) {.op = EVAL_MUL_POW, .var = var, .exp = exp,
+                            .coeff = PolyZero()});
+}
+
+/**
+ * Dopisuje instrukcje wstawiające na stos rejestr z wartością wielomianu,
+ * którego zmienna ma indeks @p level.
+ * @param[in,out] plan : program
+ * @param[in] p : wielomian
+ * @param[in] level : indeks zmiennej wielomianu @p p
+ * @param[in] regs : liczba rejestrów na stosie przed wykonaniem instrukcji
+ */
+static void Compile(EvalPlan *plan, const Poly *p, size_t level, size_t regs) {
+    if (regs + 1 > plan->depth) plan->depth = regs + 1;
+    if (PolyIsCoeff(p)) {
+        EmitCoeff(plan, EVAL_PUSH, p);
+        return;
+    }
+    // Tablica jednomianów jest posortowana malejąco względem wykładników.
+    const Mono *last = &p->arr[p->size - 1];
+    if (level >= plan->nvars) {
+        // Zmienna przyjmuje wartość 0, więc zostaje tylko wyraz wolny.
+        if (last->exp == 0) {
+            Compile(plan, &last->p, level + 1, regs);
+        }
+        else {
+            Poly zero = PolyZero();
+            EmitCoeff(plan, EVAL_PUSH, &zero);
+        }
+        return;
+    }
+    Compile(plan, &p->arr[0].p, level + 1, regs);
+    for (size_t i = 1; i < p->size; i++) {
+        EmitMulPow(plan, level, p->arr[i - 1].exp - p->arr[i].exp);
+        if (PolyIsCoeff(&p->arr[i].p)) {
+            EmitCoeff(plan, EVAL_ADD_CONST, &p->arr[i].p);
+        }
+        else {
+            Compile(plan, &p->arr[i].p, level + 1, regs + 1);
+            Emit(plan, (EvalInstr) {.op = EVAL_ADD, .coeff = PolyZero()});
+        }
+    }
+    if (last->exp > 0) EmitMulPow(plan, level, last->exp);
+}
+
+/**
+ * Kompiluje wielomian do programu wyliczającego jego wartość w punktach
+ * @f$(x_0, x_1, \ldots, x_{nvars-1})@f$. Zmienne o indeksach nie mniejszych
+ * od @p nvars przyjmują wartość 0.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] nvars : liczba współrzędnych punktów
+ * @return skompilowany program
+ */
+EvalPlan* PolyEvalCompile(const Poly *p, size_t nvars) {
+    assert(p != NULL);
+    EvalPlan *plan = malloc(sizeof(EvalPlan));
+    if (plan == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    *plan = (EvalPlan) {.nvars = nvars, .capacity = EVAL_INITIAL_CAPACITY};
+    plan->code = malloc(plan->capacity * sizeof(EvalInstr));
+    if (plan->code == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    Compile(plan, p, 0, 0);
+    return plan;
+}
+
+/**
+ * Usuwa skompilowany program z pamięci.
+ * @param[in] plan : skompilowany program
+ */
+void PolyEvalPlanDestroy(EvalPlan *plan) {
+    for (size_t i = 0; i < plan->size; i++) {
+        PolyDestroy(&plan->code[i].coeff);
+    }
+    free(plan->code);
+    free(plan);
+}
+
+/**
+ * Wykonuje program na liczbach 64-bitowych (modulo @f$2^{64}@f$).
+ * @param[in] plan : program
+ * @param[in] xs : współrzędne punktów bloku; współrzędna @f$v@f$ punktu
+ * @f$j@f$ ma indeks @f$v \cdot EVAL\_BLOCK + j@f$
+ * @param[in] n : liczba punktów bloku
+ * @param[out] out : wartości w punktach bloku
+ */
+static void EvalWrapping(const EvalPlan *plan, const unsigned long xs[],
+                         size_t n, unsigned long out[]) {
+    ScratchMark mark = ScratchGetMark();
+    unsigned long *regs = ScratchAlloc(plan->depth * EVAL_BLOCK
+                                       * sizeof(unsigned long));
+    unsigned long *pw = ScratchAlloc(2 * EVAL_BLOCK * sizeof(unsigned long));
+    unsigned long *base = pw + EVAL_BLOCK;
+    unsigned long *r = regs - EVAL_BLOCK;
+    for (size_t i = 0; i < plan->size; i++) {
+        const EvalInstr *instr = &plan->code[i];
+        unsigned long c = (unsigned long) instr->coeff.coeff;
+        switch (instr->op) {
+            case EVAL_PUSH:
+                r += EVAL_BLOCK;
+                for (size_t j = 0; j < n; j++) r[j] = c;
+                break;
+            case EVAL_ADD_CONST:
+                for (size_t j = 0; j < n; j++) r[j] += c;
+                break;
+            case EVAL_ADD:
+                for (size_t j = 0; j < n; j++) r[j - EVAL_BLOCK] += r[j];
+                r -= EVAL_BLOCK;
+                break;
+            case EVAL_MUL_POW: ;
+                const unsigned long *x = xs + instr->var * EVAL_BLOCK;
+                if (instr->exp == 1) {
+                    for (size_t j = 0; j < n; j++) r[j] *= x[j];
+                    break;
+                }
+                for (size_t j = 0; j < n; j++) {
+                    pw[j] = 1;
+                    base[j] = x[j];
+                }
+                for (poly_exp_t e = instr->exp; e > 0; e >>= 1) {
+                    if (e & 1) {
+                        for (size_t j = 0; j < n; j++) pw[j] *= base[j];
+                    }
+                    for (size_t j = 0; j < n; j++) base[j] *= base[j];
+                }
+                for (size_t j = 0; j < n; j++) r[j] *= pw[j];
+                break;
+        }
+    }
+    for (size_t j = 0; j < n; j++) out[j] = r[j];
+    ScratchRelease(mark);
+}
+
+/**
+ * Wykonuje program na oszacowaniach wartości bezwzględnych: współczynniki
+ * i współrzędne zastępowane są ich wartościami bezwzględnymi, więc wynik
+ * szacuje z góry wartości bezwzględne wyników i wyników pośrednich.
+ * @param[in] plan : program
+ * @param[in] xs : wartości bezwzględne współrzędnych punktów bloku (patrz:
+ * EvalWrapping())
+ * @param[in] n : liczba punktów bloku
+ * @param[out] out : oszacowania w punktach bloku
+ */
+static void EvalBound(const EvalPlan *plan, const double xs[], size_t n,
+                      double out[]) {
+    ScratchMark mark = ScratchGetMark();
+    double *regs = ScratchAlloc(plan->depth * EVAL_BLOCK * sizeof(double));
+    double *pw = ScratchAlloc(2 * EVAL_BLOCK * sizeof(double));
+    double *base = pw + EVAL_BLOCK;
+    double *r = regs - EVAL_BLOCK;
+    for (size_t i = 0; i < plan->size; i++) {
+        const EvalInstr *instr = &plan->code[i];
+        poly_coeff_t c = instr->coeff.coeff;
+        double abs_c = c < 0 ? -(double) c : (double) c;
+        switch (instr->op) {
+            case EVAL_PUSH:
+                r += EVAL_BLOCK;
+                for (size_t j = 0; j < n; j++) r[j] = abs_c;
+                break;
+            case EVAL_ADD_CONST:
+                for (size_t j = 0; j < n; j++) r[j] += abs_c;
+                break;
+            case EVAL_ADD:
+                for (size_t j = 0; j < n; j++) r[j - EVAL_BLOCK] += r[j];
+                r -= EVAL_BLOCK;
+                break;
+            case EVAL_MUL_POW: ;
+                const double *x = xs + instr->var * EVAL_BLOCK;
+                for (size_t j = 0; j < n; j++) {
+                    pw[j] = 1;
+                    base[j] = x[j];
+                }
+                for (poly_exp_t e = instr->exp; e > 0; e >>= 1) {
+                    if (e & 1) {
+                        for (size_t j = 0; j < n; j++) pw[j] *= base[j];
+                    }
+                    for (size_t j = 0; j < n; j++) base[j] *= base[j];
+                }
+                for (size_t j = 0; j < n; j++) r[j] *= pw[j];
+                break;
+        }
+    }
+    for (size_t j = 0; j < n; j++) out[j] = r[j];
+    ScratchRelease(mark);
+}
+
+/**
+ * Wykonuje program na resztach modulo ustawiony moduł.
+ * @param[in] plan : program
+ * @param[in] xs : reszty współrzędnych punktów bloku (patrz: EvalWrapping())
+ * @param[in] n : liczba punktów bloku
+ * @param[out] out : wartości w punktach bloku
+ */
+static void EvalMod(const EvalPlan *plan, const poly_coeff_t xs[], size_t n,
+                    poly_coeff_t out[]) {
+    ScratchMark mark = ScratchGetMark();
+    poly_coeff_t *regs = ScratchAlloc(plan->depth * EVAL_BLOCK
+                                      * sizeof(poly_coeff_t));
+    poly_coeff_t *pw = ScratchAlloc(2 * EVAL_BLOCK * sizeof(poly_coeff_t));
+    poly_coeff_t *base = pw + EVAL_BLOCK;
+    poly_coeff_t *r = regs - EVAL_BLOCK;
+    for (size_t i = 0; i < plan->size; i++) {
+        const EvalInstr *instr = &plan->code[i];
+        switch (instr->op) {
+            case EVAL_PUSH: ;
+                poly_coeff_t c = BigCoeffMod(&instr->coeff);
+                r += EVAL_BLOCK;
+                for (size_t j = 0; j < n; j++) r[j] = c;
+                break;
+            case EVAL_ADD_CONST: ;
+                poly_coeff_t d = BigCoeffMod(&instr->coeff);
+                for (size_t j = 0; j < n; j++) r[j] = ModAdd(r[j], d);
+                break;
+            case EVAL_ADD:
+                for (size_t j = 0; j < n; j++) {
+                    r[j - EVAL_BLOCK] = ModAdd(r[j - EVAL_BLOCK], r[j]);
+                }
+                r -= EVAL_BLOCK;
+                break;
+            case EVAL_MUL_POW: ;
+                const poly_coeff_t *x = xs + instr->var * EVAL_BLOCK;
+                for (size_t j = 0; j < n; j++) {
+                    pw[j] = ModReduce(1);
+                    base[j] = x[j];
+                }
+                for (poly_exp_t e = instr->exp; e > 0; e >>= 1) {
+                    if (e & 1) {
+                        for (size_t j = 0; j < n; j++) {
+                            pw[j] = ModMulReduced(pw[j], base[j]);
+                        }
+                    }
+                    for (size_t j = 0; j < n; j++) {
+                        base[j] = ModMulReduced(base[j], base[j]);
+                    }
+                }
+                for (size_t j = 0; j < n; j++) r[j] = ModMulReduced(r[j], pw[j]);
+                break;
+        }
+    }
+    for (size_t j = 0; j < n; j++) out[j] = r[j];
+    ScratchRelease(mark);
+}
+
+/**
+ * Podnosi współczynnik do potęgi naturalnej.
+ * @param[in] x : podstawa potęgi
+ * @param[in] exp : wykładnik potęgi
+ * @return @f$x^{exp}@f$
+ */
+static Poly CoeffPow(poly_coeff_t x, poly_exp_t exp) {
+    Poly res = PolyFromCoeff(1), base = PolyFromCoeff(x);
+    while (exp > 0) {
+        if (exp & 1) {
+            Poly new_res = CoeffMul(&res, &base);
+            PolyDestroy(&res);
+            res = new_res;
+        }
+        exp >>= 1;
+        if (exp > 0) {
+            Poly new_base = CoeffMul(&base, &base);
+            PolyDestroy(&base);
+            base = new_base;
+        }
+    }
+    PolyDestroy(&base);
+    return res;
+}
+
+/**
+ * Wykonuje program dokładnie dla jednego punktu, na współczynnikach, które
+ * mogą być duże.
+ * @param[in] plan : program
+ * @param[in] point : współrzędne punktu
+ * @return wartość w punkcie
+ */
+static Poly EvalExact(const EvalPlan *plan, const poly_coeff_t point[]) {
+    ScratchMark mark = ScratchGetMark();
+    Poly *regs = ScratchAlloc(plan->depth * sizeof(Poly));
+    size_t top = 0;
+    for (size_t i = 0; i < plan->size; i++) {
+        const EvalInstr *instr = &plan->code[i];
+        Poly res;
+        switch (instr->op) {
+            case EVAL_PUSH:
+                regs[top++] = PolyClone(&instr->coeff);
+                break;
+            case EVAL_ADD_CONST:
+                res = CoeffAdd(&regs[top - 1], &instr->coeff);
+                PolyDestroy(&regs[top - 1]);
+                regs[top - 1] = res;
+                break;
+            case EVAL_ADD:
+                res = CoeffAdd(&regs[top - 2], &regs[top - 1]);
+                PolyDestroy(&regs[top - 2]);
+                PolyDestroy(&regs[top - 1]);
+                regs[top - 2] = res;
+                top--;
+                break;
+            case EVAL_MUL_POW: ;
+                Poly pw = CoeffPow(point[instr->var], instr->exp);
+                res = CoeffMul(&regs[top - 1], &pw);
+                PolyDestroy(&pw);
+                PolyDestroy(&regs[top - 1]);
+                regs[top - 1] = res;
+                break;
+        }
+    }
+    assert(top == 1);
+    Poly res = regs[0];
+    ScratchRelease(mark);
+    return res;
+}
+
+/**
+ * To jest struktura przechowująca dane wsadowego wyliczania wartości
+ * dzielonego na bloki punktów.
+ */
+typedef struct EvalTask {
+    const EvalPlan *plan;       ///< program
+    size_t count;               ///< liczba punktów
+    const poly_coeff_t *points; ///< współrzędne punktów
+    Poly *res;                  ///< wartości w punktach
+} EvalTask;
+
+/**
+ * Wylicza wartości w jednym bloku punktów. Jeśli moduł nie jest ustawiony,
+ * punkty, dla których obliczenia 64-bitowe mogą nie być dokładne, wylicza
+ * ponownie funkcją EvalExact().
+ * @param[in,out] ctx : dane wyliczania (EvalTask)
+ * @param[in] idx : numer bloku
+ */
+static void EvalBlock(void *ctx, size_t idx) {
+    EvalTask *task = ctx;
+    const EvalPlan *plan = task->plan;
+    size_t begin = idx * EVAL_BLOCK;
+    size_t n = task->count - begin < EVAL_BLOCK ? task->count - begin
+                                                 : EVAL_BLOCK;
+    const poly_coeff_t *points = task->points + begin * plan->nvars;
+    Poly *res = task->res + begin;
+    if (plan->has_big && !ModEnabled()) {
+        for (size_t j = 0; j < n; j++) {
+            res[j] = EvalExact(plan, points + j * plan->nvars);
+        }
+        return;
+    }
+
+    ScratchMark mark = ScratchGetMark();
+    // Współrzędne przepisujemy tak, by każda zmienna zajmowała ciągły
+    // fragment pamięci.
+    size_t lanes = (plan->nvars > 0 ? plan->nvars : 1) * EVAL_BLOCK;
+    if (ModEnabled()) {
+        poly_coeff_t *xs = ScratchAlloc(lanes * sizeof(poly_coeff_t));
+        poly_coeff_t *out = ScratchAlloc(EVAL_BLOCK * sizeof(poly_coeff_t));
+        for (size_t v = 0; v < plan->nvars; v++) {
+            for (size_t j = 0; j < n; j++) {
+                xs[v * EVAL_BLOCK + j] = ModReduce(points[j * plan->nvars + v]);
+            }
+        }
+        EvalMod(plan, xs, n, out);
+        for (size_t j = 0; j < n; j++) {
+            res[j] = PolyFromCoeff(out[j]);
+        }
+    }
+    else {
+        unsigned long *xs = ScratchAlloc(lanes * sizeof(unsigned long));
+        double *abs_xs = ScratchAlloc(lanes * sizeof(double));
+        unsigned long *out = ScratchAlloc(EVAL_BLOCK * sizeof(unsigned long));
+        double *bound = ScratchAlloc(EVAL_BLOCK * sizeof(double));
+        for (size_t v = 0; v < plan->nvars; v++) {
+            for (size_t j = 0; j < n; j++) {
+                poly_coeff_t x = points[j * plan->nvars + v];
+                xs[v * EVAL_BLOCK + j] = (unsigned long) x;
+                abs_xs[v * EVAL_BLOCK + j] = x < 0 ? -(double) x : (double) x;
+            }
+        }
+        EvalWrapping(plan, xs, n, out);
+        EvalBound(plan, abs_xs, n, bound);
+        for (size_t j = 0; j < n; j++) {
+            // Porównanie jest fałszywe także dla nieskończoności.
+            if (bound[j] < EVAL_SAFE_BOUND) {
+                res[j] = PolyFromCoeff((poly_coeff_t) out[j]);
+            }
+            else {
+                res[j] = EvalExact(plan, points + j * plan->nvars);
+            }
+        }
+    }
+    ScratchRelease(mark);
+}
+
+/**
+ * Wylicza wartości skompilowanego wielomianu w @p count punktach.
+ * @param[in] plan : skompilowany program
+ * @param[in] count : liczba punktów
+ * @param[in] points : współrzędne kolejnych punktów, po @p nvars dla każdego
+ * punktu (patrz: PolyEvalCompile())
+ * @param[out] res : wartości wielomianu w kolejnych punktach (współczynniki)
+ */
+void PolyEvalBatch(const EvalPlan *plan, size_t count,
+                   const poly_coeff_t points[], Poly res[]) {
+    assert(plan != NULL && (count == 0 || (points != NULL && res != NULL)));
+    EvalTask task = {.plan = plan, .count = count, .points = points,
+                     .res = res};
+    PoolParallelFor((count + EVAL_BLOCK - 1) / EVAL_BLOCK, EvalBlock, &task);
+}
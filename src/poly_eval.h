@@ -0,0 +1,70 @@
+/** @file
+  Interfejs wsadowego wyliczania wartości wielomianów
+
+  Wielomian kompilowany jest do płaskiego programu, który wylicza jego
+  wartość zagnieżdżonym schematem Hornera: dla kolejnych zmiennych
+  wartość współczynnika mnożona jest przez potęgę zmiennej równą różnicy
+  kolejnych wykładników. Program wykonywany jest jednocześnie dla bloku
+  punktów, a każda jego instrukcja jest pętlą po punktach bloku, którą
+  kompilator może zwektoryzować. Bloki punktów wyliczane są równolegle, jeśli
+  pula wątków jest uruchomiona.
+
+  Wartości liczone są na liczbach 64-bitowych, a równolegle wyliczane jest
+  oszacowanie ich wartości bezwzględnych. Punkty, dla których wynik mógłby
+  się nie zmieścić w typie poly_coeff_t, są wyliczane ponownie dokładnie
+  (patrz: big_coeff.h). Jeśli ustawiony jest moduł (patrz: mod_arith.h),
+  wartości liczone są modulo.
+
+  @authors Izabela Ożdżeńska <io417924@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#ifndef GAMMA_POLY_EVAL_H
+#define GAMMA_POLY_EVAL_H
+
+#include <stddef.h>
+#include "poly.h"
+
+/**
+ * To jest typ reprezentujący skompilowany program wyliczający wartość
+ * wielomianu.
+ */
+typedef struct EvalPlan EvalPlan;
+
+/**
+ * Zwraca liczbę zmiennych, od których może zależeć wielomian, czyli
+ * największą głębokość zagnieżdżenia jego współczynników. Wartość wielomianu
+ * nie zależy od współrzędnych punktu o indeksach nie mniejszych od wyniku.
+ * @param[in] p : wielomian @f$p@f$
+ * @return liczba zmiennych wielomianu
+ */
+size_t PolyEvalVars(const Poly *p);
+
+/**
+ * Kompiluje wielomian do programu wyliczającego jego wartość w punktach
+ * @f$(x_0, x_1, \ldots, x_{nvars-1})@f$. Zmienne o indeksach nie mniejszych
+ * od @p nvars przyjmują wartość 0.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] nvars : liczba współrzędnych punktów
+ * @return skompilowany program
+ */
+EvalPlan* PolyEvalCompile(const Poly *p, size_t nvars);
+
+/**
+ * Usuwa skompilowany program z pamięci.
+ * @param[in] plan : skompilowany program
+ */
+void PolyEvalPlanDestroy(EvalPlan *plan);
+
+/**
+ * Wylicza wartości skompilowanego wielomianu w @p count punktach.
+ * @param[in] plan : skompilowany program
+ * @param[in] count : liczba punktów
+ * @param[in] points : współrzędne kolejnych punktów, po @p nvars dla każdego
+ * punktu (patrz: PolyEvalCompile())
+ * @param[out] res : wartości wielomianu w kolejnych punktach (współczynniki)
+ */
+void PolyEvalBatch(const EvalPlan *plan, size_t count,
+                   const poly_coeff_t points[], Poly res[]);
+
+#endif //GAMMA_POLY_EVAL_H
@@ -0,0 +1,349 @@
+/** @file
+  Implementacja leniwych wyrażeń na wielomianach
+
+  @authors Izabela Ożdżeńska <io417924@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "poly_eval.h"
+#include "poly_expr.h"
+#include "poly_flat.h"
+
+/**
+ * Tworzy węzeł wyrażenia z jedną referencją.
+ * @param[in] kind : rodzaj węzła
+ * @param[in] left : lewe wyrażenie lub NULL
+ * @param[in] right : prawe wyrażenie lub NULL
+ * @return węzeł
+ */
+static PolyExpr* ExprNew(ExprKind kind, PolyExpr *left, PolyExpr *right) {
+    PolyExpr *e = malloc(sizeof(PolyExpr));
+    if (e == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    *e = (PolyExpr) {.kind = kind, .refs = 1, .evaluated = false,
+                     .value = PolyZero(), .left = left, .right = right};
+    return e;
+}
+
+/**
+ * Tworzy wyrażenie będące wielomianem. Przejmuje wielomian na własność.
+ * @param[in] p : wielomian
+ * @return wyrażenie z jedną referencją
+ */
+PolyExpr* ExprLeaf(Poly p) {
+    PolyExpr *e = ExprNew(EXPR_LEAF, NULL, NULL);
+    e->evaluated = true;
+    e->value = p;
+    return e;
+}
+
+/**
+ * Tworzy wyrażenie będące sumą, różnicą lub iloczynem dwóch wyrażeń.
+ * Przejmuje referencje do @p left i @p right.
+ * @param[in] kind : <EXPR_ADD>, <EXPR_SUB> lub <EXPR_MUL>
+ * @param[in] left : lewe wyrażenie
+ * @param[in] right : prawe wyrażenie
+ * @return wyrażenie z jedną referencją
+ */
+PolyExpr* ExprBinary(ExprKind kind, PolyExpr *left, PolyExpr *right) {
+    assert(kind == EXPR_ADD || kind == EXPR_SUB || kind == EXPR_MUL);
+    return ExprNew(kind, left, right);
+}
+
+/**
+ * Tworzy wyrażenie będące negacją wyrażenia. Przejmuje referencję do @p e.
+ * @param[in] e : wyrażenie
+ * @return wyrażenie z jedną referencją
+ */
+PolyExpr* ExprNeg(PolyExpr *e) {
+    return ExprNew(EXPR_NEG, e, NULL);
+}
+
+/**
+ * Dodaje referencję do wyrażenia.
+ * @param[in,out] e : wyrażenie
+ * @return @p e
+ */
+PolyExpr* ExprRetain(PolyExpr *e) {
+    e->refs++;
+    return e;
+}
+
+/**
+ * To jest struktura przechowująca powiększaną tablicę węzłów. Zastępuje
+ * rekurencję przy przechodzeniu długich łańcuchów działań.
+ */
+typedef struct ExprList {
+    size_t size;        ///< liczba węzłów
+    size_t capacity;    ///< pojemność tablicy
+    PolyExpr **arr;     ///< węzły
+} ExprList;
+
+/**
+ * Dodaje węzeł na koniec tablicy.
+ * @param[in,out] list : tablica węzłów
+ * @param[in] e : węzeł
+ */
+static void ExprListPush(ExprList *list, PolyExpr *e) {
+    if (list->size == list->capacity) {
+        list->capacity = list->capacity == 0 ? 16 : 2 * list->capacity;
+        list->arr = realloc(list->arr, list->capacity * sizeof(PolyExpr*));
+        if (list->arr == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    }
+    list->arr[list->size++] = e;
+}
+
+/**
+ * Usuwa referencję do wyrażenia. Usuwa z pamięci węzły, do których nie
+ * pozostały żadne referencje.
+ * @param[in,out] e : wyrażenie
+ */
+void ExprRelease(PolyExpr *e) {
+    ExprList pending = {0};
+    while (e != NULL) {
+        if (--e->refs == 0) {
+            if (e->left != NULL) ExprListPush(&pending, e->left);
+            if (e->right != NULL) ExprListPush(&pending, e->right);
+            PolyDestroy(&e->value);
+            free(e);
+        }
+        e = pending.size > 0 ? pending.arr[--pending.size] : NULL;
+    }
+    free(pending.arr);
+}
+
+/**
+ * To jest struktura przechowująca składnik sumy iloczynów, na którą
+ * rozkładane jest wyrażenie.
+ */
+typedef struct ExprTerm {
+    Poly a;         ///< pierwszy czynnik
+    Poly b;         ///< drugi czynnik, jeśli [has_b]
+    bool has_b;     ///< czy składnik jest iloczynem
+    bool negate;    ///< czy składnik jest odejmowany
+} ExprTerm;
+
+/**
+ * To jest struktura przechowująca powiększaną tablicę składników.
+ */
+typedef struct TermList {
+    size_t size;        ///< liczba składników
+    size_t capacity;    ///< pojemność tablicy
+    ExprTerm *arr;      ///< składniki
+} TermList;
+
+/**
+ * Dodaje składnik na koniec tablicy.
+ * @param[in,out] list : tablica składników
+ * @param[in] term : składnik
+ */
+static void TermListPush(TermList *list, ExprTerm term) {
+    if (list->size == list->capacity) {
+        list->capacity = list->capacity == 0 ? 16 : 2 * list->capacity;
+        list->arr = realloc(list->arr, list->capacity * sizeof(ExprTerm));
+        if (list->arr == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    }
+    list->arr[list->size++] = term;
+}
+
+static Poly EvalFused(PolyExpr *root);
+
+/**
+ * Oblicza i zapamiętuje wartość węzła, a następnie usuwa referencje do
+ * jego podwyrażeń.
+ * @param[in,out] e : węzeł
+ */
+static void Cache(PolyExpr *e) {
+    e->value = EvalFused(e);
+    e->evaluated = true;
+    if (e->left != NULL) ExprRelease(e->left);
+    if (e->right != NULL) ExprRelease(e->right);
+    e->left = e->right = NULL;
+}
+
+/**
+ * Rozkłada wyrażenie na sumę składników, z których każdy jest wielomianem
+ * lub iloczynem dwóch wielomianów. Sumy, różnice i negacje są rozwijane.
+ * Czynniki iloczynów i podwyrażenia współdzielone przez inne wyrażenia muszą
+ * być już obliczone (patrz: EvalOperands()); ich wartości są pożyczane
+ * z węzłów.
+ * @param[in,out] root : wyrażenie
+ * @param[out] terms : składniki
+ */
+static void Collect(PolyExpr *root, TermList *terms) {
+    // Znak węzła jest zapisany w najmłodszym bicie jego adresu na liście.
+    ExprList pending = {0};
+    ExprListPush(&pending, root);
+    while (pending.size > 0) {
+        PolyExpr *item = pending.arr[--pending.size];
+        bool negate = ((uintptr_t) item & 1) != 0;
+        PolyExpr *e = (PolyExpr*) ((uintptr_t) item & ~(uintptr_t) 1);
+        assert(e == root || e->evaluated || e->refs == 1);
+        if (e->evaluated) {
+            TermListPush(terms, (ExprTerm) {.a = e->value, .negate = negate});
+            continue;
+        }
+        uintptr_t sign = negate ? 1 : 0;
+        switch (e->kind) {
+            case EXPR_ADD:
+            case EXPR_SUB: ;
+                uintptr_t right_sign = e->kind == EXPR_SUB ? sign ^ 1 : sign;
+                ExprListPush(&pending, (PolyExpr*) ((uintptr_t) e->right |
+                                                    right_sign));
+                ExprListPush(&pending, (PolyExpr*) ((uintptr_t) e->left |
+                                                    sign));
+                break;
+            case EXPR_NEG:
+                ExprListPush(&pending, (PolyExpr*) ((uintptr_t) e->left |
+                                                    (sign ^ 1)));
+                break;
+            case EXPR_MUL: ;
+                // Czynniki obliczyła już EvalOperands().
+                assert(e->left->evaluated && e->right->evaluated);
+                TermListPush(terms, (ExprTerm) {.a = e->left->value,
+                                                .b = e->right->value,
+                                                .has_b = true,
+                                                .negate = negate});
+                break;
+            case EXPR_LEAF:
+                assert(false);
+                break;
+        }
+    }
+    free(pending.arr);
+}
+
+/**
+ * Oblicza sumę składników w rozłożonej reprezentacji (patrz:
+ * FlatSumOfProducts()).
+ * @param[in] terms : składniki
+ * @param[out] res : suma składników
+ * @return Czy wykładniki składników i iloczynów mieszczą się w polach?
+ */
+static bool SumFlat(const TermList *terms, Poly *res) {
+    if (terms->size == 0) {
+        *res = PolyZero();
+        return true;
+    }
+    size_t nvars = 1;
+    for (size_t k = 0; k < terms->size; k++) {
+        size_t a_vars = PolyEvalVars(&terms->arr[k].a);
+        size_t b_vars = terms->arr[k].has_b ? PolyEvalVars(&terms->arr[k].b)
+                                            : 0;
+        if (a_vars > nvars) nvars = a_vars;
+        if (b_vars > nvars) nvars = b_vars;
+    }
+    if (nvars > FLAT_MAX_VARS) return false;
+    FlatPoly *flats = malloc(2 * terms->size * sizeof(FlatPoly));
+    FlatTerm *flat_terms = malloc(terms->size * sizeof(FlatTerm));
+    if (flats == NULL || flat_terms == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    size_t converted = 0;
+    bool ok = true;
+    for (size_t k = 0; k < terms->size && ok; k++) {
+        const ExprTerm *term = &terms->arr[k];
+        ok = FlatFromPoly(&term->a, nvars, &flats[converted]);
+        if (!ok) break;
+        flat_terms[k] = (FlatTerm) {.a = &flats[converted++], .b = NULL,
+                                    .negate = term->negate};
+        if (term->has_b) {
+            ok = FlatFromPoly(&term->b, nvars, &flats[converted]);
+            if (ok) flat_terms[k].b = &flats[converted++];
+        }
+    }
+    FlatPoly sum;
+    if (ok) ok = FlatSumOfProducts(flat_terms, terms->size, nvars, &sum);
+    for (size_t i = 0; i < converted; i++) FlatDestroy(&flats[i]);
+    free(flats);
+    free(flat_terms);
+    if (ok) *res = FlatToPoly(&sum);
+    return ok;
+}
+
+/**
+ * Oblicza sumę składników na rekurencyjnej reprezentacji wielomianów.
+ * @param[in] terms : składniki
+ * @return suma składników
+ */
+static Poly SumRecursive(const TermList *terms) {
+    Poly res = PolyZero();
+    for (size_t k = 0; k < terms->size; k++) {
+        const ExprTerm *term = &terms->arr[k];
+        Poly value = term->has_b ? PolyMul(&term->a, &term->b)
+                                 : PolyClone(&term->a);
+        res = term->negate ? PolySubOwn(&res, &value)
+                           : PolyAddOwn(&res, &value);
+    }
+    return res;
+}
+
+/**
+ * Oblicza wartość wyrażenia, rozkładając je na sumę iloczynów (patrz:
+ * Collect()) i scalając wszystkie składniki naraz. Jeśli wykładników nie
+ * można spakować, składniki są dodawane kolejno.
+ * @param[in,out] root : wyrażenie
+ * @return wartość wyrażenia
+ */
+static Poly EvalFused(PolyExpr *root) {
+    TermList terms = {0};
+    Collect(root, &terms);
+    Poly res;
+    if (!SumFlat(&terms, &res)) res = SumRecursive(&terms);
+    free(terms.arr);
+    return res;
+}
+
+/** Znacznik węzła na liście EvalOperands(): jego podwyrażenia są na liście. */
+#define EXPR_EXPANDED ((uintptr_t) 1)
+/** Znacznik węzła na liście EvalOperands(): węzeł należy obliczyć osobno. */
+#define EXPR_SEPARATE ((uintptr_t) 2)
+
+/**
+ * Oblicza i zapamiętuje, w kolejności od najgłębszych, wartości węzłów
+ * wyrażenia, które Collect() obliczałaby osobno: czynników iloczynów
+ * i podwyrażeń współdzielonych. Dzięki temu Collect() nie wywołuje
+ * rekurencyjnie obliczania, więc głębokość rekurencji nie zależy od długości
+ * łańcucha działań.
+ * @param[in,out] root : wyrażenie
+ */
+static void EvalOperands(PolyExpr *root) {
+    // Znaczniki węzła są zapisane w najmłodszych bitach jego adresu na liście.
+    ExprList pending = {0};
+    ExprListPush(&pending, root);
+    while (pending.size > 0) {
+        uintptr_t item = (uintptr_t) pending.arr[--pending.size];
+        PolyExpr *e = (PolyExpr*) (item & ~(EXPR_EXPANDED | EXPR_SEPARATE));
+        // Węzeł współdzielony mógł zostać obliczony z innego miejsca listy.
+        if (e->evaluated) continue;
+        if (item & EXPR_EXPANDED) {
+            // Podwyrażenia węzła są już obliczone tam, gdzie to potrzebne.
+            if (item & EXPR_SEPARATE) Cache(e);
+            continue;
+        }
+        bool separate = e != root && ((item & EXPR_SEPARATE) || e->refs > 1);
+        ExprListPush(&pending, (PolyExpr*) (item | EXPR_EXPANDED |
+                                            (separate ? EXPR_SEPARATE : 0)));
+        uintptr_t operand = e->kind == EXPR_MUL ? EXPR_SEPARATE : 0;
+        if (e->right != NULL) {
+            ExprListPush(&pending, (PolyExpr*) ((uintptr_t) e->right |
+                                                operand));
+        }
+        ExprListPush(&pending, (PolyExpr*) ((uintptr_t) e->left | operand));
+    }
+    free(pending.arr);
+}
+
+/**
+ * Oblicza wartość wyrażenia. Jeśli wyrażenie ma więcej niż jedną referencję,
+ * zapamiętuje wartość i usuwa referencje do podwyrażeń.
+ * @param[in,out] e : wyrażenie
+ * @return wartość wyrażenia
+ */
+Poly ExprEval(PolyExpr *e) {
+    if (!e->evaluated) {
+        EvalOperands(e);
+        if (e->refs == 1) return EvalFused(e);
+        Cache(e);
+    }
+    return PolyClone(&e->value);
+}
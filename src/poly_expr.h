@@ -0,0 +1,93 @@
+/** @file
+  Interfejs leniwych wyrażeń na wielomianach
+
+  Wyrażenie jest acyklicznym grafem (DAG) działań: dodawania, odejmowania,
+  mnożenia i negacji, których liśćmi są wielomiany. Wyrażenie nie jest
+  obliczane w chwili tworzenia, tylko przy wywołaniu ExprEval(). Obliczanie
+  łączy działania: sumę iloczynów, np. @f$a * b + c@f$, wylicza jednym
+  scalaniem wyrazów wszystkich iloczynów i składników (patrz:
+  FlatSumOfProducts()), bez tworzenia wyników pośrednich. Wyrażenie
+  współdzielone przez kilka innych jest obliczane co najwyżej raz.
+
+  @authors Izabela Ożdżeńska <io417924@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#ifndef GAMMA_POLY_EXPR_H
+#define GAMMA_POLY_EXPR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "poly.h"
+
+/**
+ * To jest typ wyliczeniowy reprezentujący rodzaj węzła wyrażenia.
+ */
+typedef enum ExprKind {
+    EXPR_LEAF,  ///< wielomian
+    EXPR_ADD,   ///< suma lewego i prawego wyrażenia
+    EXPR_SUB,   ///< różnica lewego i prawego wyrażenia
+    EXPR_MUL,   ///< iloczyn lewego i prawego wyrażenia
+    EXPR_NEG    ///< negacja lewego wyrażenia
+} ExprKind;
+
+/**
+ * To jest struktura przechowująca węzeł wyrażenia. Węzły są zliczane
+ * referencjami, więc wyrażenie może być częścią wielu innych.
+ */
+typedef struct PolyExpr {
+    ExprKind kind;              ///< rodzaj węzła
+    size_t refs;                ///< liczba referencji
+    bool evaluated;             ///< czy wartość węzła jest obliczona
+    Poly value;                 ///< wartość węzła, jeśli [evaluated]
+    struct PolyExpr *left;      ///< lewe wyrażenie lub NULL
+    struct PolyExpr *right;     ///< prawe wyrażenie lub NULL
+} PolyExpr;
+
+/**
+ * Tworzy wyrażenie będące wielomianem. Przejmuje wielomian na własność.
+ * @param[in] p : wielomian
+ * @return wyrażenie z jedną referencją
+ */
+PolyExpr* ExprLeaf(Poly p);
+
+/**
+ * Tworzy wyrażenie będące sumą, różnicą lub iloczynem dwóch wyrażeń.
+ * Przejmuje referencje do @p left i @p right.
+ * @param[in] kind : <EXPR_ADD>, <EXPR_SUB> lub <EXPR_MUL>
+ * @param[in] left : lewe wyrażenie
+ * @param[in] right : prawe wyrażenie
+ * @return wyrażenie z jedną referencją
+ */
+PolyExpr* ExprBinary(ExprKind kind, PolyExpr *left, PolyExpr *right);
+
+/**
+ * Tworzy wyrażenie będące negacją wyrażenia. Przejmuje referencję do @p e.
+ * @param[in] e : wyrażenie
+ * @return wyrażenie z jedną referencją
+ */
+PolyExpr* ExprNeg(PolyExpr *e);
+
+/**
+ * Dodaje referencję do wyrażenia.
+ * @param[in,out] e : wyrażenie
+ * @return @p e
+ */
+PolyExpr* ExprRetain(PolyExpr *e);
+
+/**
+ * Usuwa referencję do wyrażenia. Usuwa z pamięci węzły, do których nie
+ * pozostały żadne referencje.
+ * @param[in,out] e : wyrażenie
+ */
+void ExprRelease(PolyExpr *e);
+
+/**
+ * Oblicza wartość wyrażenia. Jeśli wyrażenie ma więcej niż jedną referencję,
+ * zapamiętuje wartość i usuwa referencje do podwyrażeń.
+ * @param[in,out] e : wyrażenie
+ * @return wartość wyrażenia
+ */
+Poly ExprEval(PolyExpr *e);
+
+#endif //GAMMA_POLY_EXPR_H
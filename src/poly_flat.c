@@ -0,0 +1,589 @@
+/** @file
+  Implementacja rozłożonej reprezentacji wielomianów ze spakowanymi
+  wykładnikami
+
+  @authors Izabela Ożdżeńska <io417924@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#include <limits.h>
+#include <stdlib.h>
+#include "big_coeff.h"
+#include "mono_alloc.h"
+#include "poly_eval.h"
+#include "poly_flat.h"
+
+/**
+ * Daje szerokość pola wykładnika jednej zmiennej.
+ * @param[in] nvars : liczba zmiennych
+ * @return liczba bitów pola
+ */
+static inline unsigned FieldBits(size_t nvars) {
+    return (unsigned) (64 / nvars);
+}
+
+/**
+ * Daje największy wykładnik, który można zapisać w polu. Jest on ograniczony
+ * także przez zakres typu poly_exp_t.
+ * @param[in] nvars : liczba zmiennych
+ * @return największy wykładnik
+ */
+static inline uint64_t FieldMax(size_t nvars) {
+    unsigned bits = FieldBits(nvars);
+    uint64_t max = bits >= 64 ? UINT64_MAX : ((uint64_t) 1 << bits) - 1;
+    return max < INT_MAX ? max : INT_MAX;
+}
+
+/**
+ * Daje przesunięcie pola wykładnika zmiennej w spakowanym słowie.
+ * @param[in] nvars : liczba zmiennych
+ * @param[in] var : indeks zmiennej
+ * @return przesunięcie pola
+ */
+static inline unsigned FieldShift(size_t nvars, size_t var) {
+    return FieldBits(nvars) * (unsigned) (nvars - 1 - var);
+}
+
+/**
+ * Daje wykładnik zmiennej zapisany w spakowanym słowie.
+ * @param[in] nvars : liczba zmiennych
+ * @param[in] exp : spakowane wykładniki
+ * @param[in] var : indeks zmiennej
+ * @return wykładnik zmiennej
+ */
+static inline uint64_t FieldGet(size_t nvars, uint64_t exp, size_t var) {
+    unsigned bits = FieldBits(nvars);
+    uint64_t mask = bits >= 64 ? UINT64_MAX : ((uint64_t) 1 << bits) - 1;
+    return exp >> FieldShift(nvars, var) & mask;
+}
+
+/**
+ * Daje maskę pól zmiennych o indeksach od @p var do ostatniej.
+ * @param[in] nvars : liczba zmiennych
+ * @param[in] var : indeks zmiennej
+ * @return maska pól
+ */
+static inline uint64_t RestMask(size_t nvars, size_t var) {
+    unsigned bits = FieldBits(nvars) * (unsigned) (nvars - var);
+    return bits >= 64 ? UINT64_MAX : ((uint64_t) 1 << bits) - 1;
+}
+
+/**
+ * Usuwa współczynnik, jeśli jest duży. Zwykły współczynnik nie zajmuje
+ * pamięci.
+ * @param[in] c : współczynnik
+ */
+static inline void CoeffDestroy(Poly *c) {
+    if (c->arr != NULL) PolyDestroy(c);
+}
+
+/**
+ * Tworzy pusty wielomian w rozłożonej reprezentacji.
+ * @param[in] nvars : liczba zmiennych
+ * @param[in] capacity : liczba wyrazów, dla których przydzielana jest pamięć
+ * @return wielomian tożsamościowo równy zeru
+ */
+static FlatPoly FlatAlloc(size_t nvars, size_t capacity) {
+    if (capacity == 0) capacity = 1;
+    FlatPoly res = {.size = 0, .nvars = nvars};
+    res.exps = malloc(capacity * sizeof(uint64_t));
+    res.coeffs = malloc(capacity * sizeof(Poly));
+    if (res.exps == NULL || res.coeffs == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    return res;
+}
+
+/**
+ * Dopisuje wyraz na koniec wielomianu, powiększając w razie potrzeby jego
+ * tablice. Przejmuje współczynnik na własność.
+ * @param[in,out] f : wielomian w rozłożonej reprezentacji
+ * @param[in,out] capacity : pojemność tablic wielomianu
+ * @param[in] exp : spakowane wykładniki
+ * @param[in] c : niezerowy współczynnik
+ */
+static inline void FlatPush(FlatPoly *f, size_t *capacity, uint64_t exp,
+                            Poly c) {
+    if (f->size == *capacity) {
+        *capacity *= 2;
+        f->exps = realloc(f->exps, *capacity * sizeof(uint64_t));
+        f->coeffs = realloc(f->coeffs, *capacity * sizeof(Poly));
+        if (f->exps == NULL || f->coeffs == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    }
+    f->exps[f->size] = exp;
+    f->coeffs[f->size++] = c;
+}
+
+/**
+ * Usuwa wielomian w rozłożonej reprezentacji z pamięci.
+ * @param[in] f : wielomian w rozłożonej reprezentacji
+ */
+void FlatDestroy(FlatPoly *f) {
+    for (size_t i = 0; i < f->size; i++) CoeffDestroy(&f->coeffs[i]);
+    free(f->exps);
+    free(f->coeffs);
+    f->size = 0;
+    f->exps = NULL;
+    f->coeffs = NULL;
+}
+
+/**
+ * Liczy niezerowe współczynniki liczbowe wielomianu i sprawdza, czy jego
+ * wykładniki mieszczą się w polach.
+ * @param[in] p : wielomian
+ * @param[in] var : indeks zmiennej głównej @p p
+ * @param[in] nvars : liczba zmiennych
+ * @param[in,out] count : liczba wyrazów
+ * @return Czy wykładniki mieszczą się w polach?
+ */
+static bool CountTerms(const Poly *p, size_t var, size_t nvars,
+                       size_t *count) {
+    if (PolyIsCoeff(p)) {
+        if (!PolyIsZero(p)) (*count)++;
+        return true;
+    }
+    if (var >= nvars) return false;
+    uint64_t max = FieldMax(nvars);
+    for (size_t i = 0; i < p->size; i++) {
+        if ((uint64_t) p->arr[i].exp > max ||
+            !CountTerms(&p->arr[i].p, var + 1, nvars, count)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Dopisuje wyrazy wielomianu do rozłożonej reprezentacji. Jednomiany
+ * przechodzone są w kolejności malejących wykładników, więc wyrazy
+ * dopisywane są malejąco w porządku leksykograficznym.
+ * @param[in] p : wielomian
+ * @param[in] var : indeks zmiennej głównej @p p
+ * @param[in] prefix : spakowane wykładniki zmiennych o indeksach mniejszych
+ * od @p var
+ * @param[in,out] f : wielomian w rozłożonej reprezentacji
+ */
+static void FillTerms(const Poly *p, size_t var, uint64_t prefix,
+                      FlatPoly *f) {
+    if (PolyIsCoeff(p)) {
+        if (!PolyIsZero(p)) {
+            f->exps[f->size] = prefix;
+            f->coeffs[f->size++] = PolyClone(p);
+        }
+        return;
+    }
+    unsigned shift = FieldShift(f->nvars, var);
+    for (size_t i = 0; i < p->size; i++) {
+        FillTerms(&p->arr[i].p, var + 1,
+                  prefix | (uint64_t) p->arr[i].exp << shift, f);
+    }
+}
+
+/**
+ * Zamienia wielomian na rozłożoną reprezentację o @p nvars zmiennych.
+ * @param[in] p : wielomian zależny od co najwyżej @p nvars zmiennych
+ * (patrz: PolyEvalVars())
+ * @param[in] nvars : liczba zmiennych, od 1 do @p FLAT_MAX_VARS
+ * @param[out] res : wielomian w rozłożonej reprezentacji
+ * @return Czy wszystkie wykładniki mieszczą się w polach?
+ */
+bool FlatFromPoly(const Poly *p, size_t nvars, FlatPoly *res) {
+    assert(p != NULL && nvars >= 1 && nvars <= FLAT_MAX_VARS);
+    size_t count = 0;
+    if (!CountTerms(p, 0, nvars, &count)) return false;
+    *res = FlatAlloc(nvars, count);
+    FillTerms(p, 0, 0, res);
+    return true;
+}
+
+/**
+ * Tworzy wielomian z wyrazów o indeksach z przedziału [@p begin, @p end),
+ * które mają równe wykładniki zmiennych o indeksach mniejszych od @p var.
+ * Przenosi współczynniki wyrazów do wyniku.
+ * @param[in,out] f : wielomian w rozłożonej reprezentacji
+ * @param[in] begin : indeks pierwszego wyrazu
+ * @param[in] end : indeks za ostatnim wyrazem
+ * @param[in] var : indeks zmiennej głównej wyniku
+ * @return wielomian będący sumą wyrazów bez zmiennych o indeksach mniejszych
+ * od @p var
+ */
+static Poly RangeToPoly(FlatPoly *f, size_t begin, size_t end, size_t var) {
+    if (end - begin == 1 && (f->exps[begin] & RestMask(f->nvars, var)) == 0) {
+        return f->coeffs[begin];
+    }
+    assert(var < f->nvars);
+    size_t count = 0;
+    for (size_t i = begin; i < end; i++) {
+        if (i == begin || FieldGet(f->nvars, f->exps[i], var) !=
+                          FieldGet(f->nvars, f->exps[i - 1], var)) {
+            count++;
+        }
+    }
+    // Wyrazy są posortowane malejąco, więc jednomiany powstają w kolejności
+    // malejących wykładników.
+    Mono *arr = MonoArrAlloc(count);
+    size_t k = 0;
+    for (size_t i = begin; i < end;) {
+        uint64_t exp = FieldGet(f->nvars, f->exps[i], var);
+        size_t next = i + 1;
+        while (next < end && FieldGet(f->nvars, f->exps[next], var) == exp) {
+            next++;
+        }
+        arr[k++] = (Mono) {.p = RangeToPoly(f, i, next, var + 1),
+                           .exp = (poly_exp_t) exp};
+        i = next;
+    }
+    return PolyArrMonos(count, arr);
+}
+
+/**
+ * Zamienia wielomian w rozłożonej reprezentacji na wielomian. Przejmuje
+ * @p f na własność: po wywołaniu nie należy go używać ani usuwać.
+ * @param[in] f : wielomian w rozłożonej reprezentacji
+ * @return wielomian
+ */
+Poly FlatToPoly(FlatPoly *f) {
+    Poly res = f->size == 0 ? PolyZero() : RangeToPoly(f, 0, f->size, 0);
+    // Współczynniki zostały przeniesione do wyniku.
+    f->size = 0;
+    FlatDestroy(f);
+    return res;
+}
+
+/**
+ * Scala wyrazy dwóch wielomianów, dodając lub odejmując współczynniki
+ * wyrazów o równych wykładnikach.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @param[in] negate : czy odjąć @f$q@f$ zamiast go dodać
+ * @return @f$p + q@f$ lub @f$p - q@f$
+ */
+static FlatPoly FlatMerge(const FlatPoly *p, const FlatPoly *q, bool negate) {
+    assert(p->nvars == q->nvars);
+    size_t capacity = p->size + q->size;
+    FlatPoly res = FlatAlloc(p->nvars, capacity);
+    Poly minus_one = PolyFromCoeff(-1);
+    size_t i = 0, j = 0;
+    while (i < p->size || j < q->size) {
+        uint64_t exp;
+        Poly c;
+        if (j == q->size || (i < p->size && p->exps[i] > q->exps[j])) {
+            exp = p->exps[i];
+            c = PolyClone(&p->coeffs[i++]);
+        }
+        else {
+            exp = q->exps[j];
+            Poly qc = negate ? CoeffMul(&q->coeffs[j], &minus_one)
+                             : PolyClone(&q->coeffs[j]);
+            j++;
+            if (i < p->size && p->exps[i] == exp) {
+                c = CoeffAdd(&p->coeffs[i++], &qc);
+                CoeffDestroy(&qc);
+            }
+            else {
+                c = qc;
+            }
+        }
+        if (PolyIsZero(&c)) continue;
+        FlatPush(&res, &capacity, exp, c);
+    }
+    return res;
+}
+
+/**
+ * Dodaje dwa wielomiany w rozłożonej reprezentacji o tej samej liczbie
+ * zmiennych.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p + q@f$
+ */
+FlatPoly FlatAdd(const FlatPoly *p, const FlatPoly *q) {
+    return FlatMerge(p, q, false);
+}
+
+/**
+ * Odejmuje wielomiany w rozłożonej reprezentacji o tej samej liczbie
+ * zmiennych.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p - q@f$
+ */
+FlatPoly FlatSub(const FlatPoly *p, const FlatPoly *q) {
+    return FlatMerge(p, q, true);
+}
+
+/**
+ * Wyznacza największe wykładniki kolejnych zmiennych w wyrazach wielomianu.
+ * @param[in] f : wielomian w rozłożonej reprezentacji
+ * @param[out] max : największe wykładniki, dla każdej zmiennej
+ */
+static void FieldMaxima(const FlatPoly *f, uint64_t max[]) {
+    for (size_t v = 0; v < f->nvars; v++) max[v] = 0;
+    for (size_t i = 0; i < f->size; i++) {
+        for (size_t v = 0; v < f->nvars; v++) {
+            uint64_t exp = FieldGet(f->nvars, f->exps[i], v);
+            if (exp > max[v]) max[v] = exp;
+        }
+    }
+}
+
+/**
+ * Sprawdza, czy wykładniki iloczynu dwóch wielomianów mieszczą się w polach.
+ * Jeśli tak, mnożenie wyrazów jest dodawaniem spakowanych słów.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return Czy wykładniki @f$p * q@f$ mieszczą się w polach?
+ */
+static bool ProductFits(const FlatPoly *p, const FlatPoly *q) {
+    uint64_t p_max[FLAT_MAX_VARS], q_max[FLAT_MAX_VARS];
+    FieldMaxima(p, p_max);
+    FieldMaxima(q, q_max);
+    for (size_t v = 0; v < p->nvars; v++) {
+        if (p_max[v] + q_max[v] > FieldMax(p->nvars)) return false;
+    }
+    return true;
+}
+
+/**
+ * To jest struktura przechowująca wiersz sumy iloczynów: malejący ciąg
+ * wyrazów @p seq pomnożonych przez wyraz @p fixed o indeksie @p i.
+ */
+typedef struct ProductRow {
+    const FlatPoly *fixed;  ///< czynnik stały w wierszu lub NULL, jeśli
+                            ///< wiersz jest równy @p seq
+    size_t i;               ///< indeks wyrazu czynnika [fixed]
+    const FlatPoly *seq;    ///< czynnik, którego wyrazy przechodzi wiersz
+    bool negate;            ///< czy wiersz jest odejmowany
+} ProductRow;
+
+/**
+ * To jest struktura przechowująca element kopca wierszy: bieżący wyraz
+ * wiersza.
+ */
+typedef struct HeapEntry {
+    uint64_t exp;   ///< spakowane wykładniki bieżącego wyrazu
+    size_t row;     ///< indeks wiersza
+    size_t j;       ///< indeks wyrazu czynnika [seq] wiersza
+} HeapEntry;
+
+/**
+ * Przywraca własność kopca (maksimum na szczycie) po zmianie elementu
+ * @p pos.
+ * @param[in,out] heap : kopiec
+ * @param[in] size : liczba elementów kopca
+ * @param[in] pos : indeks zmienionego elementu
+ */
+static void SiftDown(HeapEntry heap[], size_t size, size_t pos) {
+    HeapEntry moved = heap[pos];
+    while (2 * pos + 1 < size) {
+        size_t child = 2 * pos + 1;
+        if (child + 1 < size && heap[child + 1].exp > heap[child].exp) child++;
+        if (heap[child].exp <= moved.exp) break;
+        heap[pos] = heap[child];
+        pos = child;
+    }
+    heap[pos] = moved;
+}
+
+/**
+ * Dzieli składniki sumy iloczynów na malejące wiersze. Iloczyn dzielony jest
+ * na wiersze według wyrazów mniejszego czynnika.
+ * @param[in] terms : składniki
+ * @param[in] count : liczba składników
+ * @param[out] rows : wiersze
+ * @param[out] heap : pierwsze wyrazy wierszy
+ * @return liczba wierszy
+ */
+static size_t FillRows(const FlatTerm terms[], size_t count, ProductRow rows[],
+                       HeapEntry heap[]) {
+    size_t n = 0;
+    for (size_t k = 0; k < count; k++) {
+        const FlatPoly *fixed = terms[k].a, *seq = terms[k].b;
+        if (seq == NULL) {
+            if (fixed->size == 0) continue;
+            rows[n] = (ProductRow) {.fixed = NULL, .seq = fixed,
+                                    .negate = terms[k].negate};
+            heap[n] = (HeapEntry) {.exp = fixed->exps[0], .row = n, .j = 0};
+            n++;
+            continue;
+        }
+        if (fixed->size > seq->size) {
+            const FlatPoly *temp = fixed;
+            fixed = seq;
+            seq = temp;
+        }
+        if (seq->size == 0) continue;
+        for (size_t i = 0; i < fixed->size; i++) {
+            rows[n] = (ProductRow) {.fixed = fixed, .i = i, .seq = seq,
+                                    .negate = terms[k].negate};
+            heap[n] = (HeapEntry) {.exp = fixed->exps[i] + seq->exps[0],
+                                   .row = n, .j = 0};
+            n++;
+        }
+    }
+    return n;
+}
+
+/**
+ * Wylicza sumę iloczynów wielomianów w rozłożonej reprezentacji
+ * o @p nvars zmiennych. Wiersze iloczynów (wyraz mniejszego czynnika razy
+ * kolejne wyrazy większego) i składniki bez drugiego czynnika są malejące,
+ * więc ich scalanie kopcem daje wyrazy wyniku w kolejności malejącej, bez
+ * tworzenia iloczynów ani sum częściowych.
+ * @param[in] terms : składniki sumy
+ * @param[in] count : liczba składników
+ * @param[in] nvars : liczba zmiennych wszystkich czynników
+ * @param[out] res : suma iloczynów
+ * @return Czy wykładniki wszystkich iloczynów mieszczą się w polach? Jeśli
+ * nie, @p res nie jest tworzony.
+ */
+bool FlatSumOfProducts(const FlatTerm terms[], size_t count, size_t nvars,
+                       FlatPoly *res) {
+    size_t rows_count = 0, capacity = 0;
+    for (size_t k = 0; k < count; k++) {
+        const FlatPoly *a = terms[k].a, *b = terms[k].b;
+        assert(a->nvars == nvars && (b == NULL || b->nvars == nvars));
+        if (b == NULL) {
+            rows_count++;
+            capacity += a->size;
+            continue;
+        }
+        if (!ProductFits(a, b)) return false;
+        rows_count += a->size < b->size ? a->size : b->size;
+        capacity += a->size + b->size;
+    }
+    *res = FlatAlloc(nvars, capacity);
+    if (rows_count == 0) return true;
+
+    ProductRow *rows = malloc(rows_count * sizeof(ProductRow));
+    HeapEntry *heap = malloc(rows_count * sizeof(HeapEntry));
+    if (rows == NULL || heap == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    size_t heap_size = FillRows(terms, count, rows, heap);
+    for (size_t pos = heap_size / 2; pos-- > 0;) SiftDown(heap, heap_size, pos);
+    Poly minus_one = PolyFromCoeff(-1);
+    // To jest suma wyrazów o wykładnikach [curr_exp].
+    Poly curr = PolyZero();
+    uint64_t curr_exp = heap_size > 0 ? heap[0].exp : 0;
+    while (heap_size > 0) {
+        HeapEntry top = heap[0];
+        const ProductRow *row = &rows[top.row];
+        if (top.exp != curr_exp) {
+            if (!PolyIsZero(&curr)) FlatPush(res, &capacity, curr_exp, curr);
+            curr = PolyZero();
+            curr_exp = top.exp;
+        }
+        Poly term = row->fixed == NULL
+                    ? PolyClone(&row->seq->coeffs[top.j])
+                    : CoeffMul(&row->fixed->coeffs[row->i],
+                               &row->seq->coeffs[top.j]);
+        if (row->negate) {
+            Poly neg = CoeffMul(&term, &minus_one);
+            CoeffDestroy(&term);
+            term = neg;
+        }
+        Poly sum = CoeffAdd(&curr, &term);
+        CoeffDestroy(&term);
+        CoeffDestroy(&curr);
+        curr = sum;
+        if (top.j + 1 < row->seq->size) {
+            heap[0].j++;
+            heap[0].exp = row->seq->exps[top.j + 1];
+            if (row->fixed != NULL) heap[0].exp += row->fixed->exps[row->i];
+        }
+        else {
+            heap[0] = heap[--heap_size];
+        }
+        if (heap_size > 0) SiftDown(heap, heap_size, 0);
+    }
+    if (!PolyIsZero(&curr)) FlatPush(res, &capacity, curr_exp, curr);
+    free(rows);
+    free(heap);
+    return true;
+}
+
+/**
+ * Mnoży dwa wielomiany w rozłożonej reprezentacji o tej samej liczbie
+ * zmiennych (patrz: FlatSumOfProducts()). Kopiec ma rozmiar równy liczbie
+ * wyrazów mniejszego czynnika.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @param[out] res : @f$p * q@f$
+ * @return Czy wykładniki iloczynu mieszczą się w polach? Jeśli nie, @p res
+ * nie jest tworzony.
+ */
+bool FlatMul(const FlatPoly *p, const FlatPoly *q, FlatPoly *res) {
+    assert(p->nvars == q->nvars);
+    FlatTerm term = {.a = p, .b = q, .negate = false};
+    return FlatSumOfProducts(&term, 1, p->nvars, res);
+}
+
+/**
+ * To jest typ wyliczeniowy reprezentujący działanie wykonywane
+ * w rozłożonej reprezentacji.
+ */
+typedef enum FlatOp {
+    FLAT_ADD,   ///< dodawanie
+    FLAT_SUB,   ///< odejmowanie
+    FLAT_MUL    ///< mnożenie
+} FlatOp;
+
+/**
+ * Wykonuje działanie na dwóch wielomianach w rozłożonej reprezentacji. Jeśli
+ * oba wielomiany są współczynnikami lub wykładników nie można spakować,
+ * wykonuje działanie na rekurencyjnej reprezentacji.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @param[in] op : działanie
+ * @return wynik działania
+ */
+static Poly FlatApply(const Poly *p, const Poly *q, FlatOp op) {
+    assert(p != NULL && q != NULL);
+    size_t p_vars = PolyEvalVars(p), q_vars = PolyEvalVars(q);
+    size_t nvars = p_vars > q_vars ? p_vars : q_vars;
+    FlatPoly fp, fq, fr;
+    if (nvars > 0 && nvars <= FLAT_MAX_VARS && FlatFromPoly(p, nvars, &fp)) {
+        bool ok = FlatFromPoly(q, nvars, &fq);
+        if (ok) {
+            if (op == FLAT_ADD) fr = FlatAdd(&fp, &fq);
+            else if (op == FLAT_SUB) fr = FlatSub(&fp, &fq);
+            else ok = FlatMul(&fp, &fq, &fr);
+            FlatDestroy(&fq);
+        }
+        FlatDestroy(&fp);
+        if (ok) return FlatToPoly(&fr);
+    }
+    if (op == FLAT_ADD) return PolyAdd(p, q);
+    else if (op == FLAT_SUB) return PolySub(p, q);
+    else return PolyMul(p, q);
+}
+
+/**
+ * Dodaje dwa wielomiany w rozłożonej reprezentacji (patrz: PolyAdd()). Jeśli
+ * wykładników nie można spakować, używa PolyAdd().
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p + q@f$
+ */
+Poly PolyFlatAdd(const Poly *p, const Poly *q) {
+    return FlatApply(p, q, FLAT_ADD);
+}
+
+/**
+ * Odejmuje wielomiany w rozłożonej reprezentacji (patrz: PolySub()). Jeśli
+ * wykładników nie można spakować, używa PolySub().
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p - q@f$
+ */
+Poly PolyFlatSub(const Poly *p, const Poly *q) {
+    return FlatApply(p, q, FLAT_SUB);
+}
+
+/**
+ * Mnoży dwa wielomiany w rozłożonej reprezentacji (patrz: PolyMul()). Jeśli
+ * wykładników nie można spakować, używa PolyMul().
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p * q@f$
+ */
+Poly PolyFlatMul(const Poly *p, const Poly *q) {
+    return FlatApply(p, q, FLAT_MUL);
+}
@@ -0,0 +1,148 @@
+/** @file
+  Interfejs rozłożonej reprezentacji wielomianów ze spakowanymi wykładnikami
+
+  Wielomian @f$n@f$ zmiennych przechowywany jest jako tablica wyrazów
+  posortowana malejąco w porządku leksykograficznym wykładników. Wykładniki
+  wyrazu są spakowane w jedno 64-bitowe słowo: każda zmienna ma pole
+  o szerokości @f$\lfloor 64 / n \rfloor@f$ bitów, a zmienna @f$x_0@f$ zajmuje
+  najstarsze pole. Porównanie wyrazów jest więc porównaniem dwóch liczb,
+  a mnożenie wyrazów - dodaniem dwóch liczb, o ile żadne pole się nie
+  przepełni. Współczynniki wyrazów są liczbami (także dużymi, patrz:
+  big_coeff.h).
+
+  Reprezentacja jest alternatywą dla rekurencyjnej struktury Poly: nie
+  wymaga tablicy jednomianów dla każdego współczynnika i pozwala mnożyć
+  wielomiany wielu zmiennych bez rekurencji, scalając iloczyny wyrazów
+  kopcem (metoda Johnsona).
+
+  @authors Izabela Ożdżeńska <io417924@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#ifndef GAMMA_POLY_FLAT_H
+#define GAMMA_POLY_FLAT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "poly.h"
+
+/** Największa liczba zmiennych, dla której można spakować wykładniki. */
+#define FLAT_MAX_VARS 64
+
+/**
+ * To jest struktura przechowująca wielomian w rozłożonej reprezentacji.
+ */
+typedef struct FlatPoly {
+    size_t size;        ///< liczba wyrazów
+    size_t nvars;       ///< liczba zmiennych, od 1 do @p FLAT_MAX_VARS
+    uint64_t *exps;     ///< spakowane wykładniki wyrazów, malejąco
+    Poly *coeffs;       ///< niezerowe współczynniki wyrazów
+} FlatPoly;
+
+/**
+ * Zamienia wielomian na rozłożoną reprezentację o @p nvars zmiennych.
+ * @param[in] p : wielomian zależny od co najwyżej @p nvars zmiennych
+ * (patrz: PolyEvalVars())
+ * @param[in] nvars : liczba zmiennych, od 1 do @p FLAT_MAX_VARS
+ * @param[out] res : wielomian w rozłożonej reprezentacji
+ * @return Czy wszystkie wykładniki mieszczą się w polach?
+ */
+bool FlatFromPoly(const Poly *p, size_t nvars, FlatPoly *res);
+
+/**
+ * Zamienia wielomian w rozłożonej reprezentacji na wielomian. Przejmuje
+ * @p f na własność: po wywołaniu nie należy go używać ani usuwać.
+ * @param[in] f : wielomian w rozłożonej reprezentacji
+ * @return wielomian
+ */
+Poly FlatToPoly(FlatPoly *f);
+
+/**
+ * Usuwa wielomian w rozłożonej reprezentacji z pamięci.
+ * @param[in] f : wielomian w rozłożonej reprezentacji
+ */
+void FlatDestroy(FlatPoly *f);
+
+/**
+ * Dodaje dwa wielomiany w rozłożonej reprezentacji o tej samej liczbie
+ * zmiennych.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p + q@f$
+ */
+FlatPoly FlatAdd(const FlatPoly *p, const FlatPoly *q);
+
+/**
+ * Odejmuje wielomiany w rozłożonej reprezentacji o tej samej liczbie
+ * zmiennych.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p - q@f$
+ */
+FlatPoly FlatSub(const FlatPoly *p, const FlatPoly *q);
+
+/**
+ * Mnoży dwa wielomiany w rozłożonej reprezentacji o tej samej liczbie
+ * zmiennych.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @param[out] res : @f$p * q@f$
+ * @return Czy wykładniki iloczynu mieszczą się w polach? Jeśli nie, @p res
+ * nie jest tworzony.
+ */
+bool FlatMul(const FlatPoly *p, const FlatPoly *q, FlatPoly *res);
+
+/**
+ * To jest struktura przechowująca składnik sumy iloczynów (patrz:
+ * FlatSumOfProducts()).
+ */
+typedef struct FlatTerm {
+    const FlatPoly *a;  ///< pierwszy czynnik
+    const FlatPoly *b;  ///< drugi czynnik lub NULL, jeśli składnik jest
+                        ///< równy [a]
+    bool negate;        ///< czy składnik jest odejmowany
+} FlatTerm;
+
+/**
+ * Wylicza sumę iloczynów wielomianów w rozłożonej reprezentacji
+ * o @p nvars zmiennych, np. @f$a * b + c@f$, scalając wyrazy wszystkich
+ * iloczynów jednym kopcem, bez tworzenia iloczynów ani sum częściowych.
+ * @param[in] terms : składniki sumy
+ * @param[in] count : liczba składników
+ * @param[in] nvars : liczba zmiennych wszystkich czynników
+ * @param[out] res : suma iloczynów
+ * @return Czy wykładniki wszystkich iloczynów mieszczą się w polach? Jeśli
+ * nie, @p res nie jest tworzony.
+ */
+bool FlatSumOfProducts(const FlatTerm terms[], size_t count, size_t nvars,
+                       FlatPoly *res);
+
+/**
+ * Dodaje dwa wielomiany w rozłożonej reprezentacji (patrz: PolyAdd()). Jeśli
+ * wykładników nie można spakować, używa PolyAdd().
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p + q@f$
+ */
+Poly PolyFlatAdd(const Poly *p, const Poly *q);
+
+/**
+ * Odejmuje wielomiany w rozłożonej reprezentacji (patrz: PolySub()). Jeśli
+ * wykładników nie można spakować, używa PolySub().
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p - q@f$
+ */
+Poly PolyFlatSub(const Poly *p, const Poly *q);
+
+/**
+ * Mnoży dwa wielomiany w rozłożonej reprezentacji (patrz: PolyMul()). Jeśli
+ * wykładników nie można spakować, używa PolyMul().
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p * q@f$
+ */
+Poly PolyFlatMul(const Poly *p, const Poly *q);
+
+#endif //GAMMA_POLY_FLAT_H
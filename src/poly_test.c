@@ -0,0 +1,2431 @@
+/** @file
+  Testy biblioteki wielomianów i kalkulatora
+
+  Uruchomienie bez argumentów wykonuje wszystkie testy, a z nazwą testu -
+  tylko ten test. Program wypisuje wynik każdego testu i kończy się kodem 1,
+  jeśli któryś z nich się nie powiódł.
+
+  @authors Izabela Ożdżeńska <io417924@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#define _GNU_SOURCE
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "calc_parse.h"
+#include "calc_stats.h"
+#include "line_reader.h"
+#include "mod_arith.h"
+#include "mono_alloc.h"
+#include "poly.h"
+#include "poly_eval.h"
+#include "poly_flat.h"
+#include "poly_view.h"
+#include "thread_pool.h"
+
+/**
+ * Sprawdza warunek. Jeśli nie jest spełniony, wypisuje go na standardowe
+ * wyjście diagnostyczne i kończy test niepowodzeniem.
+ */
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond);      \
+            return false;                                                   \
+        }                                                                   \
+    } while (0)
+
+/**
+ * Tworzy wielomian z tekstu w formacie wczytywanym przez kalkulator.
+ * Niepoprawny tekst kończy program.
+ * @param[in] text : tekst wielomianu
+ * @return wielomian
+ */
+static Poly P(const char *text) {
+    Poly p;
+    if (!ReadPoly(text, &p)) {
+        fprintf(stderr, "Invalid test polynomial %s\n", text);
+        exit(1);
+    }
+    return p;
+}
+
+/**
+ * Sprawdza, czy wielomian jest równy wielomianowi zapisanemu w tekście,
+ * i usuwa go z pamięci.
+ * @param[in] p : wielomian
+ * @param[in] text : tekst wielomianu
+ * @return Czy wielomiany są równe?
+ */
+static bool PolyIsText(Poly p, const char *text) {
+    Poly q = P(text);
+    bool res = PolyIsEq(&p, &q);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    return res;
+}
+
+/**
+ * Wczytuje całą zawartość pliku od początku i zamyka go.
+ * @param[in] file : plik
+ * @return zawartość pliku zakończona znakiem '\0', przydzielona przez malloc()
+ */
+static char* ReadAll(FILE *file) {
+    rewind(file);
+    size_t size = 0, capacity = 64;
+    char *res = malloc(capacity);
+    if (res == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    int c;
+    while ((c = fgetc(file)) != EOF) {
+        if (size + 1 == capacity) {
+            capacity *= 2;
+            res = realloc(res, capacity);
+            if (res == NULL) exit(1); // Błąd podczas alokacji pamięci.
+        }
+        res[size++] = (char) c;
+    }
+    res[size] = '\0';
+    fclose(file);
+    return res;
+}
+
+/**
+ * Wykonuje polecenia kalkulatora wczytywane z @p reader i zwraca to, co
+ * wypisał na standardowe wyjście i na standardowe wyjście diagnostyczne.
+ * Standardowe wyjścia są na czas wykonania poleceń przekierowywane do plików
+ * tymczasowych.
+ * @param[in,out] reader : źródło poleceń; jest zamykane
+ * @param[out] out_text : standardowe wyjście, przydzielone przez malloc()
+ * @param[out] err_text : standardowe wyjście diagnostyczne, przydzielone przez
+ * malloc()
+ */
+static void CalcRun(LineReader *reader, char **out_text, char **err_text) {
+    FILE *out_file = tmpfile(), *err_file = tmpfile();
+    if (out_file == NULL || err_file == NULL) exit(1);
+    fflush(stdout);
+    fflush(stderr);
+    int saved_out = dup(STDOUT_FILENO), saved_err = dup(STDERR_FILENO);
+    dup2(fileno(out_file), STDOUT_FILENO);
+    dup2(fileno(err_file), STDERR_FILENO);
+
+    GetInput(reader);
+    LineReaderClose(reader);
+
+    fflush(stdout);
+    fflush(stderr);
+    dup2(saved_out, STDOUT_FILENO);
+    dup2(saved_err, STDERR_FILENO);
+    close(saved_out);
+    close(saved_err);
+    *out_text = ReadAll(out_file);
+    *err_text = ReadAll(err_file);
+}
+
+/**
+ * Wykonuje polecenia kalkulatora i porównuje to, co wypisał na standardowe
+ * wyjście i na standardowe wyjście diagnostyczne, z oczekiwanym tekstem.
+ * @param[in] input : polecenia, zakończone znakami nowej linii
+ * @param[in] out : oczekiwane standardowe wyjście
+ * @param[in] err : oczekiwane standardowe wyjście diagnostyczne
+ * @return Czy kalkulator wypisał oczekiwany tekst?
+ */
+static bool CalcOutputs(const char *input, const char *out, const char *err) {
+    FILE *in = fmemopen((void *) input, strlen(input), "r");
+    if (in == NULL) exit(1);
+    LineReader reader;
+    LineReaderFromStream(&reader, in);
+    char *out_text, *err_text;
+    CalcRun(&reader, &out_text, &err_text);
+    fclose(in);
+    bool res = strcmp(out_text, out) == 0 && strcmp(err_text, err) == 0;
+    if (!res) {
+        fprintf(stderr, "stdout:\n%sstderr:\n%s", out_text, err_text);
+    }
+    free(out_text);
+    free(err_text);
+    return res;
+}
+
+/**
+ * Wykonuje polecenia kalkulatora w trybie leniwym (patrz: UseLazyEvaluation())
+ * i porównuje wypisany tekst z oczekiwanym, tak jak CalcOutputs().
+ * @param[in] input : polecenia
+ * @param[in] out : oczekiwane standardowe wyjście
+ * @param[in] err : oczekiwane standardowe wyjście diagnostyczne
+ * @return Czy kalkulator wypisał oczekiwany tekst?
+ */
+static bool LazyCalcOutputs(const char *input, const char *out,
+                            const char *err) {
+    UseLazyEvaluation(true);
+    bool res = CalcOutputs(input, out, err);
+    UseLazyEvaluation(false);
+    return res;
+}
+
+/**
+ * Wielomiany, na których porównywane są różne implementacje tych samych
+ * działań: współczynniki, także skrajne, wielomiany jednej i wielu zmiennych
+ * oraz pary wielomianów, których suma lub iloczyn się skraca.
+ */
+static const char *const samples[] = {
+    "0",
+    "1",
+    "-7",
+    "9223372036854775807",
+    "-9223372036854775808",
+    "(1,1)+(1,0)",
+    "(-1,1)+(-1,0)",
+    "(9223372036854775807,3)+(-9223372036854775808,0)",
+    "((1,2)+(3,0),1)+((2,1),0)",
+    "((-1,2)+(-3,0),1)+(5,3)",
+    "(((1,1)+(2,0),1),2)+((4,1),1)",
+    "(1,100)+(((7,3),2)+(-1,0),50)",
+};
+
+/** Liczba wielomianów w tablicy @p samples. */
+#define SAMPLES_COUNT (sizeof(samples) / sizeof(samples[0]))
+
+/**
+ * Tworzy iloczyn wielomianów zapisanych w tekstach.
+ * @param[in] p : tekst wielomianu @f$p@f$
+ * @param[in] q : tekst wielomianu @f$q@f$
+ * @return @f$p \cdot q@f$
+ */
+static Poly Product(const char *p, const char *q) {
+    Poly a = P(p), b = P(q);
+    Poly res = PolyMul(&a, &b);
+    PolyDestroy(&a);
+    PolyDestroy(&b);
+    return res;
+}
+
+/**
+ * Wypełnia tablicę jednomianów kolejnymi wykładnikami.
+ * @param[out] arr : tablica jednomianów
+ * @param[in] count : liczba jednomianów
+ */
+static void FillMonos(Mono arr[], size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        arr[i] = (Mono) {.p = PolyZero(), .exp = (poly_exp_t) i};
+    }
+}
+
+/**
+ * Sprawdza, czy tablica jednomianów zawiera kolejne wykładniki.
+ * @param[in] arr : tablica jednomianów
+ * @param[in] count : liczba jednomianów
+ * @return Czy jednomiany mają kolejne wykładniki?
+ */
+static bool MonosFilled(const Mono arr[], size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (arr[i].exp != (poly_exp_t) i) return false;
+    }
+    return true;
+}
+
+/**
+ * Sprawdza pule alokatora tablic jednomianów: zwolniony blok jest ponownie
+ * przydzielany tablicom z tej samej klasy rozmiaru, zmiana rozmiaru
+ * zachowuje zawartość tablicy, a każdy przydział jest zliczany.
+ * @return Czy test się powiódł?
+ */
+static bool TestMonoAllocPools(void) {
+    static const size_t counts[] = {1, 2, 3, 5, 16, 17, 1000, 1024, 1025, 5000};
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        size_t before = MonoAllocCount();
+        Mono *arr = MonoArrAlloc(counts[i]);
+        CHECK(MonoAllocCount() == before + 1);
+        CHECK((uintptr_t) arr % _Alignof(max_align_t) == 0);
+        FillMonos(arr, counts[i]);
+        CHECK(MonosFilled(arr, counts[i]));
+        MonoArrFree(arr);
+        // Blok puli wraca na listę wolnych bloków swojej klasy.
+        if (counts[i] <= 1024) {
+            Mono *again = MonoArrAlloc(counts[i]);
+            CHECK(again == arr);
+            MonoArrFree(again);
+        }
+    }
+    Mono *small = MonoArrAlloc(5);
+    MonoArrFree(small);
+    Mono *same_class = MonoArrAlloc(8);
+    CHECK(same_class == small);
+    MonoArrFree(same_class);
+
+    Mono *arr = MonoArrAlloc(3);
+    FillMonos(arr, 3);
+    arr = MonoArrGrow(arr, 100);
+    CHECK(MonosFilled(arr, 3));
+    FillMonos(arr, 100);
+    arr = MonoArrGrow(arr, 3000);
+    CHECK(MonosFilled(arr, 100));
+    FillMonos(arr, 3000);
+    arr = MonoArrShrink(arr, 2000);
+    CHECK(MonosFilled(arr, 2000));
+    arr = MonoArrShrink(arr, 7);
+    CHECK(MonosFilled(arr, 7));
+    arr = MonoArrShrink(arr, 5);
+    CHECK(MonosFilled(arr, 5));
+    MonoArrFree(arr);
+    MonoArrFree(NULL);
+    return true;
+}
+
+/**
+ * Sprawdza arenę pamięci tymczasowej: przydziały są rozłączne i wyrównane,
+ * ScratchRelease() oddaje pamięć przydzieloną po zapamiętaniu stanu,
+ * a ScratchReset() całą pamięć, także ponadwymiarowych fragmentów.
+ * @return Czy test się powiódł?
+ */
+static bool TestScratchArena(void) {
+    ScratchReset();
+    char *first = ScratchAlloc(10);
+    char *second = ScratchAlloc(10);
+    CHECK((uintptr_t) first % 16 == 0 && (uintptr_t) second % 16 == 0);
+    CHECK(second >= first + 10);
+    ScratchMark mark = ScratchGetMark();
+    char *third = ScratchAlloc(100);
+    memset(third, 1, 100);
+    // Przydział większy od fragmentu areny dostaje własny fragment.
+    size_t big_size = (size_t) 1 << 20;
+    char *big = ScratchAlloc(big_size);
+    memset(big, 2, big_size);
+    CHECK(third[99] == 1);
+    ScratchRelease(mark);
+    CHECK(ScratchAlloc(100) == third);
+    ScratchReset();
+    CHECK(ScratchAlloc(10) == first);
+    ScratchReset();
+    return true;
+}
+
+/** To jest stan generatora liczb pseudolosowych testów. */
+static uint64_t random_state = 1;
+
+/**
+ * Daje kolejną liczbę pseudolosową (generator xorshift64*).
+ * @param[in] bound : ograniczenie górne, większe od zera
+ * @return liczba z przedziału @f$[0, bound)@f$
+ */
+static uint64_t Random(uint64_t bound) {
+    random_state ^= random_state >> 12;
+    random_state ^= random_state << 25;
+    random_state ^= random_state >> 27;
+    return (random_state * 0x2545F4914F6CDD1DULL >> 11) % bound;
+}
+
+/**
+ * Tworzy pseudolosowy wielomian będący sumą @p terms jednomianów
+ * @f$c x_0^{e_0} \cdots x_{nvars-1}^{e_{nvars-1}}@f$, gdzie
+ * @f$0 \leq e_i \leq max\_exp@f$ oraz @f$|c| \leq max\_coeff@f$.
+ * @param[in] nvars : liczba zmiennych, większa od zera
+ * @param[in] terms : liczba jednomianów
+ * @param[in] max_exp : największy wykładnik
+ * @param[in] max_coeff : największa wartość bezwzględna współczynnika
+ * @return wielomian
+ */
+static Poly RandomPoly(size_t nvars, size_t terms, poly_exp_t max_exp,
+                       poly_coeff_t max_coeff) {
+    if (terms == 0) return PolyZero();
+    Mono *monos = MonoArrAlloc(terms);
+    for (size_t t = 0; t < terms; t++) {
+        Poly coeff = PolyFromCoeff((poly_coeff_t) Random(2 * max_coeff + 1)
+                                   - max_coeff);
+        for (size_t var = nvars; var-- > 0;) {
+            poly_exp_t exp = (poly_exp_t) Random((uint64_t) max_exp + 1);
+            monos[t] = (Mono) {.p = coeff, .exp = exp};
+            if (var > 0) coeff = PolyAddMonos(1, &monos[t]);
+        }
+    }
+    return PolyArrMonos(terms, monos);
+}
+
+/**
+ * Mnoży wielomiany algorytmem szkolnym: sumuje iloczyny wszystkich par
+ * jednomianów. Służy jako wzorzec dla PolyMul(), która mnoży jedynie
+ * współczynniki liczbowe.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p * q@f$
+ */
+static Poly ReferenceMul(const Poly *p, const Poly *q) {
+    if (PolyIsCoeff(p) && PolyIsCoeff(q)) return PolyMul(p, q);
+    // Współczynnik jest jednomianem z zerowym wykładnikiem.
+    Mono p_coeff = {.p = *p, .exp = 0}, q_coeff = {.p = *q, .exp = 0};
+    size_t p_size = PolyIsCoeff(p) ? 1 : p->size;
+    size_t q_size = PolyIsCoeff(q) ? 1 : q->size;
+    const Mono *p_monos = PolyIsCoeff(p) ? &p_coeff : p->arr;
+    const Mono *q_monos = PolyIsCoeff(q) ? &q_coeff : q->arr;
+    Mono *monos = MonoArrAlloc(p_size * q_size);
+    for (size_t i = 0; i < p_size; i++) {
+        for (size_t j = 0; j < q_size; j++) {
+            monos[i * q_size + j] = (Mono) {
+                .p = ReferenceMul(&p_monos[i].p, &q_monos[j].p),
+                .exp = p_monos[i].exp + q_monos[j].exp};
+        }
+    }
+    return PolyArrMonos(p_size * q_size, monos);
+}
+
+/**
+ * Sprawdza, czy PolyMul() daje ten sam iloczyn co ReferenceMul(), i usuwa
+ * czynniki z pamięci.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return Czy iloczyny są równe?
+ */
+static bool MulMatchesReference(Poly p, Poly q) {
+    Poly res = PolyMul(&p, &q), expected = ReferenceMul(&p, &q);
+    bool equal = PolyIsEq(&res, &expected);
+    PolyDestroy(&res);
+    PolyDestroy(&expected);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    return equal;
+}
+
+/**
+ * Sprawdza mnożenie rzadkich wielomianów przez kopiec: iloczyny par
+ * przykładowych wielomianów oraz pseudolosowych wielomianów wielu zmiennych,
+ * także takich, których iloczyn się skraca.
+ * @return Czy test się powiódł?
+ */
+static bool TestMulHeap(void) {
+    for (size_t i = 0; i < SAMPLES_COUNT; i++) {
+        for (size_t j = 0; j < SAMPLES_COUNT; j++) {
+            CHECK(MulMatchesReference(P(samples[i]), P(samples[j])));
+        }
+    }
+    random_state = 2;
+    for (size_t nvars = 1; nvars <= 4; nvars++) {
+        for (size_t terms = 1; terms <= 64; terms *= 4) {
+            CHECK(MulMatchesReference(RandomPoly(nvars, terms, 1000, 100),
+                                      RandomPoly(nvars, terms + 3, 1000, 100)));
+        }
+    }
+    // (x + 1) * (x - 1) i (x^2 + x*y + y^2) * (x - y) skracają się.
+    CHECK(PolyIsText(Product("(1,1)+(1,0)", "(1,1)+(-1,0)"),
+                     "(-1,0)+(1,2)"));
+    CHECK(PolyIsText(Product("((1,2),0)+((1,1),1)+(1,2)",
+                             "((-1,1),0)+(1,1)"),
+                     "((-1,3),0)+(1,3)"));
+    // Iloczyn tysięcy jednomianów nie może przepełnić stosu wywołań.
+    Poly p = RandomPoly(1, 2000, 1000000, 1000);
+    Poly q = RandomPoly(1, 2000, 1000000, 1000);
+    Poly res = PolyMul(&p, &q);
+    CHECK(PolyDeg(&res) == PolyDeg(&p) + PolyDeg(&q));
+    PolyDestroy(&res);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    return true;
+}
+
+/**
+ * Sprawdza, czy tekst jest wczytywany jako wielomian równy wielomianowi
+ * zapisanemu w innym tekście.
+ * @param[in] input : wczytywany tekst
+ * @param[in] expected : tekst oczekiwanego wielomianu w postaci wypisywanej
+ * przez PrintPoly()
+ * @return Czy wczytany wielomian jest wypisywany jako @p expected?
+ */
+static bool ReadsAs(const char *input, const char *expected) {
+    Poly p;
+    if (!ReadPoly(input, &p)) return false;
+    char *text;
+    size_t len;
+    FILE *stream = open_memstream(&text, &len);
+    if (stream == NULL) exit(1);
+    PrintPoly(&p, stream);
+    fclose(stream);
+    PolyDestroy(&p);
+    bool res = len > 0 && strncmp(text, expected, len - 1) == 0 &&
+               expected[len - 1] == '\0';
+    if (!res) fprintf(stderr, "%s read as %s", input, text);
+    free(text);
+    return res;
+}
+
+/**
+ * Sprawdza wczytywanie wielomianów: jednomiany w dowolnej kolejności są
+ * sortowane i łączone, zerowe współczynniki pomijane, a niepoprawne teksty
+ * odrzucane, także przez kalkulator.
+ * @return Czy test się powiódł?
+ */
+static bool TestReadPoly(void) {
+    CHECK(ReadsAs("0", "0"));
+    CHECK(ReadsAs("-0", "0"));
+    CHECK(ReadsAs("-42", "-42"));
+    CHECK(ReadsAs("(1,0)", "1"));
+    CHECK(ReadsAs("(0,5)", "0"));
+    CHECK(ReadsAs("(1,0)+(2,1)+(3,2)", "(1,0)+(2,1)+(3,2)"));
+    CHECK(ReadsAs("(3,2)+(2,1)+(1,0)", "(1,0)+(2,1)+(3,2)"));
+    CHECK(ReadsAs("(2,1)+(3,2)+(1,0)", "(1,0)+(2,1)+(3,2)"));
+    CHECK(ReadsAs("(2,1)+(3,1)+(-5,1)+(1,0)", "1"));
+    CHECK(ReadsAs("(1,1)+(2,1)+(3,1)", "(6,1)"));
+    CHECK(ReadsAs("((1,0),0)", "1"));
+    CHECK(ReadsAs("(((4,2),0)+(1,0),3)+((1,1),3)",
+                  "(((1,0)+(4,2),0)+(1,1),3)"));
+    CHECK(ReadsAs("(1,2147483647)", "(1,2147483647)"));
+    CHECK(ReadsAs("(-9223372036854775808,1)", "(-9223372036854775808,1)"));
+
+    static const char *const wrong[] = {
+        "", " 1", "1 ", "+1", "--1", "1a", "()", "(1)", "(1,)", "(,1)",
+        "(1,2", "1,2)", "(1,2))", "((1,2),3", "(1,2)+", "+(1,2)",
+        "(1,2)(1,3)", "(1,2)++(1,3)", "(1, 2)", "(1,-1)", "(1,+1)",
+        "(1,2147483648)", "(1,1a)", "(1,2)+1", "1+(1,2)", "(a,1)",
+    };
+    for (size_t i = 0; i < sizeof(wrong) / sizeof(wrong[0]); i++) {
+        Poly p;
+        if (ReadPoly(wrong[i], &p)) {
+            fprintf(stderr, "Accepted wrong polynomial \"%s\"\n", wrong[i]);
+            PolyDestroy(&p);
+            return false;
+        }
+    }
+    CHECK(CalcOutputs("(1,2)+\n(1,1)+(2,1)\n((1,2),3\nPRINT\n", "(3,1)\n",
+                      "ERROR 1 WRONG POLY\nERROR 3 WRONG POLY\n"));
+    return true;
+}
+
+/**
+ * Sprawdza, czy wielomian wypisany funkcją PrintPoly() wczytuje się z powrotem
+ * jako ten sam wielomian.
+ * @param[in] p : wielomian
+ * @return Czy wczytany wielomian jest równy @p p?
+ */
+static bool PrintReadsBack(const Poly *p) {
+    char *text;
+    size_t len;
+    FILE *stream = open_memstream(&text, &len);
+    if (stream == NULL) exit(1);
+    PrintPoly(p, stream);
+    fclose(stream);
+    text[len - 1] = '\0'; // Usuwamy znak nowej linii.
+    Poly q;
+    bool res = ReadPoly(text, &q);
+    if (res) {
+        res = PolyIsEq(p, &q);
+        PolyDestroy(&q);
+    }
+    free(text);
+    return res;
+}
+
+/**
+ * Sprawdza wypisywanie wielomianów przez bufor wyjścia: format liczb
+ * skrajnych i zagnieżdżonych jednomianów, wielomian dłuższy od bufora oraz
+ * kolejność wyjścia polecenia PRINT względem wyników innych poleceń.
+ * @return Czy test się powiódł?
+ */
+static bool TestPrintPoly(void) {
+    CHECK(ReadsAs("9223372036854775807", "9223372036854775807"));
+    CHECK(ReadsAs("-9223372036854775808", "-9223372036854775808"));
+    CHECK(ReadsAs("((-1,0)+(1,2147483647),10)+(-7,11)",
+                  "((-1,0)+(1,2147483647),10)+(-7,11)"));
+    random_state = 4;
+    for (size_t nvars = 1; nvars <= 3; nvars++) {
+        // Zapis wielomianu jest kilkukrotnie dłuższy od bufora wyjścia.
+        Poly p = RandomPoly(nvars, 20000, 100000, 1000000000);
+        CHECK(PrintReadsBack(&p));
+        PolyDestroy(&p);
+    }
+    CHECK(CalcOutputs("(1,1)\nPRINT\nIS_ZERO\nDEG\nPRINT\nZERO\nPRINT\n",
+                      "(1,1)\n0\n1\n(1,1)\n0\n", ""));
+    return true;
+}
+
+/**
+ * Sprawdza współdzielenie tablic jednomianów: kopia wielomianu dostaje
+ * odwołanie do tej samej tablicy, która jest zwalniana dopiero z ostatnim
+ * odwołaniem, a PolyCloneMonos() nie zmienia kopiowanych jednomianów, także
+ * gdy łączy kilka jednomianów o tym samym wykładniku.
+ * @return Czy test się powiódł?
+ */
+static bool TestSharedMonos(void) {
+    Poly p = P("((1,2)+(3,0),1)+((2,1),0)");
+    CHECK(!MonoArrIsShared(p.arr));
+    Poly clone = PolyClone(&p);
+    CHECK(clone.arr == p.arr && MonoArrIsShared(p.arr));
+    Poly second = PolyClone(&clone);
+    PolyDestroy(&p);
+    CHECK(MonoArrIsShared(clone.arr));
+    PolyDestroy(&second);
+    CHECK(!MonoArrIsShared(clone.arr));
+    CHECK(PolyIsText(clone, "((1,2)+(3,0),1)+((2,1),0)"));
+
+    Poly coeffs[] = {P("(1,1)+(1,0)"), P("(2,1)"), P("(-1,0)+(3,2)")};
+    Mono monos[] = {{.p = coeffs[0], .exp = 4}, {.p = coeffs[1], .exp = 4},
+                    {.p = coeffs[2], .exp = 4}, {.p = coeffs[1], .exp = 1}};
+    Poly sum = PolyCloneMonos(4, monos);
+    CHECK(PolyIsText(sum, "((2,1),1)+((3,1)+(3,2),4)"));
+    CHECK(PolyIsText(coeffs[0], "(1,1)+(1,0)"));
+    CHECK(PolyIsText(coeffs[1], "(2,1)"));
+    CHECK(PolyIsText(coeffs[2], "(-1,0)+(3,2)"));
+
+    CHECK(CalcOutputs("(1,1)+(2,0)\nCLONE\nCLONE\nMUL\nSWAP\nNEG\nPRINT\n"
+                      "POP\nPRINT\n",
+                      "(-2,0)+(-1,1)\n(4,0)+(4,1)+(1,2)\n", ""));
+    return true;
+}
+
+/**
+ * Sprawdza internowanie wielomianów: równe wielomiany utworzone na różne
+ * sposoby współdzielą tablicę jednomianów, różne internowane wielomiany
+ * są rozróżniane bez porównywania jednomianów, a wielomian utworzony przy
+ * wyłączonym internowaniu jest nadal porównywany przez zawartość.
+ * @return Czy test się powiódł?
+ */
+static bool TestIntern(void) {
+    Poly plain = P("((1,1),0)+((2,0)+(1,2),3)");
+    PolySetInterning(true);
+    Poly p = P("((1,1),0)+((2,0)+(1,2),3)");
+    Poly q = P("((1,2)+(2,0),3)+((1,1),0)");
+    Poly x = P("((1,1),0)"), rest = P("((2,0)+(1,2),3)");
+    Poly added = PolyAdd(&x, &rest);
+    CHECK(PolyIsInterned(&p));
+    CHECK(q.arr == p.arr && added.arr == p.arr);
+    CHECK(PolyIsEq(&p, &added));
+    // Tablice współczynników równych wielomianów też są współdzielone.
+    CHECK(p.arr[0].p.arr == rest.arr[0].p.arr);
+    CHECK(p.arr[1].p.arr == x.arr[0].p.arr);
+
+    Poly other = P("((1,1),0)+((2,0)+(1,2),4)");
+    Poly neg = PolyNeg(&p);
+    CHECK(other.arr != p.arr && !PolyIsEq(&p, &other));
+    CHECK(!PolyIsEq(&p, &neg));
+    CHECK(!PolyIsInterned(&plain) && PolyIsEq(&plain, &p));
+
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    CHECK(PolyIsInterned(&added));
+    CHECK(PolyIsText(added, "((1,1),0)+((2,0)+(1,2),3)"));
+    PolyDestroy(&x);
+    PolyDestroy(&rest);
+    PolyDestroy(&other);
+    PolyDestroy(&neg);
+    // Wielomian równy usuniętym jest internowany od nowa.
+    p = P("((1,1),0)+((2,0)+(1,2),3)");
+    CHECK(PolyIsInterned(&p) && PolyIsEq(&p, &plain));
+    PolyDestroy(&p);
+    PolySetInterning(false);
+    p = P("((1,1),0)+((2,0)+(1,2),3)");
+    CHECK(!PolyIsInterned(&p) && p.arr != plain.arr);
+    CHECK(PolyIsEq(&p, &plain));
+    PolyDestroy(&p);
+    PolyDestroy(&plain);
+    return true;
+}
+
+/**
+ * Sprawdza, czy iloczyny, wartości w punktach i złożenia wyliczane przez
+ * pulę wątków są równe wyliczonym sekwencyjnie, również przy kolejnych
+ * wykonaniach.
+ * @return Czy test się powiódł?
+ */
+static bool TestPoolDeterminism(void) {
+    enum { ROUNDS = 3 };
+    random_state = 6;
+    // Rzadkie wielomiany trzech zmiennych mnożone są przez kopiec.
+    Poly p = RandomPoly(3, 300, 100000, 1000);
+    Poly q = RandomPoly(3, 200, 100000, 1000);
+    // Wartości liczone są dla wielomianu o małych wykładnikach, bo potęgi
+    // argumentów są liczone dokładnie.
+    Poly e = RandomPoly(3, 3000, 60, 1000);
+    Poly c = RandomPoly(3, 60, 10, 10);
+    Poly args[] = {P("(1,1)+(2,0)"), P("((1,2),0)+(-1,1)"), P("(3,3)")};
+    poly_coeff_t xs[] = {-3, 2, 7};
+    Poly serial_mul = PolyMul(&p, &q);
+    Poly serial_at = PolyAt(&e, 5);
+    Poly serial_at_multi[3];
+    PolyAtMulti(&e, 3, xs, serial_at_multi);
+    Poly serial_compose = PolyCompose(&c, 3, args);
+
+    PoolStart(4);
+    CHECK(PoolThreads() == 4);
+    bool equal = true;
+    for (int round = 0; round < ROUNDS; round++) {
+        Poly mul = PolyMul(&p, &q);
+        Poly at = PolyAt(&e, 5);
+        Poly at_multi[3];
+        PolyAtMulti(&e, 3, xs, at_multi);
+        Poly compose = PolyCompose(&c, 3, args);
+        equal = equal && PolyIsEq(&mul, &serial_mul) &&
+                PolyIsEq(&at, &serial_at) &&
+                PolyIsEq(&compose, &serial_compose);
+        for (size_t i = 0; i < 3; i++) {
+            equal = equal && PolyIsEq(&at_multi[i], &serial_at_multi[i]);
+            PolyDestroy(&at_multi[i]);
+        }
+        PolyDestroy(&mul);
+        PolyDestroy(&at);
+        PolyDestroy(&compose);
+    }
+    PoolStop();
+    CHECK(equal);
+    CHECK(PoolThreads() == 1);
+
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    PolyDestroy(&e);
+    PolyDestroy(&c);
+    PolyDestroy(&serial_mul);
+    PolyDestroy(&serial_at);
+    PolyDestroy(&serial_compose);
+    for (size_t i = 0; i < 3; i++) {
+        PolyDestroy(&args[i]);
+        PolyDestroy(&serial_at_multi[i]);
+    }
+    return true;
+}
+
+/**
+ * Podnosi wielomian do potęgi wielokrotnym mnożeniem przez niego.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] n : wykładnik @f$n@f$
+ * @return @f$p^n@f$
+ */
+static Poly PowByMul(const Poly *p, poly_exp_t n) {
+    Poly res = PolyFromCoeff(1);
+    for (poly_exp_t i = 0; i < n; i++) {
+        Poly next = PolyMul(&res, p);
+        PolyDestroy(&res);
+        res = next;
+    }
+    return res;
+}
+
+/**
+ * Sprawdza mnożenie gęstych wielomianów wielu zmiennych przez podstawienie
+ * Kroneckera, także gdy współczynniki iloczynu nie mieszczą się w gęstej
+ * tablicy, oraz przy ustawionym module.
+ * @return Czy test się powiódł?
+ */
+static bool TestMulKronecker(void) {
+    random_state = 7;
+    for (size_t nvars = 2; nvars <= 4; nvars++) {
+        poly_exp_t max_exp = nvars == 2 ? 12 : 4;
+        CHECK(MulMatchesReference(RandomPoly(nvars, 100, max_exp, 1000),
+                                  RandomPoly(nvars, 80, max_exp, 1000)));
+        // Czynniki o różnej liczbie zmiennych.
+        CHECK(MulMatchesReference(RandomPoly(nvars, 100, max_exp, 1000),
+                                  RandomPoly(nvars - 1, 80, max_exp, 1000)));
+    }
+    // Współczynniki iloczynu mogą przekroczyć zakres poly_coeff_t.
+    CHECK(MulMatchesReference(RandomPoly(2, 100, 12, 1000000000),
+                              RandomPoly(2, 100, 12, 1000000000)));
+    // (x_0 + x_1)^6 * (x_0 - x_1)^6 = (x_0^2 - x_1^2)^6
+    Poly sum = P("(1,1)+((1,1),0)"), diff = P("(1,1)+((-1,1),0)");
+    Poly p = PowByMul(&sum, 6), q = PowByMul(&diff, 6);
+    Poly res = PolyMul(&p, &q);
+    Poly square = P("(1,2)+((-1,2),0)");
+    Poly expected = PowByMul(&square, 6);
+    CHECK(PolyIsEq(&res, &expected));
+    PolyDestroy(&sum);
+    PolyDestroy(&diff);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    PolyDestroy(&res);
+    PolyDestroy(&square);
+    PolyDestroy(&expected);
+
+    PolySetModulus(1000003);
+    for (size_t nvars = 2; nvars <= 3; nvars++) {
+        Poly a = RandomPoly(nvars, 100, 8, 1000000000);
+        Poly b = RandomPoly(nvars, 100, 8, 1000000000);
+        bool equal = MulMatchesReference(PolyReduce(&a), PolyReduce(&b));
+        PolyDestroy(&a);
+        PolyDestroy(&b);
+        CHECK(equal);
+    }
+    PolySetModulus(0);
+    return true;
+}
+
+/**
+ * Sprawdza mnożenie gęstych wielomianów jednej zmiennej algorytmem
+ * Karatsuby i przez transformatę (także z dokładnym odtworzeniem dużych
+ * współczynników iloczynu) oraz przy ustawionym module.
+ * @return Czy test się powiódł?
+ */
+static bool TestMulDense(void) {
+    random_state = 8;
+    static const size_t sizes[][2] = {
+        {40, 40}, {100, 70}, {33, 500}, {300, 300}, {700, 650}, {1000, 40},
+    };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        size_t np = sizes[i][0], nq = sizes[i][1];
+        CHECK(MulMatchesReference(
+            RandomPoly(1, np, (poly_exp_t) np - 1, 1000000),
+            RandomPoly(1, nq, (poly_exp_t) nq - 1, 1000000)));
+        // Współczynniki iloczynu nie mieszczą się w typie poly_coeff_t.
+        CHECK(MulMatchesReference(
+            RandomPoly(1, np, (poly_exp_t) np - 1, 10000000000),
+            RandomPoly(1, nq, (poly_exp_t) nq - 1, 10000000000)));
+    }
+    // Współczynniki bliskie granicom zakresu poly_coeff_t.
+    CHECK(MulMatchesReference(RandomPoly(1, 700, 699, (poly_coeff_t) 1 << 58),
+                              RandomPoly(1, 700, 699, (poly_coeff_t) 1 << 58)));
+    PolySetModulus(998244353);
+    for (size_t n = 50; n <= 800; n *= 4) {
+        Poly a = RandomPoly(1, n, (poly_exp_t) n - 1, 1000000000000);
+        Poly b = RandomPoly(1, n, (poly_exp_t) n - 1, 1000000000000);
+        bool equal = MulMatchesReference(PolyReduce(&a), PolyReduce(&b));
+        PolyDestroy(&a);
+        PolyDestroy(&b);
+        CHECK(equal);
+    }
+    PolySetModulus(0);
+    return true;
+}
+
+/**
+ * Tworzy wielomian o dużych współczynnikach (patrz: big_coeff.h): iloczyn
+ * wielomianów, których współczynniki mieszczą się w typie poly_coeff_t.
+ * @param[in] i : numer wielomianu, od 0 do 2
+ * @return wielomian
+ */
+static Poly BigSample(size_t i) {
+    static const char *const factors[][2] = {
+        {"9223372036854775807", "9223372036854775807"},
+        {"-9223372036854775808", "(9223372036854775807,1)+(2,0)"},
+        {"(9223372036854775807,2)+((3,1),0)",
+         "((-9223372036854775807,1),1)+(5,0)"},
+    };
+    return Product(factors[i][0], factors[i][1]);
+}
+
+/** Liczba wielomianów tworzonych przez BigSample(). */
+#define BIG_SAMPLES_COUNT 3
+
+/**
+ * Sprawdza wczytywanie współczynników, które nie mieszczą się w typie
+ * poly_coeff_t: wielomiany o dużych współczynnikach wypisane poleceniem PRINT
+ * wczytują się z powrotem, a wykładniki nadal muszą mieścić się w typie
+ * poly_exp_t.
+ * @return Czy test się powiódł?
+ */
+static bool TestParseBigCoeff(void) {
+    for (size_t i = 0; i < BIG_SAMPLES_COUNT; i++) {
+        Poly p = BigSample(i);
+        CHECK(PrintReadsBack(&p));
+        PolyDestroy(&p);
+    }
+    for (size_t i = 0; i < SAMPLES_COUNT; i++) {
+        Poly p = P(samples[i]);
+        CHECK(PrintReadsBack(&p));
+        PolyDestroy(&p);
+    }
+    CHECK(PolyIsText(Product("9223372036854775807", "-9223372036854775807"),
+                     "-85070591730234615847396907784232501249"));
+    CHECK(PolyIsText(P("9223372036854775808"),
+                     "(9223372036854775807,0)+(1,0)"));
+    CHECK(PolyIsText(P("-0000000000000000000000000000000012"), "-12"));
+    CHECK(CalcOutputs("(85070591730234615847396907784232501249,2)"
+                      "+(-9223372036854775809,0)\n"
+                      "(1,2147483648)\n-\n(1,1)+(-1)\nPRINT\n"
+                      "MOD 7\n85070591730234615847396907784232501249\nPRINT\n"
+                      "MOD 0\n",
+                      "(-9223372036854775809,0)"
+                      "+(85070591730234615847396907784232501249,2)\n0\n",
+                      "ERROR 2 WRONG POLY\nERROR 3 WRONG POLY\n"
+                      "ERROR 4 WRONG POLY\n"));
+    return true;
+}
+
+/**
+ * Sprawdza obliczenia modulo: redukcję wielomianów, działania na resztach
+ * (także dla modułu bliskiego MOD_MAX), zgodność iloczynu z redukcją
+ * iloczynu dokładnego oraz polecenie "MOD" kalkulatora.
+ * @return Czy test się powiódł?
+ */
+static bool TestModulus(void) {
+    random_state = 11;
+    Poly p = RandomPoly(2, 300, 40, 1000000000000);
+    Poly q = RandomPoly(2, 200, 40, 1000000000000);
+    Poly exact = PolyMul(&p, &q);
+
+    CHECK(!PolySetModulus(1) && !PolySetModulus(MOD_MAX + 1));
+    CHECK(PolySetModulus(7));
+    Poly r = P("(-1,0)+(9,1)+((15,2),3)");
+    CHECK(PolyIsText(PolyReduce(&r), "(6,0)+(2,1)+((1,2),3)"));
+    PolyDestroy(&r);
+    CHECK(PolyIsText(Product("(3,1)+(1,0)", "(5,1)+(6,0)"),
+                     "(6,0)+(2,1)+(1,2)"));
+    Poly a = P("(3,1)"), b = P("(4,1)");
+    CHECK(PolyIsText(PolyAdd(&a, &b), "0"));
+    CHECK(PolyIsText(PolyNeg(&a), "(4,1)"));
+    PolyDestroy(&a);
+    PolyDestroy(&b);
+
+    CHECK(PolySetModulus(1000000007));
+    Poly p_mod = PolyReduce(&p), q_mod = PolyReduce(&q);
+    Poly res = PolyMul(&p_mod, &q_mod), expected = PolyReduce(&exact);
+    CHECK(PolyIsEq(&res, &expected));
+    PolyDestroy(&p_mod);
+    PolyDestroy(&q_mod);
+    PolyDestroy(&res);
+    PolyDestroy(&expected);
+
+    // (-1)^2 = 1 modulo MOD_MAX.
+    CHECK(PolySetModulus(MOD_MAX));
+    CHECK(PolyIsText(Product("(4611686018427387902,1)",
+                             "(4611686018427387902,1)"), "(1,2)"));
+    CHECK(PolySetModulus(0));
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    PolyDestroy(&exact);
+
+    CHECK(CalcOutputs("(9,1)+(-1,0)\nMOD 7\nPRINT\nCLONE\nMUL\nPRINT\nMOD 0\n"
+                      "(10,0)\nADD\nPRINT\nMOD 1\nMOD -3\nMOD\n"
+                      "MOD 4611686018427387904\nMOD 5\nPRINT\nMOD 0\n",
+                      "(6,0)+(2,1)\n(1,0)+(3,1)+(4,2)\n"
+                      "(11,0)+(3,1)+(4,2)\n(1,0)+(3,1)+(4,2)\n",
+                      "ERROR 11 MOD WRONG VALUE\nERROR 12 MOD WRONG VALUE\n"
+                      "ERROR 13 MOD WRONG VALUE\nERROR 14 MOD WRONG VALUE\n"));
+    return true;
+}
+
+/**
+ * Sprawdza wyliczanie wartości wielomianu w wielu punktach: wyniki
+ * PolyAtMulti() są równe wynikom PolyAt() dla kolejnych punktów, także gdy
+ * wartości nie mieszczą się w typie poly_coeff_t. Sprawdza też polecenie
+ * "AT_MULTI" kalkulatora.
+ * @return Czy test się powiódł?
+ */
+static bool TestAtMulti(void) {
+    static const poly_coeff_t xs[] = {0, 1, -1, 2, -7, 1000, 3, 3};
+    enum { XS_COUNT = sizeof(xs) / sizeof(xs[0]) };
+    random_state = 12;
+    for (size_t s = 0; s < SAMPLES_COUNT + 3; s++) {
+        Poly p = s < SAMPLES_COUNT ? P(samples[s])
+                                   : RandomPoly(s - SAMPLES_COUNT + 1, 200, 30,
+                                                1000000000);
+        Poly values[XS_COUNT];
+        for (size_t k = 1; k <= XS_COUNT; k++) {
+            PolyAtMulti(&p, k, xs, values);
+            bool equal = true;
+            for (size_t i = 0; i < k; i++) {
+                Poly expected = PolyAt(&p, xs[i]);
+                equal = equal && PolyIsEq(&values[i], &expected);
+                PolyDestroy(&expected);
+                PolyDestroy(&values[i]);
+            }
+            CHECK(equal);
+        }
+        PolyDestroy(&p);
+    }
+    CHECK(CalcOutputs("(1,2)+((1,1),1)\nAT_MULTI 2 -1 0\nPRINT\nPOP\nPRINT\n"
+                      "POP\nPRINT\nAT_MULTI\nAT_MULTI \nAT_MULTI 1 \n"
+                      "AT_MULTI 1  2\nAT_MULTI 1,2\nAT_MULTI -\n"
+                      "AT_MULTI 9223372036854775808\nPOP\nAT_MULTI 1\n",
+                      "0\n(1,0)+(-1,1)\n(4,0)+(2,1)\n",
+                      "ERROR 8 AT_MULTI WRONG VALUE\n"
+                      "ERROR 9 AT_MULTI WRONG VALUE\n"
+                      "ERROR 10 AT_MULTI WRONG VALUE\n"
+                      "ERROR 11 AT_MULTI WRONG VALUE\n"
+                      "ERROR 12 AT_MULTI WRONG VALUE\n"
+                      "ERROR 13 AT_MULTI WRONG VALUE\n"
+                      "ERROR 14 AT_MULTI WRONG VALUE\n"
+                      "ERROR 16 STACK UNDERFLOW\n"));
+    return true;
+}
+
+/**
+ * Wylicza wartość wielomianu w punkcie, podstawiając kolejne współrzędne
+ * funkcją PolyAt(). Pod zmienne o indeksach nie mniejszych od @p nvars
+ * podstawiane jest zero.
+ * @param[in] p : wielomian
+ * @param[in] nvars : liczba współrzędnych punktu
+ * @param[in] point : współrzędne punktu
+ * @return wartość wielomianu w punkcie
+ */
+static Poly ReferenceEval(const Poly *p, size_t nvars,
+                          const poly_coeff_t point[]) {
+    Poly value = PolyClone(p);
+    for (size_t i = 0; !PolyIsCoeff(&value); i++) {
+        Poly next = PolyAt(&value, i < nvars ? point[i] : 0);
+        PolyDestroy(&value);
+        value = next;
+    }
+    return value;
+}
+
+/**
+ * Sprawdza wyliczanie wartości skompilowanego wielomianu w wielu punktach
+ * (także z pominiętymi współrzędnymi) względem podstawiania współrzędnych
+ * funkcją PolyAt() oraz polecenie "EVAL_BATCH" z punktami z kolejnych
+ * wierszy poleceń i z pliku dłuższego od porcji punktów.
+ * @return Czy test się powiódł?
+ */
+static bool TestEvalBatch(void) {
+    enum { POINTS = 64, MAX_VARS = 4 };
+    poly_coeff_t points[POINTS * MAX_VARS];
+    Poly values[POINTS];
+    random_state = 13;
+    for (size_t s = 0; s < SAMPLES_COUNT + MAX_VARS; s++) {
+        Poly p = s < SAMPLES_COUNT ? P(samples[s])
+                                   : RandomPoly(s - SAMPLES_COUNT + 1, 100, 8,
+                                                1000);
+        size_t vars = PolyEvalVars(&p);
+        CHECK(vars <= MAX_VARS);
+        for (size_t nvars = vars > 0 ? vars - 1 : 0; nvars <= vars; nvars++) {
+            for (size_t i = 0; i < POINTS * nvars; i++) {
+                points[i] = (poly_coeff_t) Random(2001) - 1000;
+            }
+            EvalPlan *plan = PolyEvalCompile(&p, nvars);
+            PolyEvalBatch(plan, POINTS, points, values);
+            PolyEvalPlanDestroy(plan);
+            bool equal = true;
+            for (size_t i = 0; i < POINTS; i++) {
+                Poly expected = ReferenceEval(&p, nvars, points + i * nvars);
+                equal = equal && PolyIsEq(&values[i], &expected);
+                PolyDestroy(&expected);
+                PolyDestroy(&values[i]);
+            }
+            CHECK(equal);
+        }
+        PolyDestroy(&p);
+    }
+
+    CHECK(CalcOutputs("(1,1)+((2,1),0)\nEVAL_BATCH -\n1 2\n# punkt\n\n3\n"
+                      "-1 -1 5\nx\n1  2\nEND\nPRINT\n",
+                      "5\n3\n-3\n((2,1),0)+(1,1)\n",
+                      "ERROR 8 EVAL_BATCH WRONG POINT\n"
+                      "ERROR 9 EVAL_BATCH WRONG POINT\n"));
+
+    // Wartości x_0^2 w punktach 0, 1, ..., POINTS_IN_FILE - 1.
+    enum { POINTS_IN_FILE = 5000 };
+    char path[] = "/tmp/poly_test_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd != -1);
+    FILE *file = fdopen(fd, "w");
+    CHECK(file != NULL);
+    char *expected = malloc(POINTS_IN_FILE * 12);
+    if (expected == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    size_t len = 0;
+    fprintf(file, "# x\n");
+    for (long x = 0; x < POINTS_IN_FILE; x++) {
+        fprintf(file, "%ld\n", x);
+        len += (size_t) sprintf(expected + len, "%ld\n", x * x);
+    }
+    fprintf(file, "y\n");
+    fclose(file);
+    char input[256];
+    snprintf(input, sizeof(input), "(1,2)\nEVAL_BATCH %s\n"
+             "EVAL_BATCH /nonexistent/points\n", path);
+    bool calc = CalcOutputs(input, expected,
+                            "ERROR 2 EVAL_BATCH WRONG POINT\n"
+                            "ERROR 3 EVAL_BATCH WRONG FILE\n");
+    unlink(path);
+    free(expected);
+    CHECK(calc);
+    return true;
+}
+
+/**
+ * Składa wielomiany wprost z definicji: sumuje złożenia współczynników
+ * pomnożone przez potęgi podstawianych wielomianów.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] k : liczba wielomianów @f$q_i@f$
+ * @param[in] q : wielomiany @f$q_0, q_1, \ldots, q_{k-1}@f$
+ * @return @f$p(q_0, q_1, \ldots, q_{k-1}, 0, 0, \ldots)@f$
+ */
+static Poly ReferenceCompose(const Poly *p, size_t k, const Poly q[]) {
+    if (PolyIsCoeff(p)) return PolyClone(p);
+    Poly res = PolyZero();
+    for (size_t i = 0; i < p->size; i++) {
+        Poly coeff = k > 0 ? ReferenceCompose(&p->arr[i].p, k - 1, q + 1)
+                           : ReferenceCompose(&p->arr[i].p, 0, q);
+        Poly power = k > 0 ? PowByMul(&q[0], p->arr[i].exp)
+                           : PolyFromCoeff(p->arr[i].exp == 0 ? 1 : 0);
+        Poly term = PolyMul(&coeff, &power);
+        Poly sum = PolyAdd(&res, &term);
+        PolyDestroy(&coeff);
+        PolyDestroy(&power);
+        PolyDestroy(&term);
+        PolyDestroy(&res);
+        res = sum;
+    }
+    return res;
+}
+
+/**
+ * Sprawdza, czy PolyCompose() daje to samo co ReferenceCompose().
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] k : liczba wielomianów @f$q_i@f$
+ * @param[in] q : wielomiany @f$q_0, q_1, \ldots, q_{k-1}@f$
+ * @return Czy złożenia są równe?
+ */
+static bool ComposeMatchesReference(const Poly *p, size_t k, const Poly q[]) {
+    Poly res = PolyCompose(p, k, q), expected = ReferenceCompose(p, k, q);
+    bool equal = PolyIsEq(&res, &expected);
+    PolyDestroy(&res);
+    PolyDestroy(&expected);
+    return equal;
+}
+
+/**
+ * Sprawdza składanie wielomianów: złożenia przykładowych i pseudolosowych
+ * wielomianów z różną liczbą podstawianych wielomianów, także mniejszą
+ * i większą od liczby zmiennych, oraz polecenie "COMPOSE" kalkulatora.
+ * @return Czy test się powiódł?
+ */
+static bool TestCompose(void) {
+    enum { MAX_K = 4 };
+    random_state = 14;
+    Poly q[MAX_K];
+    for (size_t i = 0; i < MAX_K; i++) {
+        q[i] = RandomPoly(i % 3 + 1, 3, 2, 5);
+    }
+    for (size_t s = 0; s < SAMPLES_COUNT + 3; s++) {
+        Poly p = s < SAMPLES_COUNT ? P(samples[s])
+                                   : RandomPoly(s - SAMPLES_COUNT + 1, 20, 6,
+                                                100);
+        for (size_t k = 0; k <= MAX_K; k++) {
+            CHECK(ComposeMatchesReference(&p, k, q));
+        }
+        PolyDestroy(&p);
+    }
+    for (size_t i = 0; i < MAX_K; i++) {
+        PolyDestroy(&q[i]);
+    }
+
+    // p(x_0, x_1) = x_0^2 + x_0 x_1 + 3, złożone z x_0 + 1 i x_0 - 1.
+    CHECK(CalcOutputs("(1,1)+(1,0)\n(1,1)+(-1,0)\n((1,1),1)+(1,2)+(3,0)\n"
+                      "COMPOSE 2\nPRINT\n(1,1)\nCOMPOSE 0\nPRINT\nCOMPOSE 2\n"
+                      "COMPOSE\nCOMPOSE -1\nCOMPOSE 1a\n"
+                      "COMPOSE 18446744073709551615\n"
+                      "COMPOSE 18446744073709551616\n",
+                      "(3,0)+(2,1)+(2,2)\n0\n",
+                      "ERROR 9 STACK UNDERFLOW\n"
+                      "ERROR 10 COMPOSE WRONG PARAMETER\n"
+                      "ERROR 11 COMPOSE WRONG PARAMETER\n"
+                      "ERROR 12 COMPOSE WRONG PARAMETER\n"
+                      "ERROR 13 STACK UNDERFLOW\n"
+                      "ERROR 14 COMPOSE WRONG PARAMETER\n"));
+    return true;
+}
+
+/**
+ * Sposób współdzielenia pamięci przez wielomian przekazywany funkcji, która
+ * przejmuje go na własność (patrz: OwnArg()).
+ */
+typedef enum Sharing {
+    UNIQUE,         ///< wielomian jest jedynym właścicielem swojej pamięci
+    SHARED,         ///< tablica jednomianów jest współdzielona
+    SHARED_MONOS,   ///< współczynniki jednomianów są współdzielone
+    INTERNED,       ///< wielomian jest internowany (patrz: PolySetInterning())
+} Sharing;
+
+/**
+ * Tworzy wielomian zapisany w tekście, współdzielący pamięć z wielomianem
+ * @p keep w zadany sposób. Po działaniu na wielomianie @p keep musi nadal
+ * być równy wielomianowi zapisanemu w tekście.
+ * @param[in] text : tekst wielomianu
+ * @param[in] sharing : sposób współdzielenia pamięci
+ * @param[out] keep : wielomian współdzielący pamięć z wynikiem
+ * @return wielomian
+ */
+static Poly OwnArg(const char *text, Sharing sharing, Poly *keep) {
+    PolySetInterning(sharing == INTERNED);
+    *keep = P(text);
+    Poly res;
+    if (sharing == UNIQUE || sharing == INTERNED) {
+        res = P(text);
+    }
+    else if (sharing == SHARED || PolyIsCoeff(keep)) {
+        res = PolyClone(keep);
+    }
+    else {
+        res = PolyCloneMonos(keep->size, keep->arr);
+    }
+    PolySetInterning(false);
+    return res;
+}
+
+/**
+ * Sprawdza, czy działanie przejmujące argumenty na własność daje ten sam
+ * wynik co działanie, które ich nie zmienia, i nie zmienia wielomianów
+ * współdzielących z nimi pamięć.
+ * @param[in] op : działanie niezmieniające argumentów
+ * @param[in] own_op : działanie przejmujące argumenty na własność
+ * @param[in] p_text : tekst wielomianu @f$p@f$
+ * @param[in] q_text : tekst wielomianu @f$q@f$
+ * @param[in] sharing : sposób współdzielenia pamięci przez argumenty
+ * @return Czy wyniki są równe, a wielomiany współdzielące pamięć
+ * niezmienione?
+ */
+static bool OwnMatches(Poly (*op)(const Poly *, const Poly *),
+                       Poly (*own_op)(Poly *, Poly *), const char *p_text,
+                       const char *q_text, Sharing sharing) {
+    Poly p = P(p_text), q = P(q_text);
+    Poly expected = op(&p, &q);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    Poly p_keep, q_keep;
+    p = OwnArg(p_text, sharing, &p_keep);
+    q = OwnArg(q_text, sharing, &q_keep);
+    PolySetInterning(sharing == INTERNED);
+    Poly res = own_op(&p, &q);
+    PolySetInterning(false);
+    bool equal = PolyIsEq(&res, &expected);
+    PolyDestroy(&res);
+    PolyDestroy(&expected);
+    bool p_kept = PolyIsText(p_keep, p_text);
+    return PolyIsText(q_keep, q_text) && p_kept && equal;
+}
+
+/**
+ * Sprawdza działanie przejmujące na własność dwa argumenty, z których drugi
+ * jest kopią pierwszego, czyli współdzieli z nim tablicę jednomianów.
+ * @param[in] op : działanie niezmieniające argumentów
+ * @param[in] own_op : działanie przejmujące argumenty na własność
+ * @param[in] text : tekst wielomianu
+ * @return Czy wynik jest równy wynikowi działania niezmieniającego
+ * argumentów?
+ */
+static bool OwnSelfMatches(Poly (*op)(const Poly *, const Poly *),
+                           Poly (*own_op)(Poly *, Poly *), const char *text) {
+    Poly p = P(text);
+    Poly expected = op(&p, &p), q = PolyClone(&p);
+    Poly res = own_op(&p, &q);
+    bool equal = PolyIsEq(&res, &expected);
+    PolyDestroy(&res);
+    PolyDestroy(&expected);
+    return equal;
+}
+
+/**
+ * Sprawdza PolyAddOwn(), PolySubOwn() i PolyMulOwn() z PolyAdd(), PolySub()
+ * i PolyMul() dla wszystkich par wielomianów z tablicy @p samples,
+ * przekazywanych na każdy ze sposobów współdzielenia pamięci.
+ * @return Czy test się powiódł?
+ */
+static bool TestOwnBinary(void) {
+    for (Sharing s = UNIQUE; s <= INTERNED; s++) {
+        for (size_t i = 0; i < SAMPLES_COUNT; i++) {
+            for (size_t j = 0; j < SAMPLES_COUNT; j++) {
+                const char *p = samples[i], *q = samples[j];
+                CHECK(OwnMatches(PolyAdd, PolyAddOwn, p, q, s));
+                CHECK(OwnMatches(PolySub, PolySubOwn, p, q, s));
+                CHECK(OwnMatches(PolyMul, PolyMulOwn, p, q, s));
+            }
+        }
+    }
+    for (size_t i = 0; i < SAMPLES_COUNT; i++) {
+        CHECK(OwnSelfMatches(PolyAdd, PolyAddOwn, samples[i]));
+        CHECK(OwnSelfMatches(PolySub, PolySubOwn, samples[i]));
+        CHECK(OwnSelfMatches(PolyMul, PolyMulOwn, samples[i]));
+    }
+    return true;
+}
+
+/**
+ * Sprawdza PolyNegOwn() z PolyNeg() i PolyAtOwn() z PolyAt() dla wielomianów
+ * z tablicy @p samples, przekazywanych na każdy ze sposobów współdzielenia
+ * pamięci.
+ * @return Czy test się powiódł?
+ */
+static bool TestOwnUnary(void) {
+    static const poly_coeff_t points[] = {0, 1, -2, 3};
+    size_t points_count = sizeof(points) / sizeof(points[0]);
+    for (Sharing s = UNIQUE; s <= INTERNED; s++) {
+        for (size_t i = 0; i < SAMPLES_COUNT; i++) {
+            Poly p = P(samples[i]), keep;
+            Poly expected = PolyNeg(&p), arg = OwnArg(samples[i], s, &keep);
+            PolySetInterning(s == INTERNED);
+            Poly res = PolyNegOwn(&arg);
+            PolySetInterning(false);
+            CHECK(PolyIsEq(&res, &expected));
+            CHECK(PolyIsText(keep, samples[i]));
+            PolyDestroy(&res);
+            PolyDestroy(&expected);
+
+            for (size_t k = 0; k < points_count; k++) {
+                expected = PolyAt(&p, points[k]);
+                arg = OwnArg(samples[i], s, &keep);
+                PolySetInterning(s == INTERNED);
+                res = PolyAtOwn(&arg, points[k]);
+                PolySetInterning(false);
+                CHECK(PolyIsEq(&res, &expected));
+                CHECK(PolyIsText(keep, samples[i]));
+                PolyDestroy(&res);
+                PolyDestroy(&expected);
+            }
+            PolyDestroy(&p);
+        }
+    }
+    return true;
+}
+
+/**
+ * Sprawdza argumenty poleceń ROT i PICK: ROT 0 jest odrzucane, a ROT
+ * i PICK wymagają odpowiednio @f$n@f$ i @f$n + 1@f$ wielomianów na stosie.
+ * @return Czy test się powiódł?
+ */
+static bool TestStackArgs(void) {
+    const char *input = "1\n2\n3\nROT 0\nROT 3\nPRINT\nROT 1\nPRINT\nROT 4\n"
+                        "ROT -1\nPICK 0\nPRINT\nPICK 3\nPICK 5\nPRINT\n";
+    const char *out = "1\n1\n1\n2\n";
+    const char *err = "ERROR 4 ROT WRONG PARAMETER\n"
+                      "ERROR 9 STACK UNDERFLOW\n"
+                      "ERROR 10 ROT WRONG PARAMETER\n"
+                      "ERROR 14 STACK UNDERFLOW\n";
+    CHECK(CalcOutputs(input, out, err));
+    CHECK(LazyCalcOutputs(input, out, err));
+    return true;
+}
+
+/**
+ * Sprawdza, czy kalkulator wypisuje to samo, gdy polecenia wczytuje ze
+ * strumienia i gdy wczytuje je z odwzorowanego w pamięci pliku (opcja
+ * "--script").
+ * @param[in] input : polecenia
+ * @param[in] len : długość poleceń
+ * @return Czy wyniki są takie same?
+ */
+static bool ScriptMatchesStream(const char *input, size_t len) {
+    char path[] = "/tmp/poly_test_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd == -1) return false;
+    bool written = write(fd, input, len) == (ssize_t) len;
+    close(fd);
+    LineReader script;
+    bool opened = written && LineReaderOpen(&script, path);
+    unlink(path);
+    if (!opened) return false;
+    char *script_out, *script_err;
+    CalcRun(&script, &script_out, &script_err);
+
+    FILE *in = fmemopen((void *) input, len, "r");
+    if (in == NULL) exit(1);
+    LineReader stream;
+    LineReaderFromStream(&stream, in);
+    char *stream_out, *stream_err;
+    CalcRun(&stream, &stream_out, &stream_err);
+    fclose(in);
+
+    bool res = strcmp(script_out, stream_out) == 0 &&
+               strcmp(script_err, stream_err) == 0;
+    free(script_out);
+    free(script_err);
+    free(stream_out);
+    free(stream_err);
+    return res;
+}
+
+/**
+ * Sprawdza wczytywanie poleceń z pliku (opcja "--script"): pusty plik,
+ * ostatni wiersz bez znaku nowej linii (także z argumentem polecenia, który
+ * kończy się razem z odwzorowaniem), wiersze ze znakiem '\0', puste
+ * wiersze i komentarze oraz plik zajmujący wiele stron pamięci.
+ * @return Czy test się powiódł?
+ */
+static bool TestScriptInput(void) {
+    static const char *const inputs[] = {
+        "",
+        "\n",
+        "(1,1)\nPRINT",
+        "(1,1)\n# komentarz\n\nCLONE\nADD\nPRINT\nDEG\n",
+        "(1,2)\nEVAL_BATCH -\n1\n2\nEND\nPRINT\nEVAL_BATCH -\n3",
+        "PRINT\nPOP\nFOO\n(1,\n",
+        "(1,1)\nAT 3",
+        "(1,2)\nAT_MULTI 1 -2",
+        "(1,1)\nPOW 12\nDEG_BY 0",
+        "(1,1)\nEVAL_BATCH -\n7",
+        "(1,1)\n(2,3)+(4,5)",
+    };
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+        CHECK(ScriptMatchesStream(inputs[i], strlen(inputs[i])));
+    }
+    CHECK(CalcOutputs(inputs[3], "(2,1)\n1\n", ""));
+    CHECK(CalcOutputs("(1,1)\nPOW 12\nDEG_BY 0", "12\n", ""));
+    static const char with_zero[] = "1\nPRI\0NT\n(1,1)\0\nPRINT\n";
+    CHECK(ScriptMatchesStream(with_zero, sizeof(with_zero) - 1));
+
+    // Wiele stron poleceń; ostatni wiersz nie ma znaku nowej linii.
+    enum { LINES = 100000 };
+    char *big = malloc(LINES * 16);
+    if (big == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    size_t len = 0;
+    for (size_t i = 0; i < LINES; i++) {
+        if (i % 2 == 0) len += (size_t) sprintf(big + len, "(%zu,1)\n", i);
+        else len += (size_t) sprintf(big + len, "ADD\n");
+    }
+    len += (size_t) sprintf(big + len, "PRINT");
+    bool big_matches = ScriptMatchesStream(big, len);
+    free(big);
+    CHECK(big_matches);
+    return true;
+}
+
+/**
+ * Sprawdza, czy binarny zapis wielomianu daje poprawny widok równy temu
+ * wielomianowi i czy działania na widoku dają te same wyniki co działania na
+ * wielomianie.
+ * @param[in] p : wielomian
+ * @return Czy zapis jest poprawny i zgodny z wielomianem?
+ */
+static bool BinaryRoundTrips(const Poly *p) {
+    size_t size;
+    uint64_t *data = PolyToBinary(p, &size);
+    PolyView view;
+    bool res = PolyViewFromBinary(data, size, &view);
+    if (res) {
+        Poly copy = PolyViewToPoly(view);
+        Poly at = PolyAt(p, -3), view_at = PolyViewAt(view, -3);
+        res = PolyIsEq(&copy, p) && PolyViewIsEqPoly(view, p) &&
+              PolyViewDeg(view) == PolyDeg(p) &&
+              PolyViewIsCoeff(view) == PolyIsCoeff(p) &&
+              PolyIsEq(&at, &view_at);
+        // Równe wielomiany mają identyczne zapisy.
+        size_t copy_size;
+        uint64_t *copy_data = PolyToBinary(&copy, &copy_size);
+        res = res && copy_size == size && memcmp(copy_data, data, size) == 0;
+        free(copy_data);
+        PolyDestroy(&copy);
+        PolyDestroy(&at);
+        PolyDestroy(&view_at);
+    }
+    free(data);
+    return res;
+}
+
+/**
+ * Sprawdza binarny zapis wielomianów z tablicy @p samples i wielomianów
+ * o dużych współczynnikach, w pamięci i w pliku, także poleceniami SAVE
+ * i LOAD kalkulatora.
+ * @return Czy test się powiódł?
+ */
+static bool TestBinaryRoundTrip(void) {
+    for (size_t i = 0; i < SAMPLES_COUNT; i++) {
+        Poly p = P(samples[i]);
+        CHECK(BinaryRoundTrips(&p));
+        PolyDestroy(&p);
+    }
+    char path[] = "/tmp/poly_test_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd != -1);
+    close(fd);
+    for (size_t i = 0; i < BIG_SAMPLES_COUNT; i++) {
+        Poly p = BigSample(i);
+        CHECK(BinaryRoundTrips(&p));
+        PolyFile file;
+        CHECK(PolySave(&p, path));
+        CHECK(PolyFileOpen(&file, path));
+        CHECK(PolyViewIsEqPoly(file.root, &p));
+        PolyFileClose(&file);
+        PolyDestroy(&p);
+    }
+
+    char input[256];
+    snprintf(input, sizeof(input), "((2,1)+(7,0),3)+(-1,0)\nSAVE %s\nLOAD %s\n"
+             "IS_EQ\nZERO\nSAVE %s\nLOAD %s\nPRINT\n", path, path, path, path);
+    bool calc = CalcOutputs(input, "1\n0\n", "");
+    unlink(path);
+    CHECK(calc);
+    return true;
+}
+
+/**
+ * Sprawdza, czy niepoprawne binarne zapisy są odrzucane: z błędnym
+ * nagłówkiem, ucięte, z nadmiarowymi słowami i uszkodzone. Uszkodzony zapis,
+ * który okazał się poprawny, musi dać się zamienić na wielomian.
+ * @return Czy test się powiódł?
+ */
+static bool TestBinaryCorrupt(void) {
+    Poly p = BigSample(2);
+    size_t size;
+    uint64_t *data = PolyToBinary(&p, &size);
+    PolyDestroy(&p);
+    size_t count = size / sizeof(uint64_t);
+    uint64_t *copy = calloc(count + 1, sizeof(uint64_t));
+    CHECK(copy != NULL);
+    memcpy(copy, data, size);
+    PolyView view;
+    CHECK(PolyViewFromBinary(copy, size, &view));
+    for (size_t len = 0; len < size; len++) {
+        CHECK(!PolyViewFromBinary(copy, len, &view));
+    }
+    CHECK(!PolyViewFromBinary(copy, size + sizeof(uint64_t), &view));
+
+    for (size_t i = 0; i < count; i++) {
+        for (unsigned bit = 0; bit < 64; bit++) {
+            copy[i] = data[i] ^ ((uint64_t) 1 << bit);
+            bool valid = PolyViewFromBinary(copy, size, &view);
+            // Nagłówek musi być dokładnie taki, jak zapisany.
+            CHECK(i >= 2 || !valid);
+            if (valid) {
+                Poly q = PolyViewToPoly(view);
+                PolyDestroy(&q);
+            }
+        }
+        copy[i] = data[i];
+    }
+    free(copy);
+
+    char path[] = "/tmp/poly_test_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd != -1);
+    bool written = write(fd, data, size / 2) == (ssize_t) (size / 2);
+    close(fd);
+    free(data);
+    PolyFile file;
+    bool opened = PolyFileOpen(&file, path);
+    char input[256];
+    snprintf(input, sizeof(input), "LOAD %s\nLOAD /nonexistent/poly\n", path);
+    bool calc = CalcOutputs(input, "", "ERROR 1 LOAD WRONG FILE\n"
+                            "ERROR 2 LOAD WRONG FILE\n");
+    unlink(path);
+    CHECK(written && !opened && calc);
+    return true;
+}
+
+/**
+ * Sprawdza, czy polecenia "SAVE" i "LOAD" odrzucają pustą ścieżkę pliku
+ * i ścieżkę złożoną z samych białych znaków.
+ * @return Czy test się powiódł?
+ */
+static bool TestFileArgs(void) {
+    CHECK(CalcOutputs("1\nSAVE\nSAVE \nSAVE  \t\nLOAD\nLOAD  \nPRINT\n", "1\n",
+                      "ERROR 2 SAVE WRONG FILE\n"
+                      "ERROR 3 SAVE WRONG FILE\n"
+                      "ERROR 4 SAVE WRONG FILE\n"
+                      "ERROR 5 LOAD WRONG FILE\n"
+                      "ERROR 6 LOAD WRONG FILE\n"));
+    CHECK(access(" ", F_OK) != 0);
+    return true;
+}
+
+/**
+ * Daje liczbę tablic jednomianów wielomianu i jego współczynników.
+ * @param[in] p : wielomian
+ * @return liczba tablic jednomianów
+ */
+static size_t MonoArrays(const Poly *p) {
+    if (PolyIsCoeff(p)) return 0;
+    size_t res = 1;
+    for (size_t i = 0; i < p->size; i++) res += MonoArrays(&p->arr[i].p);
+    return res;
+}
+
+/**
+ * Sprawdza, czy PolyViewAt() daje ten sam wynik co PolyAt() i czy
+ * przydziela jedynie tablice jednomianów wyniku.
+ * @param[in] p : wielomian
+ * @param[in] x : wartość argumentu
+ * @return Czy wynik jest poprawny i nie było innych przydziałów?
+ */
+static bool ViewAtAllocatesResult(const Poly *p, poly_coeff_t x) {
+    size_t size;
+    uint64_t *data = PolyToBinary(p, &size);
+    PolyView view;
+    bool res = PolyViewFromBinary(data, size, &view);
+    if (res) {
+        size_t before = MonoAllocCount();
+        Poly view_at = PolyViewAt(view, x);
+        size_t allocs = MonoAllocCount() - before;
+        Poly at = PolyAt(p, x);
+        res = PolyIsEq(&at, &view_at) && allocs == MonoArrays(&view_at);
+        PolyDestroy(&at);
+        PolyDestroy(&view_at);
+    }
+    free(data);
+    return res;
+}
+
+/**
+ * Sprawdza, czy PolyViewAt() przydziela jedynie tablice jednomianów wyniku,
+ * także gdy współczynniki wyniku się znoszą.
+ * @return Czy test się powiódł?
+ */
+static bool TestViewAtAllocs(void) {
+    static const poly_coeff_t xs[] = {-3, -1, 1, 2};
+    for (size_t k = 0; k < sizeof(xs) / sizeof(xs[0]); k++) {
+        for (size_t i = 0; i < SAMPLES_COUNT; i++) {
+            Poly p = P(samples[i]);
+            CHECK(ViewAtAllocatesResult(&p, xs[k]));
+            PolyDestroy(&p);
+        }
+        for (size_t i = 0; i < BIG_SAMPLES_COUNT; i++) {
+            Poly p = BigSample(i);
+            CHECK(ViewAtAllocatesResult(&p, xs[k]));
+            PolyDestroy(&p);
+        }
+    }
+    // Dla x_0 = 1 wielomian x_0(x_1 + 1) - x_1 jest stały.
+    Poly p = P("((1,1)+(1,0),1)+((-1,1),0)");
+    CHECK(ViewAtAllocatesResult(&p, 1));
+    PolyDestroy(&p);
+    return true;
+}
+
+/**
+ * Tworzy wielomian @f$x_0 x_1 \ldots x_{n-1}@f$, w którym współczynniki są
+ * zagnieżdżone na głębokość @p n.
+ * @param[in] n : liczba zmiennych
+ * @return wielomian
+ */
+static Poly NestedPoly(size_t n) {
+    Poly res = PolyFromCoeff(1);
+    for (size_t i = 0; i < n; i++) {
+        Mono m = MonoFromPoly(&res, 1);
+        res = PolyAddMonos(1, &m);
+    }
+    return res;
+}
+
+/**
+ * Sprawdza, czy binarny zapis wielomianu zagnieżdżonego na największą
+ * dozwoloną głębokość jest poprawny, a głębszego - odrzucany, oraz czy
+ * stopień widoku jest nasycany tak jak stopień wielomianu.
+ * @return Czy test się powiódł?
+ */
+static bool TestViewLimits(void) {
+    Poly p = NestedPoly(POLY_VIEW_MAX_DEPTH);
+    size_t size;
+    uint64_t *data = PolyToBinary(&p, &size);
+    PolyView view;
+    CHECK(PolyViewFromBinary(data, size, &view));
+    CHECK(PolyViewDeg(view) == POLY_VIEW_MAX_DEPTH);
+    Poly at = PolyAt(&p, 2), view_at = PolyViewAt(view, 2);
+    CHECK(PolyIsEq(&at, &view_at));
+    PolyDestroy(&at);
+    PolyDestroy(&view_at);
+    free(data);
+    PolyDestroy(&p);
+
+    char path[] = "/tmp/poly_test_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd != -1);
+    close(fd);
+    p = NestedPoly(POLY_VIEW_MAX_DEPTH + 1);
+    data = PolyToBinary(&p, &size);
+    bool valid = PolyViewFromBinary(data, size, &view);
+    bool saved = PolySave(&p, path);
+    free(data);
+    PolyDestroy(&p);
+    unlink(path);
+    CHECK(!valid && !saved);
+
+    p = P("((1,2147483647),2147483647)");
+    data = PolyToBinary(&p, &size);
+    CHECK(PolyViewFromBinary(data, size, &view));
+    CHECK(PolyViewDeg(view) == INT_MAX && PolyDeg(&p) == INT_MAX);
+    free(data);
+    PolyDestroy(&p);
+    return true;
+}
+
+/**
+ * Sprawdza, czy działanie w rozłożonej reprezentacji daje ten sam wynik co
+ * działanie w rekurencyjnej reprezentacji i nie zmienia wielomianów
+ * współdzielących pamięć z argumentami.
+ * @param[in] op : działanie w rekurencyjnej reprezentacji
+ * @param[in] flat_op : działanie w rozłożonej reprezentacji
+ * @param[in] p_text : tekst wielomianu @f$p@f$
+ * @param[in] q_text : tekst wielomianu @f$q@f$
+ * @param[in] sharing : sposób współdzielenia pamięci przez argumenty
+ * @return Czy wyniki są równe, a wielomiany współdzielące pamięć
+ * niezmienione?
+ */
+static bool FlatMatches(Poly (*op)(const Poly *, const Poly *),
+                        Poly (*flat_op)(const Poly *, const Poly *),
+                        const char *p_text, const char *q_text,
+                        Sharing sharing) {
+    Poly p = P(p_text), q = P(q_text);
+    Poly expected = op(&p, &q);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    Poly p_keep, q_keep;
+    p = OwnArg(p_text, sharing, &p_keep);
+    q = OwnArg(q_text, sharing, &q_keep);
+    PolySetInterning(sharing == INTERNED);
+    Poly res = flat_op(&p, &q);
+    PolySetInterning(false);
+    bool equal = PolyIsEq(&res, &expected);
+    PolyDestroy(&res);
+    PolyDestroy(&expected);
+    bool kept = PolyIsText(p, p_text) && PolyIsText(q, q_text);
+    bool p_kept = PolyIsText(p_keep, p_text);
+    return PolyIsText(q_keep, q_text) && p_kept && kept && equal;
+}
+
+/**
+ * Sprawdza PolyFlatAdd(), PolyFlatSub() i PolyFlatMul() z PolyAdd(),
+ * PolySub() i PolyMul() dla wszystkich par wielomianów z tablicy
+ * @p samples, przekazywanych na każdy ze sposobów współdzielenia pamięci,
+ * także gdy wykładników iloczynu nie można spakować, oraz wykonywanie
+ * poleceń kalkulatora w rozłożonej reprezentacji.
+ * @return Czy test się powiódł?
+ */
+static bool TestFlatOps(void) {
+    for (Sharing s = UNIQUE; s <= INTERNED; s++) {
+        for (size_t i = 0; i < SAMPLES_COUNT; i++) {
+            for (size_t j = 0; j < SAMPLES_COUNT; j++) {
+                const char *p = samples[i], *q = samples[j];
+                CHECK(FlatMatches(PolyAdd, PolyFlatAdd, p, q, s));
+                CHECK(FlatMatches(PolySub, PolyFlatSub, p, q, s));
+                CHECK(FlatMatches(PolyMul, PolyFlatMul, p, q, s));
+            }
+        }
+    }
+    // Osiem zmiennych ma pola ośmiobitowe: x_0^200 mieści się w polu,
+    // a x_0^400 już nie.
+    const char *deep = "((((((((1,1),0),0),0),0),0),0),200)+(1,0)";
+    for (Sharing s = UNIQUE; s <= INTERNED; s++) {
+        CHECK(FlatMatches(PolyAdd, PolyFlatAdd, deep, deep, s));
+        CHECK(FlatMatches(PolyMul, PolyFlatMul, deep, deep, s));
+        CHECK(FlatMatches(PolyMul, PolyFlatMul, deep, samples[8], s));
+    }
+
+    UseFlatEngine(true);
+    bool calc = CalcOutputs("(1,1)+(1,0)\nCLONE\nMUL\nCLONE\nADD\nPRINT\n"
+                            "(1,1)\nSUB\nPRINT\n",
+                            "(2,0)+(4,1)+(2,2)\n(-2,0)+(-3,1)+(-2,2)\n", "");
+    UseFlatEngine(false);
+    CHECK(calc);
+    return true;
+}
+
+/**
+ * Sprawdza FlatSumOfProducts() z wynikiem działań w rekurencyjnej
+ * reprezentacji: @f$ab + c - bc@f$ dla wszystkich trójek wielomianów
+ * z tablicy @p samples.
+ * @return Czy test się powiódł?
+ */
+static bool TestFlatSumOfProducts(void) {
+    for (size_t i = 0; i < SAMPLES_COUNT; i++) {
+        for (size_t j = 0; j < SAMPLES_COUNT; j++) {
+            for (size_t k = 0; k < SAMPLES_COUNT; k++) {
+                Poly a = P(samples[i]), b = P(samples[j]), c = P(samples[k]);
+                Poly ab = PolyMul(&a, &b), bc = PolyMul(&b, &c);
+                Poly sum = PolyAdd(&ab, &c), expected = PolySubOwn(&sum, &bc);
+                PolyDestroy(&ab);
+
+                size_t nvars = 1;
+                const Poly *polys[] = {&a, &b, &c};
+                for (size_t t = 0; t < 3; t++) {
+                    size_t vars = PolyEvalVars(polys[t]);
+                    if (vars > nvars) nvars = vars;
+                }
+                FlatPoly fa, fb, fc, res;
+                CHECK(FlatFromPoly(&a, nvars, &fa));
+                CHECK(FlatFromPoly(&b, nvars, &fb));
+                CHECK(FlatFromPoly(&c, nvars, &fc));
+                FlatTerm terms[] = {{.a = &fa, .b = &fb, .negate = false},
+                                    {.a = &fc, .b = NULL, .negate = false},
+                                    {.a = &fb, .b = &fc, .negate = true}};
+                CHECK(FlatSumOfProducts(terms, 3, nvars, &res));
+                Poly flat = FlatToPoly(&res);
+                CHECK(PolyIsEq(&flat, &expected));
+                PolyDestroy(&flat);
+                PolyDestroy(&expected);
+                FlatDestroy(&fa);
+                FlatDestroy(&fb);
+                FlatDestroy(&fc);
+                PolyDestroy(&a);
+                PolyDestroy(&b);
+                PolyDestroy(&c);
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Sprawdza polecenie "EVAL_BATCH -" przy pustym stosie w trybie leniwym: brak
+ * wielomianu jest zgłaszany tak jak w trybie zwykłym, a wiersze z punktami
+ * są pomijane.
+ * @return Czy test się powiódł?
+ */
+static bool TestLazyEvalBatchUnderflow(void) {
+    const char *input = "EVAL_BATCH -\n1 2\nEND\n";
+    CHECK(CalcOutputs(input, "", "ERROR 1 STACK UNDERFLOW\n"));
+    CHECK(LazyCalcOutputs(input, "", "ERROR 1 STACK UNDERFLOW\n"));
+    CHECK(LazyCalcOutputs("(1,1)\n2\nADD\nEVAL_BATCH -\n3\nEND\nPRINT\n",
+                          "5\n(2,0)+(1,1)\n", ""));
+    return true;
+}
+
+/**
+ * Sprawdza, że polecenia "SWAP", "ROT" i "PICK" w trybie leniwym przenoszą
+ * i kopiują nieobliczone wyrażenia razem z ich miejscem na stosie, a wynik
+ * jest taki sam jak w trybie zwykłym.
+ * @return Czy test się powiódł?
+ */
+static bool TestLazyStackOps(void) {
+    const char *input = "(1,1)\n2\nMUL\n3\nSWAP\nPRINT\nROT 2\nPRINT\n"
+                        "(1,2)\n6\nADD\n4\nNEG\nROT 4\nPRINT\nPICK 2\n"
+                        "PRINT\nPOP\nSWAP\nPRINT\nADD\nADD\nPRINT\n";
+    const char *out = "(2,1)\n3\n(2,1)\n(6,0)+(1,2)\n-4\n"
+                      "(2,0)+(2,1)+(1,2)\n";
+    CHECK(CalcOutputs(input, out, ""));
+    CHECK(LazyCalcOutputs(input, out, ""));
+    return true;
+}
+
+/**
+ * Liczba działań w długich łańcuchach poleceń testu TestLazyLongChains().
+ */
+#define LONG_CHAIN_LENGTH 100000
+
+/**
+ * Sprawdza, czy w trybie leniwym obliczane są długie łańcuchy mnożeń oraz
+ * przeplatanych odejmowań i mnożeń. Głębokość rekurencji przy ich obliczaniu
+ * nie może zależeć od długości łańcucha.
+ * @return Czy test się powiódł?
+ */
+static bool TestLazyLongChains(void) {
+    char *input;
+    size_t len;
+    FILE *stream = open_memstream(&input, &len);
+    if (stream == NULL) exit(1);
+    fputs("(1,1)\n", stream);
+    for (size_t i = 0; i < LONG_CHAIN_LENGTH; i++) fputs("1\nMUL\n", stream);
+    fputs("PRINT\nPOP\n1\n", stream);
+    for (size_t i = 0; i < LONG_CHAIN_LENGTH; i++) {
+        fputs(i % 2 == 0 ? "1\nSUB\n" : "-1\nMUL\n", stream);
+    }
+    fputs("PRINT\n", stream);
+    fclose(stream);
+    // Naprzemienne 1 - x i -1 * x dają po każdej parze działań x - 1.
+    const char *out = "(1,1)\n-49999\n";
+    bool res = CalcOutputs(input, out, "") && LazyCalcOutputs(input, out, "");
+    free(input);
+    return res;
+}
+
+/**
+ * Wylicza stopień wielomianu ze względu na zmienną rekurencyjnie, bez
+ * korzystania z danych wielomianu.
+ * @param[in] p : wielomian
+ * @param[in] var_idx : indeks zmiennej
+ * @return stopień wielomianu @p p ze względu na zmienną o indeksie @p var_idx
+ */
+static poly_exp_t ReferenceDegBy(const Poly *p, size_t var_idx) {
+    if (PolyIsCoeff(p)) return PolyIsZero(p) ? -1 : 0;
+    poly_exp_t deg = -1;
+    for (size_t i = 0; i < p->size; i++) {
+        poly_exp_t mono_deg = var_idx == 0 ?
+                              p->arr[i].exp :
+                              ReferenceDegBy(&p->arr[i].p, var_idx - 1);
+        if (mono_deg > deg) deg = mono_deg;
+    }
+    return deg;
+}
+
+/**
+ * Wylicza stopień wielomianu rekurencyjnie, bez korzystania z danych
+ * wielomianu.
+ * @param[in] p : wielomian
+ * @return stopień wielomianu @p p
+ */
+static poly_exp_t ReferenceDeg(const Poly *p) {
+    if (PolyIsCoeff(p)) return PolyIsZero(p) ? -1 : 0;
+    poly_exp_t deg = -1;
+    for (size_t i = 0; i < p->size; i++) {
+        poly_exp_t mono_deg = ReferenceDeg(&p->arr[i].p) + p->arr[i].exp;
+        if (mono_deg > deg) deg = mono_deg;
+    }
+    return deg;
+}
+
+/**
+ * Wylicza liczbę niezerowych współczynników liczbowych wielomianu
+ * rekurencyjnie, bez korzystania z danych wielomianu.
+ * @param[in] p : wielomian
+ * @return liczba wyrazów wielomianu @p p
+ */
+static size_t ReferenceTermCount(const Poly *p) {
+    if (PolyIsCoeff(p)) return PolyIsZero(p) ? 0 : 1;
+    size_t terms = 0;
+    for (size_t i = 0; i < p->size; i++) {
+        terms += ReferenceTermCount(&p->arr[i].p);
+    }
+    return terms;
+}
+
+/**
+ * Liczba początkowych zmiennych, których stopnie zapamiętywane są w danych
+ * wielomianu (patrz: poly.c).
+ */
+#define META_LEVELS 3
+
+/**
+ * Sprawdza, czy dane wielomianu zgadzają się z wartościami wyliczonymi
+ * rekurencyjnie dla zmiennych o indeksach mniejszych od @p vars.
+ * @param[in] p : wielomian
+ * @param[in] vars : liczba sprawdzanych zmiennych
+ * @return Czy dane wielomianu są poprawne?
+ */
+static bool MetaMatchesReference(const Poly *p, size_t vars) {
+    if (PolyDeg(p) != ReferenceDeg(p)) return false;
+    if (PolyTermCount(p) != ReferenceTermCount(p)) return false;
+    for (size_t var = 0; var < vars; var++) {
+        poly_exp_t deg = ReferenceDegBy(p, var);
+        if (PolyDegBy(p, var) != deg) return false;
+        if (PolyHasVar(p, var) != (deg > 0)) return false;
+    }
+    return true;
+}
+
+/**
+ * Sprawdza stopnie, liczbę wyrazów i występowanie zmiennych wyliczane
+ * z danych wielomianu, także dla zmiennych spoza pierwszych
+ * META_LEVELS zmiennych i o indeksach od 63 wzwyż oraz dla stopnia przekraczającego zakres
+ * typu poly_exp_t.
+ * @return Czy test się powiódł?
+ */
+static bool TestPolyMeta(void) {
+    for (size_t i = 0; i < SAMPLES_COUNT; i++) {
+        Poly p = P(samples[i]);
+        CHECK(MetaMatchesReference(&p, META_LEVELS + 2));
+        PolyDestroy(&p);
+    }
+    random_state = 5;
+    for (size_t nvars = 1; nvars <= META_LEVELS + 3; nvars++) {
+        Poly p = RandomPoly(nvars, 50, 20, 10);
+        Poly q = RandomPoly(nvars, 50, 20, 10);
+        Poly sum = PolyAdd(&p, &q), prod = PolyMul(&p, &q);
+        CHECK(MetaMatchesReference(&p, nvars + 1));
+        CHECK(MetaMatchesReference(&sum, nvars + 1));
+        CHECK(MetaMatchesReference(&prod, nvars + 1));
+        PolyDestroy(&p);
+        PolyDestroy(&q);
+        PolyDestroy(&sum);
+        PolyDestroy(&prod);
+    }
+    // x_70^2 * x_0 + 1
+    Poly p = PolyFromCoeff(1);
+    for (size_t var = 70; var-- > 0;) {
+        Mono mono = {.p = p, .exp = var == 69 ? 2 : 0};
+        p = PolyAddMonos(1, &mono);
+    }
+    Mono monos[] = {{.p = p, .exp = 1}, {.p = PolyFromCoeff(1), .exp = 0}};
+    p = PolyAddMonos(2, monos);
+    CHECK(MetaMatchesReference(&p, 75));
+    CHECK(PolyDegBy(&p, 70) == 2 && PolyHasVar(&p, 70));
+    CHECK(PolyDeg(&p) == 3 && PolyTermCount(&p) == 2);
+    PolyDestroy(&p);
+
+    p = P("((-1,0)+(1,2147483647),10)+(-7,11)");
+    CHECK(PolyDeg(&p) == INT_MAX && PolyDegBy(&p, 1) == INT_MAX);
+    PolyDestroy(&p);
+    CHECK(CalcOutputs("((1,3)+(2,0),1)+(5,4)\nDEG\nDEG_BY 0\nDEG_BY 1\n"
+                      "DEG_BY 2\n0\nDEG\nDEG_BY 1\n",
+                      "4\n4\n3\n0\n-1\n-1\n", ""));
+    return true;
+}
+
+/**
+ * Daje liczbę tablic jednomianów przydzielonych przez wywołanie funkcji
+ * @p op dla wielomianów @p p i @p q, tak jak mierzy ją poly_bench.c,
+ * i usuwa wynik z pamięci.
+ * @param[in] op : działanie
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return liczba przydzielonych tablic jednomianów
+ */
+static size_t AllocsOf(Poly (*op)(const Poly *, const Poly *), const Poly *p,
+                       const Poly *q) {
+    size_t before = MonoAllocCount();
+    Poly res = op(p, q);
+    size_t allocs = MonoAllocCount() - before;
+    PolyDestroy(&res);
+    return allocs;
+}
+
+/**
+ * Sprawdza liczby przydzielanych tablic jednomianów, które raportuje
+ * poly_bench.c: kopia wielomianu i zapytania o jego dane nie przydzielają
+ * tablic, a suma, wczytanie i utworzenie wielomianu jednej zmiennej
+ * przydzielają dokładnie jedną.
+ * @return Czy test się powiódł?
+ */
+static bool TestAllocCounts(void) {
+    Poly p = P("(1,0)+(2,2)+(3,4)+(4,6)"), q = P("(5,1)+(6,3)+(7,5)+(8,7)");
+    size_t before = MonoAllocCount();
+    Poly clone = PolyClone(&p);
+    CHECK(PolyIsEq(&clone, &p) && PolyDeg(&clone) == 6);
+    CHECK(PolyDegBy(&clone, 0) == 6 && PolyTermCount(&clone) == 4);
+    PolyDestroy(&clone);
+    CHECK(MonoAllocCount() == before);
+
+    CHECK(AllocsOf(PolyAdd, &p, &q) == 1);
+    CHECK(AllocsOf(PolyMul, &p, &q) == 1);
+    before = MonoAllocCount();
+    Poly monos = PolyCloneMonos(p.size, p.arr);
+    CHECK(MonoAllocCount() == before + 1);
+    PolyDestroy(&monos);
+    before = MonoAllocCount();
+    Poly read = P("(1,0)+(2,1)+(3,2)");
+    CHECK(MonoAllocCount() == before + 1);
+    PolyDestroy(&read);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    return true;
+}
+
+/**
+ * Daje liczbę wykonań poleceń z zadaną opcją z wiersza "STATS" wypisanego
+ * przez polecenie "STATS".
+ * @param[in] text : wyjście kalkulatora
+ * @param[in] name : nazwa opcji
+ * @return liczba wykonań lub 0, jeśli nie ma wiersza opcji
+ */
+static size_t StatsCalls(const char *text, const char *name) {
+    char prefix[32];
+    snprintf(prefix, sizeof(prefix), "STATS %s calls=", name);
+    const char *line = strstr(text, prefix);
+    return line == NULL ? 0 : strtoul(line + strlen(prefix), NULL, 10);
+}
+
+/**
+ * Sprawdza format wierszy "STATS" wyjścia kalkulatora: czas maksymalny nie
+ * przekracza łącznego, granice przedziałów histogramu są rosnącymi potęgami
+ * dwójki, a liczby wykonań w przedziałach sumują się do liczby wykonań.
+ * @param[in] text : wyjście kalkulatora
+ * @return Czy wiersze są poprawne?
+ */
+static bool StatsLinesValid(const char *text) {
+    for (const char *line = strstr(text, "STATS "); line != NULL;
+         line = strstr(line + 1, "\nSTATS ")) {
+        if (*line == '\n') line++;
+        char name[32];
+        size_t calls;
+        unsigned long long total_us, max_us;
+        int len;
+        if (sscanf(line, "STATS %31s calls=%zu total_us=%llu max_us=%llu "
+                         "hist=%n", name, &calls, &total_us, &max_us,
+                   &len) != 4 || max_us > total_us) {
+            return false;
+        }
+        const char *hist = line + len;
+        unsigned long long prev_bound = 0;
+        size_t sum = 0;
+        while (true) {
+            unsigned long long bound;
+            size_t count;
+            if (sscanf(hist, "%llu:%zu%n", &bound, &count, &len) != 2 ||
+                bound <= prev_bound || (bound & (bound - 1)) != 0 ||
+                count == 0) {
+                return false;
+            }
+            prev_bound = bound;
+            sum += count;
+            hist += len;
+            if (*hist != ',') break;
+            hist++;
+        }
+        if (*hist != '\n' || sum != calls) return false;
+    }
+    return true;
+}
+
+/**
+ * Sprawdza polecenie "STATS": liczby wykonań kolejnych opcji (także samego
+ * "STATS") rosną o liczbę ich wykonań, odrzucone polecenia nie są liczone,
+ * wiersze mają poprawny format, a po włączeniu zliczania działań wypisywany
+ * jest wiersz "COUNTERS".
+ * @return Czy test się powiódł?
+ */
+static bool TestStats(void) {
+    static const char *const names[] = {
+        "POLY", "CLONE", "MUL", "PRINT", "POP", "ERROR", "STATS", "ADD",
+    };
+    static const size_t added[] = {2, 1, 2, 1, 1, 0, 1, 0};
+    enum { NAMES_COUNT = sizeof(names) / sizeof(names[0]) };
+    const char *inputs[] = {
+        "STATS\n",
+        "(1,1)\nCLONE\nMUL\nPRINT\n(2,0)\nMUL\nPOP\nFOO\nADD\nSTATS\n",
+    };
+    char *out[2], *err[2];
+    for (size_t i = 0; i < 2; i++) {
+        FILE *in = fmemopen((void *) inputs[i], strlen(inputs[i]), "r");
+        if (in == NULL) exit(1);
+        LineReader reader;
+        LineReaderFromStream(&reader, in);
+        CalcRun(&reader, &out[i], &err[i]);
+        fclose(in);
+    }
+    bool valid = StatsLinesValid(out[0]) && StatsLinesValid(out[1]) &&
+                 strncmp(out[1], "(1,2)\nSTATS ", 12) == 0 &&
+                 strcmp(err[1], "ERROR 8 WRONG COMMAND\n"
+                                "ERROR 9 STACK UNDERFLOW\n") == 0 &&
+                 strstr(out[1], "COUNTERS") == NULL;
+    for (size_t i = 0; i < NAMES_COUNT; i++) {
+        valid = valid && StatsCalls(out[1], names[i]) ==
+                         StatsCalls(out[0], names[i]) + added[i];
+    }
+    for (size_t i = 0; i < 2; i++) {
+        free(out[i]);
+        free(err[i]);
+    }
+    CHECK(valid);
+
+    StatsEnableCounters();
+    const char *input = "(1,3)+(1,1)+(1,2)\nCLONE\nMUL\nSTATS\n";
+    FILE *in = fmemopen((void *) input, strlen(input), "r");
+    if (in == NULL) exit(1);
+    LineReader reader;
+    LineReaderFromStream(&reader, in);
+    char *counters_out, *counters_err;
+    CalcRun(&reader, &counters_out, &counters_err);
+    fclose(in);
+    PolySetCounting(false);
+    const char *counters = strstr(counters_out, "COUNTERS ");
+    size_t monos, mul_calls, sorts;
+    bool counted = counters != NULL &&
+                   sscanf(counters, "COUNTERS monos=%zu mul_calls=%zu "
+                                    "sorts=%zu\n", &monos, &mul_calls,
+                          &sorts) == 3 &&
+                   monos > 0 && mul_calls > 0 && sorts > 0 &&
+                   counters_err[0] == '\0';
+    free(counters_out);
+    free(counters_err);
+    CHECK(counted);
+    return true;
+}
+
+/**
+ * Sprawdza, czy PolyPow() daje to samo co wielokrotne mnożenie dla
+ * wykładników od 0 do @p max_n, i usuwa wielomian z pamięci.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] max_n : największy wykładnik
+ * @return Czy potęgi są równe?
+ */
+static bool PowMatchesMul(Poly p, poly_exp_t max_n) {
+    bool res = true;
+    for (poly_exp_t n = 0; n <= max_n && res; n++) {
+        Poly pow = PolyPow(&p, n), expected = PowByMul(&p, n);
+        res = PolyIsEq(&pow, &expected);
+        PolyDestroy(&pow);
+        PolyDestroy(&expected);
+    }
+    PolyDestroy(&p);
+    return res;
+}
+
+/**
+ * Sprawdza potęgi o wykładnikach 0 i 1 oraz potęgi współczynników
+ * i jednomianów.
+ * @return Czy test się powiódł?
+ */
+static bool TestPowTrivial(void) {
+    Poly p = P("(1,1)+((2,1),0)");
+    CHECK(PolyIsText(PolyPow(&p, 0), "1"));
+    CHECK(PolyIsText(PolyPow(&p, 1), "(1,1)+((2,1),0)"));
+    PolyDestroy(&p);
+    p = PolyZero();
+    CHECK(PolyIsText(PolyPow(&p, 0), "1"));
+    CHECK(PolyIsText(PolyPow(&p, 1), "0"));
+    CHECK(PolyIsText(PolyPow(&p, 5), "0"));
+    p = P("-3");
+    CHECK(PolyIsText(PolyPow(&p, 3), "-27"));
+    p = P("((2,3),2)");
+    CHECK(PolyIsText(PolyPow(&p, 3), "((8,9),6)"));
+    PolyDestroy(&p);
+    return true;
+}
+
+/**
+ * Sprawdza każdą z metod PolyPow() z wynikiem wielokrotnego mnożenia:
+ * rekurencję Millera (rzadki wielomian jednej zmiennej), rozwinięcie dwumianu
+ * (rzadki wielomian wielu zmiennych lub jednej zmiennej o dużym wyrazie
+ * wolnym) i podnoszenie do kwadratu (wielomian gęsty lub mały wykładnik).
+ * @return Czy test się powiódł?
+ */
+static bool TestPowMethods(void) {
+    // Rekurencja Millera.
+    CHECK(PowMatchesMul(P("(-2,0)+(3,7)+(1,20)"), 6));
+    CHECK(PowMatchesMul(P("(5,0)+(-1,3)+(2,11)+(1,40)"), 5));
+    // Rozwinięcie dwumianu.
+    CHECK(PowMatchesMul(P("((1,4),5)+((2,6)+(7,0),0)"), 6));
+    CHECK(PowMatchesMul(P("(5000000000,0)+(1,20)"), 5));
+    // Podnoszenie do kwadratu.
+    CHECK(PowMatchesMul(P("(1,1)+(1,0)"), 9));
+    CHECK(PowMatchesMul(P("(1,1)+((1,1)+(1,0),0)"), 6));
+    CHECK(PowMatchesMul(P("(1,1)+((-1,1)+(3,0),0)"), 3));
+    // Współczynniki wyniku nie mieszczą się w typie poly_coeff_t.
+    CHECK(PowMatchesMul(P("(3000000000,1)+(-1,0)"), 5));
+    return true;
+}
+
+/**
+ * Sprawdza potęgi modulo liczba pierwsza i złożona oraz odrzucanie przez
+ * kalkulator wykładników, dla których wykładniki wyniku nie mieszczą się
+ * w typie poly_exp_t.
+ * @return Czy test się powiódł?
+ */
+static bool TestPowModAndOverflow(void) {
+    PolySetModulus(7);
+    // (x_0 + 1)^7 = x_0^7 + 1 modulo 7.
+    Poly p = P("(1,1)+(1,0)");
+    CHECK(PolyIsText(PolyPow(&p, 7), "(1,7)+(1,0)"));
+    CHECK(PowMatchesMul(p, 9));
+    CHECK(PowMatchesMul(P("(6,0)+(3,7)+(1,20)"), 6));
+    CHECK(PowMatchesMul(P("((1,4),5)+((2,6)+(5,0),0)"), 5));
+    PolySetModulus(8);
+    // (2x_0)^3 = 0 modulo 8.
+    p = P("(2,1)");
+    CHECK(PolyIsText(PolyPow(&p, 3), "0"));
+    CHECK(PowMatchesMul(P("(2,1)+(3,0)"), 6));
+    PolySetModulus(0);
+
+    CHECK(CalcOutputs("(1,2)+(1,0)\nPOW 2147483648\nPOW -1\nPOW 2\nPRINT\n"
+                      "POW 0\nPRINT\n",
+                      "(1,0)+(2,2)+(1,4)\n1\n",
+                      "ERROR 2 POW WRONG PARAMETER\n"
+                      "ERROR 3 POW WRONG PARAMETER\n"));
+    CHECK(CalcOutputs("(1,1073741824)\nPOW 2\nPRINT\nPOW 1\nPRINT\n",
+                      "(1,1073741824)\n(1,1073741824)\n",
+                      "ERROR 2 POW WRONG PARAMETER\n"));
+    CHECK(CalcOutputs("MOD 5\n(1,1)+(1,0)\nPOW 5\nPRINT\nMOD 0\n",
+                      "(1,0)+(1,5)\n", ""));
+    CHECK(CalcOutputs("POW 2\n", "", "ERROR 1 STACK UNDERFLOW\n"));
+    return true;
+}
+
+/**
+ * Sprawdza, czy NWD wielomianów jest równy wielomianowi zapisanemu
+ * w tekście, i usuwa wielomiany z pamięci.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @param[in] text : tekst oczekiwanego NWD
+ * @return Czy NWD jest określony i równy oczekiwanemu?
+ */
+static bool GcdIsText(Poly p, Poly q, const char *text) {
+    Poly gcd;
+    bool res = PolyGcd(&p, &q, &gcd);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    return res && PolyIsText(gcd, text);
+}
+
+/**
+ * Sprawdza dzielenie wielomianów bez reszty: dzielenia wykonalne, także
+ * wielu zmiennych, i niewykonalne, także w kalkulatorze.
+ * @return Czy test się powiódł?
+ */
+static bool TestDivExact(void) {
+    Poly p = P("(1,2)+(-1,0)"), q = P("(1,1)+(1,0)"), res;
+    CHECK(PolyDivExact(&p, &q, &res));
+    CHECK(PolyIsText(res, "(1,1)+(-1,0)"));
+    PolyDestroy(&p);
+    p = P("(1,2)+(1,0)");
+    CHECK(!PolyDivExact(&p, &q, &res));
+    PolyDestroy(&p);
+    p = PolyZero();
+    CHECK(PolyDivExact(&p, &q, &res));
+    CHECK(PolyIsText(res, "0"));
+    PolyDestroy(&q);
+
+    p = P("6");
+    q = P("3");
+    CHECK(PolyDivExact(&p, &q, &res));
+    CHECK(PolyIsText(res, "2"));
+    PolyDestroy(&q);
+    q = P("4");
+    CHECK(!PolyDivExact(&p, &q, &res));
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+
+    // (x_0 + x_1)(2x_0x_1^2 + 3) dzielone przez x_0 + x_1.
+    p = Product("(1,1)+((1,1),0)", "((2,2),1)+(3,0)");
+    q = P("(1,1)+((1,1),0)");
+    CHECK(PolyDivExact(&p, &q, &res));
+    CHECK(PolyIsText(res, "((2,2),1)+(3,0)"));
+    PolyDestroy(&q);
+    q = P("(1,1)+((2,1),0)");
+    CHECK(!PolyDivExact(&p, &q, &res));
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+
+    // Dzielenie x_0^60 - 1 przez 15. wielomian podziału koła: kopiec
+    // przechowuje więcej iloczynów, niż dzielna ma jednomianów.
+    p = P("(1,60)+(-1,0)");
+    q = P("(1,8)+(-1,7)+(1,5)+(-1,4)+(1,3)+(-1,1)+(1,0)");
+    CHECK(PolyDivExact(&p, &q, &res));
+    CHECK(res.size == 24);
+    Poly product = PolyMul(&res, &q);
+    CHECK(PolyIsEq(&product, &p));
+    PolyDestroy(&product);
+    PolyDestroy(&res);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+
+    CHECK(CalcOutputs("(1,1)+(1,0)\n(1,2)+(-1,0)\nDIV\nPRINT\n",
+                      "(-1,0)+(1,1)\n", ""));
+    CHECK(CalcOutputs("(1,1)+(1,0)\n(1,2)+(1,0)\nDIV\nPRINT\nPOP\nPRINT\n",
+                      "(1,0)+(1,2)\n(1,0)+(1,1)\n",
+                      "ERROR 3 DIV WRONG DIVISOR\n"));
+    CHECK(CalcOutputs("0\n1\nDIV\nPRINT\n", "1\n",
+                      "ERROR 3 DIV WRONG DIVISOR\n"));
+    CHECK(CalcOutputs("1\nDIV\n", "", "ERROR 2 STACK UNDERFLOW\n"));
+    return true;
+}
+
+/**
+ * Sprawdza pseudo-dzielenie: @f$4(x_0^2 + 1) = (2x_0 - 1)(2x_0 + 1) + 5@f$.
+ * @return Czy test się powiódł?
+ */
+static bool TestDivRem(void) {
+    Poly p = P("(1,2)+(1,0)"), q = P("(2,1)+(1,0)"), quot, rem;
+    PolyDivRem(&p, &q, &quot, &rem);
+    CHECK(PolyIsText(quot, "(2,1)+(-1,0)"));
+    CHECK(PolyIsText(rem, "5"));
+    PolyDivRem(&q, &p, &quot, &rem);
+    CHECK(PolyIsText(quot, "0"));
+    CHECK(PolyIsText(rem, "(2,1)+(1,0)"));
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    return true;
+}
+
+/**
+ * Sprawdza NWD, gdy jeden z wielomianów jest zerem lub współczynnikiem.
+ * @return Czy test się powiódł?
+ */
+static bool TestGcdTrivial(void) {
+    CHECK(GcdIsText(PolyZero(), PolyZero(), "0"));
+    CHECK(GcdIsText(PolyZero(), P("(-2,1)+(-4,0)"), "(2,1)+(4,0)"));
+    CHECK(GcdIsText(P("(-2,1)+(-4,0)"), PolyZero(), "(2,1)+(4,0)"));
+    CHECK(GcdIsText(P("-6"), PolyZero(), "6"));
+    CHECK(GcdIsText(P("6"), P("-4"), "2"));
+    CHECK(GcdIsText(P("6"), P("(2,1)+(4,0)"), "2"));
+    CHECK(GcdIsText(P("3"), P("(1,1)+(1,0)"), "1"));
+    CHECK(GcdIsText(P("(1,1)"), P("((1,1),0)"), "1"));
+    CHECK(GcdIsText(P("(2,1)+(4,0)"), P("(6,1)+(12,0)"), "(2,1)+(4,0)"));
+    return true;
+}
+
+/**
+ * Sprawdza NWD wielomianów wielu zmiennych o wspólnym czynniku
+ * @f$a = x_0^2 - 3x_0x_1 + 2x_1^3@f$: @f$\gcd(6ab, 4ac) = 2a@f$.
+ * @return Czy test się powiódł?
+ */
+static bool TestGcdMultivariate(void) {
+    const char *a = "(1,2)+((-3,1),1)+((2,3),0)";
+    Poly p = Product(a, "(12,1)+((6,1)+(30,0),0)");
+    Poly q = Product(a, "((4,1),1)+((-4,2)+(28,0),0)");
+    CHECK(GcdIsText(p, q, "(2,2)+((-6,1),1)+((4,3),0)"));
+    CHECK(CalcOutputs("(1,1)+((1,1),0)\n((1,1),1)+(2,0)\nMUL\n"
+                      "(1,1)+((1,1),0)\n(1,1)+(-1,0)\nMUL\nGCD\nPRINT\n",
+                      "((1,1),0)+(1,1)\n", ""));
+    return true;
+}
+
+/**
+ * Sprawdza NWD modulo małe liczby pierwsze, gdy brakuje punktów do
+ * interpolacji i NWD wyznaczany jest ciągiem podrezultantów, oraz modulo
+ * liczba złożona, gdy NWD nie jest określony.
+ * @return Czy test się powiódł?
+ */
+static bool TestGcdSmallModulus(void) {
+    const char *a = "(1,1)+((1,1)+(1,0),0)";
+    PolySetModulus(2);
+    // x_0^2 + 1 = (x_0 + 1)^2 modulo 2.
+    CHECK(GcdIsText(P("(1,2)+(1,0)"), P("(1,1)+(1,0)"), "(1,1)+(1,0)"));
+    CHECK(GcdIsText(Product(a, "((1,1),1)+(1,0)"),
+                    Product(a, "(1,2)+((1,1)+(1,0),0)"), a));
+    PolySetModulus(3);
+    CHECK(GcdIsText(Product(a, "((1,1),1)+(2,0)"),
+                    Product(a, "(1,2)+((1,2)+(1,0),0)"), a));
+    CHECK(GcdIsText(P("(2,1)+(1,0)"), P("(2,1)"), "1"));
+    CHECK(GcdIsText(P("(2,1)+(1,0)"), PolyZero(), "(1,1)+(2,0)"));
+    PolySetModulus(4);
+    Poly p = P("(1,1)"), q = P("(2,1)"), res;
+    CHECK(!PolyGcd(&p, &q, &res));
+    PolySetModulus(0);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+
+    CHECK(CalcOutputs("MOD 3\n(1,2)+(2,0)\n(1,1)+(1,0)\nGCD\nPRINT\n"
+                      "MOD 6\n(1,1)\nGCD\nPRINT\nMOD 0\n",
+                      "(1,0)+(1,1)\n(1,1)\n", "ERROR 8 GCD WRONG MODULUS\n"));
+    return true;
+}
+
+/**
+ * To jest struktura przechowująca test: jego nazwę i funkcję, która go
+ * wykonuje.
+ */
+typedef struct Test {
+    const char *name;       ///< nazwa testu
+    bool (*function)(void); ///< funkcja wykonująca test
+} Test;
+
+/** Tablica wszystkich testów. */
+static const Test tests[] = {
+    {"mono_alloc_pools", TestMonoAllocPools},
+    {"scratch_arena", TestScratchArena},
+    {"mul_heap", TestMulHeap},
+    {"read_poly", TestReadPoly},
+    {"print_poly", TestPrintPoly},
+    {"shared_monos", TestSharedMonos},
+    {"intern", TestIntern},
+    {"pool_determinism", TestPoolDeterminism},
+    {"mul_kronecker", TestMulKronecker},
+    {"mul_dense", TestMulDense},
+    {"parse_big_coeff", TestParseBigCoeff},
+    {"modulus", TestModulus},
+    {"at_multi", TestAtMulti},
+    {"eval_batch", TestEvalBatch},
+    {"compose", TestCompose},
+    {"own_binary", TestOwnBinary},
+    {"own_unary", TestOwnUnary},
+    {"stack_args", TestStackArgs},
+    {"script_input", TestScriptInput},
+    {"binary_round_trip", TestBinaryRoundTrip},
+    {"binary_corrupt", TestBinaryCorrupt},
+    {"file_args", TestFileArgs},
+    {"view_at_allocs", TestViewAtAllocs},
+    {"view_limits", TestViewLimits},
+    {"flat_ops", TestFlatOps},
+    {"flat_sum_of_products", TestFlatSumOfProducts},
+    {"lazy_eval_batch_underflow", TestLazyEvalBatchUnderflow},
+    {"lazy_stack_ops", TestLazyStackOps},
+    {"lazy_long_chains", TestLazyLongChains},
+    {"poly_meta", TestPolyMeta},
+    {"alloc_counts", TestAllocCounts},
+    {"stats", TestStats},
+    {"pow_trivial", TestPowTrivial},
+    {"pow_methods", TestPowMethods},
+    {"pow_mod_and_overflow", TestPowModAndOverflow},
+    {"div_exact", TestDivExact},
+    {"div_rem", TestDivRem},
+    {"gcd_trivial", TestGcdTrivial},
+    {"gcd_multivariate", TestGcdMultivariate},
+    {"gcd_small_modulus", TestGcdSmallModulus},
+};
+
+/**
+ * Wykonuje wszystkie testy lub test o nazwie podanej w wierszu poleceń
+ * i wypisuje ich wyniki.
+ * @param[in] argc : liczba argumentów wiersza poleceń
+ * @param[in] argv : argumenty wiersza poleceń
+ * @return 0, jeśli wszystkie wykonane testy się powiodły; 1 w przeciwnym
+ * wypadku
+ */
+int main(int argc, char *argv[]) {
+    size_t count = sizeof(tests) / sizeof(tests[0]), run = 0, failed = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (argc > 1 && strcmp(argv[1], tests[i].name) != 0) continue;
+        bool passed = tests[i].function();
+        printf("%s: %s\n", tests[i].name, passed ? "OK" : "FAILED");
+        run++;
+        if (!passed) failed++;
+    }
+    if (run == 0) {
+        fprintf(stderr, "Unknown test %s\n", argv[1]);
+        return 1;
+    }
+    printf("%zu/%zu tests passed\n", run - failed, run);
+    return failed == 0 ? 0 : 1;
+}
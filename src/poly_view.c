@@ -0,0 +1,810 @@
+/** @file
+  Implementacja binarnego zapisu wielomianów i widoków tylko do odczytu
+
+  @authors Izabela Ożdżeńska <io417924@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "big_coeff.h"
+#include "mod_arith.h"
+#include "mono_alloc.h"
+#include "poly_view.h"
+
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Binarny zapis wielomianów jest czytany bez konwersji: wymaga architektury little-endian."
+#endif
+
+_Static_assert(sizeof(poly_coeff_t) == sizeof(uint64_t),
+               "Współczynniki zapisywane są w 64-bitowych słowach.");
+
+/** Pierwsze słowo nagłówka zapisu: napis "POLYVIEW". */
+#define VIEW_MAGIC ((uint64_t) 0x57454956594c4f50ULL)
+
+/** Liczba słów nagłówka zapisu. */
+#define VIEW_HEADER_WORDS 2
+
+/** Maska bitów pierwszego słowa węzła określających rodzaj węzła. */
+#define VIEW_KIND_MASK ((uint64_t) 3)
+
+/** Liczba bitów pierwszego słowa węzła określających rodzaj węzła. */
+#define VIEW_KIND_BITS 2
+
+
+/**
+ * Najmniejsza potęga dwójki, której nie można zapisać w słowie węzła
+ * współczynnika z rodzajem @p VIEW_SMALL.
+ */
+#define VIEW_SMALL_LIMIT ((poly_coeff_t) 1 << 61)
+
+/**
+ * To jest typ wyliczeniowy reprezentujący rodzaj węzła zapisu.
+ */
+typedef enum ViewKind {
+    VIEW_SMALL = 0, ///< współczynnik zapisany w pierwszym słowie
+    VIEW_POLY = 1,  ///< wielomian niebędący współczynnikiem
+    VIEW_WIDE = 2,  ///< współczynnik zapisany w drugim słowie
+    VIEW_BIG = 3    ///< duży współczynnik
+} ViewKind;
+
+/**
+ * Daje rodzaj węzła.
+ * @param[in] node : węzeł
+ * @return rodzaj węzła
+ */
+static inline ViewKind NodeKind(const uint64_t *node) {
+    return (ViewKind) (node[0] & VIEW_KIND_MASK);
+}
+
+/**
+ * Daje liczbę zapisaną w starszych bitach pierwszego słowa węzła (liczbę
+ * jednomianów wielomianu lub cyfr i znak dużego współczynnika).
+ * @param[in] node : węzeł
+ * @return liczba zapisana w węźle
+ */
+static inline uint64_t NodeCount(const uint64_t *node) {
+    return node[0] >> VIEW_KIND_BITS;
+}
+
+/**
+ * Daje liczbę cyfr dużego współczynnika.
+ * @param[in] node : węzeł z rodzajem @p VIEW_BIG
+ * @return liczba cyfr
+ */
+static inline size_t BigNodeLen(const uint64_t *node) {
+    return (size_t) (NodeCount(node) >> 1);
+}
+
+/**
+ * Daje liczbę słów węzła.
+ * @param[in] node : węzeł
+ * @return liczba słów węzła
+ */
+static inline size_t NodeWords(const uint64_t *node) {
+    switch (NodeKind(node)) {
+        case VIEW_SMALL:
+            return 1;
+        case VIEW_WIDE:
+            return 2;
+        case VIEW_BIG:
+            return 1 + (BigNodeLen(node) + 1) / 2;
+        default:
+            return (size_t) node[1];
+    }
+}
+
+/**
+ * Daje wartość współczynnika zapisanego w węźle.
+ * @param[in] node : węzeł z rodzajem @p VIEW_SMALL lub @p VIEW_WIDE
+ * @return wartość współczynnika
+ */
+static inline poly_coeff_t NodeCoeff(const uint64_t *node) {
+    if (NodeKind(node) == VIEW_WIDE) return (poly_coeff_t) node[1];
+    // Rozszerzamy znak 62-bitowej liczby bez przesuwania liczby ujemnej.
+    uint64_t bits = node[0] >> VIEW_KIND_BITS;
+    return (poly_coeff_t) (bits ^ (uint64_t) VIEW_SMALL_LIMIT)
+           - VIEW_SMALL_LIMIT;
+}
+
+/**
+ * Daje cyfry wartości bezwzględnej dużego współczynnika zapisanego
+ * w węźle.
+ * @param[in] node : węzeł z rodzajem @p VIEW_BIG
+ * @return cyfry, od najmniej znaczącej
+ */
+static inline const uint32_t* BigNodeDigits(const uint64_t *node) {
+    return (const uint32_t*) (node + 1);
+}
+
+/**
+ * Sprawdza, czy węzeł jest współczynnikiem równym zeru.
+ * @param[in] node : węzeł
+ * @return Czy węzeł jest zerem?
+ */
+static inline bool NodeIsZero(const uint64_t *node) {
+    return node[0] == VIEW_SMALL;
+}
+
+/**
+ * Sprawdza, czy współczynnik można zapisać w węźle z rodzajem
+ * @p VIEW_SMALL.
+ * @param[in] c : współczynnik
+ * @return Czy współczynnik mieści się w 62 bitach?
+ */
+static inline bool FitsSmall(poly_coeff_t c) {
+    return c >= -VIEW_SMALL_LIMIT && c < VIEW_SMALL_LIMIT;
+}
+
+/**
+ * To jest struktura przechowująca tworzony zapis wielomianu.
+ */
+typedef struct Encoder {
+    uint64_t *words;    ///< słowa zapisu
+    size_t size;        ///< liczba słów zapisu
+    size_t capacity;    ///< pojemność tablicy [words]
+    size_t max_depth;   ///< największa głębokość węzła wielomianu w zapisie
+} Encoder;
+
+/**
+ * Dopisuje do zapisu @p count słów o nieustalonej wartości.
+ * @param[in,out] enc : tworzony zapis
+ * @param[in] count : liczba słów
+ * @return indeks pierwszego dopisanego słowa
+ */
+static size_t Reserve(Encoder *enc, size_t count) {
+    if (enc->size + count > enc->capacity) {
+        while (enc->size + count > enc->capacity) enc->capacity *= 2;
+        enc->words = realloc(enc->words, enc->capacity * sizeof(uint64_t));
+        if (enc->words == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    }
+    size_t pos = enc->size;
+    enc->size += count;
+    return pos;
+}
+
+/**
+ * Dopisuje do zapisu węzeł wielomianu.
+ * @param[in,out] enc : tworzony zapis
+ * @param[in] p : wielomian
+ * @param[in] depth : liczba węzłów wielomianów nad węzłem
+ */
+static void EncodeNode(Encoder *enc, const Poly *p, size_t depth) {
+    if (PolyIsBigCoeff(p)) {
+        bool negative;
+        const uint32_t *digits;
+        size_t len = BigCoeffDigits(p, &negative, &digits);
+        size_t words = (len + 1) / 2;
+        size_t pos = Reserve(enc, 1 + words);
+        enc->words[pos] = ((uint64_t) len << 1 | negative) << VIEW_KIND_BITS
+                          | VIEW_BIG;
+        // Nieparzysta liczba cyfr zostawia w ostatnim słowie zerową połowę.
+        enc->words[pos + words] = 0;
+        memcpy(&enc->words[pos + 1], digits, len * sizeof(uint32_t));
+    }
+    else if (PolyIsCoeff(p)) {
+        if (FitsSmall(p->coeff)) {
+            size_t pos = Reserve(enc, 1);
+            enc->words[pos] = (uint64_t) p->coeff << VIEW_KIND_BITS | VIEW_SMALL;
+        }
+        else {
+            size_t pos = Reserve(enc, 2);
+            enc->words[pos] = VIEW_WIDE;
+            enc->words[pos + 1] = (uint64_t) p->coeff;
+        }
+    }
+    else {
+        if (depth + 1 > enc->max_depth) enc->max_depth = depth + 1;
+        size_t pos = Reserve(enc, 2);
+        enc->words[pos] = (uint64_t) p->size << VIEW_KIND_BITS | VIEW_POLY;
+        // Tablica jednomianów jest posortowana malejąco względem wykładników.
+        for (size_t i = p->size; i-- > 0;) {
+            size_t exp_pos = Reserve(enc, 1);
+            enc->words[exp_pos] = (uint64_t) p->arr[i].exp;
+            EncodeNode(enc, &p->arr[i].p, depth + 1);
+        }
+        enc->words[pos + 1] = enc->size - pos;
+    }
+}
+
+/**
+ * Tworzy binarny zapis wielomianu razem z nagłówkiem.
+ * @param[in] p : wielomian
+ * @param[out] size : rozmiar zapisu w bajtach
+ * @param[out] depth : największa głębokość węzła wielomianu w zapisie
+ * @return zapis przydzielony przez malloc()
+ */
+static uint64_t* Encode(const Poly *p, size_t *size, size_t *depth) {
+    Encoder enc = {.size = 0, .capacity = 64, .max_depth = 0};
+    enc.words = malloc(enc.capacity * sizeof(uint64_t));
+    if (enc.words == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    size_t pos = Reserve(&enc, VIEW_HEADER_WORDS);
+    enc.words[pos] = VIEW_MAGIC;
+    enc.words[pos + 1] = POLY_VIEW_VERSION;
+    EncodeNode(&enc, p, 0);
+    *size = enc.size * sizeof(uint64_t);
+    *depth = enc.max_depth;
+    return enc.words;
+}
+
+/**
+ * Tworzy binarny zapis wielomianu razem z nagłówkiem.
+ * @param[in] p : wielomian
+ * @param[out] size : rozmiar zapisu w bajtach
+ * @return zapis przydzielony przez malloc()
+ */
+uint64_t* PolyToBinary(const Poly *p, size_t *size) {
+    assert(p != NULL && size != NULL);
+    size_t depth;
+    return Encode(p, size, &depth);
+}
+
+/**
+ * Sprawdza, czy duży współczynnik jest zapisany jednoznacznie, czyli tak,
+ * jak zapisałaby go funkcja EncodeNode(): ma niezerową najbardziej znaczącą
+ * cyfrę, zerową nieużywaną połowę ostatniego słowa i nie mieści się w typie
+ * poly_coeff_t.
+ * @param[in] node : węzeł z rodzajem @p VIEW_BIG
+ * @return Czy zapis jest jednoznaczny?
+ */
+static bool CheckBigNode(const uint64_t *node) {
+    size_t len = BigNodeLen(node);
+    const uint32_t *digits = BigNodeDigits(node);
+    if (len < 2 || digits[len - 1] == 0) return false;
+    if (len % 2 == 1 && digits[len] != 0) return false;
+    if (len > 2) return true;
+    uint64_t abs = (uint64_t) digits[1] << 32 | digits[0];
+    bool negative = (NodeCount(node) & 1) != 0;
+    return abs > (uint64_t) LONG_MAX + negative;
+}
+
+/**
+ * Sprawdza poprawność węzła: czy mieści się w dostępnych słowach i czy jest
+ * jednoznacznym zapisem wielomianu (jednomiany o rosnących wykładnikach
+ * i niezerowych współczynnikach, bez wielomianów sprowadzalnych do
+ * współczynnika) o głębokości nie większej niż @p POLY_VIEW_MAX_DEPTH.
+ * @param[in] node : węzeł
+ * @param[in] avail : liczba dostępnych słów od początku węzła
+ * @param[out] words : liczba słów węzła
+ * @param[in] depth : liczba węzłów wielomianów nad węzłem
+ * @return Czy węzeł jest poprawny?
+ */
+static bool CheckNode(const uint64_t *node, size_t avail, size_t *words,
+                      size_t depth) {
+    if (avail == 0) return false;
+    switch (NodeKind(node)) {
+        case VIEW_SMALL:
+            *words = 1;
+            return true;
+        case VIEW_WIDE:
+            *words = 2;
+            return node[0] == VIEW_WIDE && avail >= 2 &&
+                   !FitsSmall((poly_coeff_t) node[1]);
+        case VIEW_BIG:
+            // Liczba cyfr jest sprawdzana przed wyliczeniem liczby słów,
+            // żeby uniknąć przepełnienia.
+            if (BigNodeLen(node) / 2 >= avail) return false;
+            *words = NodeWords(node);
+            return *words <= avail && CheckBigNode(node);
+        default:
+            break;
+    }
+    if (depth == POLY_VIEW_MAX_DEPTH) return false;
+    uint64_t size = NodeCount(node);
+    // Każdy jednomian zajmuje co najmniej dwa słowa.
+    if (avail < 2 || size == 0 || size > avail / 2) return false;
+    uint64_t total = node[1];
+    if (total > avail || total < 2 + 2 * size) return false;
+    size_t pos = 2;
+    uint64_t prev_exp = 0;
+    for (uint64_t i = 0; i < size; i++) {
+        if (pos + 2 > total) return false;
+        uint64_t exp = node[pos];
+        if (exp > INT_MAX || (i > 0 && exp <= prev_exp)) return false;
+        prev_exp = exp;
+        const uint64_t *coeff = node + pos + 1;
+        size_t coeff_words;
+        if (!CheckNode(coeff, total - pos - 1, &coeff_words, depth + 1)) {
+            return false;
+        }
+        if (NodeIsZero(coeff)) return false;
+        if (size == 1 && exp == 0 && NodeKind(coeff) != VIEW_POLY) {
+            return false;
+        }
+        pos += 1 + coeff_words;
+    }
+    *words = total;
+    return pos == total;
+}
+
+/**
+ * Sprawdza poprawność binarnego zapisu wielomianu i tworzy jego widok.
+ * @param[in] data : zapis wyrównany do 8 bajtów
+ * @param[in] size : rozmiar zapisu w bajtach
+ * @param[out] view : widok zapisanego wielomianu
+ * @return Czy zapis jest poprawny?
+ */
+bool PolyViewFromBinary(const void *data, size_t size, PolyView *view) {
+    assert(((uintptr_t) data % sizeof(uint64_t)) == 0);
+    if (size % sizeof(uint64_t) != 0) return false;
+    size_t count = size / sizeof(uint64_t);
+    const uint64_t *words = data;
+    if (count <= VIEW_HEADER_WORDS || words[0] != VIEW_MAGIC ||
+        words[1] != POLY_VIEW_VERSION) {
+        return false;
+    }
+    size_t root_words;
+    if (!CheckNode(words + VIEW_HEADER_WORDS, count - VIEW_HEADER_WORDS,
+                   &root_words, 0) ||
+        root_words != count - VIEW_HEADER_WORDS) {
+        return false;
+    }
+    view->node = words + VIEW_HEADER_WORDS;
+    return true;
+}
+
+/**
+ * Zapisuje wielomian do pliku w postaci binarnej. Wielomian zagnieżdżony
+ * głębiej, niż pozwala na to PolyViewFromBinary(), nie jest zapisywany.
+ * @param[in] p : wielomian
+ * @param[in] path : ścieżka pliku
+ * @return Czy udało się zapisać plik?
+ */
+bool PolySave(const Poly *p, const char *path) {
+    size_t size, depth;
+    uint64_t *data = Encode(p, &size, &depth);
+    if (depth > POLY_VIEW_MAX_DEPTH) {
+        free(data);
+        return false;
+    }
+    FILE *file = fopen(path, "wb");
+    bool ok = file != NULL;
+    if (ok) {
+        ok = fwrite(data, 1, size, file) == size;
+        ok = fclose(file) == 0 && ok;
+    }
+    free(data);
+    return ok;
+}
+
+/**
+ * Wczytuje w całości plik, którego nie można odwzorować w pamięci.
+ * @param[in,out] file : otwierany plik
+ * @param[in] fd : deskryptor pliku
+ * @return Czy udało się wczytać plik?
+ */
+static bool ReadWhole(PolyFile *file, int fd) {
+    size_t capacity = 1 << 12;
+    // Pamięć przydzielona przez malloc() jest wyrównana do 8 bajtów.
+    char *data = malloc(capacity);
+    if (data == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    size_t size = 0;
+    ssize_t got;
+    while ((got = read(fd, data + size, capacity - size)) > 0) {
+        size += (size_t) got;
+        if (size == capacity) {
+            capacity *= 2;
+            data = realloc(data, capacity);
+            if (data == NULL) exit(1); // Błąd podczas alokacji pamięci.
+        }
+    }
+    file->data = data;
+    file->size = size;
+    file->mapped = false;
+    return got == 0;
+}
+
+/**
+ * Otwiera plik z binarnym zapisem wielomianu. Zwykły plik jest odwzorowywany
+ * w pamięci, a inny jest wczytywany w całości.
+ * @param[out] file : otwarty plik
+ * @param[in] path : ścieżka pliku
+ * @return Czy udało się otworzyć plik i czy zawiera on poprawny zapis?
+ */
+bool PolyFileOpen(PolyFile *file, const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) return false;
+    struct stat st;
+    bool ok = false;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    if (map != MAP_FAILED) {
+        *file = (PolyFile) {.data = map, .size = (size_t) st.st_size,
+                            .mapped = true};
+        ok = true;
+    }
+    else {
+        ok = ReadWhole(file, fd);
+    }
+    close(fd);
+    if (ok && PolyViewFromBinary(file->data, file->size, &file->root)) {
+        return true;
+    }
+    PolyFileClose(file);
+    return false;
+}
+
+/**
+ * Zamyka plik z binarnym zapisem wielomianu. Widoki wielomianu z pliku
+ * przestają być ważne.
+ * @param[in,out] file : otwarty plik
+ */
+void PolyFileClose(PolyFile *file) {
+    if (file->mapped) munmap(file->data, file->size);
+    else free(file->data);
+    file->data = NULL;
+    file->size = 0;
+}
+
+/**
+ * Sprawdza, czy wielomian widoku jest współczynnikiem.
+ * @param[in] v : widok wielomianu
+ * @return Czy wielomian jest współczynnikiem?
+ */
+bool PolyViewIsCoeff(PolyView v) {
+    return NodeKind(v.node) != VIEW_POLY;
+}
+
+/**
+ * Zwraca stopień wielomianu zapisanego w węźle.
+ * @param[in] node : węzeł
+ * @return stopień wielomianu
+ */
+static poly_exp_t NodeDeg(const uint64_t *node) {
+    if (NodeKind(node) != VIEW_POLY) return NodeIsZero(node) ? -1 : 0;
+    poly_exp_t res = 0;
+    const uint64_t *mono = node + 2;
+    for (uint64_t i = NodeCount(node); i > 0; i--) {
+        const uint64_t *coeff = mono + 1;
+        poly_exp_t exp = (poly_exp_t) mono[0], child = NodeDeg(coeff);
+        // Stopień nasycany jest do INT_MAX, tak jak w PolyDeg().
+        poly_exp_t deg = child > INT_MAX - exp ? INT_MAX : exp + child;
+        if (deg > res) res = deg;
+        mono = coeff + NodeWords(coeff);
+    }
+    return res;
+}
+
+/**
+ * Zwraca stopień wielomianu widoku (-1 dla wielomianu tożsamościowo równego
+ * zeru) (patrz: PolyDeg()).
+ * @param[in] v : widok wielomianu
+ * @return stopień wielomianu
+ */
+poly_exp_t PolyViewDeg(PolyView v) {
+    return NodeDeg(v.node);
+}
+
+/**
+ * Sprawdza równość wielomianów dwóch widoków, porównując ich zapisy.
+ * @param[in] v : widok wielomianu @f$p@f$
+ * @param[in] w : widok wielomianu @f$q@f$
+ * @return @f$p = q@f$
+ */
+bool PolyViewIsEq(PolyView v, PolyView w) {
+    // Zapis wielomianu jest jednoznaczny.
+    size_t words = NodeWords(v.node);
+    return words == NodeWords(w.node) &&
+           memcmp(v.node, w.node, words * sizeof(uint64_t)) == 0;
+}
+
+/**
+ * Sprawdza równość wielomianu zapisanego w węźle i wielomianu.
+ * @param[in] node : węzeł wielomianu @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p = q@f$
+ */
+static bool NodeIsEqPoly(const uint64_t *node, const Poly *q) {
+    switch (NodeKind(node)) {
+        case VIEW_SMALL:
+        case VIEW_WIDE:
+            return q->arr == NULL && q->coeff == NodeCoeff(node);
+        case VIEW_BIG: ;
+            if (!PolyIsBigCoeff(q)) return false;
+            bool negative;
+            const uint32_t *digits;
+            size_t len = BigCoeffDigits(q, &negative, &digits);
+            return len == BigNodeLen(node) &&
+                   negative == ((NodeCount(node) & 1) != 0) &&
+                   memcmp(digits, BigNodeDigits(node),
+                          len * sizeof(uint32_t)) == 0;
+        default:
+            break;
+    }
+    if (PolyIsCoeff(q) || q->size != NodeCount(node)) return false;
+    const uint64_t *mono = node + 2;
+    // Tablica jednomianów jest posortowana malejąco względem wykładników.
+    for (size_t i = q->size; i-- > 0;) {
+        const uint64_t *coeff = mono + 1;
+        if ((poly_exp_t) mono[0] != q->arr[i].exp ||
+            !NodeIsEqPoly(coeff, &q->arr[i].p)) {
+            return false;
+        }
+        mono = coeff + NodeWords(coeff);
+    }
+    return true;
+}
+
+/**
+ * Sprawdza równość wielomianu widoku i wielomianu.
+ * @param[in] v : widok wielomianu @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p = q@f$
+ */
+bool PolyViewIsEqPoly(PolyView v, const Poly *q) {
+    assert(q != NULL);
+    return NodeIsEqPoly(v.node, q);
+}
+
+/**
+ * Tworzy wielomian równy wielomianowi zapisanemu w węźle, redukując
+ * współczynniki modulo, jeśli ustawiony jest moduł.
+ * @param[in] node : węzeł
+ * @return wielomian
+ */
+static Poly NodeToPoly(const uint64_t *node) {
+    switch (NodeKind(node)) {
+        case VIEW_SMALL:
+        case VIEW_WIDE: ;
+            poly_coeff_t c = NodeCoeff(node);
+            return PolyFromCoeff(ModEnabled() ? ModReduce(c) : c);
+        case VIEW_BIG:
+            return BigCoeffFromDigits((NodeCount(node) & 1) != 0,
+                                      BigNodeLen(node), BigNodeDigits(node));
+        default:
+            break;
+    }
+    size_t size = (size_t) NodeCount(node);
+    Mono *arr = MonoArrAlloc(size);
+    const uint64_t *mono = node + 2;
+    // Jednomiany zapisane są w kolejności rosnących wykładników.
+    for (size_t i = size; i-- > 0;) {
+        const uint64_t *coeff = mono + 1;
+        arr[i] = (Mono) {.p = NodeToPoly(coeff), .exp = (poly_exp_t) mono[0]};
+        mono = coeff + NodeWords(coeff);
+    }
+    return PolyArrMonos(size, arr);
+}
+
+/**
+ * Tworzy wielomian równy wielomianowi widoku. Jeśli ustawiony jest moduł
+ * (patrz: mod_arith.h), współczynniki są redukowane modulo.
+ * @param[in] v : widok wielomianu
+ * @return wielomian
+ */
+Poly PolyViewToPoly(PolyView v) {
+    return NodeToPoly(v.node);
+}
+
+/**
+ * Podnosi liczbę do potęgi, mnożąc kolejne kwadraty.
+ * @param[in] x : podstawa @f$x@f$
+ * @param[in] exp : wykładnik @f$n@f$
+ * @return @f$x^n@f$ (współczynnik)
+ */
+static Poly CoeffPower(poly_coeff_t x, poly_exp_t exp) {
+    Poly res = PolyFromCoeff(1), base = PolyFromCoeff(x);
+    while (exp > 0) {
+        if (exp % 2 == 1) {
+            Poly next = CoeffMul(&res, &base);
+            PolyDestroy(&res);
+            res = next;
+        }
+        exp /= 2;
+        if (exp > 0) {
+            Poly square = CoeffMul(&base, &base);
+            PolyDestroy(&base);
+            base = square;
+        }
+    }
+    PolyDestroy(&base);
+    return res;
+}
+
+/**
+ * To jest struktura przechowująca składnik sumy @f$\sum_j x^{e_j} c_j@f$
+ * wyliczanej przez NodesAt(): węzeł współczynnika @f$c_j@f$, wykładnik
+ * @f$e_j@f$ i wykładnik jednomianu, w którym węzeł występuje na bieżącym
+ * poziomie zagnieżdżenia.
+ */
+typedef struct ViewTerm {
+    const uint64_t *node;   ///< węzeł współczynnika @f$c_j@f$
+    poly_exp_t power;       ///< wykładnik @f$e_j@f$ potęgi @f$x@f$
+    poly_exp_t exp;         ///< wykładnik jednomianu zawierającego węzeł
+} ViewTerm;
+
+/**
+ * Porównuje składniki względem wykładników jednomianów, a przy równych
+ * wykładnikach względem wykładników potęg @f$x@f$.
+ * @param[in] a : składnik
+ * @param[in] b : składnik
+ * @return liczba ujemna, zero lub dodatnia, gdy @p a jest odpowiednio
+ * mniejszy, równy lub większy od @p b
+ */
+static int CompareViewTerms(const void *a, const void *b) {
+    const ViewTerm *t = a, *u = b;
+    if (t->exp != u->exp) return t->exp < u->exp ? -1 : 1;
+    if (t->power != u->power) return t->power < u->power ? -1 : 1;
+    return 0;
+}
+
+/**
+ * Wylicza sumę @f$\sum_j x^{e_j} c_j@f$ współczynników liczbowych
+ * schematem Hornera.
+ * @param[in] terms : składniki o rosnących wykładnikach @f$e_j@f$, których
+ * węzły są współczynnikami
+ * @param[in] count : liczba składników, większa od zera
+ * @param[in] x : wartość @f$x@f$
+ * @return suma składników (współczynnik)
+ */
+static Poly CoeffsAt(const ViewTerm terms[], size_t count, poly_coeff_t x) {
+    Poly res = NodeToPoly(terms[count - 1].node);
+    for (size_t j = count - 1; j-- > 0;) {
+        Poly power = CoeffPower(x, terms[j + 1].power - terms[j].power);
+        Poly scaled = CoeffMul(&res, &power);
+        Poly c = NodeToPoly(terms[j].node);
+        PolyDestroy(&res);
+        res = CoeffAdd(&scaled, &c);
+        PolyDestroy(&power);
+        PolyDestroy(&scaled);
+        PolyDestroy(&c);
+    }
+    Poly power = CoeffPower(x, terms[0].power);
+    Poly scaled = CoeffMul(&res, &power);
+    PolyDestroy(&res);
+    PolyDestroy(&power);
+    return scaled;
+}
+
+/**
+ * Wylicza sumę @f$\sum_j x^{e_j} c_j@f$ wielomianów zapisanych w węzłach.
+ * Jednomiany współczynników @f$c_j@f$ grupowane są według wykładników,
+ * a współczynniki jednomianów o równym wykładniku sumowane są rekurencyjnie,
+ * więc na stercie tworzone są tylko tablice jednomianów wyniku. Pamięć
+ * pomocnicza pochodzi z areny.
+ * @param[in] terms : składniki o rosnących wykładnikach @f$e_j@f$
+ * @param[in] count : liczba składników, większa od zera
+ * @param[in] x : wartość @f$x@f$
+ * @return suma składników
+ */
+static Poly NodesAt(const ViewTerm terms[], size_t count, poly_coeff_t x) {
+    size_t children = 0;
+    bool coeffs = true;
+    for (size_t j = 0; j < count; j++) {
+        const uint64_t *node = terms[j].node;
+        if (NodeKind(node) == VIEW_POLY) {
+            coeffs = false;
+            children += (size_t) NodeCount(node);
+        }
+        else {
+            children++;
+        }
+    }
+    if (coeffs) return CoeffsAt(terms, count, x);
+
+    ScratchMark mark = ScratchGetMark();
+    ViewTerm *child = ScratchAlloc(children * sizeof(ViewTerm));
+    size_t n = 0;
+    for (size_t j = 0; j < count; j++) {
+        const uint64_t *node = terms[j].node;
+        if (NodeKind(node) != VIEW_POLY) {
+            // Współczynnik jest jednomianem z zerowym wykładnikiem.
+            child[n++] = (ViewTerm) {.node = node, .power = terms[j].power,
+                                     .exp = 0};
+            continue;
+        }
+        const uint64_t *mono = node + 2;
+        for (uint64_t i = NodeCount(node); i > 0; i--) {
+            const uint64_t *coeff = mono + 1;
+            child[n++] = (ViewTerm) {.node = coeff, .power = terms[j].power,
+                                     .exp = (poly_exp_t) mono[0]};
+            mono = coeff + NodeWords(coeff);
+        }
+    }
+    qsort(child, n, sizeof(ViewTerm), CompareViewTerms);
+
+    Mono *monos = ScratchAlloc(n * sizeof(Mono));
+    size_t size = 0;
+    for (size_t start = 0, end; start < n; start = end) {
+        end = start + 1;
+        while (end < n && child[end].exp == child[start].exp) end++;
+        Poly c = NodesAt(child + start, end - start, x);
+        if (!PolyIsZero(&c)) monos[size++] = MonoFromPoly(&c, child[start].exp);
+    }
+    Poly res = PolyZero();
+    if (size == 1 && monos[0].exp == 0 && PolyIsCoeff(&monos[0].p)) {
+        // Wielomian stały jest współczynnikiem (patrz: PolyArrMonos()).
+        res = monos[0].p;
+    }
+    else if (size > 0) {
+        // Liczba jednomianów jest dokładna, więc tablica nie jest zmniejszana.
+        Mono *arr = MonoArrAlloc(size);
+        memcpy(arr, monos, size * sizeof(Mono));
+        res = PolyArrMonos(size, arr);
+    }
+    ScratchRelease(mark);
+    return res;
+}
+
+/**
+ * Wylicza wartość wielomianu widoku w punkcie @p x (patrz: PolyAt()).
+ * Współczynniki wyniku wyliczane są schematem Hornera bezpośrednio z zapisu,
+ * więc na stercie tworzony jest tylko wynik.
+ * @param[in] v : widok wielomianu @f$p@f$
+ * @param[in] x : wartość argumentu @f$x@f$
+ * @return @f$p(x, x_0, x_1, \ldots)@f$
+ */
+Poly PolyViewAt(PolyView v, poly_coeff_t x) {
+    const uint64_t *node = v.node;
+    if (NodeKind(node) != VIEW_POLY) return NodeToPoly(node);
+    if (x == 0) {
+        // Pierwszy jednomian ma najmniejszy wykładnik.
+        return node[2] == 0 ? NodeToPoly(node + 3) : PolyZero();
+    }
+    size_t count = (size_t) NodeCount(node);
+    ScratchMark mark = ScratchGetMark();
+    ViewTerm *terms = ScratchAlloc(count * sizeof(ViewTerm));
+    const uint64_t *mono = node + 2;
+    // Jednomiany zapisane są w kolejności rosnących wykładników.
+    for (size_t i = 0; i < count; i++) {
+        const uint64_t *coeff = mono + 1;
+        terms[i] = (ViewTerm) {.node = coeff, .power = (poly_exp_t) mono[0],
+                               .exp = 0};
+        mono = coeff + NodeWords(coeff);
+    }
+    Poly res = NodesAt(terms, count, x);
+    ScratchRelease(mark);
+    return res;
+}
+
+/**
+ * Wypisuje wielomian zapisany w węźle na zadany strumień.
+ * @param[in] node : węzeł
+ * @param[in] stream : strumień wyjściowy
+ */
+static void PrintNode(const uint64_t *node, FILE *stream) {
+    switch (NodeKind(node)) {
+        case VIEW_SMALL:
+        case VIEW_WIDE:
+            fprintf(stream, "%ld", NodeCoeff(node));
+            return;
+        case VIEW_BIG: ;
+            char *digits = BigCoeffDigitsToStr((NodeCount(node) & 1) != 0,
+                                               BigNodeLen(node),
+                                               BigNodeDigits(node));
+            fputs(digits, stream);
+            free(digits);
+            return;
+        default:
+            break;
+    }
+    const uint64_t *mono = node + 2;
+    for (uint64_t i = NodeCount(node); i > 0; i--) {
+        const uint64_t *coeff = mono + 1;
+        putc('(', stream);
+        PrintNode(coeff, stream);
+        fprintf(stream, ",%d)", (poly_exp_t) mono[0]);
+        if (i > 1) putc('+', stream);
+        mono = coeff + NodeWords(coeff);
+    }
+}
+
+/**
+ * Wypisuje wielomian widoku, zakończony znakiem nowej linii, na zadany
+ * strumień w formacie polecenia PRINT.
+ * @param[in] v : widok wielomianu
+ * @param[in] stream : strumień wyjściowy
+ */
+void PolyViewPrint(PolyView v, FILE *stream) {
+    PrintNode(v.node, stream);
+    putc('\n', stream);
+}
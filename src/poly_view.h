@@ -0,0 +1,163 @@
+/** @file
+  Interfejs binarnego zapisu wielomianów i widoków tylko do odczytu
+
+  Wielomian zapisywany jest jako ciąg 64-bitowych słów w kolejności
+  little-endian, w porządku preorder: po nagłówku pliku następuje węzeł
+  wielomianu. Węzeł zaczyna się słowem, którego dwa najmłodsze bity określają
+  jego rodzaj:
+  - współczynnik mieszczący się w 62 bitach jest zapisany w pozostałych
+    bitach tego słowa,
+  - inny współczynnik typu poly_coeff_t zajmuje kolejne słowo,
+  - duży współczynnik (patrz: big_coeff.h) ma w słowie liczbę cyfr i znak,
+    a w kolejnych słowach cyfry wartości bezwzględnej, po dwie w słowie,
+  - wielomian ma w słowie liczbę jednomianów, w kolejnym słowie długość
+    całego węzła, a dalej jednomiany w kolejności rosnących wykładników:
+    słowo z wykładnikiem i węzeł współczynnika.
+
+  Zapis każdego wielomianu jest jednoznaczny, więc równe wielomiany mają
+  identyczne zapisy. Widok (PolyView) wskazuje węzeł w zapisie, np.
+  w odwzorowanym w pamięci pliku, i pozwala wykonywać na nim działania bez
+  tworzenia wielomianu na stercie.
+
+  @authors Izabela Ożdżeńska <io417924@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#ifndef GAMMA_POLY_VIEW_H
+#define GAMMA_POLY_VIEW_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "poly.h"
+
+/** Wersja binarnego zapisu wielomianów. */
+#define POLY_VIEW_VERSION 1
+
+/**
+ * Największa głębokość zagnieżdżenia wielomianów w binarnym zapisie. Funkcje
+ * przetwarzające zapis są rekurencyjne, więc głębsze zapisy są odrzucane
+ * i nie są tworzone, żeby uszkodzony plik nie przepełnił stosu.
+ */
+#define POLY_VIEW_MAX_DEPTH 4096
+
+/**
+ * To jest struktura przechowująca widok wielomianu: wskaźnik na węzeł
+ * w binarnym zapisie. Widok jest ważny, dopóki istnieje zapis.
+ */
+typedef struct PolyView {
+    const uint64_t *node; ///< pierwsze słowo węzła
+} PolyView;
+
+/**
+ * To jest struktura przechowująca otwarty plik z binarnym zapisem wielomianu.
+ */
+typedef struct PolyFile {
+    void *data;     ///< zawartość pliku
+    size_t size;    ///< rozmiar pliku w bajtach
+    bool mapped;    ///< czy zawartość jest odwzorowana w pamięci (mmap)
+    PolyView root;  ///< widok zapisanego wielomianu
+} PolyFile;
+
+/**
+ * Tworzy binarny zapis wielomianu razem z nagłówkiem.
+ * @param[in] p : wielomian
+ * @param[out] size : rozmiar zapisu w bajtach
+ * @return zapis przydzielony przez malloc()
+ */
+uint64_t* PolyToBinary(const Poly *p, size_t *size);
+
+/**
+ * Sprawdza poprawność binarnego zapisu wielomianu i tworzy jego widok.
+ * Zapisy o zbyt głęboko zagnieżdżonych wielomianach są odrzucane.
+ * @param[in] data : zapis wyrównany do 8 bajtów
+ * @param[in] size : rozmiar zapisu w bajtach
+ * @param[out] view : widok zapisanego wielomianu
+ * @return Czy zapis jest poprawny?
+ */
+bool PolyViewFromBinary(const void *data, size_t size, PolyView *view);
+
+/**
+ * Zapisuje wielomian do pliku w postaci binarnej. Wielomian zagnieżdżony
+ * głębiej, niż pozwala na to PolyViewFromBinary(), nie jest zapisywany.
+ * @param[in] p : wielomian
+ * @param[in] path : ścieżka pliku
+ * @return Czy udało się zapisać plik?
+ */
+bool PolySave(const Poly *p, const char *path);
+
+/**
+ * Otwiera plik z binarnym zapisem wielomianu. Zwykły plik jest odwzorowywany
+ * w pamięci, a inny jest wczytywany w całości.
+ * @param[out] file : otwarty plik
+ * @param[in] path : ścieżka pliku
+ * @return Czy udało się otworzyć plik i czy zawiera on poprawny zapis?
+ */
+bool PolyFileOpen(PolyFile *file, const char *path);
+
+/**
+ * Zamyka plik z binarnym zapisem wielomianu. Widoki wielomianu z pliku
+ * przestają być ważne.
+ * @param[in,out] file : otwarty plik
+ */
+void PolyFileClose(PolyFile *file);
+
+/**
+ * Sprawdza, czy wielomian widoku jest współczynnikiem.
+ * @param[in] v : widok wielomianu
+ * @return Czy wielomian jest współczynnikiem?
+ */
+bool PolyViewIsCoeff(PolyView v);
+
+/**
+ * Zwraca stopień wielomianu widoku (-1 dla wielomianu tożsamościowo równego
+ * zeru) (patrz: PolyDeg()).
+ * @param[in] v : widok wielomianu
+ * @return stopień wielomianu
+ */
+poly_exp_t PolyViewDeg(PolyView v);
+
+/**
+ * Sprawdza równość wielomianów dwóch widoków, porównując ich zapisy.
+ * @param[in] v : widok wielomianu @f$p@f$
+ * @param[in] w : widok wielomianu @f$q@f$
+ * @return @f$p = q@f$
+ */
+bool PolyViewIsEq(PolyView v, PolyView w);
+
+/**
+ * Sprawdza równość wielomianu widoku i wielomianu.
+ * @param[in] v : widok wielomianu @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p = q@f$
+ */
+bool PolyViewIsEqPoly(PolyView v, const Poly *q);
+
+/**
+ * Wylicza wartość wielomianu widoku w punkcie @p x (patrz: PolyAt()).
+ * Współczynniki wyniku wyliczane są schematem Hornera bezpośrednio z zapisu,
+ * więc na stercie tworzony jest tylko wynik.
+ * @param[in] v : widok wielomianu @f$p@f$
+ * @param[in] x : wartość argumentu @f$x@f$
+ * @return @f$p(x, x_0, x_1, \ldots)@f$
+ */
+Poly PolyViewAt(PolyView v, poly_coeff_t x);
+
+/**
+ * Tworzy wielomian równy wielomianowi widoku. Jeśli ustawiony jest moduł
+ * (patrz: mod_arith.h), współczynniki są redukowane modulo.
+ * @param[in] v : widok wielomianu
+ * @return wielomian
+ */
+Poly PolyViewToPoly(PolyView v);
+
+/**
+ * Wypisuje wielomian widoku, zakończony znakiem nowej linii, na zadany
+ * strumień w formacie polecenia PRINT.
+ * @param[in] v : widok wielomianu
+ * @param[in] stream : strumień wyjściowy
+ */
+void PolyViewPrint(PolyView v, FILE *stream);
+
+#endif //GAMMA_POLY_VIEW_H
@@ -5,77 +5,62 @@
   @date 2021
 */
 
-#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
 #include "poly.h"
 #include "stack.h"
 
 /**
- * Tworzy nowy element stosu. Ustawia jako parametr zadany wielomian.
- * @param[in] p : wielomian
- * @return element stosu z zadanym wielomianem
+ * Początkowa pojemność tablicy wielomianów stosu.
  */
-static StackNode* newNode(Poly p) {
-    StackNode *stackNode = malloc(sizeof(StackNode));
-    stackNode->p = p;
-    stackNode->next = NULL;
-    return stackNode;
-}
+#define STACK_INITIAL_CAPACITY 16
 
 /**
- * Sprawdza czy stos ma co najmniej @p n elementów.
- * @param[in] top : stos (in. wierzchni element stosu)
- * @param[in] n : liczba elementów
- * @return @f$0@f$, jeśli stos ma mniej niż @p n elementów; @f$1@f$
- * w przeciwnym przypadku
+ * Dodaje wielomian na wierzch stosu.
+ * @param[in,out] stack : stos
+ * @param[in] p : wielomian
  */
-bool hasnElements(const StackNode *top, size_t n) {
-    for (size_t i = 0; i < n; i++) {
-        if (!top) return false;
-        top = top->next;
+void push(Stack *stack, Poly p) {
+    if (stack->size == stack->capacity) {
+        stack->capacity = stack->capacity == 0 ? STACK_INITIAL_CAPACITY
+                                               : 2 * stack->capacity;
+        stack->polys = realloc(stack->polys, stack->capacity * sizeof(Poly));
+        if (stack->polys == NULL) exit(1); // Błąd podczas alokacji pamięci.
     }
-    return true;
+    stack->polys[stack->size++] = p;
 }
 
 /**
- * Zwraca @p n -ty element stosu. Elementy indeksowane są od @f$0@f$.
- * W przypadku gdy na stosie jest mniej niż @p n elementów, program kończy
- * działanie.
- * @param[in] top : stos (in. wierzchni element stosu)
- * @param[in] n : indeks elementu
- * @return @p n -ty element stosu
+ * Zwraca wierzchni element stosu. Usuwa element ze stosu.
+ * @param[in,out] stack : stos, niepusty
+ * @return wierzchni element stosu
  */
-Poly nthElement(const StackNode *top, size_t n) {
-    assert(hasnElements(top, n + 1));
-    for (size_t i = 0; i < n; i++) {
-        top = top->next;
-    }
-    return top->p;
+Poly pop(Stack *stack) {
+    assert(hasnElements(stack, 1));
+    return stack->polys[--stack->size];
 }
 
 /**
- * Dodaje wielomian na wierzch stosu.
- * @param[in,out] top : stos (in. wierzchni element stosu)
- * @param[in] p : wielomian
+ * Przenosi @p n -ty element stosu na wierzchołek, przesuwając elementy
+ * leżące nad nim o jedno miejsce w dół. Elementy indeksowane są od @f$0@f$.
+ * @param[in,out] stack : stos
+ * @param[in] n : indeks elementu, mniejszy od liczby elementów stosu
  */
-void push(StackNode **top, Poly p) {
-    StackNode *stackNode = newNode(p);
-    stackNode->next = *top;
-    *top = stackNode;
+void rotate(Stack *stack, size_t n) {
+    Poly *moved = nthElementPtr(stack, n);
+    Poly p = *moved;
+    memmove(moved, moved + 1, n * sizeof(Poly));
+    stack->polys[stack->size - 1] = p;
 }
 
 /**
- * Zwraca wierzchni element stosu. Usuwa element ze stosu. W przypadku gdy
- * stos jest pusty, program kończy działanie.
- * @param[in,out] top : stos (in. wierzchi element stosu)
- * @return stos bez wierzchniego elementu
+ * Usuwa wszystkie wielomiany ze stosu i zwalnia jego pamięć.
+ * @param[in,out] stack : stos
  */
-Poly pop(StackNode **top) {
-    assert(hasnElements(*top, 1));
-    StackNode *temp = *top;
-    *top = (*top)->next;
-    Poly popped = temp->p;
-    free(temp);
-
-    return popped;
+void destroy(Stack *stack) {
+    for (size_t i = 0; i < stack->size; i++) {
+        PolyDestroy(&stack->polys[i]);
+    }
+    free(stack->polys);
+    *stack = create();
 }
-
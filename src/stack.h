@@ -11,58 +11,85 @@
 #include "poly.h"
 
 /**
- * To jest struktura przechowująca element stosu wielomianów.
+ * To jest struktura przechowująca stos wielomianów. Wielomiany przechowywane
+ * są w powiększanej tablicy, od dna stosu, więc liczba elementów stosu
+ * i dostęp do dowolnego z nich wymagają stałego czasu.
  */
-typedef struct StackNode {
-    Poly p;                 ///< wielomian
-    struct StackNode *next; ///< kolejny element stosu
-} StackNode;
-
-/**
- * To jest typ przechowujący stos wielomianów.
- */
-typedef StackNode* Stack;
+typedef struct Stack {
+    size_t size;        ///< liczba wielomianów na stosie
+    size_t capacity;    ///< pojemność tablicy wielomianów
+    Poly *polys;        ///< wielomiany; wierzchołek ma indeks @p size - 1
+} Stack;
 
 /**
  * Zwraca pusty stos.
  * @return pusty stos
  */
 static inline Stack create(void) {
-    return NULL;
+    return (Stack) {.size = 0, .capacity = 0, .polys = NULL};
 }
 
 /**
  * Sprawdza czy stos ma co najmniej @p n elementów.
- * @param[in] top : stos (in. wierzchni element stosu)
+ * @param[in] stack : stos
  * @param[in] n : liczba elementów
  * @return @f$0@f$, jeśli stos ma mniej niż @p n elementów; @f$1@f$
  * w przeciwnym przypadku
  */
-bool hasnElements(const StackNode *top, size_t n);
+static inline bool hasnElements(const Stack *stack, size_t n) {
+    return stack->size >= n;
+}
+
+/**
+ * Zwraca wskaźnik na @p n -ty element stosu. Elementy indeksowane są od
+ * @f$0@f$, począwszy od wierzchołka. Wskaźnik jest ważny do następnej
+ * zmiany liczby elementów stosu.
+ * @param[in] stack : stos
+ * @param[in] n : indeks elementu, mniejszy od liczby elementów stosu
+ * @return wskaźnik na @p n -ty element stosu
+ */
+static inline Poly* nthElementPtr(const Stack *stack, size_t n) {
+    assert(n < stack->size);
+    return &stack->polys[stack->size - 1 - n];
+}
 
 /**
- * Zwraca @p n -ty element stosu. Elementy indeksowane są od @f$0@f$.
- * W przypadku gdy na stosie jest mniej niż @p n elementów, program kończy
- * działanie.
- * @param[in] top : stos (in. wierzchni element stosu)
- * @param[in] n : indeks elementu
+ * Zwraca @p n -ty element stosu. Elementy indeksowane są od @f$0@f$,
+ * począwszy od wierzchołka.
+ * @param[in] stack : stos
+ * @param[in] n : indeks elementu, mniejszy od liczby elementów stosu
  * @return @p n -ty element stosu
  */
-Poly nthElement(const StackNode *top, size_t n);
+static inline Poly nthElement(const Stack *stack, size_t n) {
+    return *nthElementPtr(stack, n);
+}
 
 /**
  * Dodaje wielomian na wierzch stosu.
- * @param[in,out] top : stos (in. wierzchni element stosu)
+ * @param[in,out] stack : stos
  * @param[in] p : wielomian
  */
-void push(StackNode **top, Poly p);
+void push(Stack *stack, Poly p);
+
+/**
+ * Zwraca wierzchni element stosu. Usuwa element ze stosu.
+ * @param[in,out] stack : stos, niepusty
+ * @return wierzchni element stosu
+ */
+Poly pop(Stack *stack);
+
+/**
+ * Przenosi @p n -ty element stosu na wierzchołek, przesuwając elementy
+ * leżące nad nim o jedno miejsce w dół. Elementy indeksowane są od @f$0@f$.
+ * @param[in,out] stack : stos
+ * @param[in] n : indeks elementu, mniejszy od liczby elementów stosu
+ */
+void rotate(Stack *stack, size_t n);
 
 /**
- * Zwraca wierzchni element stosu. Usuwa element ze stosu. W przypadku gdy
- * stos jest pusty, program kończy działanie.
- * @param[in,out] top : stos (in. wierzchi element stosu)
- * @return stos bez wierzchniego elementu
+ * Usuwa wszystkie wielomiany ze stosu i zwalnia jego pamięć.
+ * @param[in,out] stack : stos
  */
-Poly pop(StackNode **top);
+void destroy(Stack *stack);
 
 #endif //GAMMA_STACK_H
@@ -0,0 +1,281 @@
+/** @file
+  Implementacja puli wątków z podkradaniem zadań
+
+  @authors Izabela Ożdżeńska <io417924@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mono_alloc.h"
+#include "thread_pool.h"
+
+/**
+ * Początkowa pojemność kolejki zadań wątku.
+ */
+#define DEQUE_INITIAL_CAPACITY 64
+
+/**
+ * To jest struktura przechowująca zadanie: pojedyncze wywołanie funkcji
+ * zleconej przez PoolParallelFor().
+ */
+typedef struct Task {
+    void (*body)(void *ctx, size_t idx); ///< wykonywana funkcja
+    void *ctx;                           ///< argument funkcji
+    size_t idx;                          ///< numer wywołania
+    atomic_bool done;                    ///< czy zadanie zostało wykonane
+} Task;
+
+/**
+ * To jest struktura przechowująca kolejkę zadań wątku. Zadania znajdują się
+ * na pozycjach od @p head do @p tail - 1 tablicy @p tasks.
+ */
+typedef struct TaskDeque {
+    pthread_mutex_t lock; ///< blokada kolejki
+    Task **tasks;         ///< tablica zadań
+    size_t head;          ///< początek kolejki, z którego podkradane są zadania
+    size_t tail;          ///< koniec kolejki, na który trafiają nowe zadania
+    size_t capacity;      ///< pojemność tablicy zadań
+} TaskDeque;
+
+/**
+ * To jest struktura przechowująca stan puli wątków.
+ */
+typedef struct ThreadPool {
+    size_t threads;             ///< liczba wątków (łącznie z głównym)
+    pthread_t *workers;         ///< wątki pomocnicze
+    TaskDeque *deques;          ///< kolejki zadań kolejnych wątków
+    atomic_size_t queued;       ///< liczba zadań oczekujących w kolejkach
+    atomic_bool stopping;       ///< czy pula jest zatrzymywana
+    pthread_mutex_t sleep_lock; ///< blokada usypiania bezczynnych wątków
+    pthread_cond_t wake;        ///< sygnał budzący bezczynne wątki
+} ThreadPool;
+
+/** To jest pula wątków. */
+static ThreadPool pool = {.threads = 1};
+
+/** To jest numer wątku w puli (wątek, który uruchomił pulę, ma numer 0). */
+static _Thread_local size_t worker_id = 0;
+
+/**
+ * Wstawia zadanie na koniec kolejki.
+ * @param[in,out] deque : kolejka
+ * @param[in] task : zadanie
+ */
+static void DequePush(TaskDeque *deque, Task *task) {
+    pthread_mutex_lock(&deque->lock);
+    if (deque->tail == deque->capacity) {
+        if (deque->head > 0) {
+            // Przesuwamy zadania na początek tablicy.
+            memmove(deque->tasks, deque->tasks + deque->head,
+                    (deque->tail - deque->head) * sizeof(Task*));
+            deque->tail -= deque->head;
+            deque->head = 0;
+        }
+        else {
+            deque->capacity *= 2;
+            deque->tasks = realloc(deque->tasks, deque->capacity * sizeof(Task*));
+            if (deque->tasks == NULL) exit(1); // Błąd podczas alokacji pamięci.
+        }
+    }
+    deque->tasks[deque->tail++] = task;
+    pthread_mutex_unlock(&deque->lock);
+}
+
+/**
+ * Zdejmuje zadanie z kolejki: z jej końca, jeśli robi to właściciel kolejki,
+ * lub z jej początku, jeśli zadanie jest podkradane.
+ * @param[in,out] deque : kolejka
+ * @param[in] steal : czy zadanie jest podkradane
+ * @return zadanie lub NULL, jeśli kolejka jest pusta
+ */
+static Task* DequeTake(TaskDeque *deque, bool steal) {
+    Task *task = NULL;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->head < deque->tail) {
+        task = steal ? deque->tasks[deque->head++] : deque->tasks[--deque->tail];
+        if (deque->head == deque->tail) deque->head = deque->tail = 0;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return task;
+}
+
+/**
+ * Szuka zadania do wykonania: najpierw w kolejce wątku, a następnie
+ * w kolejkach pozostałych wątków.
+ * @return zadanie lub NULL, jeśli wszystkie kolejki są puste
+ */
+static Task* FindTask(void) {
+    Task *task = DequeTake(&pool.deques[worker_id], false);
+    for (size_t i = 1; task == NULL && i < pool.threads; i++) {
+        task = DequeTake(&pool.deques[(worker_id + i) % pool.threads], true);
+    }
+    if (task != NULL) atomic_fetch_sub(&pool.queued, 1);
+    return task;
+}
+
+/**
+ * Wykonuje zadanie i oznacza je jako wykonane.
+ * @param[in,out] task : zadanie
+ */
+static void RunTask(Task *task) {
+    task->body(task->ctx, task->idx);
+    atomic_store_explicit(&task->done, true, memory_order_release);
+}
+
+/**
+ * Wstawia zadanie do kolejki wątku i budzi bezczynny wątek.
+ * @param[in] task : zadanie
+ */
+static void SpawnTask(Task *task) {
+    // Licznik zwiększamy przed wstawieniem, aby nigdy nie był mniejszy od
+    // faktycznej liczby zadań w kolejkach.
+    atomic_fetch_add(&pool.queued, 1);
+    DequePush(&pool.deques[worker_id], task);
+    pthread_mutex_lock(&pool.sleep_lock);
+    pthread_cond_signal(&pool.wake);
+    pthread_mutex_unlock(&pool.sleep_lock);
+}
+
+/**
+ * Czeka na wykonanie zadania, w międzyczasie wykonując inne zadania.
+ * @param[in] task : zadanie
+ */
+static void WaitTask(Task *task) {
+    while (!atomic_load_explicit(&task->done, memory_order_acquire)) {
+        Task *other = FindTask();
+        if (other != NULL) RunTask(other);
+        else sched_yield();
+    }
+}
+
+/**
+ * Pętla wątku pomocniczego: wykonuje zadania, a gdy ich brak, zasypia do
+ * czasu pojawienia się nowych zadań lub zatrzymania puli.
+ * @param[in] arg : numer wątku
+ * @return NULL
+ */
+static void* WorkerMain(void *arg) {
+    worker_id = (size_t) arg;
+    while (!atomic_load(&pool.stopping)) {
+        Task *task = FindTask();
+        if (task != NULL) {
+            RunTask(task);
+            continue;
+        }
+        pthread_mutex_lock(&pool.sleep_lock);
+        while (atomic_load(&pool.queued) == 0 && !atomic_load(&pool.stopping)) {
+            pthread_cond_wait(&pool.wake, &pool.sleep_lock);
+        }
+        pthread_mutex_unlock(&pool.sleep_lock);
+    }
+    MonoAllocThreadExit();
+    return NULL;
+}
+
+/**
+ * Uruchamia pulę wątków. Wątek wywołujący staje się jednym z @p threads
+ * wątków puli. Dla @f$threads \leq 1@f$ pula nie jest uruchamiana i wszystkie
+ * zadania wykonywane są sekwencyjnie.
+ * @param[in] threads : łączna liczba wątków wykonujących zadania
+ */
+void PoolStart(size_t threads) {
+    if (threads <= 1 || pool.threads > 1) return;
+    pool.threads = threads;
+    atomic_init(&pool.queued, 0);
+    atomic_init(&pool.stopping, false);
+    pthread_mutex_init(&pool.sleep_lock, NULL);
+    pthread_cond_init(&pool.wake, NULL);
+    pool.deques = malloc(threads * sizeof(TaskDeque));
+    pool.workers = malloc((threads - 1) * sizeof(pthread_t));
+    if (pool.deques == NULL || pool.workers == NULL) exit(1); // Błąd podczas
+    // alokacji pamięci.
+    for (size_t i = 0; i < threads; i++) {
+        pthread_mutex_init(&pool.deques[i].lock, NULL);
+        pool.deques[i].head = pool.deques[i].tail = 0;
+        pool.deques[i].capacity = DEQUE_INITIAL_CAPACITY;
+        pool.deques[i].tasks = malloc(DEQUE_INITIAL_CAPACITY * sizeof(Task*));
+        if (pool.deques[i].tasks == NULL) exit(1); // Błąd podczas alokacji
+        // pamięci.
+    }
+    for (size_t i = 1; i < threads; i++) {
+        if (pthread_create(&pool.workers[i - 1], NULL, WorkerMain,
+                           (void*) i) != 0) {
+            exit(1); // Błąd podczas tworzenia wątku.
+        }
+    }
+}
+
+/**
+ * Zatrzymuje pulę wątków. Wywoływana przez wątek, który uruchomił pulę, gdy
+ * nie ma już niezakończonych zadań.
+ */
+void PoolStop(void) {
+    if (pool.threads <= 1) return;
+    pthread_mutex_lock(&pool.sleep_lock);
+    atomic_store(&pool.stopping, true);
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.sleep_lock);
+    for (size_t i = 1; i < pool.threads; i++) {
+        pthread_join(pool.workers[i - 1], NULL);
+    }
+    for (size_t i = 0; i < pool.threads; i++) {
+        pthread_mutex_destroy(&pool.deques[i].lock);
+        free(pool.deques[i].tasks);
+    }
+    free(pool.deques);
+    free(pool.workers);
+    pthread_mutex_destroy(&pool.sleep_lock);
+    pthread_cond_destroy(&pool.wake);
+    pool.threads = 1;
+}
+
+/**
+ * Daje liczbę wątków wykonujących zadania.
+ * @return liczba wątków puli lub 1, jeśli pula nie jest uruchomiona
+ */
+size_t PoolThreads(void) {
+    return pool.threads;
+}
+
+/**
+ * Wykonuje @p body(@p ctx, @f$i@f$) dla każdego @f$i = 0, 1, \ldots, count-1@f$,
+ * potencjalnie równolegle, i czeka na zakończenie wszystkich wywołań.
+ * Wywołania nie mogą od siebie zależeć.
+ * @param[in] count : liczba wywołań
+ * @param[in] body : wykonywana funkcja
+ * @param[in] ctx : argument przekazywany do każdego wywołania
+ */
+void PoolParallelFor(size_t count, void (*body)(void *ctx, size_t idx),
+                     void *ctx) {
+    if (pool.threads <= 1 || count <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            body(ctx, i);
+        }
+        return;
+    }
+    Task *tasks = malloc(count * sizeof(Task));
+    if (tasks == NULL) exit(1); // Błąd podczas alokacji pamięci.
+    for (size_t i = 1; i < count; i++) {
+        tasks[i].body = body;
+        tasks[i].ctx = ctx;
+        tasks[i].idx = i;
+        atomic_init(&tasks[i].done, false);
+        SpawnTask(&tasks[i]);
+    }
+    // Pierwsze wywołanie wykonujemy sami, a na pozostałe czekamy w kolejności
+    // odwrotnej do wstawiania, żeby w pierwszej kolejności zdejmować je
+    // z własnej kolejki.
+    body(ctx, 0);
+    for (size_t i = count; i-- > 1;) {
+        WaitTask(&tasks[i]);
+    }
+    free(tasks);
+}
@@ -0,0 +1,51 @@
+/** @file
+  Interfejs puli wątków z podkradaniem zadań
+
+  Pula wykonuje zadania typu fork-join. Każdy wątek ma własną kolejkę zadań:
+  zadania tworzone przez wątek trafiają na koniec jego kolejki i są z niego
+  zdejmowane przez ten wątek, a bezczynne wątki podkradają zadania z początków
+  kolejek innych wątków. Wątek czekający na zakończenie zadania w tym czasie
+  wykonuje inne zadania, więc zagnieżdżone zrównoleglenie nie prowadzi do
+  zakleszczenia.
+
+  @authors Izabela Ożdżeńska <io417924@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#ifndef GAMMA_THREAD_POOL_H
+#define GAMMA_THREAD_POOL_H
+
+#include <stddef.h>
+
+/**
+ * Uruchamia pulę wątków. Wątek wywołujący staje się jednym z @p threads
+ * wątków puli. Dla @f$threads \leq 1@f$ pula nie jest uruchamiana i wszystkie
+ * zadania wykonywane są sekwencyjnie.
+ * @param[in] threads : łączna liczba wątków wykonujących zadania
+ */
+void PoolStart(size_t threads);
+
+/**
+ * Zatrzymuje pulę wątków. Wywoływana przez wątek, który uruchomił pulę, gdy
+ * nie ma już niezakończonych zadań.
+ */
+void PoolStop(void);
+
+/**
+ * Daje liczbę wątków wykonujących zadania.
+ * @return liczba wątków puli lub 1, jeśli pula nie jest uruchomiona
+ */
+size_t PoolThreads(void);
+
+/**
+ * Wykonuje @p body(@p ctx, @f$i@f$) dla każdego @f$i = 0, 1, \ldots, count-1@f$,
+ * potencjalnie równolegle, i czeka na zakończenie wszystkich wywołań.
+ * Wywołania nie mogą od siebie zależeć.
+ * @param[in] count : liczba wywołań
+ * @param[in] body : wykonywana funkcja
+ * @param[in] ctx : argument przekazywany do każdego wywołania
+ */
+void PoolParallelFor(size_t count, void (*body)(void *ctx, size_t idx),
+                     void *ctx);
+
+#endif //GAMMA_THREAD_POOL_H